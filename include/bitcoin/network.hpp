@@ -16,24 +16,55 @@
 
 #include <bitcoin/bitcoin.hpp>
 #include <bitcoin/network/acceptor.hpp>
+#include <bitcoin/network/admission.hpp>
+#include <bitcoin/network/affinity_pool.hpp>
+#include <bitcoin/network/anchors.hpp>
+#include <bitcoin/network/block_scheduler.hpp>
+#include <bitcoin/network/buffer_pool.hpp>
 #include <bitcoin/network/channel.hpp>
+#include <bitcoin/network/channel_inventory.hpp>
+#include <bitcoin/network/channel_metrics.hpp>
+#include <bitcoin/network/compact_messages.hpp>
 #include <bitcoin/network/connections.hpp>
 #include <bitcoin/network/connector.hpp>
 #include <bitcoin/network/const_buffer.hpp>
 #include <bitcoin/network/define.hpp>
+#include <bitcoin/network/dispatch_monitor.hpp>
+#include <bitcoin/network/handler_allocator.hpp>
 #include <bitcoin/network/hosts.hpp>
+#include <bitcoin/network/hosts_file.hpp>
+#include <bitcoin/network/inventory_relay.hpp>
+#include <bitcoin/network/latency_histogram.hpp>
+#include <bitcoin/network/lifecycle_metrics.hpp>
 #include <bitcoin/network/locked_socket.hpp>
 #include <bitcoin/network/logging.hpp>
+#include <bitcoin/network/memory_accounts.hpp>
+#include <bitcoin/network/message_cache.hpp>
+#include <bitcoin/network/message_checksum.hpp>
 #include <bitcoin/network/message_subscriber.hpp>
+#include <bitcoin/network/metrics_exporter.hpp>
+#include <bitcoin/network/monitored_dispatcher.hpp>
+#include <bitcoin/network/netgroup.hpp>
+#include <bitcoin/network/outbound_reservations.hpp>
 #include <bitcoin/network/p2p.hpp>
+#include <bitcoin/network/payload_streambuf.hpp>
 #include <bitcoin/network/pending_channels.hpp>
 #include <bitcoin/network/pending_sockets.hpp>
 #include <bitcoin/network/proxy.hpp>
+#include <bitcoin/network/reconnect_backoff.hpp>
+#include <bitcoin/network/resolver_cache.hpp>
+#include <bitcoin/network/rolling_filter.hpp>
 #include <bitcoin/network/settings.hpp>
+#include <bitcoin/network/slab_allocator.hpp>
 #include <bitcoin/network/socket.hpp>
+#include <bitcoin/network/timer_wheel.hpp>
+#include <bitcoin/network/token_bucket.hpp>
+#include <bitcoin/network/traffic_capture.hpp>
 #include <bitcoin/network/version.hpp>
 #include <bitcoin/network/protocols/protocol.hpp>
 #include <bitcoin/network/protocols/protocol_address.hpp>
+#include <bitcoin/network/protocols/protocol_block_sync.hpp>
+#include <bitcoin/network/protocols/protocol_compact_block.hpp>
 #include <bitcoin/network/protocols/protocol_events.hpp>
 #include <bitcoin/network/protocols/protocol_ping.hpp>
 #include <bitcoin/network/protocols/protocol_seed.hpp>
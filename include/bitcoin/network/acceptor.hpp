@@ -25,10 +25,18 @@
 #include <functional>
 #include <memory>
 #include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/admission.hpp>
+#include <bitcoin/network/affinity_pool.hpp>
+#include <bitcoin/network/buffer_pool.hpp>
 #include <bitcoin/network/channel.hpp>
 #include <bitcoin/network/define.hpp>
+#include <bitcoin/network/dispatch_monitor.hpp>
+#include <bitcoin/network/memory_accounts.hpp>
+#include <bitcoin/network/monitored_dispatcher.hpp>
 #include <bitcoin/network/settings.hpp>
 #include <bitcoin/network/socket.hpp>
+#include <bitcoin/network/timer_wheel.hpp>
+#include <bitcoin/network/token_bucket.hpp>
 
 namespace libbitcoin {
 namespace network {
@@ -43,7 +51,11 @@ public:
     typedef std::function<void(const code&, channel::ptr)> accept_handler;
 
     /// Construct an instance.
-    acceptor(threadpool& pool, const settings& settings);
+    acceptor(threadpool& pool, const settings& settings,
+        buffer_pool::ptr buffers, affinity_pool::ptr affinity,
+        admission::ptr admission, timer_wheel::ptr timers,
+        token_bucket::ptr uploads, memory_accounts::ptr memory,
+        dispatch_monitor::ptr dispatches);
 
     /// Validate acceptor stopped.
     ~acceptor();
@@ -52,17 +64,23 @@ public:
     acceptor(const acceptor&) = delete;
     void operator=(const acceptor&) = delete;
 
-    /// Start the listener on the specified port.
+    /// Start the listener on the specified port of all interfaces.
     virtual void listen(uint16_t port, result_handler handler);
 
-    /// Accept the next connection available, until canceled.
+    /// Start the listener on the specified address and port.
+    /// Sharing the port among listeners requires SO_REUSEPORT support.
+    virtual void listen(const config::authority& bind, bool reuse_port,
+        result_handler handler);
+
+    /// Accept the next admitted connection available, until canceled.
+    /// Sockets that are not admitted are closed without creating a channel.
     virtual void accept(accept_handler handler);
 
     /// Cancel the listener and all outstanding accept attempts.
     virtual void stop();
 
 private:
-    code safe_listen(uint16_t port);
+    code safe_listen(const asio::endpoint& endpoint, bool reuse_port);
     void safe_accept(socket::ptr socket, accept_handler handler);
     std::shared_ptr<channel> new_channel(socket::ptr socket);
     void handle_accept(const boost_code& ec, socket::ptr socket,
@@ -70,7 +88,13 @@ private:
 
     threadpool& pool_;
     const settings& settings_;
-    dispatcher dispatch_;
+    buffer_pool::ptr buffers_;
+    affinity_pool::ptr affinity_;
+    admission::ptr admission_;
+    timer_wheel::ptr timers_;
+    token_bucket::ptr uploads_;
+    memory_accounts::ptr memory_;
+    monitored_dispatcher dispatch_;
     asio::acceptor_ptr acceptor_;
     mutable shared_mutex mutex_;
 };
@@ -0,0 +1,114 @@
+/**
+ * Copyright (c) 2011-2016 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NETWORK_ADMISSION_HPP
+#define LIBBITCOIN_NETWORK_ADMISSION_HPP
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <vector>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/connections.hpp>
+#include <bitcoin/network/define.hpp>
+#include <bitcoin/network/memory_accounts.hpp>
+#include <bitcoin/network/netgroup.hpp>
+#include <bitcoin/network/settings.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+/// Admission control for accepted sockets, thread and lock safe.
+/// This is applied before a channel is constructed, so that rejected sockets
+/// cost no more than the accept. Accepts are rate limited per subnet (/24 for
+/// IPv4 and /48 for IPv6), each subnet with a token bucket of one minute.
+/// When all connection slots are filled the least useful inbound channel
+/// may be evicted in favor of the new peer. While the network is over its
+/// memory limit no peer is admitted.
+class BCT_API admission
+{
+public:
+    typedef std::shared_ptr<admission> ptr;
+
+    /// The eviction properties of an inbound channel.
+    struct candidate
+    {
+        typedef std::vector<candidate> list;
+
+        network::netgroup netgroup;
+        uint64_t ping_microseconds;
+        uint64_t useful_bytes;
+        uint64_t connected_milliseconds;
+    };
+
+    /// Select the candidate to evict, returns the list size if none.
+    /// Peers of lowest ping, of most useful bytes (blocks, transactions and
+    /// headers) and of longest connection are protected. Of the remainder
+    /// the youngest of the most populous network group is selected.
+    static size_t select_eviction(const candidate::list& candidates);
+
+    /// Construct an instance.
+    admission(const settings& settings, connections::ptr connections,
+        memory_accounts::ptr memory);
+
+    /// This class is not copyable.
+    admission(const admission&) = delete;
+    void operator=(const admission&) = delete;
+
+    /// Determine if a connection from the peer may be admitted.
+    virtual code admit(const config::authority& peer);
+
+private:
+    typedef std::chrono::steady_clock clock;
+    typedef std::array<uint8_t, 6> subnet;
+
+    struct bucket
+    {
+        double tokens;
+        clock::time_point updated;
+    };
+
+    typedef std::map<subnet, bucket> bucket_map;
+
+    static subnet to_subnet(const config::authority& peer);
+
+    bool evict();
+    bool blacklisted(const config::authority& peer) const;
+    bool throttled(const config::authority& peer);
+    void safe_refill(bucket& entry, clock::time_point now) const;
+    void safe_purge(clock::time_point now);
+
+    const settings& settings_;
+    const size_t connection_limit_;
+    const double rate_;
+    connections::ptr connections_;
+    memory_accounts::ptr memory_;
+
+    // These are protected by mutex.
+    bucket_map buckets_;
+    mutable shared_mutex mutex_;
+};
+
+} // namespace network
+} // namespace libbitcoin
+
+#endif
@@ -0,0 +1,76 @@
+/**
+ * Copyright (c) 2011-2016 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NETWORK_AFFINITY_POOL_HPP
+#define LIBBITCOIN_NETWORK_AFFINITY_POOL_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/define.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+/// A fixed set of single threaded threadpools, each with its own service.
+/// Channels are assigned to a pool round robin, so that the socket, timers
+/// and subscribers of a channel complete on one thread, thread safe.
+/// With no pools all channels are assigned to the shared threadpool.
+class BCT_API affinity_pool
+{
+public:
+    typedef std::shared_ptr<affinity_pool> ptr;
+
+    /// Construct an instance of the specified number of pools.
+    affinity_pool(threadpool& shared, size_t count);
+
+    /// This class is not copyable.
+    affinity_pool(const affinity_pool&) = delete;
+    void operator=(const affinity_pool&) = delete;
+
+    /// The number of pools, zero if only the shared threadpool is used.
+    virtual size_t size() const;
+
+    /// Obtain the threadpool to which the next channel is assigned.
+    virtual threadpool& next();
+
+    /// Start one thread on each pool.
+    virtual void spawn(thread_priority priority);
+
+    /// Allow each pool to complete its work and then stop.
+    virtual void shutdown();
+
+    /// Wait for the threads of each pool to exit.
+    virtual void join();
+
+private:
+    typedef std::vector<std::unique_ptr<threadpool>> pool_list;
+
+    // These are thread safe.
+    threadpool& shared_;
+    const pool_list pools_;
+    std::atomic<size_t> next_;
+};
+
+} // namespace network
+} // namespace libbitcoin
+
+#endif
@@ -0,0 +1,56 @@
+/**
+ * Copyright (c) 2011-2016 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NETWORK_ANCHORS_HPP
+#define LIBBITCOIN_NETWORK_ANCHORS_HPP
+
+#include <cstddef>
+#include <boost/filesystem.hpp>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/define.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+/// The outbound peers connected at shutdown, persisted for a warm restart.
+/// The file is a line-oriented list of config::authority serializations.
+/// This class is not thread safe.
+class BCT_API anchors
+{
+public:
+
+    /// Construct an instance, at most capacity anchors are loaded or saved.
+    anchors(const boost::filesystem::path& file, size_t capacity);
+
+    /// Read the anchors and remove the file, so that each is used once.
+    /// A missing file is not an error and produces no anchors.
+    virtual code load(config::authority::list& out) const;
+
+    /// Write the anchors, replacing any previous file.
+    virtual code save(const config::authority::list& anchors) const;
+
+private:
+    const boost::filesystem::path file_;
+    const size_t capacity_;
+};
+
+} // namespace network
+} // namespace libbitcoin
+
+#endif
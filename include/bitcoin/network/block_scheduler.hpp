@@ -0,0 +1,158 @@
+/**
+ * Copyright (c) 2011-2016 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NETWORK_BLOCK_SCHEDULER_HPP
+#define LIBBITCOIN_NETWORK_BLOCK_SCHEDULER_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <set>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/define.hpp>
+#include <bitcoin/network/settings.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+/// Headers-first block download work allocation, thread and lock safe.
+/// Headers are accepted from one peer at a time, and the hashes of their
+/// blocks are queued in header order. Each peer is allocated a share of the
+/// download window in proportion to its measured throughput, and requests
+/// that stall are returned to the front of the queue for another peer.
+/// Peers are identified by channel identifier.
+class BCT_API block_scheduler
+{
+public:
+    typedef std::shared_ptr<block_scheduler> ptr;
+
+    /// Construct an instance.
+    block_scheduler(const settings& settings);
+
+    /// This class is not copyable.
+    block_scheduler(const block_scheduler&) = delete;
+    void operator=(const block_scheduler&) = delete;
+
+    /// Discard all work and begin from the locator (ordered from the top).
+    virtual void reset(const hash_list& locator);
+
+    /// Determine if a download has been started.
+    virtual bool active() const;
+
+    /// The number of block hashes not yet requested.
+    virtual size_t queued() const;
+
+    /// The number of blocks requested and not yet received.
+    virtual size_t outstanding() const;
+
+    /// The number of blocks requested of the peer and not yet received.
+    virtual size_t outstanding(uint64_t peer) const;
+
+    // Headers.
+    // ------------------------------------------------------------------------
+
+    /// Assign the header role to the peer if it is vacant, true if assigned.
+    /// A peer that has stalled on headers is not assigned the role again.
+    virtual bool claim_headers(uint64_t peer);
+
+    /// Determine if the peer has the header role.
+    virtual bool header_peer(uint64_t peer) const;
+
+    /// Record a header request by the peer, returning its block locator.
+    virtual hash_list request_headers(uint64_t peer);
+
+    /// Queue the blocks of headers from the peer, in order.
+    /// Returns error::not_found if the peer does not have the header role
+    /// and error::bad_stream if the headers do not link to prior headers.
+    virtual code store_headers(uint64_t peer,
+        const chain::header::list& headers);
+
+    // Blocks.
+    // ------------------------------------------------------------------------
+
+    /// Allocate the next block hashes to request from the peer, may be empty.
+    virtual hash_list allocate(uint64_t peer);
+
+    /// Record receipt of a block from the peer, of the serialized size.
+    /// Returns false if the block is not outstanding (unrequested or late).
+    virtual bool complete(uint64_t peer, const hash_digest& hash,
+        size_t bytes);
+
+    /// Return stalled block requests of the peer to the queue, and release
+    /// a stalled header role. Returns the number of requests returned.
+    virtual size_t expire(uint64_t peer);
+
+    /// Return all work of the peer to the queue and forget the peer.
+    virtual void remove(uint64_t peer);
+
+    /// The measured throughput of the peer in bytes per second, zero if
+    /// not yet measured.
+    virtual double rate(uint64_t peer) const;
+
+private:
+    typedef std::chrono::steady_clock clock;
+
+    struct request
+    {
+        size_t sequence;
+        uint64_t peer;
+        clock::time_point time;
+    };
+
+    struct peer_state
+    {
+        size_t outstanding;
+        double rate;
+        clock::time_point last;
+    };
+
+    typedef std::map<size_t, hash_digest> hash_queue;
+    typedef std::map<hash_digest, request> request_map;
+    typedef std::map<uint64_t, peer_state> peer_map;
+
+    size_t safe_quota(const peer_state& peer) const;
+    size_t safe_return(uint64_t peer, bool stalled_only,
+        clock::time_point now);
+
+    const size_t window_;
+    const size_t peer_blocks_;
+    const clock::duration stall_;
+
+    // These are protected by mutex.
+    bool active_;
+    hash_list locator_;
+    hash_digest last_header_;
+    bool claimed_;
+    uint64_t header_peer_;
+    bool header_pending_;
+    clock::time_point header_requested_;
+    std::set<uint64_t> header_stalled_;
+    size_t sequence_;
+    hash_queue queue_;
+    request_map requests_;
+    peer_map peers_;
+    mutable shared_mutex mutex_;
+};
+
+} // namespace network
+} // namespace libbitcoin
+
+#endif
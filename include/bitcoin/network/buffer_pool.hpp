@@ -0,0 +1,104 @@
+/**
+ * Copyright (c) 2011-2016 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NETWORK_BUFFER_POOL_HPP
+#define LIBBITCOIN_NETWORK_BUFFER_POOL_HPP
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include <boost/thread.hpp>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/define.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+/// A shared pool of size-classed payload buffers, thread and lock safe.
+/// Buffers are borrowed per message and return to the pool when released.
+/// Each size class retains no more than the configured high-water bytes.
+class BCT_API buffer_pool
+  : public enable_shared_from_base<buffer_pool>
+{
+public:
+    typedef std::shared_ptr<buffer_pool> ptr;
+    typedef std::shared_ptr<data_chunk> buffer;
+
+    /// Usage counters for a single size class.
+    struct class_statistics
+    {
+        size_t capacity;
+        size_t borrowed;
+        size_t reused;
+        size_t returned;
+        size_t discarded;
+        size_t retained;
+    };
+
+    /// Usage counters for all size classes and for unpooled allocations.
+    struct statistics
+    {
+        std::vector<class_statistics> classes;
+        size_t oversized;
+        size_t retained_bytes;
+    };
+
+    /// Construct an instance, a zero high-water disables retention.
+    buffer_pool(size_t class_high_water_bytes);
+
+    /// This class is not copyable.
+    buffer_pool(const buffer_pool&) = delete;
+    void operator=(const buffer_pool&) = delete;
+
+    /// Borrow a buffer sized to the specified number of bytes.
+    /// The buffer is returned to the pool when the last reference is released.
+    virtual buffer borrow(size_t size);
+
+    /// Get a snapshot of the pool usage counters.
+    virtual statistics pool_statistics() const;
+
+private:
+    typedef std::unique_ptr<data_chunk> chunk_ptr;
+    typedef std::vector<chunk_ptr> chunk_list;
+
+    struct size_class
+    {
+        chunk_list free;
+        class_statistics counters;
+    };
+
+    static size_t to_class(size_t size);
+    static size_t to_capacity(size_t index);
+    static void release(std::weak_ptr<buffer_pool> pool, data_chunk* chunk);
+
+    chunk_ptr safe_take(size_t index);
+    void safe_restore(size_t index, chunk_ptr chunk);
+
+    const size_t high_water_;
+
+    // These are protected by mutex.
+    size_t oversized_;
+    std::vector<size_class> classes_;
+    mutable shared_mutex mutex_;
+};
+
+} // namespace network
+} // namespace libbitcoin
+
+#endif
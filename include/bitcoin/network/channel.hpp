@@ -20,18 +20,26 @@
 #ifndef LIBBITCOIN_NETWORK_CHANNEL_HPP
 #define LIBBITCOIN_NETWORK_CHANNEL_HPP
 
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
 #include <memory>
 #include <utility>
 #include <string>
 #include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/buffer_pool.hpp>
+#include <bitcoin/network/channel_inventory.hpp>
+#include <bitcoin/network/channel_metrics.hpp>
 #include <bitcoin/network/const_buffer.hpp>
 #include <bitcoin/network/define.hpp>
+#include <bitcoin/network/lifecycle_metrics.hpp>
+#include <bitcoin/network/memory_accounts.hpp>
 #include <bitcoin/network/proxy.hpp>
 #include <bitcoin/network/message_subscriber.hpp>
 #include <bitcoin/network/settings.hpp>
 #include <bitcoin/network/socket.hpp>
+#include <bitcoin/network/timer_wheel.hpp>
+#include <bitcoin/network/token_bucket.hpp>
 
 namespace libbitcoin {
 namespace network {
@@ -44,16 +52,27 @@ public:
     typedef std::shared_ptr<channel> ptr;
 
     /// Construct an instance.
-    channel(threadpool& pool, socket::ptr socket, const settings& settings);
+    channel(threadpool& pool, socket::ptr socket, const settings& settings,
+        buffer_pool::ptr buffers, timer_wheel::ptr timers,
+        token_bucket::ptr uploads, memory_accounts::ptr memory);
+
+    /// Release the memory accounted to the channel.
+    ~channel();
 
     void start(result_handler handler) override;
 
     virtual bool notify() const;
     virtual void set_notify(bool value);
 
+    virtual bool inbound() const;
+    virtual void set_inbound(bool value);
+
     virtual uint64_t nonce() const;
     virtual void set_nonce(uint64_t value);
 
+    /// Unique within the process and fixed for the life of the channel.
+    virtual uint64_t identifier() const;
+
     virtual const message::version& version() const;
     virtual void set_version(const message::version& value);
 
@@ -68,6 +87,20 @@ public:
     virtual void set_located(const hash_digest& start,
         const hash_digest& stop);
 
+    /// Set the number of requests awaiting a response from the peer.
+    /// While requests are outstanding the channel is stopped if its receive
+    /// throughput over the stall interval falls below the minimum.
+    virtual void set_outstanding(size_t requests);
+
+    /// The inventory known to the peer and queued for relay to it.
+    /// Inventory, transactions and blocks read from the peer are known to it,
+    /// those skipped as unsubscribed are not.
+    virtual channel_inventory& inventory();
+
+    /// The startup times of the channel, connected upon construction.
+    /// This is NOT thread safe, times are set in the startup sequence.
+    virtual lifecycle_metrics::timeline& timeline();
+
 protected:
     virtual void handle_activity();
     virtual void handle_stopping();
@@ -78,18 +111,40 @@ private:
     void start_expiration();
     void handle_expiration(const code& ec);
 
-    void start_inactivity();
+    void start_inactivity(const asio::duration& delay);
     void handle_inactivity(const code& ec);
 
+    void check_throughput();
+
+    bool handle_inventory(const code& ec, message::inventory::ptr message);
+    bool handle_transactions(const code& ec,
+        message_subscriber::batch_ptr<message::transaction> messages);
+    bool handle_block(const code& ec, message::block::ptr message);
+
     bool notify_;
+    bool inbound_;
     uint64_t nonce_;
+    const uint64_t identifier_;
     hash_digest located_start_;
     hash_digest located_stop_;
     message::version version_;
-    deadline::ptr expiration_;
-    deadline::ptr inactivity_;
+    timer_wheel::ptr timers_;
+    memory_accounts::ptr memory_;
+    const asio::duration expiration_;
+    const asio::duration inactivity_;
+    std::atomic<uint64_t> expiration_timer_;
+    std::atomic<uint64_t> inactivity_timer_;
     bc::atomic<hash_digest> own_threshold_;
     bc::atomic<hash_digest> peer_threshold_;
+    channel_inventory inventory_;
+    const uint64_t minimum_throughput_;
+    const channel_metrics::clock::duration stall_interval_;
+    std::atomic<size_t> outstanding_;
+    lifecycle_metrics::timeline timeline_;
+
+    // These are accessed only by the read sequence.
+    channel_metrics::clock::time_point sample_start_;
+    uint64_t sample_bytes_;
 };
 
 } // namespace network
@@ -0,0 +1,73 @@
+/**
+ * Copyright (c) 2011-2016 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NETWORK_CHANNEL_INVENTORY_HPP
+#define LIBBITCOIN_NETWORK_CHANNEL_INVENTORY_HPP
+
+#include <cstddef>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/define.hpp>
+#include <bitcoin/network/rolling_filter.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+/// The inventory relay state of a single channel, thread safe.
+/// Hashes the peer is known to have are held in a rolling filter of fixed
+/// footprint, so the oldest are forgotten (and may be announced again) and
+/// about one in a thousand unknown hashes is mistaken as known.
+class BCT_API channel_inventory
+{
+public:
+    typedef message::inventory_vector::list list;
+
+    /// Construct an instance.
+    channel_inventory(size_t known_capacity);
+
+    /// This class is not copyable.
+    channel_inventory(const channel_inventory&) = delete;
+    void operator=(const channel_inventory&) = delete;
+
+    /// Record items the peer is known to have.
+    void add_known(const list& items);
+
+    /// Determine if the peer is known to have the item.
+    bool is_known(const message::inventory_vector& item) const;
+
+    /// Select the items the peer is not known to have.
+    list unknown(const list& items) const;
+
+    /// Queue the items the peer is not known to have, returns the count.
+    /// Queued items are known, so each is announced to the peer once.
+    size_t queue(const list& items);
+
+    /// Take all queued items.
+    list take();
+
+private:
+    // These are protected by mutex.
+    rolling_filter known_;
+    list queued_;
+    mutable shared_mutex mutex_;
+};
+
+} // namespace network
+} // namespace libbitcoin
+
+#endif
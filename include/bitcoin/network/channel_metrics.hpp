@@ -0,0 +1,146 @@
+/**
+ * Copyright (c) 2011-2016 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NETWORK_CHANNEL_METRICS_HPP
+#define LIBBITCOIN_NETWORK_CHANNEL_METRICS_HPP
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/define.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+/// Traffic and latency counters for a single channel, thread and lock safe.
+/// Counters are relaxed atomics, so a snapshot is not a consistent cut.
+class BCT_API channel_metrics
+{
+public:
+    typedef std::chrono::steady_clock clock;
+
+    /// The number of message types, including unknown.
+    static constexpr size_t type_count =
+        static_cast<size_t>(message::message_type::version) + 1;
+
+    /// Message and byte counts for a direction (in or out).
+    struct traffic
+    {
+        uint64_t bytes;
+        uint64_t messages;
+        std::array<uint64_t, type_count> messages_by_type;
+        std::array<uint64_t, type_count> bytes_by_type;
+    };
+
+    /// A copy of the channel counters.
+    struct snapshot
+    {
+        typedef std::vector<snapshot> list;
+
+        config::authority authority;
+        uint64_t nonce;
+        traffic received;
+        traffic sent;
+        uint64_t ping_count;
+        uint64_t ping_last_microseconds;
+        uint64_t ping_minimum_microseconds;
+        uint64_t ping_average_microseconds;
+        uint64_t ping_smoothed_microseconds;
+        uint64_t queued_messages;
+        uint64_t queued_bytes;
+        uint64_t skipped_messages;
+        uint64_t skipped_bytes;
+        uint64_t idle_milliseconds;
+        uint64_t connected_milliseconds;
+    };
+
+    /// Construct an instance.
+    channel_metrics();
+
+    /// This class is not copyable.
+    channel_metrics(const channel_metrics&) = delete;
+    void operator=(const channel_metrics&) = delete;
+
+    /// Record a completely received message.
+    void received(message::message_type type, size_t bytes);
+
+    /// Record a completely sent message.
+    void sent(message::message_type type, size_t bytes);
+
+    /// Record a ping round trip time, round trips are recorded in sequence.
+    void ping(const clock::duration& round_trip);
+
+    /// Record a received message that was dropped without parsing.
+    void skipped(size_t bytes);
+
+    /// Record the current send queue depth.
+    void queued(size_t messages, size_t bytes);
+
+    /// Record activity on the channel.
+    void activity();
+
+    /// The time elapsed since the last activity.
+    clock::duration idle() const;
+
+    /// The total bytes of completely received messages.
+    uint64_t received_bytes() const;
+
+    /// Copy the counters (authority and nonce are set by the caller).
+    snapshot copy() const;
+
+private:
+    typedef std::atomic<uint64_t> counter;
+    typedef std::array<counter, type_count> counters;
+
+    struct direction
+    {
+        counter bytes;
+        counter messages;
+        counters messages_by_type;
+        counters bytes_by_type;
+    };
+
+    static size_t to_index(message::message_type type);
+    static void record(direction& to, message::message_type type,
+        size_t bytes);
+    static traffic copy(const direction& from);
+
+    direction received_;
+    direction sent_;
+    counter ping_count_;
+    counter ping_last_;
+    counter ping_minimum_;
+    counter ping_total_;
+    counter ping_smoothed_;
+    counter queued_messages_;
+    counter queued_bytes_;
+    counter skipped_messages_;
+    counter skipped_bytes_;
+    std::atomic<clock::rep> last_activity_;
+    const clock::time_point created_;
+};
+
+} // namespace network
+} // namespace libbitcoin
+
+#endif
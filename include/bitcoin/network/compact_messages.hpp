@@ -0,0 +1,133 @@
+/**
+ * Copyright (c) 2011-2016 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NETWORK_COMPACT_MESSAGES_HPP
+#define LIBBITCOIN_NETWORK_COMPACT_MESSAGES_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/define.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+// Compact block relay messages (BIP152), not provided by the library.
+// These are registered with the message subscriber by command.
+
+/// The negotiation of compact block relay.
+class BCT_API send_compact
+{
+public:
+    typedef std::shared_ptr<send_compact> ptr;
+    static const std::string command;
+
+    send_compact();
+    send_compact(bool high_bandwidth, uint64_t version);
+
+    bool from_data(std::istream& stream);
+    data_chunk to_data() const;
+
+    /// The peer asks that new blocks be sent as compact blocks unannounced.
+    bool high_bandwidth;
+    uint64_t version;
+};
+
+/// A transaction sent in full within a compact block.
+struct BCT_API prefilled_transaction
+{
+    typedef std::vector<prefilled_transaction> list;
+
+    /// The absolute index of the transaction within the block.
+    uint64_t index;
+    message::transaction transaction;
+};
+
+/// A block sketch of its header and the short ids of its transactions.
+class BCT_API compact_block
+{
+public:
+    typedef std::shared_ptr<compact_block> ptr;
+    typedef std::pair<uint64_t, uint64_t> key;
+    static const std::string command;
+
+    /// The width of a short transaction id in bytes.
+    static constexpr size_t short_id_size = 6;
+
+    /// The siphash key of the short ids of a block and nonce.
+    static key to_key(const chain::header& header, uint64_t nonce);
+
+    /// The short id of the transaction hash under the key.
+    static uint64_t short_id(const key& key, const hash_digest& hash);
+
+    /// Create a sketch of the block, the coinbase is prefilled.
+    static compact_block factory_from_block(const message::block& block,
+        uint64_t nonce);
+
+    bool from_data(std::istream& stream);
+    data_chunk to_data() const;
+
+    /// The number of transactions in the block.
+    size_t transaction_count() const;
+
+    chain::header header;
+    uint64_t nonce;
+    std::vector<uint64_t> short_ids;
+    prefilled_transaction::list prefilled;
+};
+
+/// A request for the transactions of a block by index.
+class BCT_API get_block_transactions
+{
+public:
+    typedef std::shared_ptr<get_block_transactions> ptr;
+    static const std::string command;
+
+    bool from_data(std::istream& stream);
+    data_chunk to_data() const;
+
+    hash_digest block_hash;
+
+    /// The absolute, ascending indexes of the requested transactions.
+    std::vector<uint64_t> indexes;
+};
+
+/// The transactions of a block requested by index.
+class BCT_API block_transactions
+{
+public:
+    typedef std::shared_ptr<block_transactions> ptr;
+    static const std::string command;
+
+    bool from_data(std::istream& stream);
+    data_chunk to_data() const;
+
+    hash_digest block_hash;
+    message::transaction::list transactions;
+};
+
+} // namespace network
+} // namespace libbitcoin
+
+#endif
@@ -26,16 +26,22 @@
 #include <functional>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 #include <boost/thread.hpp>
 #include <bitcoin/bitcoin.hpp>
 #include <bitcoin/network/channel.hpp>
+#include <bitcoin/network/channel_metrics.hpp>
+#include <bitcoin/network/const_buffer.hpp>
 #include <bitcoin/network/define.hpp>
+#include <bitcoin/network/monitored_dispatcher.hpp>
 
 namespace libbitcoin {
 namespace network {
 
 /// Pool of active connections, thread and lock safe.
+/// Channels are sharded by authority, each shard with its own lock, and
+/// broadcasts read an immutable snapshot that is rebuilt only after change.
 class BCT_API connections
   : public enable_shared_from_base<connections>
 {
@@ -45,9 +51,12 @@ public:
     typedef std::function<void(size_t)> count_handler;
     typedef std::function<void(const code&)> result_handler;
     typedef std::function<void(const code&, channel::ptr)> channel_handler;
+    typedef std::function<void(channel::ptr)> channel_visitor;
+    typedef std::function<void(const channel_metrics::snapshot::list&)>
+        metrics_handler;
 
     /// Construct an instance.
-    connections();
+    connections(uint32_t magic);
 
     /// Validate connections stopped.
     ~connections();
@@ -57,14 +66,27 @@ public:
     void operator=(const connections&) = delete;
 
     /// Completion handler always returns success.
+    /// The message is serialized once and the buffer is shared by all sends.
     template <typename Message>
-    void broadcast(const Message& message, channel_handler handle_channel,
+    void broadcast(const Message& packet, channel_handler handle_channel,
         result_handler handle_complete)
     {
+        const auto channels = safe_copy();
+
+        if (channels->empty())
+        {
+            handle_complete(error::success);
+            return;
+        }
+
+        const auto& command = packet.command;
+        const auto buffer = const_buffer(message::serialize(packet, magic_));
+        bytes_saved_ += (channels->size() - 1) * buffer.size();
+
         // We cannot use a synchronizer here because handler closure in loop.
-        auto counter = std::make_shared<std::atomic<size_t>>(channels_.size());
+        auto counter = std::make_shared<std::atomic<size_t>>(channels->size());
 
-        for (const auto channel: safe_copy())
+        for (const auto channel: *channels)
         {
             const auto handle_send = [=](code ec)
             {
@@ -74,11 +96,26 @@ public:
                     handle_complete(error::success);
             };
 
-            channel->send(message, handle_send);
+            channel->send_buffer(command, buffer, handle_send);
         }
     }
 
+    /// Copy the traffic and latency counters of all channels.
+    virtual void metrics(metrics_handler handler) const;
+
+    /// Invoke the visitor for each channel, on the calling thread.
+    virtual void visit(channel_visitor visitor) const;
+
+    /// The serialization bytes avoided by sharing broadcast buffers.
+    virtual uint64_t broadcast_bytes_saved() const;
+
     virtual void stop(const code& ec);
+
+    /// Stop all channels, each shard of channels as one job of the dispatcher.
+    /// The handler is invoked once each channel has been stopped.
+    virtual void stop(const code& ec, monitored_dispatcher& dispatch,
+        result_handler handler);
+
     virtual void count(count_handler handler) const;
     virtual void store(channel::ptr channel, result_handler handler);
     virtual void remove(channel::ptr channel, result_handler handler);
@@ -87,16 +124,54 @@ public:
 
 private:
     typedef std::vector<channel::ptr> list;
+    typedef std::shared_ptr<const list> list_ptr;
+    typedef std::shared_ptr<std::atomic<size_t>> counter_ptr;
 
-    list safe_copy() const;
+    struct authority_hash
+    {
+        size_t operator()(const config::authority& authority) const;
+    };
+
+    typedef std::unordered_map<config::authority, channel::ptr,
+        authority_hash> map;
+
+    struct shard
+    {
+        map channels;
+        mutable upgrade_mutex mutex;
+    };
+
+    struct snapshot
+    {
+        uint64_t epoch;
+        list channels;
+    };
+
+    typedef std::shared_ptr<const snapshot> snapshot_ptr;
+
+    shard& to_shard(const config::authority& authority);
+    const shard& to_shard(const config::authority& authority) const;
+
+    list_ptr safe_copy() const;
+    bool safe_partition(std::vector<list>& out);
+    void stop_shard(const code& ec, std::shared_ptr<list> channels,
+        counter_ptr remaining, result_handler handler);
     size_t safe_count() const;
     code safe_store(channel::ptr channel);
     bool safe_remove(channel::ptr channel);
     bool safe_exists(const config::authority& address) const;
 
-    list channels_;
+    const uint32_t magic_;
+    std::atomic<uint64_t> bytes_saved_;
+
+    // Each shard is protected by its own mutex.
+    std::vector<shard> shards_;
+    std::atomic<size_t> count_;
+    std::atomic<uint64_t> epoch_;
     std::atomic<bool> stopped_;
-    mutable upgrade_mutex mutex_;
+
+    // This is accessed by atomic load and store.
+    mutable snapshot_ptr snapshot_;
 };
 
 } // namespace network
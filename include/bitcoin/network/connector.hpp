@@ -25,11 +25,20 @@
 #include <memory>
 #include <string>
 #include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/affinity_pool.hpp>
+#include <bitcoin/network/buffer_pool.hpp>
 #include <bitcoin/network/channel.hpp>
 #include <bitcoin/network/define.hpp>
+#include <bitcoin/network/dispatch_monitor.hpp>
+#include <bitcoin/network/lifecycle_metrics.hpp>
+#include <bitcoin/network/memory_accounts.hpp>
+#include <bitcoin/network/monitored_dispatcher.hpp>
 #include <bitcoin/network/pending_sockets.hpp>
+#include <bitcoin/network/resolver_cache.hpp>
 #include <bitcoin/network/settings.hpp>
 #include <bitcoin/network/socket.hpp>
+#include <bitcoin/network/timer_wheel.hpp>
+#include <bitcoin/network/token_bucket.hpp>
 
 namespace libbitcoin {
 namespace network {
@@ -41,9 +50,15 @@ class BCT_API connector
 public:
     typedef std::shared_ptr<connector> ptr;
     typedef std::function<void(const code& ec, channel::ptr)> connect_handler;
+    typedef std::function<void(const code& ec, const config::authority::list&)>
+        resolve_handler;
 
     /// Construct an instance.
-    connector(threadpool& pool, const settings& settings);
+    connector(threadpool& pool, const settings& settings,
+        buffer_pool::ptr buffers, affinity_pool::ptr affinity,
+        resolver_cache::ptr resolved, timer_wheel::ptr timers,
+        token_bucket::ptr uploads, memory_accounts::ptr memory,
+        dispatch_monitor::ptr dispatches);
 
     /// This class is not copyable.
     connector(const connector&) = delete;
@@ -61,32 +76,61 @@ public:
     virtual void connect(const std::string& hostname, uint16_t port,
         connect_handler handler);
 
+    /// Try to connect to the authority, as one attempt of a batch.
+    /// Clearing the batch cancels each of its attempts that is still pending.
+    virtual void connect(const config::authority& authority,
+        connect_handler handler, pending_sockets::ptr batch);
+
+    /// Resolve host:port to all of its addresses.
+    virtual void resolve(const std::string& hostname, uint16_t port,
+        resolve_handler handler);
+
     /// Cancel all outstanding connection attempts.
     void stop();
 
 private:
+    typedef std::shared_ptr<asio::resolver> resolver_ptr;
+    typedef std::function<void(const boost_code&, asio::iterator)>
+        lookup_handler;
+
     bool stopped();
     void close_socket(socket socket);
     std::shared_ptr<channel> new_channel(socket::ptr socket);
 
     void safe_stop();
-    void safe_resolve(asio::query_ptr query, connect_handler handler);
+    void lookup(const std::string& hostname, uint16_t port,
+        lookup_handler handler);
+    void start_resolve(const std::string& hostname, uint16_t port,
+        pending_sockets::ptr batch, connect_handler handler);
     void safe_connect(asio::iterator iterator, socket::ptr socket,
-        deadline::ptr timer, connect_handler handler);
+        deadline::ptr timer, pending_sockets::ptr batch,
+        lifecycle_metrics::timeline times, connect_handler handler);
 
+    void handle_lookup(const boost_code& ec, asio::iterator iterator,
+        resolver_ptr resolver, const std::string& hostname, uint16_t port,
+        lookup_handler handler);
     void handle_resolve(const boost_code& ec, asio::iterator iterator,
+        pending_sockets::ptr batch, lifecycle_metrics::timeline times,
         connect_handler handler);
+    void handle_resolve_all(const boost_code& ec, asio::iterator iterator,
+        resolve_handler handler);
     void handle_timer(const code& ec, socket::ptr socket,
         connect_handler handler);
     void handle_connect(const boost_code& ec, asio::iterator iterator,
-        socket::ptr socket, deadline::ptr timer, connect_handler handler);
+        socket::ptr socket, deadline::ptr timer, pending_sockets::ptr batch,
+        lifecycle_metrics::timeline times, connect_handler handler);
 
     std::atomic<bool> stopped_;
     threadpool& pool_;
     const settings& settings_;
+    buffer_pool::ptr buffers_;
+    affinity_pool::ptr affinity_;
     pending_sockets pending_;
-    dispatcher dispatch_;
-    std::shared_ptr<asio::resolver> resolver_;
+    monitored_dispatcher dispatch_;
+    resolver_cache::ptr resolved_;
+    timer_wheel::ptr timers_;
+    token_bucket::ptr uploads_;
+    memory_accounts::ptr memory_;
     mutable upgrade_mutex mutex_;
 };
 
@@ -41,12 +41,18 @@ public:
     explicit const_buffer(data_chunk&& data);
     explicit const_buffer(const data_chunk& data);
 
+    // A buffer over memory kept by the owner, such as a mapped file region.
+    const_buffer(std::shared_ptr<const void> owner, const uint8_t* data,
+        size_t size);
+
     size_t size() const;
     const_iterator begin() const;
     const_iterator end() const;
 
 private:
-    std::shared_ptr<data_chunk> data_;
+    explicit const_buffer(std::shared_ptr<data_chunk> data);
+
+    std::shared_ptr<const void> data_;
     value_type buffer_;
 };
 
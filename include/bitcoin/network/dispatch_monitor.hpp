@@ -0,0 +1,113 @@
+/**
+ * Copyright (c) 2011-2016 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NETWORK_DISPATCH_MONITOR_HPP
+#define LIBBITCOIN_NETWORK_DISPATCH_MONITOR_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/define.hpp>
+#include <bitcoin/network/latency_histogram.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+/// Job counts and latencies of the dispatchers by name, thread safe.
+/// Counters are shared by all dispatchers of a name and are lock free, the
+/// lock is taken only to register a name and to copy the names.
+class BCT_API dispatch_monitor
+{
+public:
+    typedef std::shared_ptr<dispatch_monitor> ptr;
+    typedef latency_histogram::clock clock;
+
+    /// The counters of one name, thread and lock safe.
+    class BCT_API counters
+    {
+    public:
+        typedef std::shared_ptr<counters> ptr;
+
+        /// Construct zeroed counters.
+        counters();
+
+        /// This class is not copyable.
+        counters(const counters&) = delete;
+        void operator=(const counters&) = delete;
+
+        /// Record a job queued to the threadpool, returns the time.
+        clock::time_point enqueue();
+
+        /// Record the start of a job queued at the time, returns the time.
+        clock::time_point start(const clock::time_point& enqueued);
+
+        /// Record the completion of a job started at the time.
+        void complete(const clock::time_point& started);
+
+    private:
+        friend class dispatch_monitor;
+
+        std::atomic<uint64_t> enqueued_;
+        std::atomic<uint64_t> started_;
+        std::atomic<uint64_t> completed_;
+        latency_histogram wait_;
+        latency_histogram execution_;
+    };
+
+    /// A copy of the counters of one name.
+    struct summary
+    {
+        std::string name;
+        uint64_t enqueued;
+        uint64_t queued;
+        uint64_t running;
+        uint64_t completed;
+        latency_histogram::summary wait;
+        latency_histogram::summary execution;
+    };
+
+    /// The summaries of all names, in name order.
+    typedef std::vector<summary> statistics;
+
+    /// Construct an instance with no names.
+    dispatch_monitor();
+
+    /// This class is not copyable.
+    dispatch_monitor(const dispatch_monitor&) = delete;
+    void operator=(const dispatch_monitor&) = delete;
+
+    /// The counters of the name, created upon first use.
+    virtual counters::ptr lookup(const std::string& name);
+
+    /// Copy the counters of all names.
+    virtual statistics snapshot() const;
+
+private:
+    std::map<std::string, counters::ptr> names_;
+    mutable shared_mutex mutex_;
+};
+
+} // namespace network
+} // namespace libbitcoin
+
+#endif
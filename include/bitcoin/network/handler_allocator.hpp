@@ -0,0 +1,105 @@
+/**
+ * Copyright (c) 2011-2016 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NETWORK_HANDLER_ALLOCATOR_HPP
+#define LIBBITCOIN_NETWORK_HANDLER_ALLOCATOR_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/define.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+/// A reusable block of handler memory for a sequence of operations, of which
+/// no more than one is outstanding at a time, thread safe. A request that
+/// does not fit the block, or that overlaps its use, is taken from the heap.
+class BCT_API handler_allocator
+{
+public:
+    /// The size of the reusable block.
+    static constexpr size_t capacity = 512;
+
+    /// Construct an instance with the block free.
+    handler_allocator();
+
+    /// This class is not copyable.
+    handler_allocator(const handler_allocator&) = delete;
+    void operator=(const handler_allocator&) = delete;
+
+    /// Allocate the block if it is free and fits, otherwise from the heap.
+    void* allocate(size_t size);
+
+    /// Free the block, or release a heap allocation.
+    void deallocate(void* block);
+
+private:
+    std::aligned_storage<capacity>::type storage_;
+    std::atomic<bool> in_use_;
+};
+
+/// A completion handler whose asio operation state is allocated from the
+/// referenced allocator, which must outlive the operation.
+template <typename Handler>
+class allocated_handler
+{
+public:
+    allocated_handler(handler_allocator& allocator, Handler handler)
+      : allocator_(allocator), handler_(std::move(handler))
+    {
+    }
+
+    template <typename... Args>
+    void operator()(Args&&... args)
+    {
+        handler_(std::forward<Args>(args)...);
+    }
+
+    friend void* asio_handler_allocate(size_t size, allocated_handler* self)
+    {
+        return self->allocator_.allocate(size);
+    }
+
+    friend void asio_handler_deallocate(void* block, size_t,
+        allocated_handler* self)
+    {
+        self->allocator_.deallocate(block);
+    }
+
+private:
+    handler_allocator& allocator_;
+    Handler handler_;
+};
+
+/// Wrap a completion handler for allocation of its operation by allocator.
+template <typename Handler>
+allocated_handler<typename std::decay<Handler>::type> make_allocated_handler(
+    handler_allocator& allocator, Handler&& handler)
+{
+    return allocated_handler<typename std::decay<Handler>::type>(allocator,
+        std::forward<Handler>(handler));
+}
+
+} // namespace network
+} // namespace libbitcoin
+
+#endif
@@ -20,16 +20,24 @@
 #ifndef LIBBITCOIN_NETWORK_HOSTS_HPP
 #define LIBBITCOIN_NETWORK_HOSTS_HPP
 
+#include <atomic>
+#include <chrono>
 #include <cstddef>
 #include <cstdint>
 #include <functional>
+#include <list>
 #include <memory>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
-#include <boost/circular_buffer.hpp>
 #include <boost/filesystem.hpp>
 #include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/const_buffer.hpp>
 #include <bitcoin/network/define.hpp>
+#include <bitcoin/network/dispatch_monitor.hpp>
+#include <bitcoin/network/hosts_file.hpp>
+#include <bitcoin/network/monitored_dispatcher.hpp>
 #include <bitcoin/network/settings.hpp>
 
 namespace libbitcoin {
@@ -37,9 +45,17 @@ namespace network {
 
 /// This class is thread safe.
 /// The hosts class manages a thread-safe dynamic store of network addresses.
-/// The store can be loaded and saved from/to the specified file path.
-/// The file is a line-oriented set of config::authority serializations.
+/// The store is loaded from and persisted to the configured file path.
+/// The file is a memory-mapped hosts_file, changed records are written in
+/// place as they change and flushed to disk periodically and on save.
+/// A line-oriented file of config::authority serializations is imported.
 /// Duplicate addresses and those with zero-valued ports are disacarded.
+/// Addresses are held in a "new" table until a connection to them succeeds,
+/// at which point they move to a smaller "tried" table. Connection outcomes
+/// are scored so that fetch favors addresses likely to connect quickly.
+/// Fetch selects from an immutable snapshot of the tables, published on
+/// structural change, so that it never waits on the tables lock. Scores are
+/// shared with the snapshot, so attempts and results do not republish it.
 class BCT_API hosts
   : public enable_shared_from_base<hosts>
 {
@@ -51,6 +67,10 @@ public:
     /// Construct an instance.
     hosts(threadpool& pool, const settings& settings);
 
+    /// Construct an instance, with its jobs counted in the monitor.
+    hosts(threadpool& pool, const settings& settings,
+        dispatch_monitor::ptr dispatches);
+
     /// This class is not copyable.
     hosts(const hosts&) = delete;
     void operator=(const hosts&) = delete;
@@ -58,28 +78,149 @@ public:
     virtual code load();
     virtual code save();
     virtual size_t count() const;
+
+    /// The estimated bytes of memory held by the tables and their index.
+    virtual size_t footprint() const;
     virtual code fetch(address& out);
     virtual code remove(const address& host);
     virtual code store(const address& host);
+
+    /// Store a batch on another thread under one lock, with one completion.
     virtual void store(const address::list& hosts, result_handler handler);
 
+    /// Record the start of a connection attempt to the address.
+    virtual code attempt(const address& host);
+
+    /// Record the result of the last connection attempt to the address.
+    virtual code score(const address& host, const code& result);
+
+    /// Get a serialized address message of randomly-selected good hosts.
+    /// The message is shared by all callers until its lifetime expires.
+    virtual code sample(const_buffer& out);
+
 private:
-    typedef boost::circular_buffer<address> list;
+    typedef std::chrono::steady_clock clock;
+
+    struct address_hash
+    {
+        size_t operator()(const address& host) const;
+    };
+
+    struct address_equal
+    {
+        bool operator()(const address& left, const address& right) const;
+    };
+
+    // The scores read by fetch, written under the mutex and read without it.
+    struct score_state
+    {
+        std::atomic<uint32_t> last_attempt;
+        std::atomic<uint32_t> failures;
+        std::atomic<uint32_t> latency_milliseconds;
+    };
+
+    typedef std::shared_ptr<score_state> score_ptr;
+
+    // The score state of one address, times are in seconds since epoch.
+    struct entry
+    {
+        entry(const address& host);
+        entry(const hosts_file::record& record, uint32_t slot);
+
+        hosts_file::record to_record(bool tried) const;
+        void share() const;
+
+        address host;
+        uint32_t last_success;
+        uint32_t last_attempt;
+        uint32_t failures;
+        uint32_t latency_milliseconds;
+        uint32_t slot;
+        clock::time_point started;
+
+        // This is shared by copies of the entry and by the snapshot.
+        score_ptr shared;
+    };
+
+    struct candidate
+    {
+        address host;
+        score_ptr shared;
+    };
+
+    // An immutable copy of the tables, from which fetch selects.
+    struct snapshot
+    {
+        std::vector<candidate> fresh;
+        std::vector<candidate> tried;
+    };
+
+    // The tables are bounded by capacity and ordered oldest first, their
+    // iterators are stable so that the index can locate each entry.
+    typedef std::list<entry> list;
     typedef list::iterator iterator;
 
-    iterator find(const address& host);
-    void do_store(const address& host, result_handler handler);
+    struct location
+    {
+        list* table;
+        iterator it;
+    };
+
+    typedef std::unordered_map<address, location, address_hash,
+        address_equal> index;
+    typedef std::unordered_set<address, address_hash, address_equal>
+        address_set;
+    typedef std::shared_ptr<const snapshot> snapshot_ptr;
+
+    static uint32_t now();
+    static double chance(const score_state& host, uint32_t now);
 
-    // The buffer is protected by a mutex.
-    list buffer_;
+    bool find(list*& table, iterator& it, const address& host);
+    bool safe_push(const address& host);
+    bool safe_push(const entry& host, bool tried);
+    void safe_push(list& table, const entry& host);
+    void safe_erase(list& table, iterator it);
+    void safe_release(const entry& host);
+    void safe_write(const entry& host, bool tried);
+    void safe_clear();
+    void safe_import(std::vector<entry>& out);
+    code safe_score(const address& host, const code& result);
+    void safe_publish();
+    void do_store(const address::list& hosts, result_handler handler);
+    void handle_timer(const code& ec);
+    message::address safe_sample() const;
+
+    const size_t new_capacity_;
+    const size_t tried_capacity_;
+
+    // The tables, their ip+port index and the file are protected by a mutex.
+    list new_;
+    list tried_;
+    index index_;
+    hosts_file file_;
+    std::vector<uint32_t> free_;
+    bool changed_;
     mutable upgrade_mutex mutex_;
 
+    // This is accessed by atomic load and store.
+    snapshot_ptr snapshot_;
+
+    // The serialized sample is protected by its own mutex.
+    const_buffer sample_;
+    clock::time_point sample_expiration_;
+    mutable shared_mutex sample_mutex_;
+
+    // This is thread safe.
+    deadline::ptr timer_;
+
     // This is thread safe.
-    dispatcher dispatch_;
+    monitored_dispatcher dispatch_;
 
     // HACK: we use this because the buffer capacity cannot be set to zero.
     const bool disabled_;
     const boost::filesystem::path file_path_;
+    const uint32_t magic_;
+    const clock::duration sample_lifetime_;
 };
 
 } // namespace network
@@ -0,0 +1,126 @@
+/**
+ * Copyright (c) 2011-2016 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NETWORK_HOSTS_FILE_HPP
+#define LIBBITCOIN_NETWORK_HOSTS_FILE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <boost/filesystem.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/define.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+/// This class is not thread safe.
+/// A memory-mapped file of fixed-size host records, one per slot.
+/// Records are read and written in place, so loading requires no parsing
+/// and a change writes only its own record. Records are in host byte order,
+/// a file from a host of another byte order is not recognized.
+class BCT_API hosts_file
+{
+public:
+    /// The table of a record, empty slots are unused.
+    enum class table : uint8_t
+    {
+        empty = 0,
+        fresh = 1,
+        tried = 2
+    };
+
+    /// The persisted state of one host.
+    struct record
+    {
+        uint8_t ip[16];
+        uint64_t services;
+        uint32_t timestamp;
+        uint32_t last_success;
+        uint32_t last_attempt;
+        uint32_t failures;
+        uint32_t latency_milliseconds;
+        uint16_t port;
+        table state;
+        uint8_t reserved;
+    };
+
+    /// Determine if the file at the path is a hosts file of this format.
+    static bool recognized(const boost::filesystem::path& path);
+
+    /// Construct an instance, the file is not opened.
+    hosts_file(const boost::filesystem::path& path);
+
+    /// Flushes and closes the file.
+    ~hosts_file();
+
+    /// This class is not copyable.
+    hosts_file(const hosts_file&) = delete;
+    void operator=(const hosts_file&) = delete;
+
+    /// Map an existing file, false if it is missing or not recognized.
+    bool open();
+
+    /// Create (or truncate) and map a file of empty slots.
+    bool create(size_t capacity);
+
+    /// Flush and unmap the file.
+    bool close();
+
+    /// Write changed records to disk, optionally without waiting.
+    bool flush(bool asynchronous);
+
+    /// True if the file is mapped.
+    bool is_open() const;
+
+    /// The number of slots in the mapped file.
+    size_t capacity() const;
+
+    /// Read the record of a slot, the slot must be less than capacity.
+    const record& read(size_t slot) const;
+
+    /// Overwrite the record of a slot, the slot must be less than capacity.
+    void write(size_t slot, const record& value);
+
+    /// Mark the slot as empty.
+    void clear(size_t slot);
+
+private:
+    struct header
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t capacity;
+        uint32_t reserved;
+    };
+
+    static bool read_header(const boost::filesystem::path& path,
+        header& out);
+
+    record* records() const;
+
+    size_t capacity_;
+    boost::interprocess::mapped_region region_;
+    const boost::filesystem::path path_;
+};
+
+} // namespace network
+} // namespace libbitcoin
+
+#endif
@@ -0,0 +1,76 @@
+/**
+ * Copyright (c) 2011-2016 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NETWORK_INVENTORY_RELAY_HPP
+#define LIBBITCOIN_NETWORK_INVENTORY_RELAY_HPP
+
+#include <atomic>
+#include <memory>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/channel.hpp>
+#include <bitcoin/network/connections.hpp>
+#include <bitcoin/network/define.hpp>
+#include <bitcoin/network/settings.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+/// Batched inventory announcement to all channels, thread safe.
+/// Announcements are queued on each channel that does not already know them
+/// and are flushed to all channels as inventory messages on a randomized
+/// trickle interval, so that many items share one message per peer.
+class BCT_API inventory_relay
+  : public enable_shared_from_base<inventory_relay>
+{
+public:
+    typedef std::shared_ptr<inventory_relay> ptr;
+
+    /// Construct an instance.
+    inventory_relay(threadpool& pool, connections::ptr connections,
+        const settings& settings);
+
+    /// This class is not copyable.
+    inventory_relay(const inventory_relay&) = delete;
+    void operator=(const inventory_relay&) = delete;
+
+    /// Start the trickle timer.
+    virtual void start();
+
+    /// Stop the trickle timer, queued items are not sent.
+    virtual void stop();
+
+    /// Queue the items for announcement to each channel.
+    virtual void announce(const message::inventory_vector::list& items);
+
+private:
+    void start_timer();
+    void handle_timer(const code& ec);
+    void flush(channel::ptr channel);
+    void handle_send(const code& ec, channel::ptr channel);
+
+    std::atomic<bool> stopped_;
+    connections::ptr connections_;
+    deadline::ptr timer_;
+    const asio::duration interval_;
+};
+
+} // namespace network
+} // namespace libbitcoin
+
+#endif
@@ -0,0 +1,95 @@
+/**
+ * Copyright (c) 2011-2016 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NETWORK_LATENCY_HISTOGRAM_HPP
+#define LIBBITCOIN_NETWORK_LATENCY_HISTOGRAM_HPP
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/define.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+/// A log-linear histogram of durations in microseconds, thread and lock safe.
+/// Each power of two is divided into eight buckets, so a percentile is within
+/// an eighth of its value. Counters are relaxed, a summary is not a cut.
+class BCT_API latency_histogram
+{
+public:
+    typedef std::chrono::steady_clock clock;
+
+    /// The number of buckets, covering the full range of microseconds.
+    static constexpr size_t bucket_count = 496;
+
+    /// The approximate distribution of the recorded durations.
+    struct summary
+    {
+        uint64_t count;
+        uint64_t total_microseconds;
+        uint64_t mean_microseconds;
+        uint64_t p50_microseconds;
+        uint64_t p99_microseconds;
+        uint64_t p999_microseconds;
+        uint64_t maximum_microseconds;
+    };
+
+    /// The bucket of a duration.
+    static size_t to_bucket(uint64_t microseconds);
+
+    /// The largest duration of a bucket.
+    static uint64_t to_upper(size_t bucket);
+
+    /// Construct an empty histogram.
+    latency_histogram();
+
+    /// This class is not copyable.
+    latency_histogram(const latency_histogram&) = delete;
+    void operator=(const latency_histogram&) = delete;
+
+    /// Record a duration, a negative duration is recorded as zero.
+    void record(const clock::duration& elapsed);
+    void record(uint64_t microseconds);
+
+    /// The number of recorded durations.
+    uint64_t count() const;
+
+    /// The upper bound of the bucket at the fraction (0..1) of the count.
+    uint64_t percentile(double fraction) const;
+
+    /// The percentiles, mean and maximum of the recorded durations.
+    summary summarize() const;
+
+private:
+    typedef std::atomic<uint64_t> counter;
+
+    std::array<counter, bucket_count> buckets_;
+    counter count_;
+    counter total_;
+    counter maximum_;
+};
+
+} // namespace network
+} // namespace libbitcoin
+
+#endif
@@ -0,0 +1,108 @@
+/**
+ * Copyright (c) 2011-2016 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NETWORK_LIFECYCLE_METRICS_HPP
+#define LIBBITCOIN_NETWORK_LIFECYCLE_METRICS_HPP
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/define.hpp>
+#include <bitcoin/network/latency_histogram.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+/// Latency histograms of each phase of channel startup by session type,
+/// thread and lock safe. Only channels that complete startup are recorded.
+class BCT_API lifecycle_metrics
+{
+public:
+    typedef std::shared_ptr<lifecycle_metrics> ptr;
+    typedef latency_histogram::clock clock;
+
+    /// The session that started the channel.
+    enum class origin
+    {
+        inbound,
+        outbound,
+        manual,
+        seed
+    };
+
+    /// The phase of startup, total is from resolve (or connected) to started.
+    enum class phase
+    {
+        resolve,
+        connect,
+        pend,
+        handshake,
+        store,
+        total
+    };
+
+    static constexpr size_t origin_count = 4;
+    static constexpr size_t phase_count = 6;
+
+    /// Monotonic times of the startup of a channel, default if not reached.
+    struct timeline
+    {
+        clock::time_point resolving;
+        clock::time_point connecting;
+        clock::time_point connected;
+        clock::time_point handshaking;
+        clock::time_point handshaken;
+        clock::time_point started;
+    };
+
+    /// The phase summaries of each session type, indexed by the enums.
+    typedef std::array<latency_histogram::summary, phase_count> phases;
+    typedef std::array<phases, origin_count> statistics;
+
+    /// Construct empty histograms.
+    lifecycle_metrics();
+
+    /// This class is not copyable.
+    lifecycle_metrics(const lifecycle_metrics&) = delete;
+    void operator=(const lifecycle_metrics&) = delete;
+
+    /// Record each phase of the timeline for which both times are set.
+    virtual void record(origin source, const timeline& times);
+
+    /// Summarize the histogram of a phase of a session type.
+    virtual latency_histogram::summary summarize(origin source,
+        phase step) const;
+
+    /// Summarize all histograms.
+    virtual statistics snapshot() const;
+
+private:
+    typedef std::array<latency_histogram, phase_count> histograms;
+
+    void record(origin source, phase step, const clock::time_point& begin,
+        const clock::time_point& end);
+
+    std::array<histograms, origin_count> histograms_;
+};
+
+} // namespace network
+} // namespace libbitcoin
+
+#endif
@@ -20,14 +20,49 @@
 #ifndef LIBBITCOIN_NETWORK_LOGGING_HPP
 #define LIBBITCOIN_NETWORK_LOGGING_HPP
 
+#include <cstdint>
 #include <fstream>
 #include <iostream>
 #include <bitcoin/bitcoin.hpp>
 #include <bitcoin/network/define.hpp>
+#include <bitcoin/network/settings.hpp>
+
+/// The compile-time minimum log level, from zero (debug) to four (fatal).
+/// Library log statements below this level are compiled out.
+#ifndef BCT_LOG_MINIMUM_LEVEL
+    #define BCT_LOG_MINIMUM_LEVEL 0
+#endif
+
+/// Conditionally log, the message is not formatted unless the level is
+/// enabled at compile time and at runtime (see network::set_log_level).
+#define BCT_LOG(severity, domain) \
+    (static_cast<int>(bc::log::level::severity) < BCT_LOG_MINIMUM_LEVEL || \
+        !bc::network::log_enabled(bc::log::level::severity)) ? (void)0 : \
+        bc::network::log_voidify() & bc::log::severity(domain)
+
+#define LOG_DEBUG(domain) BCT_LOG(debug, domain)
+#define LOG_INFO(domain) BCT_LOG(info, domain)
+#define LOG_WARNING(domain) BCT_LOG(warning, domain)
+#define LOG_ERROR(domain) BCT_LOG(error, domain)
+#define LOG_FATAL(domain) BCT_LOG(fatal, domain)
 
 namespace libbitcoin {
 namespace network {
 
+/// Lowers the precedence of a log statement below the conditional operator.
+struct BCT_API log_voidify
+{
+    void operator&(const log&) const
+    {
+    }
+};
+
+/// Set the runtime minimum log level, all levels are enabled by default.
+BCT_API void set_log_level(log::level level);
+
+/// Determine if the log level is enabled at runtime.
+BCT_API bool log_enabled(log::level level);
+
 /// Constant for logging file open mode (append output).
 BC_CONSTEXPR std::ofstream::openmode log_open_mode =
     std::ofstream::out | std::ofstream::app;
@@ -36,6 +71,23 @@ BC_CONSTEXPR std::ofstream::openmode log_open_mode =
 BCT_API void initialize_logging(std::ofstream& debug, std::ofstream& error,
     std::ostream& output_stream, std::ostream& error_stream);
 
+/// Set up global logging, asynchronous if settings.log_queue_capacity is
+/// nonzero. Asynchronous messages are queued on a bounded ring per level and
+/// written in batches by a dedicated thread, dropped if the ring is full.
+/// The output functions are replaced without synchronization, so this must
+/// not be called while other threads are logging.
+BCT_API void initialize_logging(std::ofstream& debug, std::ofstream& error,
+    std::ostream& output_stream, std::ostream& error_stream,
+    const settings& settings);
+
+/// Drain queued messages and stop the asynchronous writer, if started.
+/// The streams must remain in scope until this returns. This is safe while
+/// other threads are logging, and later messages are discarded.
+BCT_API void stop_logging();
+
+/// The number of messages dropped due to a full asynchronous log queue.
+BCT_API uint64_t dropped_log_messages();
+
 } // namespace network
 } // namespace libbitcoin
 
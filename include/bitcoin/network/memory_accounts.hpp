@@ -0,0 +1,95 @@
+/**
+ * Copyright (c) 2011-2016 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NETWORK_MEMORY_ACCOUNTS_HPP
+#define LIBBITCOIN_NETWORK_MEMORY_ACCOUNTS_HPP
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/define.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+/// Byte counts of network memory by category, thread safe.
+/// Counts are estimates of the memory held, not of the heap, and total use
+/// over the limit sheds load by refusing inbound connections and reads.
+class BCT_API memory_accounts
+{
+public:
+    typedef std::shared_ptr<memory_accounts> ptr;
+
+    enum class category
+    {
+        receive,
+        send,
+        hosts,
+        channels
+    };
+
+    struct usage
+    {
+        size_t receive;
+        size_t send;
+        size_t hosts;
+        size_t channels;
+        size_t total;
+        size_t limit;
+    };
+
+    /// Construct zeroed accounts, a zero limit is not enforced.
+    memory_accounts(size_t limit);
+
+    /// This class is not copyable.
+    memory_accounts(const memory_accounts&) = delete;
+    void operator=(const memory_accounts&) = delete;
+
+    /// Account for bytes allocated or released in the category.
+    virtual void add(category account, size_t bytes);
+    virtual void remove(category account, size_t bytes);
+
+    /// Replace the count of a category that is measured, not tracked.
+    virtual void set(category account, size_t bytes);
+
+    /// The bytes of the category.
+    virtual size_t bytes(category account) const;
+
+    /// The bytes of all categories.
+    virtual size_t total() const;
+
+    /// True if the total exceeds a non-zero limit.
+    virtual bool exhausted() const;
+
+    /// The bytes of each category, the total and the limit.
+    virtual usage snapshot() const;
+
+private:
+    static constexpr size_t category_count = 4;
+
+    const size_t limit_;
+    std::array<std::atomic<size_t>, category_count> counts_;
+};
+
+} // namespace network
+} // namespace libbitcoin
+
+#endif
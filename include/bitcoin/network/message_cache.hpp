@@ -0,0 +1,83 @@
+/**
+ * Copyright (c) 2011-2016 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NETWORK_MESSAGE_CACHE_HPP
+#define LIBBITCOIN_NETWORK_MESSAGE_CACHE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/const_buffer.hpp>
+#include <bitcoin/network/define.hpp>
+#include <bitcoin/network/settings.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+/// Serialized handshake and address messages that are constant for the
+/// life of the network, shared by all channels, thread safe.
+/// The version message is copied from a serialized template, with the peer
+/// address, nonce and height (and so the checksum) patched in place. Each
+/// field is located by serializing the template with that field changed.
+class BCT_API message_cache
+{
+public:
+    typedef std::shared_ptr<message_cache> ptr;
+
+    /// Construct an instance, serializing each message once.
+    message_cache(const settings& settings);
+
+    /// This class is not copyable.
+    message_cache(const message_cache&) = delete;
+    void operator=(const message_cache&) = delete;
+
+    /// The serialized verack message.
+    virtual const_buffer verack() const;
+
+    /// The serialized get_address message.
+    virtual const_buffer get_address() const;
+
+    /// The serialized address message of the configured self address.
+    virtual const_buffer self_address() const;
+
+    /// The serialized version message for a channel to the authority.
+    virtual const_buffer version(const config::authority& authority,
+        uint64_t nonce, size_t height) const;
+
+private:
+    static size_t to_offset(const data_chunk& left, const data_chunk& right);
+
+    const uint32_t magic_;
+    const const_buffer verack_;
+    const const_buffer get_address_;
+    const const_buffer self_address_;
+    const message::version template_;
+    const data_chunk version_;
+
+    // These are set on construction.
+    size_t address_offset_;
+    size_t nonce_offset_;
+    size_t height_offset_;
+};
+
+} // namespace network
+} // namespace libbitcoin
+
+#endif
@@ -0,0 +1,91 @@
+/**
+ * Copyright (c) 2011-2016 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NETWORK_MESSAGE_CHECKSUM_HPP
+#define LIBBITCOIN_NETWORK_MESSAGE_CHECKSUM_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/define.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+/// Streaming computation of the message checksum, not thread safe.
+/// The checksum is the first four bytes (little-endian) of the double-SHA256
+/// of the payload, equivalent to bitcoin_checksum, but bytes may be added
+/// as they arrive so that no second pass over the payload is required.
+/// The block transform is dispatched at runtime to the fastest kernel that
+/// the processor supports (SHA extensions where available).
+class BCT_API message_checksum
+{
+public:
+    /// The block transform implementations.
+    enum class kernel
+    {
+        generic,
+        sha_ni
+    };
+
+    /// True if the kernel is compiled in and supported by this processor.
+    static bool supported(kernel value);
+
+    /// The kernel currently used by all instances.
+    static kernel active_kernel();
+
+    /// Use the specified kernel for all instances, false if not supported.
+    /// This is intended for testing and benchmarking, not for concurrent use.
+    static bool select_kernel(kernel value);
+
+    /// Compute the checksum of a complete payload.
+    static uint32_t compute(const uint8_t* data, size_t size);
+    static uint32_t compute(const data_chunk& data);
+
+    /// Construct an empty instance.
+    message_checksum();
+
+    /// Clear all added bytes.
+    void reset();
+
+    /// Add payload bytes to the running hash.
+    void update(const uint8_t* data, size_t size);
+
+    /// Complete the hash and return the checksum, this resets the instance.
+    uint32_t finalize();
+
+private:
+    typedef std::array<uint32_t, 8> state;
+    typedef std::array<uint8_t, 64> block;
+
+    static void transform(state& state, const uint8_t* blocks, size_t count);
+    static void finalize(state& state, block& buffer, size_t buffered,
+        uint64_t length);
+
+    state state_;
+    block buffer_;
+    size_t buffered_;
+    uint64_t length_;
+};
+
+} // namespace network
+} // namespace libbitcoin
+
+#endif
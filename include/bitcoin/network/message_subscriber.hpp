@@ -20,64 +20,127 @@
 #ifndef LIBBITCOIN_NETWORK_MESSAGE_SUBSCRIBER_HPP
 #define LIBBITCOIN_NETWORK_MESSAGE_SUBSCRIBER_HPP
 
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <istream>
 #include <map>
 #include <memory>
 #include <utility>
 #include <string>
+#include <unordered_map>
+#include <vector>
 #include <bitcoin/bitcoin.hpp>
 #include <bitcoin/network/define.hpp>
 
 namespace libbitcoin {
 namespace network {
 
-#define DEFINE_SUBSCRIBER_TYPE(value) \
+// The message types and their commands, from which all per-type members,
+// overloads and the command dispatch are generated.
+#define MESSAGE_SUBSCRIBER_TYPES(MACRO) \
+    MACRO(address, "addr") \
+    MACRO(alert, "alert") \
+    MACRO(block, "block") \
+    MACRO(filter_add, "filteradd") \
+    MACRO(filter_clear, "filterclear") \
+    MACRO(filter_load, "filterload") \
+    MACRO(get_address, "getaddr") \
+    MACRO(get_blocks, "getblocks") \
+    MACRO(get_data, "getdata") \
+    MACRO(get_headers, "getheaders") \
+    MACRO(headers, "headers") \
+    MACRO(inventory, "inv") \
+    MACRO(memory_pool, "mempool") \
+    MACRO(merkle_block, "merkleblock") \
+    MACRO(not_found, "notfound") \
+    MACRO(ping, "ping") \
+    MACRO(pong, "pong") \
+    MACRO(reject, "reject") \
+    MACRO(transaction, "tx") \
+    MACRO(verack, "verack") \
+    MACRO(version, "version")
+
+#define DEFINE_SUBSCRIBER_TYPE(value, command) \
     typedef resubscriber<const code&, message::value::ptr> \
-        value##_subscriber_type
+        value##_subscriber_type;
 
-#define DEFINE_SUBSCRIBER_OVERLOAD(value) \
+#define DEFINE_SUBSCRIBER_OVERLOAD(value, command) \
     template <typename Handler> \
     void subscribe(message::value&&, Handler&& handler) \
     { \
-        value##_subscriber_->subscribe(std::forward<Handler>(handler), \
+        create(value##_subscriber_, #value "_sub")->subscribe( \
+            counted<message::value>(subscriptions_, \
+                static_cast<size_t>(message::message_type::value), \
+                std::forward<Handler>(handler)), \
             error::channel_stopped, nullptr); \
     }
 
-#define DECLARE_SUBSCRIBER(value) \
-    value##_subscriber_type::ptr value##_subscriber_
+#define DECLARE_SUBSCRIBER(value, command) \
+    value##_subscriber_type::ptr value##_subscriber_;
 
 /// Aggregation of subscribers by messasge type, thread safe.
+/// The subscriber of each type is created upon its first subscription, and
+/// messages of a type without a live subscription are not parsed.
+/// Message types that are not known to the library are registered by their
+/// command upon first subscription, and are always queued (not inline).
 class BCT_API message_subscriber
 {
 public:
-    DEFINE_SUBSCRIBER_TYPE(address);
-    DEFINE_SUBSCRIBER_TYPE(alert);
-    DEFINE_SUBSCRIBER_TYPE(block);
-    DEFINE_SUBSCRIBER_TYPE(filter_add);
-    DEFINE_SUBSCRIBER_TYPE(filter_clear);
-    DEFINE_SUBSCRIBER_TYPE(filter_load);
-    DEFINE_SUBSCRIBER_TYPE(get_address);
-    DEFINE_SUBSCRIBER_TYPE(get_blocks);
-    DEFINE_SUBSCRIBER_TYPE(get_data);
-    DEFINE_SUBSCRIBER_TYPE(get_headers);
-    DEFINE_SUBSCRIBER_TYPE(headers);
-    DEFINE_SUBSCRIBER_TYPE(inventory);
-    DEFINE_SUBSCRIBER_TYPE(memory_pool);
-    DEFINE_SUBSCRIBER_TYPE(merkle_block);
-    DEFINE_SUBSCRIBER_TYPE(not_found);
-    DEFINE_SUBSCRIBER_TYPE(ping);
-    DEFINE_SUBSCRIBER_TYPE(pong);
-    DEFINE_SUBSCRIBER_TYPE(reject);
-    DEFINE_SUBSCRIBER_TYPE(transaction);
-    DEFINE_SUBSCRIBER_TYPE(verack);
-    DEFINE_SUBSCRIBER_TYPE(version);
+    MESSAGE_SUBSCRIBER_TYPES(DEFINE_SUBSCRIBER_TYPE)
+
+    typedef std::vector<message::message_type> type_list;
+
+    /// Held by a queued notification and released once it has been handled.
+    typedef std::shared_ptr<void> ticket;
+
+    /// The notification of a parsed message, made when the caller invokes it.
+    typedef std::function<void()> delivery;
+
+    /// The messages of one type accumulated by a batch, in read order.
+    template <class Message>
+    using batch_ptr = std::shared_ptr<
+        const std::vector<typename Message::ptr>>;
+
+    /// The width of the command field of a message heading.
+    static constexpr size_t command_size = 12;
+    typedef std::array<uint8_t, command_size> command_field;
 
     /**
-     * Create an instance of this class.
+     * Obtain the message type of a raw heading command field.
+     * This is a switch over constant keys, with no string construction.
+     * @param[in]  field  The zero padded command field of the heading.
+     * @return            The message type, unknown if not matched.
+     */
+    static message::message_type to_type(const command_field& field);
+
+    /**
+     * Create an instance of this class, only blocks are delivered inline.
      * @param[in]  pool  The threadpool to use for sending notifications.
      */
     message_subscriber(threadpool& pool);
 
+    /**
+     * Create an instance of this class.
+     * @param[in]  pool         The threadpool to use for sending notifications.
+     * @param[in]  synchronous  The message types delivered inline, on the
+     *                          thread that loads the message, and not queued.
+     */
+    message_subscriber(threadpool& pool, const type_list& synchronous);
+
+    /**
+     * Create an instance of this class.
+     * @param[in]  pool         The threadpool to use for sending notifications.
+     * @param[in]  synchronous  The message types delivered inline, on the
+     *                          thread that loads the message, and not queued.
+     * @param[in]  strand       The strand on which other message types are
+     *                          queued, ordering their delivery.
+     */
+    message_subscriber(threadpool& pool, const type_list& synchronous,
+        asio::strand& strand);
+
     /// This class is not copyable.
     message_subscriber(const message_subscriber&) = delete;
     void operator=(const message_subscriber&) = delete;
@@ -86,6 +149,10 @@ public:
      * Subscribe to receive a notification when a message of type is received.
      * The handler is unregistered when the call is made.
      * Subscribing must be immediate, we cannot switch thread contexts.
+     * A type not known to the library must provide ptr, a static command and
+     * from_data(std::istream&). Its command must not be that of a known type
+     * or of another registered type, otherwise the handler is invoked with
+     * error::operation_failed.
      * @param[in]  handler  The handler to register.
      */
     template <class Message, typename Handler>
@@ -93,20 +160,113 @@ public:
     {
         subscribe(Message(), std::forward<Handler>(handler));
     }
+
+    /**
+     * Subscribe to receive the messages of a type loaded between flushes as
+     * one notification, in load order. Single subscriptions of the type also
+     * receive each message, which is parsed once. The batch is queued on the
+     * strand if provided, otherwise on the pool, upon flush. Only types known
+     * to the library may be batched, otherwise the handler is invoked with
+     * error::operation_failed.
+     * @param[in]  handler  The handler to register.
+     */
+    template <class Message, typename Handler>
+    void subscribe_batch(Handler&& handler)
+    {
+        const auto instance = create_batch<Message>();
+
+        if (!instance)
+        {
+            handler(error::operation_failed, nullptr);
+            return;
+        }
+
+        instance->subscribe(std::forward<Handler>(handler));
+    }
+
+    /**
+     * Determine if the message type has at least one live batch subscription.
+     * @param[in]  type  The message type.
+     * @return           True if a message of the type would be batched.
+     */
+    virtual bool batched(message::message_type type) const;
+
+    /**
+     * Count the live batch subscriptions of the message type.
+     * @param[in]  type  The message type.
+     * @return           The number of live batch subscriptions.
+     */
+    virtual size_t batch_subscriptions(message::message_type type) const;
+
+    /**
+     * Queue the notification of each nonempty batch, call from the sequence
+     * that loads messages, at the end of each read burst.
+     */
+    virtual void flush();
+
+    /**
+     * Abandon the messages of each batch, call from the sequence that loads
+     * messages, so that their tickets are released.
+     */
+    virtual void discard();
         
+    /**
+     * Determine if the message type has at least one live subscription.
+     * A subscription is live until its handler returns false.
+     * @param[in]  type  The message type.
+     * @return           True if a message of the type would be delivered.
+     */
+    virtual bool subscribed(message::message_type type) const;
+
+    /**
+     * Count the live subscriptions of the message type.
+     * @param[in]  type  The message type.
+     * @return           The number of live subscriptions.
+     */
+    virtual size_t subscriptions(message::message_type type) const;
+
+    /**
+     * Determine if a type not known to the library is registered by command.
+     * @param[in]  command  The zero padded command field of the heading.
+     * @return              True if the command has been subscribed.
+     */
+    virtual bool registered(const command_field& command) const;
+
+    /**
+     * Determine if a registered command has at least one live subscription.
+     * @param[in]  command  The zero padded command field of the heading.
+     * @return              True if a message of the command would be delivered.
+     */
+    virtual bool subscribed(const command_field& command) const;
+
     /**
      * Load a stream into a message instance and notify subscribers.
+     * Notification is queued on the strand if provided, otherwise on the pool.
      * @param[in]  stream      The stream from which to load the message.
      * @param[in]  subscriber  The subscriber for the message type.
+     * @param[in]  held        Released once the strand notification is
+     *                         handled, or immediately if there is no strand.
      * @return                 Returns error::bad_stream if failed.
      */
     template <class Message, class Subscriber>
-    code relay(std::istream& stream, Subscriber subscriber) const
+    code relay(std::istream& stream, Subscriber subscriber,
+        ticket held) const
     {
         const auto message_ptr = std::make_shared<Message>();
         const bool parsed = message_ptr->from_data(stream);
         const code ec(parsed ? error::success : error::bad_stream);
-        subscriber->relay(ec, message_ptr);
+
+        if (strand_ == nullptr)
+        {
+            subscriber->relay(ec, message_ptr);
+            return ec;
+        }
+
+        strand_->post([subscriber, ec, message_ptr, held]()
+        {
+            subscriber->do_relay(ec, message_ptr);
+        });
+
         return ec;
     }
 
@@ -134,14 +294,61 @@ public:
 
     /*
      * Load a stream of the specified command type.
-     * Creates an instance of the indicated message type.
-     * Sends the message instance to each subscriber of the type.
+     * Creates an instance of the indicated message type. The stream is not
+     * read if the type has no live subscription.
+     * Sends the message instance to each subscriber of the type, inline if
+     * the type is synchronous, otherwise queued on the threadpool.
      * @param[in]  type    The stream message type identifier.
      * @param[in]  stream  The stream from which to load the message.
      * @return             Returns error::bad_stream if failed.
      */
     virtual code load(message::message_type type, std::istream& stream) const;
 
+    /*
+     * Load a stream of the specified command type, holding the ticket until
+     * the notification is handled.
+     * @param[in]  type    The stream message type identifier.
+     * @param[in]  stream  The stream from which to load the message.
+     * @param[in]  held    The ticket held by a queued notification.
+     * @return             Returns error::bad_stream if failed.
+     */
+    virtual code load(message::message_type type, std::istream& stream,
+        ticket held) const;
+
+    /*
+     * Load a stream of a command registered by a type not known to the library.
+     * @param[in]  command  The zero padded command field of the heading.
+     * @param[in]  stream   The stream from which to load the message.
+     * @return              Returns error::not_found if not registered.
+     */
+    virtual code load(const command_field& command,
+        std::istream& stream) const;
+
+    /*
+     * Load a stream of a command registered by a type not known to the
+     * library, holding the ticket until the notification is handled.
+     * @param[in]  command  The zero padded command field of the heading.
+     * @param[in]  stream   The stream from which to load the message.
+     * @param[in]  held     The ticket held by a queued notification.
+     * @return              Returns error::not_found if not registered.
+     */
+    virtual code load(const command_field& command, std::istream& stream,
+        ticket held) const;
+
+    /*
+     * Load a stream of the specified command type without notifying, so that
+     * the parse may be made on any thread and its delivery ordered by the
+     * caller. The delivery notifies each subscriber of the type inline, and
+     * is empty if the type has no live subscription.
+     * @param[in]  type    The stream message type identifier.
+     * @param[in]  stream  The stream from which to load the message.
+     * @param[in]  held    The ticket held until the delivery is released.
+     * @param[out] out     The delivery of the parsed message.
+     * @return             Returns error::bad_stream if failed.
+     */
+    virtual code parse(message::message_type type, std::istream& stream,
+        ticket held, delivery& out) const;
+
     /**
      * Start all subscribers so that they accept subscription.
      */
@@ -153,49 +360,488 @@ public:
     virtual void stop();
 
 private:
-    DEFINE_SUBSCRIBER_OVERLOAD(address);
-    DEFINE_SUBSCRIBER_OVERLOAD(alert);
-    DEFINE_SUBSCRIBER_OVERLOAD(block);
-    DEFINE_SUBSCRIBER_OVERLOAD(filter_add);
-    DEFINE_SUBSCRIBER_OVERLOAD(filter_clear);
-    DEFINE_SUBSCRIBER_OVERLOAD(filter_load);
-    DEFINE_SUBSCRIBER_OVERLOAD(get_address);
-    DEFINE_SUBSCRIBER_OVERLOAD(get_blocks);
-    DEFINE_SUBSCRIBER_OVERLOAD(get_data);
-    DEFINE_SUBSCRIBER_OVERLOAD(get_headers);
-    DEFINE_SUBSCRIBER_OVERLOAD(headers);
-    DEFINE_SUBSCRIBER_OVERLOAD(inventory);
-    DEFINE_SUBSCRIBER_OVERLOAD(memory_pool);
-    DEFINE_SUBSCRIBER_OVERLOAD(merkle_block);
-    DEFINE_SUBSCRIBER_OVERLOAD(not_found);
-    DEFINE_SUBSCRIBER_OVERLOAD(ping);
-    DEFINE_SUBSCRIBER_OVERLOAD(pong);
-    DEFINE_SUBSCRIBER_OVERLOAD(reject);
-    DEFINE_SUBSCRIBER_OVERLOAD(transaction);
-    DEFINE_SUBSCRIBER_OVERLOAD(verack);
-    DEFINE_SUBSCRIBER_OVERLOAD(version);
-
-    DECLARE_SUBSCRIBER(address);
-    DECLARE_SUBSCRIBER(alert);
-    DECLARE_SUBSCRIBER(block);
-    DECLARE_SUBSCRIBER(filter_add);
-    DECLARE_SUBSCRIBER(filter_clear);
-    DECLARE_SUBSCRIBER(filter_load);
-    DECLARE_SUBSCRIBER(get_address);
-    DECLARE_SUBSCRIBER(get_blocks);
-    DECLARE_SUBSCRIBER(get_data);
-    DECLARE_SUBSCRIBER(get_headers);
-    DECLARE_SUBSCRIBER(headers);
-    DECLARE_SUBSCRIBER(inventory);
-    DECLARE_SUBSCRIBER(memory_pool);
-    DECLARE_SUBSCRIBER(merkle_block);
-    DECLARE_SUBSCRIBER(not_found);
-    DECLARE_SUBSCRIBER(ping);
-    DECLARE_SUBSCRIBER(pong);
-    DECLARE_SUBSCRIBER(reject);
-    DECLARE_SUBSCRIBER(transaction);
-    DECLARE_SUBSCRIBER(verack);
-    DECLARE_SUBSCRIBER(version);
+    message_subscriber(threadpool& pool, const type_list& synchronous,
+        asio::strand* strand);
+
+    typedef std::atomic<size_t> counter;
+    typedef std::shared_ptr<std::vector<counter>> counters_ptr;
+
+    // The subscriber of a message type that is not known to the library.
+    class custom
+    {
+    public:
+        typedef std::shared_ptr<custom> ptr;
+
+        custom(const command_field& field)
+          : command(field), counts(std::make_shared<std::vector<counter>>(1))
+        {
+            counts->front().store(0);
+        }
+
+        virtual ~custom()
+        {
+        }
+
+        virtual code load(const message_subscriber& owner,
+            std::istream& stream, ticket held) const = 0;
+        virtual void relay(const code& ec) = 0;
+        virtual void start() = 0;
+        virtual void stop() = 0;
+
+        const command_field command;
+        const counters_ptr counts;
+    };
+
+    template <class Message>
+    class custom_subscriber
+      : public custom
+    {
+    public:
+        typedef resubscriber<const code&, typename Message::ptr>
+            subscriber_type;
+
+        custom_subscriber(threadpool& pool, const command_field& field)
+          : custom(field),
+            subscriber(std::make_shared<subscriber_type>(pool,
+                Message::command + "_sub"))
+        {
+        }
+
+        code load(const message_subscriber& owner,
+            std::istream& stream, ticket held) const override
+        {
+            return owner.relay<Message>(stream, subscriber, held);
+        }
+
+        void relay(const code& ec) override
+        {
+            subscriber->relay(ec, nullptr);
+        }
+
+        void start() override
+        {
+            subscriber->start();
+        }
+
+        void stop() override
+        {
+            subscriber->stop();
+        }
+
+        const typename subscriber_type::ptr subscriber;
+    };
+
+    typedef std::unordered_map<uint64_t, custom::ptr> custom_map;
+
+    // The batch of a known message type, filled and flushed by the loader.
+    class batch
+    {
+    public:
+        typedef std::shared_ptr<batch> ptr;
+
+        batch()
+          : counts(std::make_shared<std::vector<counter>>(1))
+        {
+            counts->front().store(0);
+        }
+
+        virtual ~batch()
+        {
+        }
+
+        virtual void flush(asio::strand* strand) = 0;
+        virtual void discard() = 0;
+        virtual void relay(const code& ec) = 0;
+        virtual void start() = 0;
+        virtual void stop() = 0;
+
+        const counters_ptr counts;
+    };
+
+    template <class Message>
+    class batch_subscriber
+      : public batch
+    {
+    public:
+        typedef std::vector<typename Message::ptr> list;
+        typedef resubscriber<const code&, batch_ptr<Message>>
+            subscriber_type;
+
+        batch_subscriber(threadpool& pool)
+          : subscriber(std::make_shared<subscriber_type>(pool,
+                Message::command + "_batch_sub")),
+            pending_(std::make_shared<list>())
+        {
+        }
+
+        template <typename Handler>
+        void subscribe(Handler&& handler)
+        {
+            const auto notify = std::forward<Handler>(handler);
+            const auto live = counts;
+            ++live->front();
+
+            subscriber->subscribe(
+                [live, notify](const code& ec, batch_ptr<Message> messages)
+                {
+                    const auto resubscribe = notify(ec, messages);
+
+                    if (!resubscribe)
+                        --live->front();
+
+                    return resubscribe;
+                }, error::channel_stopped, nullptr);
+        }
+
+        void append(typename Message::ptr message, ticket held)
+        {
+            pending_->push_back(message);
+            held_.push_back(held);
+        }
+
+        void flush(asio::strand* strand) override
+        {
+            if (pending_->empty())
+                return;
+
+            const batch_ptr<Message> messages = pending_;
+            const auto held = std::make_shared<std::vector<ticket>>();
+            held->swap(held_);
+            pending_ = std::make_shared<list>();
+
+            if (strand == nullptr)
+            {
+                subscriber->relay(error::success, messages);
+                return;
+            }
+
+            const auto instance = subscriber;
+            strand->post([instance, messages, held]()
+            {
+                instance->do_relay(error::success, messages);
+            });
+        }
+
+        void discard() override
+        {
+            pending_ = std::make_shared<list>();
+            held_.clear();
+        }
+
+        void relay(const code& ec) override
+        {
+            subscriber->relay(ec, nullptr);
+        }
+
+        void start() override
+        {
+            subscriber->start();
+        }
+
+        void stop() override
+        {
+            subscriber->stop();
+        }
+
+        const typename subscriber_type::ptr subscriber;
+
+    private:
+        // These are accessed only by the loading sequence.
+        std::shared_ptr<list> pending_;
+        std::vector<ticket> held_;
+    };
+
+    typedef std::vector<batch::ptr> batch_list;
+
+    static command_field to_field(const std::string& command);
+    static uint64_t to_key(const command_field& command);
+
+    bool is_synchronous(message::message_type type) const;
+    custom::ptr find(const command_field& command) const;
+
+    // Message types not known to the library are registered by command.
+    template <class Message, typename Handler>
+    void subscribe(Message&&, Handler&& handler)
+    {
+        const auto instance = create<Message>();
+
+        if (!instance)
+        {
+            handler(error::operation_failed, nullptr);
+            return;
+        }
+
+        instance->subscriber->subscribe(
+            counted<Message>(instance->counts, 0,
+                std::forward<Handler>(handler)),
+            error::channel_stopped, nullptr);
+    }
+
+    // Obtain the registration of the type, creating it if not registered.
+    // Returns null if the command is that of a known or another type.
+    template <class Message>
+    std::shared_ptr<custom_subscriber<Message>> create()
+    {
+        const auto command = to_field(Message::command);
+
+        if (to_type(command) != message::message_type::unknown)
+            return nullptr;
+
+        const auto key = to_key(command);
+
+        // Critical Section
+        ///////////////////////////////////////////////////////////////////////
+        mutex_.lock_upgrade();
+
+        auto it = customs_.find(key);
+
+        if (it == customs_.end())
+        {
+            //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+            mutex_.unlock_upgrade_and_lock();
+
+            // The subscriber assumes the current state of the aggregation.
+            const auto instance = std::make_shared<
+                custom_subscriber<Message>>(pool_, command);
+
+            if (started_)
+                instance->start();
+
+            it = customs_.emplace(key, instance).first;
+
+            mutex_.unlock_and_lock_upgrade();
+            //-----------------------------------------------------------------
+        }
+
+        const auto instance = std::dynamic_pointer_cast<
+            custom_subscriber<Message>>(it->second);
+
+        mutex_.unlock_upgrade();
+        ///////////////////////////////////////////////////////////////////////
+
+        return instance && instance->command == command ? instance : nullptr;
+    }
+
+    // Obtain the batch of the type, creating it if never batched.
+    // Returns null if the command is not that of a known type.
+    template <class Message>
+    std::shared_ptr<batch_subscriber<Message>> create_batch()
+    {
+        const auto type = to_type(to_field(Message::command));
+
+        if (type == message::message_type::unknown)
+            return nullptr;
+
+        const auto index = static_cast<size_t>(type);
+
+        // Critical Section
+        ///////////////////////////////////////////////////////////////////////
+        mutex_.lock_upgrade();
+
+        if (!batches_[index])
+        {
+            //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+            mutex_.unlock_upgrade_and_lock();
+
+            // The subscriber assumes the current state of the aggregation.
+            batches_[index] = std::make_shared<batch_subscriber<Message>>(
+                pool_);
+
+            if (started_)
+                batches_[index]->start();
+
+            mutex_.unlock_and_lock_upgrade();
+            //-----------------------------------------------------------------
+        }
+
+        const auto instance = batches_[index];
+        mutex_.unlock_upgrade();
+        ///////////////////////////////////////////////////////////////////////
+
+        return std::static_pointer_cast<batch_subscriber<Message>>(instance);
+    }
+
+    // Obtain the batch of the type, null if it has no live subscription.
+    template <class Message>
+    std::shared_ptr<batch_subscriber<Message>> find_batch(
+        message::message_type type) const
+    {
+        // Critical Section
+        ///////////////////////////////////////////////////////////////////////
+        mutex_.lock_shared();
+        const auto instance = batches_[static_cast<size_t>(type)];
+        mutex_.unlock_shared();
+        ///////////////////////////////////////////////////////////////////////
+
+        return instance && instance->counts->front() > 0 ?
+            std::static_pointer_cast<batch_subscriber<Message>>(instance) :
+            nullptr;
+    }
+
+    // Wrap the handler so that the live subscription count of the type is
+    // decremented when the handler declines to resubscribe.
+    template <class Message, typename Handler>
+    std::function<bool(const code&, typename Message::ptr)> counted(
+        counters_ptr counts, size_t index, Handler&& handler)
+    {
+        const auto notify = std::forward<Handler>(handler);
+        ++(*counts)[index];
+
+        return [counts, index, notify](const code& ec,
+            typename Message::ptr message)
+        {
+            const auto resubscribe = notify(ec, message);
+
+            if (!resubscribe)
+                --(*counts)[index];
+
+            return resubscribe;
+        };
+    }
+
+    // Obtain the subscriber of the type, null if never subscribed.
+    template <class Subscriber>
+    Subscriber find(const Subscriber& subscriber) const
+    {
+        // Critical Section
+        ///////////////////////////////////////////////////////////////////////
+        mutex_.lock_shared();
+        const auto instance = subscriber;
+        mutex_.unlock_shared();
+        ///////////////////////////////////////////////////////////////////////
+
+        return instance;
+    }
+
+    // Obtain the subscriber of the type, creating it if never subscribed.
+    template <class Subscriber>
+    Subscriber create(Subscriber& subscriber, const std::string& name)
+    {
+        typedef typename Subscriber::element_type subscriber_type;
+
+        // Critical Section
+        ///////////////////////////////////////////////////////////////////////
+        mutex_.lock_upgrade();
+
+        if (!subscriber)
+        {
+            //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+            mutex_.unlock_upgrade_and_lock();
+
+            // The subscriber assumes the current state of the aggregation.
+            subscriber = std::make_shared<subscriber_type>(pool_, name);
+
+            if (started_)
+                subscriber->start();
+
+            mutex_.unlock_and_lock_upgrade();
+            //-----------------------------------------------------------------
+        }
+
+        const auto instance = subscriber;
+        mutex_.unlock_upgrade();
+        ///////////////////////////////////////////////////////////////////////
+
+        return instance;
+    }
+
+    // Parse and notify only if the type has been subscribed.
+    template <class Message, class Subscriber>
+    code deliver(message::message_type type, std::istream& stream,
+        const Subscriber& subscriber, ticket held) const
+    {
+        const auto instance = find(subscriber);
+        const auto batch = find_batch<Message>(type);
+
+        if (batch)
+            return collect<Message>(type, stream,
+                subscribed(type) ? instance : nullptr, batch, held);
+
+        if (!instance || !subscribed(type))
+            return error::success;
+
+        return is_synchronous(type) ? handle<Message>(stream, instance) :
+            relay<Message>(stream, instance, held);
+    }
+
+    // Parse once for the batch and any single subscription of the type.
+    template <class Message, class Subscriber>
+    code collect(message::message_type type, std::istream& stream,
+        const Subscriber& single,
+        std::shared_ptr<batch_subscriber<Message>> batch, ticket held) const
+    {
+        const auto message_ptr = std::make_shared<Message>();
+        const bool parsed = message_ptr->from_data(stream);
+        const code ec(parsed ? error::success : error::bad_stream);
+
+        if (parsed)
+            batch->append(message_ptr, held);
+
+        if (!single)
+            return ec;
+
+        if (is_synchronous(type))
+            single->do_relay(ec, message_ptr);
+        else if (strand_ == nullptr)
+            single->relay(ec, message_ptr);
+        else
+            strand_->post([single, ec, message_ptr, held]()
+            {
+                single->do_relay(ec, message_ptr);
+            });
+
+        return ec;
+    }
+
+    // Parse only if the type has been subscribed, and defer notification.
+    // A batched message is appended to its batch upon delivery.
+    template <class Message, class Subscriber>
+    code prepare(message::message_type type, std::istream& stream,
+        const Subscriber& subscriber, ticket held, delivery& out) const
+    {
+        out = nullptr;
+        const auto instance = find(subscriber);
+        const auto single = subscribed(type) ? instance : nullptr;
+        const auto batch = find_batch<Message>(type);
+
+        if (!single && !batch)
+            return error::success;
+
+        const auto message_ptr = std::make_shared<Message>();
+        const bool parsed = message_ptr->from_data(stream);
+        const code ec(parsed ? error::success : error::bad_stream);
+
+        out = [single, batch, ec, message_ptr, held]()
+        {
+            if (batch && !ec)
+                batch->append(message_ptr, held);
+
+            if (single)
+                single->do_relay(ec, message_ptr);
+        };
+
+        return ec;
+    }
+
+    MESSAGE_SUBSCRIBER_TYPES(DEFINE_SUBSCRIBER_OVERLOAD)
+
+    MESSAGE_SUBSCRIBER_TYPES(DECLARE_SUBSCRIBER)
+
+    threadpool& pool_;
+
+    // Indexed by message type, this is not modified after construction.
+    std::vector<bool> synchronous_;
+    asio::strand* strand_;
+
+    // Indexed by message type, shared with the counted handlers.
+    counters_ptr subscriptions_;
+
+    // The subscriber pointers, registrations, batches and started state are
+    // protected by mutex.
+    custom_map customs_;
+    batch_list batches_;
+    bool started_;
+    mutable upgrade_mutex mutex_;
 };
 
 #undef DEFINE_SUBSCRIBER_TYPE
@@ -0,0 +1,129 @@
+/**
+ * Copyright (c) 2011-2016 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NETWORK_METRICS_EXPORTER_HPP
+#define LIBBITCOIN_NETWORK_METRICS_EXPORTER_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/buffer_pool.hpp>
+#include <bitcoin/network/channel_metrics.hpp>
+#include <bitcoin/network/define.hpp>
+#include <bitcoin/network/dispatch_monitor.hpp>
+#include <bitcoin/network/lifecycle_metrics.hpp>
+#include <bitcoin/network/memory_accounts.hpp>
+#include <bitcoin/network/pending_sockets.hpp>
+#include <bitcoin/network/settings.hpp>
+#include <bitcoin/network/socket.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+class p2p;
+
+/// Serves network metrics in the Prometheus text format, thread safe.
+/// Metrics are collected and rendered on a timer and each scrape is served
+/// the last rendering, so a scrape never waits on a network lock. A scrape
+/// that is not answered within a timeout is closed.
+class BCT_API metrics_exporter
+  : public enable_shared_from_base<metrics_exporter>
+{
+public:
+    typedef std::shared_ptr<metrics_exporter> ptr;
+    typedef std::shared_ptr<const std::string> text_ptr;
+
+    /// The collected metrics, each copied without holding other locks.
+    struct snapshot
+    {
+        size_t connections;
+        size_t addresses;
+        uint64_t broadcast_bytes_saved;
+        channel_metrics::snapshot::list channels;
+        lifecycle_metrics::statistics lifecycle;
+        dispatch_monitor::statistics dispatches;
+        memory_accounts::usage memory;
+        buffer_pool::statistics buffers;
+    };
+
+    /// Render the snapshot in the Prometheus text exposition format.
+    static std::string render(const snapshot& metrics);
+
+    /// Construct an instance.
+    metrics_exporter(p2p& network, threadpool& pool, const settings& settings);
+
+    /// This class is not copyable.
+    metrics_exporter(const metrics_exporter&) = delete;
+    void operator=(const metrics_exporter&) = delete;
+
+    /// Listen on the metrics port and start collection, zero disables.
+    virtual code start();
+
+    /// Stop listening and collection, open scrapes are closed.
+    virtual void stop();
+
+    /// Collect and render the metrics now.
+    virtual void collect();
+
+    /// The last rendering, empty before the first collection.
+    virtual text_ptr text() const;
+
+private:
+    typedef std::shared_ptr<data_chunk> request_ptr;
+    typedef std::shared_ptr<std::string> response_ptr;
+
+    snapshot copy();
+
+    void start_timer();
+    void handle_timer(const code& ec);
+
+    void start_accept();
+    void handle_accept(const boost_code& ec, socket::ptr socket);
+    void handle_retry(const code& ec);
+    void handle_timeout(const code& ec, socket::ptr socket);
+    void start_request(socket::ptr socket, deadline::ptr timer);
+    void handle_request(const boost_code& ec, size_t size, socket::ptr socket,
+        deadline::ptr timer, request_ptr request);
+    void handle_response(const boost_code& ec, socket::ptr socket,
+        deadline::ptr timer, response_ptr response);
+    void close(socket::ptr socket, deadline::ptr timer);
+
+    std::atomic<bool> stopped_;
+    p2p& network_;
+    threadpool& pool_;
+    const settings& settings_;
+
+    // These are thread safe.
+    deadline::ptr timer_;
+    deadline::ptr retry_;
+    bc::atomic<text_ptr> text_;
+    pending_sockets scrapes_;
+
+    // This is protected by mutex.
+    asio::acceptor_ptr acceptor_;
+    mutable shared_mutex mutex_;
+};
+
+} // namespace network
+} // namespace libbitcoin
+
+#endif
@@ -0,0 +1,103 @@
+/**
+ * Copyright (c) 2011-2016 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NETWORK_MONITORED_DISPATCHER_HPP
+#define LIBBITCOIN_NETWORK_MONITORED_DISPATCHER_HPP
+
+#include <functional>
+#include <string>
+#include <utility>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/define.hpp>
+#include <bitcoin/network/dispatch_monitor.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+/// A dispatcher that counts its concurrent jobs and times their queue waits
+/// and executions under its name, thread safe.
+class BCT_API monitored_dispatcher
+{
+public:
+    /// A job timed from its dispatch.
+    template <typename Handler>
+    struct job
+    {
+        void operator()()
+        {
+            const auto started = counters->start(enqueued);
+            handler();
+            counters->complete(started);
+        }
+
+        Handler handler;
+        dispatch_monitor::counters::ptr counters;
+        dispatch_monitor::clock::time_point enqueued;
+    };
+
+    /// A handler that dispatches each invocation as a concurrent job.
+    template <typename Handler>
+    struct delegate
+    {
+        template <typename... Args>
+        void operator()(Args&&... args)
+        {
+            dispatcher->concurrent(handler, std::forward<Args>(args)...);
+        }
+
+        monitored_dispatcher* dispatcher;
+        Handler handler;
+    };
+
+    /// Construct an instance, counted under the name in the monitor.
+    monitored_dispatcher(threadpool& pool, const std::string& name,
+        dispatch_monitor::ptr monitor);
+
+    /// This class is not copyable.
+    monitored_dispatcher(const monitored_dispatcher&) = delete;
+    void operator=(const monitored_dispatcher&) = delete;
+
+    /// Post a job to the threadpool, the job is counted and timed.
+    template <typename... Args>
+    void concurrent(Args&&... args)
+    {
+        typedef decltype(std::bind(std::forward<Args>(args)...)) bound;
+        const auto enqueued = counters_->enqueue();
+        dispatch_.concurrent(job<bound>{
+            std::bind(std::forward<Args>(args)...), counters_, enqueued });
+    }
+
+    /// Bind a handler that posts each of its invocations as a job.
+    /// The delegate must not outlive this dispatcher.
+    template <typename... Args>
+    auto concurrent_delegate(Args&&... args) ->
+        delegate<decltype(std::bind(std::forward<Args>(args)...))>
+    {
+        return { this, std::bind(std::forward<Args>(args)...) };
+    }
+
+private:
+    dispatch_monitor::counters::ptr counters_;
+    dispatcher dispatch_;
+};
+
+} // namespace network
+} // namespace libbitcoin
+
+#endif
@@ -0,0 +1,41 @@
+/**
+ * Copyright (c) 2011-2016 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NETWORK_NETGROUP_HPP
+#define LIBBITCOIN_NETWORK_NETGROUP_HPP
+
+#include <array>
+#include <cstdint>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/define.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+/// The network group of an address, hosts of a group are likely to be under
+/// common control. A group is an IPv4 /16 or an IPv6 /32, tagged by family.
+typedef std::array<uint8_t, 5> netgroup;
+
+/// Get the network group of the address.
+BCT_API netgroup to_netgroup(const config::authority& authority);
+
+} // namespace network
+} // namespace libbitcoin
+
+#endif
@@ -0,0 +1,79 @@
+/**
+ * Copyright (c) 2011-2016 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NETWORK_OUTBOUND_RESERVATIONS_HPP
+#define LIBBITCOIN_NETWORK_OUTBOUND_RESERVATIONS_HPP
+
+#include <cstddef>
+#include <map>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/define.hpp>
+#include <bitcoin/network/netgroup.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+/// Coordination of outbound connection attempts, thread and lock safe.
+/// A host is reserved from its fetch until its attempt fails or its channel
+/// stops, and only one host of each network group may be reserved, so that
+/// concurrent slots neither duplicate attempts nor share a group. The number
+/// of attempts in flight over all slots is bounded.
+class BCT_API outbound_reservations
+{
+public:
+
+    /// Construct an instance, an attempt limit of zero is unbounded.
+    outbound_reservations(size_t attempt_limit);
+
+    /// This class is not copyable.
+    outbound_reservations(const outbound_reservations&) = delete;
+    void operator=(const outbound_reservations&) = delete;
+
+    /// Begin an attempt, false if the limit of attempts is in flight.
+    virtual bool begin_attempt();
+
+    /// End an attempt begun with begin_attempt.
+    virtual void end_attempt();
+
+    /// Reserve the host, false if the host or its group is reserved.
+    virtual bool reserve(const config::authority& host);
+
+    /// Release a reserved host and its group.
+    virtual void release(const config::authority& host);
+
+    /// The number of attempts in flight.
+    virtual size_t attempts() const;
+
+    /// The number of hosts reserved.
+    virtual size_t reserved() const;
+
+private:
+    const size_t attempt_limit_;
+
+    // These are protected by mutex.
+    // One host per group, so the group map also excludes duplicate hosts.
+    size_t attempts_;
+    std::map<netgroup, config::authority> hosts_;
+    mutable shared_mutex mutex_;
+};
+
+} // namespace network
+} // namespace libbitcoin
+
+#endif
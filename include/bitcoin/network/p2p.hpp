@@ -21,20 +21,39 @@
 #define LIBBITCOIN_NETWORK_P2P_HPP
 
 #include <atomic>
+#include <chrono>
 #include <cstddef>
 #include <cstdint>
 #include <functional>
+#include <future>
 #include <memory>
 #include <string>
 #include <vector>
 #include <boost/thread.hpp>
 #include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/admission.hpp>
+#include <bitcoin/network/affinity_pool.hpp>
+#include <bitcoin/network/anchors.hpp>
+#include <bitcoin/network/block_scheduler.hpp>
+#include <bitcoin/network/buffer_pool.hpp>
 #include <bitcoin/network/channel.hpp>
 #include <bitcoin/network/connections.hpp>
+#include <bitcoin/network/const_buffer.hpp>
 #include <bitcoin/network/define.hpp>
+#include <bitcoin/network/dispatch_monitor.hpp>
 #include <bitcoin/network/hosts.hpp>
+#include <bitcoin/network/inventory_relay.hpp>
+#include <bitcoin/network/lifecycle_metrics.hpp>
+#include <bitcoin/network/memory_accounts.hpp>
+#include <bitcoin/network/message_cache.hpp>
+#include <bitcoin/network/metrics_exporter.hpp>
+#include <bitcoin/network/monitored_dispatcher.hpp>
+#include <bitcoin/network/resolver_cache.hpp>
 #include <bitcoin/network/sessions/session_manual.hpp>
 #include <bitcoin/network/settings.hpp>
+#include <bitcoin/network/timer_wheel.hpp>
+#include <bitcoin/network/token_bucket.hpp>
+#include <bitcoin/network/traffic_capture.hpp>
 
 namespace libbitcoin {
 namespace network {
@@ -51,10 +70,22 @@ public:
     typedef std::function<void(size_t)> count_handler;
     typedef std::function<void(const code&)> result_handler;
     typedef std::function<void(const code&, const address&)> address_handler;
+    typedef std::function<void(const code&, const_buffer)> buffer_handler;
     typedef std::function<void(const code&, channel::ptr)> channel_handler;
     typedef std::function<bool(const code&, channel::ptr)> connect_handler;
+    typedef connections::metrics_handler metrics_handler;
     typedef subscriber<const code&> stop_subscriber;
     typedef resubscriber<const code&, channel::ptr> channel_subscriber;
+    typedef std::function<void(const code&, message::block::ptr)>
+        block_handler;
+    typedef std::function<bool(const code&, message::block::ptr)>
+        relay_handler;
+    typedef std::function<void(message::transaction::ptr)>
+        transaction_visitor;
+    typedef std::function<void(transaction_visitor)> transaction_source;
+    typedef resubscriber<const code&, message::block::ptr> block_subscriber;
+    typedef std::function<bool(const code&)> work_handler;
+    typedef resubscriber<const code&> work_subscriber;
 
     // ------------------------------------------------------------------------
 
@@ -78,6 +109,56 @@ public:
         connections_->broadcast(message, handle_channel, handle_complete);
     }
 
+    /// Queue inventory for batched announcement to each channel that does
+    /// not already know it, sent on the next trickle of the relay timer.
+    virtual void announce(const message::inventory_vector::list& items);
+
+    /// Send a block as a compact block to each channel whose peer asked for
+    /// high bandwidth compact relay.
+    virtual void relay_block(message::block::ptr block);
+
+    /// Subscribe to blocks sent by relay_block.
+    virtual void subscribe_block(relay_handler handler);
+
+    // ------------------------------------------------------------------------
+
+    /// Enable compact block reception. The source must synchronously visit
+    /// each candidate transaction (e.g. the memory pool) from which compact
+    /// blocks are reconstructed, and the handler receives each block.
+    virtual void set_compact_relay(transaction_source source,
+        block_handler handler);
+
+    /// Determine if compact block reception has been enabled.
+    virtual bool compact_relay() const;
+
+    /// Visit each candidate transaction for compact block reconstruction.
+    virtual void visit_candidates(transaction_visitor visitor);
+
+    /// Deliver a reconstructed compact block to the handler.
+    virtual void notify_block(message::block::ptr block);
+
+    /// Claim one of the three high bandwidth compact relay slots of BIP152.
+    /// Returns false if all are claimed, otherwise the claim must be released.
+    virtual bool claim_compact_announcer();
+
+    /// Release a claimed high bandwidth compact relay slot.
+    virtual void release_compact_announcer();
+
+    // ------------------------------------------------------------------------
+
+    /// Begin headers-first download of the blocks that follow the locator.
+    /// Each block is passed to the handler in order of arrival, not height.
+    virtual void synchronize(const hash_list& locator, block_handler handler);
+
+    /// Subscribe to block download work becoming available.
+    virtual void subscribe_download(work_handler handler);
+
+    /// Notify channels that block download work has become available.
+    virtual void notify_download_work();
+
+    /// Deliver a downloaded block to the synchronize handler.
+    virtual void notify_download(message::block::ptr block);
+
     // ------------------------------------------------------------------------
 
     /// Return a reference to the network configuration settings.
@@ -95,6 +176,60 @@ public:
     /// Return a reference to the network threadpool.
     virtual threadpool& thread_pool();
 
+    /// Return the threadpools to which new channels are assigned.
+    virtual affinity_pool::ptr channel_pools();
+
+    /// Return the shared pool of channel payload buffers.
+    virtual buffer_pool::ptr payload_buffers();
+
+    /// Return the host name resolutions shared by all connectors.
+    virtual resolver_cache::ptr resolved_names();
+
+    /// Return the coarse timers shared by all channels.
+    virtual timer_wheel::ptr channel_timers();
+
+    /// Return the upload rate limit shared by all channels.
+    virtual token_bucket::ptr upload_budget();
+
+    /// Return the memory accounts shared by all channels.
+    virtual memory_accounts::ptr memory_budget();
+
+    /// The bytes of network memory by category, with the hosts measured now.
+    virtual memory_accounts::usage memory_usage();
+
+    /// Return the channel startup timing shared by all sessions.
+    virtual lifecycle_metrics::ptr lifecycle_timing();
+
+    /// Get the latency percentiles of each startup phase by session type.
+    virtual lifecycle_metrics::statistics lifecycle_statistics() const;
+
+    /// Return the job counters shared by the dispatchers of all components.
+    virtual dispatch_monitor::ptr dispatch_metrics();
+
+    /// Get the job counts and latencies of each dispatcher name.
+    virtual dispatch_monitor::statistics dispatch_statistics() const;
+
+    /// Return the serialized handshake messages shared by all channels.
+    virtual message_cache::ptr cached_messages();
+
+    /// Return the capture of received messages shared by all channels.
+    virtual traffic_capture::ptr captured_traffic();
+
+    /// Take the outbound peers persisted by the last stop, once per start.
+    virtual config::authority::list take_anchors();
+
+    /// Return the admission control shared by all acceptors.
+    virtual admission::ptr inbound_admission();
+
+    /// Return the block download work allocation shared by all channels.
+    virtual block_scheduler::ptr block_download();
+
+    /// Get a snapshot of the payload buffer pool usage counters.
+    virtual buffer_pool::statistics payload_buffer_statistics() const;
+
+    /// Get the serialization bytes avoided by sharing broadcast buffers.
+    virtual uint64_t broadcast_bytes_saved() const;
+
     // ------------------------------------------------------------------------
 
     /// Invoke startup and seeding sequence, call from constructing thread.
@@ -119,6 +254,9 @@ public:
 
     /// Non-blocking call to coalesce all work, start may be reinvoked after
     /// handler fired. Handler returns the result of host file save operation.
+    /// Channels are stopped and hosts saved in parallel on the threadpool. If
+    /// this does not complete within the shutdown timeout the handler returns
+    /// channel_timeout, though the work that remains continues.
     virtual void stop(result_handler handler);
 
     /// Blocking call to coalesce all work and then terminate all threads.
@@ -140,11 +278,17 @@ public:
     /// Get the number of connections.
     virtual void connected_count(count_handler handler);
 
+    /// Copy the traffic and latency counters of all connections.
+    virtual void connected_metrics(metrics_handler handler);
+
     // ------------------------------------------------------------------------
 
     /// Get a randomly-selected adress.
     virtual void fetch_address(address_handler handler);
 
+    /// Get a shared, serialized address message sampled from the pool.
+    virtual void fetch_addresses(buffer_handler handler);
+
     /// Store an address.
     virtual void store(const address& address, result_handler handler);
 
@@ -154,6 +298,13 @@ public:
     /// Remove an address.
     virtual void remove(const address& address, result_handler handler);
 
+    /// Record the start of a connection attempt to the address.
+    virtual void attempt(const address& address, result_handler handler);
+
+    /// Record the result of a connection attempt to the address.
+    virtual void score(const address& address, const code& result,
+        result_handler handler);
+
     /// Get the number of addresses.
     virtual void address_count(count_handler handler);
 
@@ -167,7 +318,30 @@ protected:
     }
 
 private:
-    void handle_stopped(const code& ec);
+    typedef std::chrono::steady_clock clock;
+
+    // The shared state of one parallel stop sequence.
+    struct stopping
+    {
+        std::atomic<size_t> remaining;
+        std::atomic<bool> completed;
+        code result;
+        size_t channels;
+        config::authority::list anchors;
+        clock::time_point started;
+        deadline::ptr timer;
+        result_handler handler;
+    };
+
+    typedef std::shared_ptr<stopping> stopping_ptr;
+
+    void load_anchors();
+    config::authority::list select_anchors() const;
+    void do_save_hosts(stopping_ptr state);
+    void handle_stop_part(const code& ec, stopping_ptr state);
+    void handle_stop_timeout(const code& ec, stopping_ptr state);
+    void complete_stop(const code& ec, stopping_ptr state);
+    void handle_stopped(const code& ec, std::promise<code>& promise);
     void handle_manual_started(const code& ec, result_handler handler);
     void handle_inbound_started(const code& ec, result_handler handler);
     void handle_outbound_started(const code& ec, result_handler handler);
@@ -180,14 +354,37 @@ private:
     std::atomic<bool> stopped_;
     std::atomic<size_t> height_;
     bc::atomic<session_manual::ptr> manual_;
+    bc::atomic<config::authority::list> anchored_;
     const settings& settings_;
+    const anchors anchors_;
 
     // These are thread safe.
     threadpool threadpool_;
+    dispatch_monitor::ptr dispatches_;
+    monitored_dispatcher dispatch_;
+    affinity_pool::ptr channel_pools_;
+    buffer_pool::ptr buffers_;
+    resolver_cache::ptr resolved_;
+    timer_wheel::ptr timers_;
+    token_bucket::ptr uploads_;
+    memory_accounts::ptr memory_;
+    lifecycle_metrics::ptr lifecycle_;
+    metrics_exporter::ptr exporter_;
+    message_cache::ptr messages_;
+    traffic_capture::ptr capture_;
     hosts::ptr hosts_;
     connections::ptr connections_;
+    admission::ptr admission_;
+    inventory_relay::ptr relay_;
     stop_subscriber::ptr stop_subscriber_;
     channel_subscriber::ptr channel_subscriber_;
+    block_subscriber::ptr block_subscriber_;
+    bc::atomic<transaction_source> compact_source_;
+    bc::atomic<block_handler> compact_handler_;
+    std::atomic<size_t> compact_announcers_;
+    block_scheduler::ptr scheduler_;
+    work_subscriber::ptr work_subscriber_;
+    bc::atomic<block_handler> download_handler_;
 };
 
 } // namespace network
@@ -0,0 +1,65 @@
+/**
+ * Copyright (c) 2011-2016 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NETWORK_PAYLOAD_STREAMBUF_HPP
+#define LIBBITCOIN_NETWORK_PAYLOAD_STREAMBUF_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <ios>
+#include <streambuf>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/define.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+/// A read-only stream buffer over a contiguous payload, not thread safe.
+/// Reads are served directly from the caller's memory, without the copy into
+/// an intermediate buffer that a boost::iostreams source device requires.
+/// The caller must keep the memory in scope for the life of this instance.
+class BCT_API payload_streambuf
+  : public std::streambuf
+{
+public:
+    /// Construct an instance over the specified bytes.
+    payload_streambuf(const uint8_t* data, size_t size);
+
+    /// Construct an instance over the specified chunk.
+    explicit payload_streambuf(const data_chunk& data);
+
+    /// This class is not copyable.
+    payload_streambuf(const payload_streambuf&) = delete;
+    void operator=(const payload_streambuf&) = delete;
+
+    /// The number of bytes not yet read.
+    size_t remaining() const;
+
+protected:
+    std::streamsize showmanyc() override;
+    pos_type seekoff(off_type offset, std::ios_base::seekdir direction,
+        std::ios_base::openmode mode=std::ios_base::in) override;
+    pos_type seekpos(pos_type position,
+        std::ios_base::openmode mode=std::ios_base::in) override;
+};
+
+} // namespace network
+} // namespace libbitcoin
+
+#endif
@@ -20,9 +20,10 @@
 #ifndef LIBBITCOIN_NETWORK_PENDING_CHANNELS_HPP
 #define LIBBITCOIN_NETWORK_PENDING_CHANNELS_HPP
 
+#include <cstddef>
 #include <cstdint>
 #include <functional>
-#include <vector>
+#include <unordered_map>
 #include <boost/thread.hpp>
 #include <bitcoin/bitcoin.hpp>
 #include <bitcoin/network/channel.hpp>
@@ -36,6 +37,7 @@ class BCT_API pending_channels
 {
 public:
     typedef std::function<void(bool)> truth_handler;
+    typedef std::function<void(size_t)> count_handler;
     typedef std::function<void(const code&)> result_handler;
     
     pending_channels();
@@ -48,15 +50,20 @@ public:
     virtual void store(channel::ptr channel, result_handler handler);
     virtual void remove(channel::ptr channel, result_handler handler);
     virtual void exists(uint64_t version_nonce, truth_handler handler) const;
+    virtual void count(count_handler handler) const;
 
 private:
-    typedef std::vector<channel::ptr> list;
+    typedef std::unordered_map<uint64_t, channel::ptr> nonce_map;
+    typedef std::unordered_map<channel::ptr, uint64_t> channel_map;
 
     bool safe_store(channel::ptr channel);
     bool safe_remove(channel::ptr channel);
     bool safe_exists(uint64_t version_nonce) const;
+    size_t safe_count() const;
 
-    list channels_;
+    // The channel map retains the stored nonce in case the channel changes.
+    nonce_map nonces_;
+    channel_map channels_;
     mutable upgrade_mutex mutex_;
 };
 
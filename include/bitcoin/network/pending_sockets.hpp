@@ -20,6 +20,7 @@
 #ifndef LIBBITCOIN_NETWORK_PENDING_SOCKETS_HPP
 #define LIBBITCOIN_NETWORK_PENDING_SOCKETS_HPP
 
+#include <memory>
 #include <vector>
 #include <bitcoin/bitcoin.hpp>
 #include <bitcoin/network/define.hpp>
@@ -32,6 +33,8 @@ namespace network {
 class BCT_API pending_sockets
 {
 public:    
+    typedef std::shared_ptr<pending_sockets> ptr;
+
     pending_sockets();
     ~pending_sockets();
 
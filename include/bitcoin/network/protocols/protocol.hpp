@@ -26,6 +26,8 @@
 #include <utility>
 #include <bitcoin/bitcoin.hpp>
 #include <bitcoin/network/channel.hpp>
+#include <bitcoin/network/channel_metrics.hpp>
+#include <bitcoin/network/const_buffer.hpp>
 #include <bitcoin/network/define.hpp>
 
 namespace libbitcoin {
@@ -80,6 +82,23 @@ protected:
             BOUND_PROTOCOL(handler, args));
     }
 
+    /// Send a serialized message on the channel and handle the result.
+    template <class Protocol, typename Handler, typename... Args>
+    void send_buffer(const std::string& command, const_buffer buffer,
+        Handler&& handler, Args&&... args)
+    {
+        channel_->send_buffer(command, buffer, BOUND_PROTOCOL(handler, args));
+    }
+
+    /// Send a serialized payload on the channel and handle the result.
+    template <class Protocol, typename Handler, typename... Args>
+    void send_payload(const std::string& command, const_buffer payload,
+        Handler&& handler, Args&&... args)
+    {
+        channel_->send_payload(command, payload,
+            BOUND_PROTOCOL(handler, args));
+    }
+
     /// Subscribe to all channel messages, blocking until subscribed.
     template <class Protocol, class Message, typename Handler, typename... Args>
     void subscribe(Handler&& handler, Args&&... args)
@@ -87,6 +106,14 @@ protected:
         channel_->template subscribe<Message>(BOUND_PROTOCOL(handler, args));
     }
 
+    /// Subscribe to batches of channel messages, blocking until subscribed.
+    template <class Protocol, class Message, typename Handler, typename... Args>
+    void subscribe_batch(Handler&& handler, Args&&... args)
+    {
+        channel_->template subscribe_batch<Message>(
+            BOUND_PROTOCOL(handler, args));
+    }
+
     /// Subscribe to the channel stop, blocking until subscribed.
     template <class Protocol, typename Handler, typename... Args>
     void subscribe_stop(Handler&& handler, Args&&... args)
@@ -94,6 +121,13 @@ protected:
         channel_->subscribe_stop(BOUND_PROTOCOL(handler, args));
     }
 
+    /// Subscribe to channel send backlog changes, blocking until subscribed.
+    template <class Protocol, typename Handler, typename... Args>
+    void subscribe_pressure(Handler&& handler, Args&&... args)
+    {
+        channel_->subscribe_pressure(BOUND_PROTOCOL(handler, args));
+    }
+
     /// Get the address of the channel.
     virtual config::authority authority() const;
 
@@ -103,9 +137,15 @@ protected:
     /// Get the channel nonce.
     virtual uint64_t nonce();
 
+    /// Get the channel identifier.
+    virtual uint64_t identifier();
+
     /// Get the threadpool.
     virtual threadpool& pool();
 
+    /// Get the channel traffic and latency counters.
+    virtual channel_metrics& metrics();
+
     /// Set the channel version. This method is NOT thread safe and must
     /// complete before any other thread could read the peer version.
     void set_peer_version(const message::version& value);
@@ -114,6 +154,12 @@ protected:
     /// not be called if any other thread could write the peer version.
     virtual const message::version& peer_version();
 
+    /// Set the number of requests awaiting a response, for stall detection.
+    virtual void set_outstanding(size_t requests);
+
+    /// Hold channel writes, which are resumed when the channel is started.
+    virtual void hold_writes();
+
     /// Stop the channel (and the protocol).
     virtual void stop(const code& ec);
 
@@ -139,14 +185,23 @@ private:
     send<CLASS>(message, &CLASS::method, p1)
 #define SEND2(message, method, p1, p2) \
     send<CLASS>(message, &CLASS::method, p1, p2)
+#define SEND_BUFFER1(command, buffer, method, p1) \
+    send_buffer<CLASS>(command, buffer, &CLASS::method, p1)
 
 #define SUBSCRIBE2(message, method, p1, p2) \
     subscribe<CLASS, message>(&CLASS::method, p1, p2)
 #define SUBSCRIBE3(message, method, p1, p2, p3) \
     subscribe<CLASS, message>(&CLASS::method, p1, p2, p3)
+#define SUBSCRIBE4(message, method, p1, p2, p3, p4) \
+    subscribe<CLASS, message>(&CLASS::method, p1, p2, p3, p4)
+
+#define SUBSCRIBE_BATCH2(message, method, p1, p2) \
+    subscribe_batch<CLASS, message>(&CLASS::method, p1, p2)
 
 #define SUBSCRIBE_STOP1(method, p1) \
     subscribe_stop<CLASS>(&CLASS::method, p1)
+#define SUBSCRIBE_PRESSURE2(method, p1, p2) \
+    subscribe_pressure<CLASS>(&CLASS::method, p1, p2)
 
 } // namespace network
 } // namespace libbitcoin
@@ -20,9 +20,11 @@
 #ifndef LIBBITCOIN_NETWORK_PROTOCOL_ADDRESS_HPP
 #define LIBBITCOIN_NETWORK_PROTOCOL_ADDRESS_HPP
 
+#include <chrono>
 #include <memory>
 #include <bitcoin/bitcoin.hpp>
 #include <bitcoin/network/channel.hpp>
+#include <bitcoin/network/const_buffer.hpp>
 #include <bitcoin/network/define.hpp>
 #include <bitcoin/network/protocols/protocol_events.hpp>
 
@@ -57,13 +59,21 @@ private:
     void handle_send_address(const code& ec);
     void handle_send_get_address(const code& ec);
     void handle_store_addresses(const code& ec);
+    void handle_fetch_addresses(const code& ec, const_buffer buffer);
 
     bool handle_receive_address(const code& ec, message::address::ptr address);
     bool handle_receive_get_address(const code& ec,
         message::get_address::ptr message);
 
+    typedef std::chrono::steady_clock clock;
+
     p2p& network_;
     message::address self_;
+    const clock::duration get_address_interval_;
+
+    // These are accessed only on the channel strand.
+    bool answered_;
+    clock::time_point last_answer_;
 };
 
 } // namespace network
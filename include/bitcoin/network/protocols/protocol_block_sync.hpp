@@ -0,0 +1,78 @@
+/**
+ * Copyright (c) 2011-2016 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NETWORK_PROTOCOL_BLOCK_SYNC_HPP
+#define LIBBITCOIN_NETWORK_PROTOCOL_BLOCK_SYNC_HPP
+
+#include <memory>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/block_scheduler.hpp>
+#include <bitcoin/network/channel.hpp>
+#include <bitcoin/network/define.hpp>
+#include <bitcoin/network/protocols/protocol_timer.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+class p2p;
+
+/**
+ * Headers-first block download protocol.
+ * Attach this to a channel immediately following handshake completion.
+ * Work is allocated by the network block scheduler, which assigns the header
+ * role to one channel and spreads block requests over all channels.
+ */
+class BCT_API protocol_block_sync
+  : public protocol_timer, track<protocol_block_sync>
+{
+public:
+    typedef std::shared_ptr<protocol_block_sync> ptr;
+
+    /**
+     * Construct a block sync protocol instance.
+     * @param[in]  network   The network interface.
+     * @param[in]  channel   The channel on which to start the protocol.
+     */
+    protocol_block_sync(p2p& network, channel::ptr channel);
+
+    /**
+     * Start the protocol.
+     */
+    virtual void start();
+
+private:
+    void send_requests();
+    void send_get_headers();
+
+    void handle_event(const code& ec);
+    void handle_send(const code& ec);
+
+    bool handle_work(const code& ec);
+    bool handle_receive_headers(const code& ec,
+        message::headers::ptr message);
+    bool handle_receive_block(const code& ec, message::block::ptr message);
+
+    p2p& network_;
+    block_scheduler::ptr scheduler_;
+};
+
+} // namespace network
+} // namespace libbitcoin
+
+#endif
@@ -0,0 +1,106 @@
+/**
+ * Copyright (c) 2011-2016 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NETWORK_PROTOCOL_COMPACT_BLOCK_HPP
+#define LIBBITCOIN_NETWORK_PROTOCOL_COMPACT_BLOCK_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/channel.hpp>
+#include <bitcoin/network/compact_messages.hpp>
+#include <bitcoin/network/define.hpp>
+#include <bitcoin/network/protocols/protocol_events.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+class p2p;
+
+/**
+ * Compact block relay protocol (BIP152).
+ * Attach this to a channel immediately following handshake completion.
+ * Blocks are sent compact only to peers that request high bandwidth relay,
+ * and are received compact only if the network has a transaction source.
+ * Peers announce in low bandwidth mode until promoted, which is limited to
+ * the first three (network wide) to deliver a reconstructed block.
+ */
+class BCT_API protocol_compact_block
+  : public protocol_events, track<protocol_compact_block>
+{
+public:
+    typedef std::shared_ptr<protocol_compact_block> ptr;
+
+    /// The first protocol version to support compact blocks.
+    static const uint32_t version_minimum;
+
+    /**
+     * Construct a compact block protocol instance.
+     * @param[in]  network   The network interface.
+     * @param[in]  channel   The channel on which to start the protocol.
+     */
+    protocol_compact_block(p2p& network, channel::ptr channel);
+
+    /**
+     * Start the protocol.
+     */
+    virtual void start();
+
+private:
+    typedef std::vector<bool> presence;
+
+    bool reconstruct(const compact_block& message);
+    void complete();
+    void request_block(const hash_digest& hash);
+    void promote();
+
+    void handle_stop(const code& ec);
+    void handle_send(const code& ec);
+
+    bool handle_relay_block(const code& ec, message::block::ptr block);
+    bool handle_receive_send_compact(const code& ec,
+        send_compact::ptr message);
+    bool handle_receive_compact_block(const code& ec,
+        compact_block::ptr message);
+    bool handle_receive_get_block_transactions(const code& ec,
+        get_block_transactions::ptr message);
+    bool handle_receive_block_transactions(const code& ec,
+        block_transactions::ptr message);
+    bool handle_receive_block(const code& ec, message::block::ptr message);
+
+    p2p& network_;
+    bc::atomic<bool> compact_;
+    bc::atomic<bool> high_bandwidth_;
+    bc::atomic<message::block::ptr> last_sent_;
+    std::atomic<bool> announcer_;
+
+    // These are accessed only on the channel strand.
+    message::block pending_;
+    presence filled_;
+    bool waiting_;
+    hash_list requested_;
+};
+
+} // namespace network
+} // namespace libbitcoin
+
+#endif
@@ -20,9 +20,11 @@
 #ifndef LIBBITCOIN_NETWORK_PROTOCOL_PING_HPP
 #define LIBBITCOIN_NETWORK_PROTOCOL_PING_HPP
 
+#include <cstddef>
 #include <memory>
 #include <bitcoin/bitcoin.hpp>
 #include <bitcoin/network/channel.hpp>
+#include <bitcoin/network/channel_metrics.hpp>
 #include <bitcoin/network/define.hpp>
 #include <bitcoin/network/protocols/protocol_timer.hpp>
 #include <bitcoin/network/settings.hpp>
@@ -35,6 +37,8 @@ class p2p;
 /**
  * Ping-pong protocol.
  * Attach this to a channel immediately following handshake completion.
+ * A heartbeat ping is suppressed while other traffic from the peer proves
+ * its liveness, up to a limit that keeps the round trip measurement current.
  */
 class BCT_API protocol_ping
   : public protocol_timer, track<protocol_ping>
@@ -62,9 +66,14 @@ private:
 
     bool handle_receive_ping(const code& ec, message::ping::ptr message);
     bool handle_receive_pong(const code& ec, message::pong::ptr message,
-        uint64_t nonce);
+        uint64_t nonce, channel_metrics::clock::time_point sent);
+
+    bool suppress();
 
     const settings& settings_;
+
+    // This is accessed only on the heartbeat sequence.
+    size_t suppressed_;
 };
 
 } // namespace network
@@ -20,6 +20,7 @@
 #ifndef LIBBITCOIN_NETWORK_PROTOCOL_VERSION_HPP
 #define LIBBITCOIN_NETWORK_PROTOCOL_VERSION_HPP
 
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
 #include <memory>
@@ -49,15 +50,24 @@ public:
     
     /**
      * Start the protocol.
-     * @param[in]  handler  Invoked upon stop or receipt of version and verack.
+     * @param[in]  handler  Invoked upon stop or receipt of version and verack,
+     *                      or of version alone if the handshake is pipelined.
      */
     virtual void start(event_handler handler);
 
-private:
+    /**
+     * Construct the version message of a channel.
+     * @param[in]  authority  The authority of the peer.
+     * @param[in]  settings   The network settings.
+     * @param[in]  nonce      The nonce of the channel.
+     * @param[in]  height     The current blockchain height.
+     */
     static message::version template_factory(
         const config::authority& authority, const settings& settings,
         uint64_t nonce, size_t height);
 
+private:
+    void handle_pipelined(const code& ec, event_handler complete);
     void handle_version_sent(const code& ec);
     void handle_verack_sent(const code& ec);
 
@@ -66,6 +76,8 @@ private:
 
     static const message::version template_;
     p2p& network_;
+    const bool pipelined_;
+    std::atomic<bool> acknowledged_;
 };
 
 } // namespace network
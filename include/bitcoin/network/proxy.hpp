@@ -20,19 +20,31 @@
 #ifndef LIBBITCOIN_NETWORK_PROXY_HPP
 #define LIBBITCOIN_NETWORK_PROXY_HPP
 
+#include <array>
 #include <atomic>
 #include <cstddef>
 #include <cstdint>
+#include <deque>
 #include <functional>
+#include <map>
 #include <memory>
 #include <string>
+#include <vector>
 #include <boost/iostreams/stream.hpp>
 #include <boost/thread.hpp>
 #include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/buffer_pool.hpp>
+#include <bitcoin/network/channel_metrics.hpp>
 #include <bitcoin/network/const_buffer.hpp>
 #include <bitcoin/network/define.hpp>
+#include <bitcoin/network/handler_allocator.hpp>
+#include <bitcoin/network/memory_accounts.hpp>
+#include <bitcoin/network/message_checksum.hpp>
 #include <bitcoin/network/message_subscriber.hpp>
+#include <bitcoin/network/settings.hpp>
 #include <bitcoin/network/socket.hpp>
+#include <bitcoin/network/token_bucket.hpp>
+#include <bitcoin/network/traffic_capture.hpp>
 
 namespace libbitcoin {
 namespace network {
@@ -46,15 +58,21 @@ public:
     using message_handler = std::function<bool(const code&,
         std::shared_ptr<Message>)>;
 
+    template <class Message>
+    using batch_handler = std::function<bool(const code&,
+        message_subscriber::batch_ptr<Message>)>;
+
     typedef std::shared_ptr<proxy> ptr;
     typedef std::function<void()> completion_handler;
     typedef std::function<void(const code&)> result_handler;
+    typedef std::function<bool(const code&, bool)> pressure_handler;
     typedef subscriber<const code&> stop_subscriber;
-    typedef resubscriber<const code&, const std::string&, const_buffer,
-        result_handler> send_subscriber;
+    typedef resubscriber<const code&, bool> pressure_subscriber;
 
     /// Construct an instance.
-    proxy(threadpool& pool, socket::ptr socket, uint32_t magic);
+    proxy(threadpool& pool, socket::ptr socket, const settings& settings,
+        buffer_pool::ptr buffers, token_bucket::ptr uploads,
+        memory_accounts::ptr memory);
 
     /// Validate proxy stopped.
     ~proxy();
@@ -63,23 +81,31 @@ public:
     proxy(const proxy&) = delete;
     void operator=(const proxy&) = delete;
 
-    /// Send a message on the socket.
+    /// Queue a message for sending on the socket.
     template <class Message>
     void send(const Message& packet, result_handler handler)
     {
-        const auto success = error::success;
         const auto& command = packet.command;
         const auto buffer = const_buffer(message::serialize(packet, magic_));
-        do_send(success, command, buffer, handler);
-
-        ////// Bypass queuing for block messages.
-        ////if (packet.command == chain::block::command)
-        ////    send_subscriber_->do_relay(success, command, buffer, handler);
-        ////else
-        ////    send_subscriber_->relay(success, command, buffer, handler);
+        do_send(command, buffer, handler);
     }
 
+    /// Queue a serialized message for sending on the socket.
+    /// The buffer is immutable and may be shared by multiple channels.
+    virtual void send_buffer(const std::string& command, const_buffer buffer,
+        result_handler handler);
+
+    /// Queue a serialized payload for sending on the socket, with a heading.
+    /// The payload is immutable and may be shared, or a mapped file region.
+    virtual void send_payload(const std::string& command, const_buffer payload,
+        result_handler handler);
+
+    /// Queue a serialized payload of known checksum, with a heading.
+    virtual void send_payload(const std::string& command, const_buffer payload,
+        uint32_t checksum, result_handler handler);
+
     /// Subscribe to messages of the specified type on the socket.
+    /// A type not known to the library is registered by its command.
     template <class Message>
     void subscribe(message_handler<Message>&& handler)
     {
@@ -87,12 +113,40 @@ public:
         message_subscriber_.subscribe<Message>(stopped);
     }
 
+    /// Subscribe to the messages of a known type read in one burst, as one
+    /// notification delivered once the burst ends.
+    template <class Message>
+    void subscribe_batch(batch_handler<Message>&& handler)
+    {
+        auto stopped = std::forward<batch_handler<Message>>(handler);
+        message_subscriber_.subscribe_batch<Message>(stopped);
+    }
+
     /// Subscribe to the stop event.
     virtual void subscribe_stop(result_handler handler);
 
+    /// Subscribe to send backlog changes, true when the backlog is exceeded.
+    virtual void subscribe_pressure(pressure_handler handler);
+
+    /// Hold queued messages until resumed, so that they share one write.
+    virtual void hold_writes();
+
+    /// Resume writing, including any messages queued while held.
+    virtual void resume_writes();
+
+    /// Determine if the queued send bytes exceed the backlog limit.
+    virtual bool congested() const;
+
     /// Get the authority of the far end of this socket.
     virtual const config::authority& authority() const;
 
+    /// Write each received message to the capture, set before start.
+    virtual void set_capture(traffic_capture::ptr capture);
+
+    /// Get the traffic and latency counters of this socket.
+    virtual channel_metrics& metrics();
+    virtual const channel_metrics& metrics() const;
+
     /// Read messages from this socket.
     virtual void start(result_handler handler);
 
@@ -100,6 +154,24 @@ public:
     virtual void stop(const code& ec);
 
 protected:
+    /// Subscribe for the bookkeeping of the proxy itself. These do not solicit
+    /// the type, so its payloads are skipped unless otherwise subscribed.
+    template <class Message>
+    void subscribe_own(message_handler<Message>&& handler)
+    {
+        ++own_subscriptions_[static_cast<size_t>(to_type(Message::command))];
+        subscribe<Message>(std::forward<message_handler<Message>>(handler));
+    }
+
+    /// Subscribe to bursts for the bookkeeping of the proxy itself.
+    template <class Message>
+    void subscribe_own_batch(batch_handler<Message>&& handler)
+    {
+        ++own_batches_[static_cast<size_t>(to_type(Message::command))];
+        subscribe_batch<Message>(
+            std::forward<batch_handler<Message>>(handler));
+    }
+
     virtual bool stopped() const;
     virtual void handle_activity() = 0;
     virtual void handle_stopping() = 0;
@@ -107,41 +179,156 @@ protected:
 private:
     typedef byte_source<message::heading::buffer> heading_source;
     typedef boost::iostreams::stream<heading_source> heading_stream;
-    typedef byte_source<data_chunk> payload_source;
-    typedef boost::iostreams::stream<payload_source> payload_stream;
+
+    // The heading of a payload sent with its own heading, otherwise empty.
+    struct queued_message
+    {
+        size_t size() const;
+
+        message::message_type type;
+        std::string command;
+        const_buffer heading;
+        const_buffer buffer;
+        result_handler handler;
+    };
+
+    /// Send priorities, in order, with one queue for each.
+    enum class priority
+    {
+        control,
+        announcement,
+        transaction,
+        bulk
+    };
+
+    typedef std::deque<queued_message> message_queue;
+    typedef std::shared_ptr<message_queue> message_queue_ptr;
+    typedef std::shared_ptr<queued_message> queued_message_ptr;
+    typedef std::array<message_queue, 4> message_queues;
+    typedef std::array<std::atomic<size_t>, channel_metrics::type_count>
+        counters;
 
     static config::authority authority_factory(socket::ptr socket);
+    static message::message_type to_type(const std::string& command);
+    static priority to_priority(message::message_type type);
+    static message_subscriber::type_list to_types(
+        const std::vector<std::string>& commands);
+    static std::vector<size_t> to_limits(const settings& settings);
+    static size_t to_read_ahead(const settings& settings);
 
     void do_close();
     void stop(const boost_code& ec);
 
+    bool skipped() const;
+    bool buffered() const;
+    bool unsolicited(const message::heading& head) const;
+
+    void read_next();
     void read_heading();
     void handle_read_heading(const boost_code& ec, size_t);
+    bool handle_heading();
 
-    void read_payload(const message::heading& head);
-    void handle_read_payload(const boost_code& ec, size_t,
-        const message::heading& head);
+    void read_buffered();
+    void parse_buffered();
+    void fill_buffer();
+    void handle_fill_buffer(const boost_code& ec, size_t size);
 
-    bool do_send(const code& ec, const std::string& command,
+    void read_payload();
+    void read_payload_chunk(size_t offset);
+    void handle_read_payload_chunk(const boost_code& ec, size_t size,
+        size_t offset);
+    void handle_read_payload(const boost_code& ec, const uint8_t* payload);
+    bool parallel(size_t size) const;
+    void parse_parallel();
+    void do_parse(message::message_type type, const std::string& command,
+        size_t size, uint64_t sequence, buffer_pool::buffer buffer,
+        message_subscriber::ticket held);
+    void handle_parse(const code& ec, message::message_type type,
+        const std::string& command, size_t size, uint64_t sequence,
+        message_subscriber::delivery notify);
+    void order(uint64_t sequence, message_subscriber::delivery notify);
+    void clear_ready();
+    message_subscriber::ticket hold(size_t size);
+    void release(size_t size);
+
+    static asio::const_buffer slice(const const_buffer& buffer, size_t offset,
+        size_t size);
+
+    void do_send(const std::string& command, const_buffer buffer,
+        result_handler handler);
+    void do_send(const std::string& command, const_buffer heading,
         const_buffer buffer, result_handler handler);
-    void handle_send(const boost_code& ec, const_buffer buffer,
-        /*scope_lock::ptr lock,*/ result_handler handler);
+    void write_batch();
+    void write_chunk();
+    void pace();
+    void handle_pace(const code& ec);
+    void shed();
+    void handle_shed(const code& ec);
+    void handle_send(const boost_code& ec, message_queue_ptr batch);
+    void handle_chunk(const boost_code& ec, size_t size,
+        queued_message_ptr message);
+    void clear_queue(const code& ec);
+    size_t queued_count() const;
 
-    shared_mutex mutex_;
     std::atomic<bool> stopped_;
+    std::atomic<bool> paused_;
+    std::atomic<size_t> pending_bytes_;
 
     const uint32_t magic_;
+    const size_t write_limit_;
+    const size_t backlog_limit_;
+    const size_t unsolicited_limit_;
+    const size_t receive_backlog_;
+    const size_t parallel_limit_;
+    const std::vector<size_t> payload_limits_;
     const config::authority authority_;
 
     // These are thread safe.
+    threadpool& pool_;
     socket::ptr socket_;
-    ////send_subscriber::ptr send_subscriber_;
+    buffer_pool::ptr buffers_;
+    token_bucket::ptr uploads_;
+    token_bucket upload_;
+    memory_accounts::ptr memory_;
     stop_subscriber::ptr stop_subscriber_;
+    pressure_subscriber::ptr pressure_subscriber_;
     message_subscriber message_subscriber_;
+    channel_metrics metrics_;
+    counters own_subscriptions_;
+    counters own_batches_;
 
     // These are protected by sequential ordering.
-    data_chunk payload_buffer_;
+    traffic_capture::ptr capture_;
+    handler_allocator read_allocator_;
+    buffer_pool::buffer payload_buffer_;
+    message_checksum checksum_;
     message::heading::buffer heading_buffer_;
+    message::heading payload_heading_;
+    data_chunk read_buffer_;
+    size_t read_begin_;
+    size_t read_end_;
+    bool parsing_;
+    bool resumed_;
+    bool payload_pending_;
+    message::message_type payload_type_;
+    message_subscriber::command_field payload_command_;
+    queued_message_ptr partial_;
+    size_t partial_offset_;
+
+    // These are protected by the strand, deliveries are made in read order.
+    uint64_t next_sequence_;
+    uint64_t next_delivery_;
+    std::map<uint64_t, message_subscriber::delivery> ready_;
+
+    // These are protected by mutex.
+    bool writing_;
+    bool holding_;
+    bool pacing_;
+    bool congested_;
+    size_t queued_bytes_;
+    message_queues queues_;
+    deadline::ptr pace_timer_;
+    mutable shared_mutex mutex_;
 };
 
 } // namespace network
@@ -0,0 +1,71 @@
+/**
+ * Copyright (c) 2011-2016 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NETWORK_RECONNECT_BACKOFF_HPP
+#define LIBBITCOIN_NETWORK_RECONNECT_BACKOFF_HPP
+
+#include <cstddef>
+#include <memory>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/define.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+/// Exponential reconnect delay with jitter and a cap, thread and lock safe.
+/// Each connection loop owns one instance, counting its consecutive failures.
+class BCT_API reconnect_backoff
+{
+public:
+    typedef std::shared_ptr<reconnect_backoff> ptr;
+
+    /// Construct an instance, the delay doubles from initial up to maximum.
+    reconnect_backoff(const asio::duration& initial,
+        const asio::duration& maximum);
+
+    /// This class is not copyable.
+    reconnect_backoff(const reconnect_backoff&) = delete;
+    void operator=(const reconnect_backoff&) = delete;
+
+    /// The delay preceding the retry of the given failure, without jitter.
+    static asio::duration delay(const asio::duration& initial,
+        const asio::duration& maximum, size_t failures);
+
+    /// Count a failure and obtain its delay, randomized to [delay/2, delay].
+    virtual asio::duration next();
+
+    /// Clear the failures, so that the next delay is the initial delay.
+    virtual void reset();
+
+    /// The number of consecutive failures.
+    virtual size_t failures() const;
+
+private:
+    const asio::duration initial_;
+    const asio::duration maximum_;
+
+    // These are protected by mutex.
+    size_t failures_;
+    mutable shared_mutex mutex_;
+};
+
+} // namespace network
+} // namespace libbitcoin
+
+#endif
@@ -0,0 +1,83 @@
+/**
+ * Copyright (c) 2011-2016 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NETWORK_RESOLVER_CACHE_HPP
+#define LIBBITCOIN_NETWORK_RESOLVER_CACHE_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/define.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+/// A cache of host name resolution results, thread and lock safe.
+/// Results expire after the configured lifetime, as the system resolver does
+/// not expose record TTLs. Numeric addresses are not cached.
+class BCT_API resolver_cache
+{
+public:
+    typedef std::shared_ptr<resolver_cache> ptr;
+
+    /// Construct an instance, a zero lifetime disables caching.
+    resolver_cache(uint32_t lifetime_seconds);
+
+    /// This class is not copyable.
+    resolver_cache(const resolver_cache&) = delete;
+    void operator=(const resolver_cache&) = delete;
+
+    /// Obtain unexpired results for the host and port, false if none.
+    virtual bool find(asio::iterator& out, const std::string& hostname,
+        uint16_t port) const;
+
+    /// Cache the results for the host and port, replacing any previous.
+    virtual void store(const std::string& hostname, uint16_t port,
+        asio::iterator results);
+
+private:
+    typedef std::chrono::steady_clock clock;
+
+    struct entry
+    {
+        asio::iterator results;
+        clock::time_point expiration;
+    };
+
+    typedef std::unordered_map<std::string, entry> entry_map;
+
+    static bool is_numeric(const std::string& hostname);
+    static std::string to_key(const std::string& hostname, uint16_t port);
+
+    void safe_purge(clock::time_point now);
+
+    const clock::duration lifetime_;
+
+    // These are protected by mutex.
+    entry_map entries_;
+    mutable shared_mutex mutex_;
+};
+
+} // namespace network
+} // namespace libbitcoin
+
+#endif
@@ -0,0 +1,86 @@
+/**
+ * Copyright (c) 2011-2016 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NETWORK_ROLLING_FILTER_HPP
+#define LIBBITCOIN_NETWORK_ROLLING_FILTER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/define.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+/// This class is not thread safe.
+/// A fixed-size probabilistic set of hashes, with a false positive rate of
+/// about one in a thousand and no false negatives for recent insertions.
+/// Two generations of capacity / 2 hashes are kept. When the current one is
+/// full the older one is cleared and reused, so at least the most recent
+/// capacity / 2 hashes are always retained. Each hash sets bits in a single
+/// cache line and the bit positions are salted per instance.
+class BCT_API rolling_filter
+{
+public:
+    /// Construct an instance, the footprint is two bytes per capacity.
+    rolling_filter(size_t capacity);
+
+    /// This class is not copyable.
+    rolling_filter(const rolling_filter&) = delete;
+    void operator=(const rolling_filter&) = delete;
+
+    /// Insert the hash, false if it was (probably) already present.
+    bool insert(const hash_digest& hash);
+
+    /// Determine if the hash is (probably) present.
+    bool contains(const hash_digest& hash) const;
+
+    /// Remove all hashes.
+    void clear();
+
+    /// The memory used by the bit arrays.
+    size_t footprint() const;
+
+private:
+    typedef uint64_t word;
+
+    struct position
+    {
+        size_t block;
+        word bits[8];
+    };
+
+    position to_position(const hash_digest& hash) const;
+    bool contains(const word* generation, const position& at) const;
+    void insert(word* generation, const position& at);
+
+    const uint64_t salt_;
+    const size_t blocks_;
+    const size_t generation_size_;
+    size_t count_;
+    std::vector<word> storage_;
+    word* current_;
+    word* previous_;
+};
+
+} // namespace network
+} // namespace libbitcoin
+
+#endif
@@ -30,9 +30,13 @@
 #include <bitcoin/network/connections.hpp>
 #include <bitcoin/network/connector.hpp>
 #include <bitcoin/network/define.hpp>
+#include <bitcoin/network/dispatch_monitor.hpp>
+#include <bitcoin/network/lifecycle_metrics.hpp>
+#include <bitcoin/network/monitored_dispatcher.hpp>
 #include <bitcoin/network/pending_channels.hpp>
 #include <bitcoin/network/proxy.hpp>
 #include <bitcoin/network/settings.hpp>
+#include <bitcoin/network/slab_allocator.hpp>
 
 namespace libbitcoin {
 namespace network {
@@ -91,6 +95,9 @@ public:
     /// Subscribe to receive session stop notification.
     virtual void subscribe_stop(result_handler handler);
 
+    /// Get the number of channels pending handshake completion.
+    virtual void pending_count(count_handler handler) const;
+
 protected:
 
     /// Construct an instance.
@@ -107,8 +114,8 @@ protected:
     template <class Protocol, typename... Args>
     typename Protocol::ptr attach(channel::ptr channel, Args&&... args)
     {
-        return std::make_shared<Protocol>(network_, channel,
-            std::forward<Args>(args)...);
+        return std::allocate_shared<Protocol>(slab_allocator<Protocol>(),
+            network_, channel, std::forward<Args>(args)...);
     }
 
     /// Bind a method in the derived class.
@@ -129,7 +136,8 @@ protected:
     /// Bind a concurrent delegate to a method in the derived class.
     template <class Session, typename Handler, typename... Args>
     auto concurrent_delegate(Handler&& handler, Args&&... args) ->
-        delegates::concurrent<decltype(BOUND_SESSION_TYPE(handler, args))>
+        monitored_dispatcher::delegate<
+            decltype(BOUND_SESSION_TYPE(handler, args))>
     {
         return dispatch_.concurrent_delegate(SESSION_ARGS(handler, args));
     }
@@ -137,14 +145,22 @@ protected:
     /// Properties.
     virtual void address_count(count_handler handler);
     virtual void fetch_address(host_handler handler);
+    virtual void store_addresses(const authority::list& hosts,
+        result_handler handler);
+    virtual void attempt_address(const authority& host);
+    virtual void score_address(const authority& host, const code& result);
     virtual void connection_count(count_handler handler);
     virtual bool blacklisted(const authority& authority) const;
     virtual bool stopped() const;
+    virtual authority::list take_anchors();
 
     /// Socket creators.
     virtual acceptor::ptr create_acceptor();
     virtual connector::ptr create_connector();
 
+    /// The session type, by which channel startup times are recorded.
+    virtual lifecycle_metrics::origin origin() const;
+
     /// Register a new channel with the session and bind its handlers.
     virtual void register_channel(channel::ptr channel,
         result_handler handle_started, result_handler handle_stopped);
@@ -196,6 +212,7 @@ private:
         result_handler handle_stopped);
     void handle_unpend(const code& ec);
     void handle_remove(const code& ec);
+    void handle_scored(const code& ec);
 
     std::atomic<bool> stopped_;
     const bool incoming_;
@@ -203,7 +220,7 @@ private:
 
     // These are thread safe.
     p2p& network_;
-    dispatcher dispatch_;
+    monitored_dispatcher dispatch_;
     pending_channels pending_;
 };
 
@@ -233,6 +250,8 @@ private:
     bind<CLASS>(&CLASS::method, p1, p2, p3, p4, p5)
 #define BIND6(method, p1, p2, p3, p4, p5, p6) \
     bind<CLASS>(&CLASS::method, p1, p2, p3, p4, p5, p6)
+#define BIND7(method, p1, p2, p3, p4, p5, p6, p7) \
+    bind<CLASS>(&CLASS::method, p1, p2, p3, p4, p5, p6, p7)
 
 #define CONCURRENT2(method, p1, p2) \
     concurrent_delegate<CLASS>(&CLASS::method, p1, p2)
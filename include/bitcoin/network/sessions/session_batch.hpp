@@ -22,11 +22,16 @@
 
 #include <atomic>
 #include <cstddef>
+#include <functional>
 #include <memory>
+#include <vector>
 #include <bitcoin/bitcoin.hpp>
 #include <bitcoin/network/channel.hpp>
 #include <bitcoin/network/connector.hpp>
 #include <bitcoin/network/define.hpp>
+#include <bitcoin/network/outbound_reservations.hpp>
+#include <bitcoin/network/pending_sockets.hpp>
+#include <bitcoin/network/reconnect_backoff.hpp>
 #include <bitcoin/network/sessions/session.hpp>
 #include <bitcoin/network/settings.hpp>
 
@@ -39,34 +44,81 @@ class p2p;
 class BCT_API session_batch
   : public session
 {
+public:
+    /// Start the session, retry delays are cancelled when it stops.
+    void start(result_handler handler) override;
+
 protected:
+    typedef std::function<void()> retry_handler;
 
     /// Construct an instance.
     session_batch(p2p& network, bool persistent);
 
-    /// Create a channel from the configured number of concurrent attempts.
+    /// Create a reconnect backoff from the configured delays.
+    virtual reconnect_backoff::ptr create_backoff() const;
+
+    /// Invoke the handler after the next delay of the backoff.
+    /// The handler is invoked early if the session stops, so that it reports
+    /// the stop, and immediately if the session is stopped.
+    virtual void retry(reconnect_backoff::ptr backoff, retry_handler handler);
+
+    /// Create a channel from the configured number of staggered attempts.
+    /// Attempts of all batches are coordinated, a host is not attempted
+    /// while another of its network group is reserved.
     virtual void connect(connector::ptr connect, channel_handler handler);
 
+    /// Create a channel to the host, whose network group is reserved.
+    /// Fails with address_blocked if the group is reserved by another host.
+    virtual void connect_direct(connector::ptr connect, const authority& host,
+        channel_handler handler);
+
+    /// Release the reservation of a connected host when its channel stops.
+    virtual void release_address(const authority& host);
+
 private:
     typedef std::atomic<size_t> atomic_counter;
-    typedef std::shared_ptr<atomic_counter> atomic_counter_ptr;
-    typedef std::shared_ptr<upgrade_mutex> upgrade_mutex_ptr;
 
-    void converge(const code& ec, channel::ptr channel,
-        atomic_counter_ptr counter, upgrade_mutex_ptr mutex,
+    // The shared state of one batch of racing connection attempts.
+    struct batch
+    {
+        batch(threadpool& pool, const asio::duration& stagger);
+
+        atomic_counter started;
+        atomic_counter completed;
+        upgrade_mutex mutex;
+        pending_sockets::ptr pending;
+        deadline::ptr timer;
+    };
+
+    typedef std::shared_ptr<batch> batch_ptr;
+
+    void handle_started(const code& ec, result_handler handler);
+    void do_stop_retries(const code& ec);
+    void handle_retry(const code& ec, deadline::ptr timer,
+        retry_handler handler);
+    void handle_direct(const code& ec, channel::ptr channel,
+        const authority& host, channel_handler handler);
+
+    void converge(const code& ec, channel::ptr channel, batch_ptr batch,
         channel_handler handler);
 
     // Connect sequence
-    void new_connect(connector::ptr connect, atomic_counter_ptr counter,
+    void new_connect(connector::ptr connect, batch_ptr batch,
         channel_handler handler);
+    void handle_stagger(const code& ec, connector::ptr connect,
+        batch_ptr batch, channel_handler handler);
     void start_connect(const code& ec, const authority& host,
-        connector::ptr connect, atomic_counter_ptr counter,
-        channel_handler handler);
+        connector::ptr connect, batch_ptr batch, channel_handler handler);
     void handle_connect(const code& ec, channel::ptr channel,
-        const authority& host, connector::ptr connect,
-        atomic_counter_ptr counter, channel_handler handler);
+        const authority& host, connector::ptr connect, batch_ptr batch,
+        channel_handler handler);
 
     const size_t batch_size_;
+    outbound_reservations reservations_;
+
+    // These are protected by mutex.
+    std::vector<deadline::ptr> retries_;
+    upgrade_mutex retry_mutex_;
 };
 
 } // namespace network
@@ -48,11 +48,17 @@ public:
     /// Start the session.
     void start(result_handler handler) override;
 
+protected:
+    /// The session type, for startup timing.
+    lifecycle_metrics::origin origin() const override;
+
 private:
+    void start_listen(const config::authority& binding, bool reuse_port);
+    void start_accepts(const code& ec, const config::authority& binding,
+        acceptor::ptr accept);
     void start_accept(const code& ec, acceptor::ptr accept);
     void handle_started(const code& ec, result_handler handler);
     void handle_is_loopback(bool loopback, channel::ptr channel);
-    void handle_connection_count(size_t connections, channel::ptr channel);
     void handle_accept(const code& ec, channel::ptr channel,
         acceptor::ptr accept);
 
@@ -28,6 +28,7 @@
 #include <bitcoin/network/channel.hpp>
 #include <bitcoin/network/connector.hpp>
 #include <bitcoin/network/define.hpp>
+#include <bitcoin/network/reconnect_backoff.hpp>
 #include <bitcoin/network/sessions/session_batch.hpp>
 #include <bitcoin/network/settings.hpp>
 
@@ -57,18 +58,25 @@ public:
     virtual void connect(const std::string& hostname, uint16_t port,
         channel_handler handler);
 
+protected:
+    /// The session type, for startup timing.
+    lifecycle_metrics::origin origin() const override;
+
 private:
     void handle_started(const code& ec, result_handler handler);
     void start_connect(const std::string& hostname, uint16_t port,
-        channel_handler handler, uint32_t retries);
+        channel_handler handler, uint32_t retries,
+        reconnect_backoff::ptr backoff);
     void handle_connect(const code& ec, channel::ptr channel,
         const std::string& hostname, uint16_t port,
-        channel_handler handler, uint32_t retries);
+        channel_handler handler, uint32_t retries,
+        reconnect_backoff::ptr backoff);
 
     void handle_channel_start(const code& ec, const std::string& hostname,
-        uint16_t port, channel::ptr channel, channel_handler handler);
+        uint16_t port, channel::ptr channel, channel_handler handler,
+        reconnect_backoff::ptr backoff);
     void handle_channel_stop(const code& ec, const std::string& hostname,
-        uint16_t port);
+        uint16_t port, reconnect_backoff::ptr backoff);
 
     bc::atomic<connector::ptr> connector_;
 };
@@ -21,10 +21,13 @@
 #define LIBBITCOIN_NETWORK_SESSION_OUTBOUND_HPP
 
 #include <cstddef>
+#include <cstdint>
 #include <memory>
+#include <vector>
 #include <bitcoin/bitcoin.hpp>
 #include <bitcoin/network/channel.hpp>
 #include <bitcoin/network/define.hpp>
+#include <bitcoin/network/reconnect_backoff.hpp>
 #include <bitcoin/network/sessions/session_batch.hpp>
 #include <bitcoin/network/settings.hpp>
 
@@ -47,15 +50,37 @@ public:
     void start(result_handler handler) override;
 
 private:
-    void new_connection(connector::ptr connect);
+    void new_connection(connector::ptr connect,
+        reconnect_backoff::ptr backoff);
     void handle_started(const code& ec, result_handler handler);
     void handle_connect(const code& ec, channel::ptr channel,
-        connector::ptr connect);
+        connector::ptr connect, reconnect_backoff::ptr backoff);
 
     void handle_channel_stop(const code& ec, connector::ptr connect,
-        channel::ptr channel);
+        reconnect_backoff::ptr backoff, channel::ptr channel);
     void handle_channel_start(const code& ec, connector::ptr connect,
-        channel::ptr channel);
+        reconnect_backoff::ptr backoff, channel::ptr channel);
+
+    void start_eviction();
+    void handle_eviction(const code& ec);
+    void handle_stop(const code& ec);
+
+    void store_channel(channel::ptr channel);
+    void remove_channel(channel::ptr channel);
+    channel::ptr select_eviction();
+
+    struct sample
+    {
+        channel::ptr peer;
+        uint64_t received;
+        bool measured;
+    };
+
+    deadline::ptr eviction_;
+
+    // These are protected by mutex.
+    std::vector<sample> channels_;
+    mutable shared_mutex mutex_;
 };
 
 } // namespace network
@@ -47,22 +47,47 @@ public:
     /// Start the session.
     void start(result_handler handler) override;
 
+protected:
+    /// The session type, for startup timing.
+    lifecycle_metrics::origin origin() const override;
+
 private:
     void handle_count(size_t start_size, result_handler handler);
     void start_seeding(size_t start_size, connector::ptr connect,
         result_handler handler);
     void start_seed(const config::endpoint& seed, connector::ptr connect,
-        result_handler handler);
+        result_handler handler, result_handler complete);
     void handle_started(const code& ec, result_handler handler);
+    void handle_resolve(const code& ec,
+        const config::authority::list& authorities,
+        const config::endpoint& seed, connector::ptr connect,
+        result_handler handler, result_handler complete);
     void handle_connect(const code& ec, channel::ptr channel,
-        const config::endpoint& seed, result_handler handler);
-    void handle_complete(size_t start_size, result_handler handler);
+        const config::endpoint& seed, result_handler handler,
+        result_handler complete);
+    void handle_stored(const code& ec, const config::endpoint& seed,
+        result_handler complete);
+    void handle_seeded(const code& ec, result_handler handler,
+        result_handler complete);
+    void handle_threshold(size_t current_size, result_handler complete);
+    void handle_complete(size_t start_size, connector::ptr connect,
+        result_handler handler);
     void handle_final_count(size_t current_size, size_t start_size,
         result_handler handler);
 
     void handle_channel_start(const code& ec, channel::ptr channel,
-        result_handler handler);
-    void handle_channel_stop(const code& ec);
+        result_handler handler, result_handler complete);
+    void handle_channel_stop(const code& ec, channel::ptr channel);
+
+    void check_threshold(result_handler complete);
+    bool safe_store(channel::ptr channel);
+    void safe_remove(channel::ptr channel);
+    std::vector<channel::ptr> safe_clear();
+
+    // These are protected by mutex.
+    bool completed_;
+    std::vector<channel::ptr> channels_;
+    mutable shared_mutex mutex_;
 };
 
 } // namespace network
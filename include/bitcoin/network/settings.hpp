@@ -21,6 +21,8 @@
 #define LIBBITCOIN_NETWORK_SETTINGS_HPP
 
 #include <cstdint>
+#include <string>
+#include <vector>
 #include <boost/filesystem.hpp>
 #include <bitcoin/bitcoin.hpp>
 #include <bitcoin/network/define.hpp>
@@ -40,31 +42,95 @@ public:
     uint32_t identifier;
     uint16_t inbound_port;
     uint32_t inbound_connections;
+    uint32_t inbound_acceptors;
+    uint32_t inbound_accepts;
+    uint32_t inbound_subnet_accepts;
     uint32_t outbound_connections;
     uint32_t manual_attempt_limit;
     uint32_t connect_batch_size;
+    uint32_t connect_attempt_limit;
     uint32_t connect_timeout_seconds;
+    uint32_t connect_stagger_milliseconds;
+    uint32_t connect_backoff_milliseconds;
+    uint32_t connect_backoff_maximum_seconds;
     uint32_t channel_handshake_seconds;
     uint32_t channel_heartbeat_minutes;
     uint32_t channel_inactivity_minutes;
     uint32_t channel_expiration_minutes;
     uint32_t channel_germination_seconds;
+    uint32_t channel_get_address_seconds;
+    uint32_t channel_trickle_milliseconds;
+    uint32_t channel_known_inventory;
+    uint32_t channel_unsolicited_bytes;
+    uint32_t channel_payload_bytes;
+    uint32_t channel_stall_seconds;
+    uint32_t channel_timer_milliseconds;
+    uint32_t channel_minimum_throughput;
+    uint32_t outbound_eviction_minutes;
+    uint32_t outbound_anchors;
+    uint32_t shutdown_timeout_seconds;
     uint32_t host_pool_capacity;
+    uint32_t host_pool_flush_seconds;
+    uint32_t host_pool_sample_seconds;
+    uint32_t host_pool_seed_threshold;
+    uint32_t log_queue_capacity;
+    uint32_t log_flush_milliseconds;
+    uint32_t buffer_pool_capacity;
+    uint32_t channel_write_bytes;
+    uint32_t channel_backlog_bytes;
+    uint32_t channel_receive_backlog_bytes;
+    uint32_t channel_read_ahead_bytes;
+    uint32_t channel_parallel_parse_bytes;
+    uint32_t inbound_send_buffer_bytes;
+    uint32_t inbound_receive_buffer_bytes;
+    uint32_t outbound_send_buffer_bytes;
+    uint32_t outbound_receive_buffer_bytes;
+    uint32_t inbound_fast_open_queue;
+    uint32_t channel_upload_bytes_per_second;
+    uint32_t upload_bytes_per_second;
+    uint32_t memory_limit_bytes;
+    uint32_t resolve_cache_seconds;
+    uint32_t download_window_blocks;
+    uint32_t download_peer_blocks;
+    uint32_t download_stall_seconds;
+    uint16_t metrics_port;
+    uint32_t metrics_interval_seconds;
     bool relay_transactions;
+    bool thread_affinity;
+    bool inbound_eviction;
+    bool socket_no_delay;
+    bool socket_keep_alive;
+    bool channel_pipeline_handshake;
     boost::filesystem::path hosts_file;
+    boost::filesystem::path anchors_file;
     boost::filesystem::path debug_file;
     boost::filesystem::path error_file;
+    boost::filesystem::path capture_file;
     config::authority self;
     config::authority::list blacklists;
+    config::authority::list binds;
     config::endpoint::list seeds;
+    std::vector<std::string> synchronous_messages;
+    std::vector<std::string> payload_limits;
 
     /// Helpers.
     asio::duration connect_timeout() const;
+    asio::duration connect_stagger() const;
+    asio::duration connect_backoff() const;
+    asio::duration connect_backoff_maximum() const;
     asio::duration channel_handshake() const;
     asio::duration channel_heartbeat() const;
     asio::duration channel_inactivity() const;
     asio::duration channel_expiration() const;
     asio::duration channel_germination() const;
+    asio::duration channel_trickle() const;
+    asio::duration channel_timer() const;
+    asio::duration outbound_eviction() const;
+    asio::duration shutdown_timeout() const;
+    asio::duration host_pool_flush() const;
+    asio::duration download_stall() const;
+    asio::duration log_flush() const;
+    asio::duration metrics_interval() const;
 };
 
 } // namespace network
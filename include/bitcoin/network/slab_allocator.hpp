@@ -0,0 +1,141 @@
+/**
+ * Copyright (c) 2011-2016 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NETWORK_SLAB_ALLOCATOR_HPP
+#define LIBBITCOIN_NETWORK_SLAB_ALLOCATOR_HPP
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/define.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+/// Per-thread caches of fixed-size blocks for small objects, thread safe.
+/// Blocks are size-classed in cache line steps and are taken and returned
+/// without a lock, a block released on another thread joins that cache.
+/// Larger blocks, and those over the per-thread retention, use the heap.
+class BCT_API slab
+{
+public:
+    /// Allocate a block of at least the specified size.
+    static void* allocate(size_t size);
+
+    /// Release a block allocated with the specified size.
+    static void deallocate(void* block, size_t size);
+};
+
+/// A standard allocator over the slab, for use with std::allocate_shared.
+template <typename Type>
+class slab_allocator
+{
+public:
+    typedef Type value_type;
+    typedef Type* pointer;
+    typedef const Type* const_pointer;
+    typedef Type& reference;
+    typedef const Type& const_reference;
+    typedef size_t size_type;
+    typedef std::ptrdiff_t difference_type;
+
+    template <typename Other>
+    struct rebind
+    {
+        typedef slab_allocator<Other> other;
+    };
+
+    slab_allocator()
+    {
+    }
+
+    template <typename Other>
+    slab_allocator(const slab_allocator<Other>&)
+    {
+    }
+
+    Type* allocate(size_t count)
+    {
+        return static_cast<Type*>(slab::allocate(count * sizeof(Type)));
+    }
+
+    void deallocate(Type* block, size_t count)
+    {
+        slab::deallocate(block, count * sizeof(Type));
+    }
+
+    template <typename Other>
+    bool operator==(const slab_allocator<Other>&) const
+    {
+        return true;
+    }
+
+    template <typename Other>
+    bool operator!=(const slab_allocator<Other>&) const
+    {
+        return false;
+    }
+};
+
+/// A completion handler whose asio operation state is allocated from the
+/// slab, by the asio allocation hooks. Strand wrappers defer to these hooks.
+template <typename Handler>
+class slab_handler
+{
+public:
+    slab_handler(Handler handler)
+      : handler_(std::move(handler))
+    {
+    }
+
+    template <typename... Args>
+    void operator()(Args&&... args)
+    {
+        handler_(std::forward<Args>(args)...);
+    }
+
+    friend void* asio_handler_allocate(size_t size, slab_handler*)
+    {
+        return slab::allocate(size);
+    }
+
+    friend void asio_handler_deallocate(void* block, size_t size,
+        slab_handler*)
+    {
+        slab::deallocate(block, size);
+    }
+
+private:
+    Handler handler_;
+};
+
+/// Wrap a completion handler for slab allocation of its operation.
+template <typename Handler>
+slab_handler<typename std::decay<Handler>::type> make_slab_handler(
+    Handler&& handler)
+{
+    return slab_handler<typename std::decay<Handler>::type>(
+        std::forward<Handler>(handler));
+}
+
+} // namespace network
+} // namespace libbitcoin
+
+#endif
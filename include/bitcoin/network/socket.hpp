@@ -24,13 +24,17 @@
 #include <bitcoin/bitcoin.hpp>
 #include <bitcoin/network/define.hpp>
 #include <bitcoin/network/locked_socket.hpp>
+#include <bitcoin/network/settings.hpp>
 
 namespace libbitcoin {
 namespace network {
 
 /// A thread safe asio socket.
+/// Once connected, socket operations are initiated and completed on the
+/// socket strand, which orders them without locking. The locked socket is
+/// used only while connecting or accepting, before the strand is in use.
 class BCT_API socket
-  : public track<socket>
+  : public enable_shared_from_base<socket>, track<socket>
 {
 public:
     typedef std::shared_ptr<socket> ptr;
@@ -45,14 +49,31 @@ public:
     /// Obtain an exclusive reference to the socket.
     locked_socket::ptr get_socket();
 
+    /// Obtain an unlocked reference to the socket.
+    /// This must only be used within the strand.
+    asio::socket& get();
+
+    /// The strand on which all connected socket operations execute.
+    asio::strand& strand();
+
+    /// The threadpool with which the socket was constructed.
+    threadpool& pool();
+
     /// Obtain the authority of the remote endpoint.
     config::authority get_authority() const;
 
+    /// Apply the configured options of the direction to the open socket.
+    virtual code set_options(const settings& settings, bool inbound);
+
     /// Close the contained socket.
     virtual void close();
 
 private:
+    void do_close();
+
+    threadpool& pool_;
     asio::socket socket_;
+    asio::strand strand_;
     mutable upgrade_mutex mutex_;
 };
 
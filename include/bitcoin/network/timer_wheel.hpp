@@ -0,0 +1,103 @@
+/**
+ * Copyright (c) 2011-2016 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NETWORK_TIMER_WHEEL_HPP
+#define LIBBITCOIN_NETWORK_TIMER_WHEEL_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/define.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+/// Coarse timers shared by all channels, thread and lock safe.
+/// Timers are hashed into the slots of a wheel that is swept once per tick,
+/// and a timer beyond one revolution waits out its remaining rounds, so that
+/// scheduling and cancelation are constant time and do not touch the asio
+/// timer queue. Expiry is accurate to one tick.
+class BCT_API timer_wheel
+  : public enable_shared_from_base<timer_wheel>
+{
+public:
+    typedef std::shared_ptr<timer_wheel> ptr;
+    typedef std::function<void(const code&)> handler;
+
+    /// Construct an instance.
+    timer_wheel(threadpool& pool, const asio::duration& tick, size_t slots);
+
+    /// This class is not copyable.
+    timer_wheel(const timer_wheel&) = delete;
+    void operator=(const timer_wheel&) = delete;
+
+    /// Start the sweep timer.
+    virtual void start();
+
+    /// Stop the sweep timer, pending handlers are invoked with stopped.
+    virtual void stop();
+
+    /// Invoke the handler once the delay elapses, rounded up to the tick.
+    /// Returns the identifier of the timer, for cancelation. If stopped the
+    /// handler is invoked immediately with stopped and zero is returned.
+    virtual uint64_t schedule(const asio::duration& delay, handler handler);
+
+    /// Cancel the timer, its handler is not invoked.
+    /// Returns false if the timer has expired or been canceled.
+    virtual bool cancel(uint64_t identifier);
+
+    /// Advance the wheel by one tick, invoking the handlers that expire.
+    virtual void advance();
+
+    /// The number of pending timers.
+    virtual size_t pending() const;
+
+private:
+    struct timer
+    {
+        size_t rounds;
+        handler notify;
+    };
+
+    typedef std::unordered_map<uint64_t, timer> slot;
+
+    void start_timer();
+    void handle_timer(const code& ec);
+
+    std::atomic<bool> stopped_;
+    deadline::ptr timer_;
+    const uint64_t tick_milliseconds_;
+
+    // These are protected by mutex.
+    std::vector<slot> slots_;
+    std::unordered_map<uint64_t, size_t> index_;
+    size_t cursor_;
+    uint64_t last_identifier_;
+    mutable shared_mutex mutex_;
+};
+
+} // namespace network
+} // namespace libbitcoin
+
+#endif
@@ -0,0 +1,79 @@
+/**
+ * Copyright (c) 2011-2016 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NETWORK_TOKEN_BUCKET_HPP
+#define LIBBITCOIN_NETWORK_TOKEN_BUCKET_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/define.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+/// A byte rate limiter, refilled continuously up to a burst, thread safe.
+/// Consumption may exceed the balance, and the resulting debt is repaid by
+/// refill before tokens are again available, so large messages are paced.
+class BCT_API token_bucket
+{
+public:
+    typedef std::shared_ptr<token_bucket> ptr;
+    typedef std::chrono::steady_clock clock;
+
+    /// Construct a full bucket, a zero rate does not limit.
+    token_bucket(size_t rate, size_t burst);
+
+    /// This class is not copyable.
+    token_bucket(const token_bucket&) = delete;
+    void operator=(const token_bucket&) = delete;
+
+    /// True if the bucket does not limit.
+    virtual bool unlimited() const;
+
+    /// True if the balance is positive.
+    virtual bool available();
+    virtual bool available(clock::time_point now);
+
+    /// Remove bytes from the balance, which may become negative.
+    virtual void consume(size_t bytes);
+    virtual void consume(size_t bytes, clock::time_point now);
+
+    /// The time until the balance is positive, zero if available.
+    virtual asio::duration delay();
+    virtual asio::duration delay(clock::time_point now);
+
+private:
+    void refill(clock::time_point now);
+
+    const int64_t rate_;
+    const int64_t burst_;
+
+    // These are protected by mutex.
+    int64_t tokens_;
+    clock::time_point updated_;
+    mutable shared_mutex mutex_;
+};
+
+} // namespace network
+} // namespace libbitcoin
+
+#endif
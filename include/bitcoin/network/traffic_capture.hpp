@@ -0,0 +1,103 @@
+/**
+ * Copyright (c) 2011-2016 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NETWORK_TRAFFIC_CAPTURE_HPP
+#define LIBBITCOIN_NETWORK_TRAFFIC_CAPTURE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <boost/filesystem.hpp>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/define.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+/// Appends received messages to a binary file, for replay.
+/// The file is a magic and version, then a record for each message of the
+/// receipt time in microseconds since the epoch, the sender ipv6 address and
+/// port, and the heading and payload as received. Integers are little endian.
+/// This class is thread safe.
+class BCT_API traffic_capture
+{
+public:
+    typedef std::shared_ptr<traffic_capture> ptr;
+
+    /// A message as captured.
+    struct record
+    {
+        uint64_t timestamp;
+        config::authority authority;
+        message::heading::buffer heading;
+        data_chunk payload;
+    };
+
+    /// The magic and version that begin a capture file.
+    static const uint32_t file_magic;
+    static const uint32_t file_version;
+
+    /// The bytes of a record that precede the heading.
+    static const size_t prefix_size;
+
+    /// Read the file header, false if not a capture of this version.
+    static bool read_header(std::istream& stream);
+
+    /// Read the next record, false at the end or if truncated or oversized.
+    static bool read(std::istream& stream, record& out);
+
+    /// Construct an instance, an empty path disables capture.
+    traffic_capture(const boost::filesystem::path& file);
+
+    /// This class is not copyable.
+    traffic_capture(const traffic_capture&) = delete;
+    void operator=(const traffic_capture&) = delete;
+
+    /// Open the file for append, writing the header if the file is new.
+    virtual code start();
+
+    /// Close the file, later writes are ignored.
+    virtual void stop();
+
+    /// True if messages are written, between start and stop.
+    virtual bool capturing() const;
+
+    /// Append a validated message, ignored unless capturing.
+    virtual void write(const config::authority& authority,
+        const message::heading& head, const uint8_t* payload);
+
+    /// The number of records written since construction.
+    virtual size_t count() const;
+
+private:
+    const boost::filesystem::path file_;
+    std::atomic<bool> capturing_;
+    std::atomic<size_t> count_;
+
+    // This is protected by mutex.
+    std::shared_ptr<bc::ofstream> stream_;
+    mutable shared_mutex mutex_;
+};
+
+} // namespace network
+} // namespace libbitcoin
+
+#endif
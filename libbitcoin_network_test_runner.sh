@@ -9,7 +9,7 @@
 # Define tests and options.
 #==============================================================================
 BOOST_UNIT_TEST_OPTIONS=\
-"--run_test=empty_tests "\
+"--run_test=empty_tests,admission_tests,anchors_tests,block_scheduler_tests,buffer_pool_tests,channel_inventory_tests,compact_messages_tests,dispatch_monitor_tests,handler_allocator_tests,hosts_tests,latency_histogram_tests,lifecycle_metrics_tests,memory_accounts_tests,message_cache_tests,message_checksum_tests,message_subscriber_tests,metrics_exporter_tests,outbound_reservations_tests,payload_streambuf_tests,reconnect_backoff_tests,rolling_filter_tests,slab_allocator_tests,timer_wheel_tests,token_bucket_tests,traffic_capture_tests "\
 "--show_progress=no "\
 "--detect_memory_leak=0 "\
 "--report_level=no "\
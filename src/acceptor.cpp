@@ -23,9 +23,12 @@
 #include <iostream>
 #include <memory>
 #include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/admission.hpp>
 #include <bitcoin/network/channel.hpp>
+#include <bitcoin/network/logging.hpp>
 #include <bitcoin/network/proxy.hpp>
 #include <bitcoin/network/settings.hpp>
+#include <bitcoin/network/slab_allocator.hpp>
 #include <bitcoin/network/socket.hpp>
 
 namespace libbitcoin {
@@ -37,10 +40,32 @@ using std::placeholders::_1;
 
 static const auto reuse_address = asio::acceptor::reuse_address(true);
 
-acceptor::acceptor(threadpool& pool, const settings& settings)
+#ifdef SO_REUSEPORT
+// The kernel balances incoming connections over the listeners of the port.
+typedef boost::asio::detail::socket_option::boolean<SOL_SOCKET,
+    SO_REUSEPORT> reuse_port_option;
+#endif
+
+#ifdef TCP_FASTOPEN
+// The value is the queue length of pending fast open requests.
+typedef boost::asio::detail::socket_option::integer<IPPROTO_TCP,
+    TCP_FASTOPEN> fast_open;
+#endif
+
+acceptor::acceptor(threadpool& pool, const settings& settings,
+    buffer_pool::ptr buffers, affinity_pool::ptr affinity,
+    admission::ptr admission, timer_wheel::ptr timers,
+    token_bucket::ptr uploads, memory_accounts::ptr memory,
+    dispatch_monitor::ptr dispatches)
   : pool_(pool),
     settings_(settings),
-    dispatch_(pool, NAME),
+    buffers_(buffers),
+    affinity_(affinity),
+    admission_(admission),
+    timers_(timers),
+    uploads_(uploads),
+    memory_(memory),
+    dispatch_(pool, NAME, dispatches),
     acceptor_(std::make_shared<asio::acceptor>(pool_.service())),
     CONSTRUCT_TRACK(acceptor)
 {
@@ -70,14 +95,26 @@ void acceptor::stop()
 // ----------------------------------------------------------------------------
 
 // public:
-// This is hardwired to listen on IPv6.
+// This listens on IPv6, which also accepts mapped IPv4 where supported.
 void acceptor::listen(uint16_t port, result_handler handler)
 {
+    listen({ asio::ipv6(), port }, false, handler);
+}
+
+// public:
+void acceptor::listen(const config::authority& bind, bool reuse_port,
+    result_handler handler)
+{
+    // An IPv4 address is bound as such, not as its mapped IPv6 form.
+    const auto ip = bind.ip();
+    const auto address = ip.is_v4_mapped() ? asio::address(ip.to_v4()) :
+        asio::address(ip);
+
     // This is the end of the listen sequence.
-    handler(safe_listen(port));
+    handler(safe_listen(asio::endpoint(address, bind.port()), reuse_port));
 }
 
-code acceptor::safe_listen(uint16_t port)
+code acceptor::safe_listen(const asio::endpoint& endpoint, bool reuse_port)
 {
     // Critical Section
     ///////////////////////////////////////////////////////////////////////////
@@ -86,14 +123,38 @@ code acceptor::safe_listen(uint16_t port)
     if (acceptor_->is_open())
         return error::operation_failed;
 
-    boost_code error;
-    asio::endpoint endpoint(asio::tcp::v6(), settings_.inbound_port);
+#ifndef SO_REUSEPORT
+    // Rejected before the open, so the acceptor is not left open.
+    if (reuse_port)
+        return error::operation_failed;
+#endif
 
+    boost_code error;
     acceptor_->open(endpoint.protocol(), error);
 
     if (!error)
         acceptor_->set_option(reuse_address, error);
 
+#ifdef SO_REUSEPORT
+    if (!error && reuse_port)
+        acceptor_->set_option(reuse_port_option(true), error);
+#endif
+
+    // Accepted sockets inherit the receive buffer, sized before the listen
+    // so that the window scale of the handshake reflects it.
+    const auto receive_bytes = settings_.inbound_receive_buffer_bytes;
+
+    if (!error && receive_bytes != 0)
+        acceptor_->set_option(
+            asio::socket::receive_buffer_size(receive_bytes), error);
+
+#ifdef TCP_FASTOPEN
+    const auto fast_open_queue = settings_.inbound_fast_open_queue;
+
+    if (!error && fast_open_queue != 0)
+        acceptor_->set_option(fast_open(fast_open_queue), error);
+#endif
+
     if (!error)
         acceptor_->bind(endpoint, error);
 
@@ -122,7 +183,9 @@ void acceptor::accept(accept_handler handler)
         return;
     }
 
-    const auto socket = std::make_shared<network::socket>(pool_);
+    // The socket, and then its channel, are assigned to one service thread.
+    const auto socket = std::allocate_shared<network::socket>(
+        slab_allocator<network::socket>(), affinity_->next());
     safe_accept(socket, handler);
 
     mutex_.unlock();
@@ -145,16 +208,45 @@ void acceptor::safe_accept(socket::ptr socket, accept_handler handler)
 void acceptor::handle_accept(const boost_code& ec, socket::ptr socket,
     accept_handler handler)
 {
-    // This is the end of the accept sequence.
     if (ec)
+    {
         handler(error::boost_to_error_code(ec), nullptr);
-    else
-        handler(error::success, new_channel(socket));
+        return;
+    }
+
+    const auto peer = socket->get_authority();
+    const auto result = admission_->admit(peer);
+
+    if (result)
+    {
+        LOG_DEBUG(LOG_NETWORK)
+            << "Rejected inbound connection from [" << peer << "] "
+            << result.message();
+
+        // The rejected socket is dropped and the accept is retried, so that
+        // a connection flood does not cycle through the session.
+        socket->close();
+        accept(handler);
+        return;
+    }
+
+    const auto options = socket->set_options(settings_, true);
+
+    // Option failure is not fatal, the connection remains usable.
+    if (options)
+        LOG_DEBUG(LOG_NETWORK)
+            << "Failure setting inbound socket options for [" << peer << "] "
+            << options.message();
+
+    // This is the end of the accept sequence.
+    handler(error::success, new_channel(socket));
 }
 
 std::shared_ptr<channel> acceptor::new_channel(socket::ptr socket)
 {
-    return std::make_shared<channel>(pool_, socket, settings_);
+    return std::allocate_shared<channel>(slab_allocator<channel>(),
+        socket->pool(), socket, settings_, buffers_, timers_, uploads_,
+        memory_);
 }
 
 } // namespace network
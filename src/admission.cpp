@@ -0,0 +1,307 @@
+/**
+ * Copyright (c) 2011-2016 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/network/admission.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <utility>
+#include <vector>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/channel.hpp>
+#include <bitcoin/network/connections.hpp>
+#include <bitcoin/network/logging.hpp>
+#include <bitcoin/network/netgroup.hpp>
+#include <bitcoin/network/settings.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+using namespace bc::config;
+using namespace bc::message;
+
+// The number of subnets tracked before refilled buckets are purged.
+static constexpr size_t bucket_limit = 4096;
+
+// The number of inbound channels protected from eviction by each metric.
+static constexpr size_t protected_by_ping = 4;
+static constexpr size_t protected_by_useful = 4;
+
+admission::admission(const settings& settings, connections::ptr connections,
+    memory_accounts::ptr memory)
+  : settings_(settings),
+    connection_limit_(settings.inbound_connections +
+        settings.outbound_connections),
+    rate_(settings.inbound_subnet_accepts / 60.0),
+    connections_(connections),
+    memory_(memory)
+{
+}
+
+// An IPv4 /24 is distinct from any IPv6 /48 in the global unicast range.
+admission::subnet admission::to_subnet(const authority& peer)
+{
+    const auto ip = peer.ip();
+    const auto bytes = ip.to_bytes();
+    const auto start = ip.is_v4_mapped() ? bytes.begin() + 9 : bytes.begin();
+
+    subnet out;
+    std::copy(start, start + out.size(), out.begin());
+
+    if (ip.is_v4_mapped())
+        out[0] = out[1] = out[2] = 0;
+
+    return out;
+}
+
+code admission::admit(const authority& peer)
+{
+    if (blacklisted(peer))
+        return error::address_blocked;
+
+    // Over the memory limit a peer is refused, not exchanged for another.
+    if (memory_->exhausted())
+        return error::accept_failed;
+
+    size_t count = 0;
+    connections_->count([&count](size_t value) { count = value; });
+
+    const auto full = count >= connection_limit_;
+
+    if (full && !settings_.inbound_eviction)
+        return error::accept_failed;
+
+    // The rate limit precedes eviction, so a flood cannot cycle the slots.
+    if (throttled(peer))
+        return error::address_blocked;
+
+    if (full && !evict())
+        return error::accept_failed;
+
+    return error::success;
+}
+
+// Eviction.
+// ----------------------------------------------------------------------------
+
+bool admission::evict()
+{
+    std::vector<channel::ptr> channels;
+    candidate::list candidates;
+
+    const auto visitor = [&](channel::ptr channel)
+    {
+        if (!channel->inbound())
+            return;
+
+        const auto metrics = channel->metrics().copy();
+        const auto& bytes = metrics.received.bytes_by_type;
+        const auto useful =
+            bytes[static_cast<size_t>(message_type::block)] +
+            bytes[static_cast<size_t>(message_type::transaction)] +
+            bytes[static_cast<size_t>(message_type::headers)];
+
+        candidates.push_back(
+        {
+            to_netgroup(channel->authority()),
+            metrics.ping_minimum_microseconds,
+            useful,
+            metrics.connected_milliseconds
+        });
+
+        channels.push_back(channel);
+    };
+
+    connections_->visit(visitor);
+    const auto index = select_eviction(candidates);
+
+    if (index == candidates.size())
+        return false;
+
+    LOG_DEBUG(LOG_NETWORK)
+        << "Evicting inbound channel [" << channels[index]->authority()
+        << "] for a new connection.";
+
+    // The slot is released when the channel stop completes its removal.
+    // Eviction is reported as a stop, so it is not mistaken for a timeout.
+    channels[index]->stop(error::channel_stopped);
+    return true;
+}
+
+// Protect the best of the remaining candidates by the given ordering.
+template <typename Better>
+static void protect(std::vector<size_t>& remaining, size_t count,
+    Better better)
+{
+    count = std::min(count, remaining.size());
+    std::partial_sort(remaining.begin(), remaining.begin() + count,
+        remaining.end(), better);
+    remaining.erase(remaining.begin(), remaining.begin() + count);
+}
+
+// static
+size_t admission::select_eviction(const candidate::list& candidates)
+{
+    std::vector<size_t> remaining(candidates.size());
+
+    for (size_t index = 0; index < remaining.size(); ++index)
+        remaining[index] = index;
+
+    // An unmeasured ping is not protected by latency.
+    const auto by_ping = [&candidates](size_t left, size_t right)
+    {
+        const auto& first = candidates[left].ping_microseconds;
+        const auto& second = candidates[right].ping_microseconds;
+        return first != 0 && (second == 0 || first < second);
+    };
+
+    const auto by_useful = [&candidates](size_t left, size_t right)
+    {
+        return candidates[left].useful_bytes > candidates[right].useful_bytes;
+    };
+
+    const auto by_age = [&candidates](size_t left, size_t right)
+    {
+        return candidates[left].connected_milliseconds >
+            candidates[right].connected_milliseconds;
+    };
+
+    protect(remaining, protected_by_ping, by_ping);
+    protect(remaining, protected_by_useful, by_useful);
+    protect(remaining, remaining.size() / 2, by_age);
+
+    if (remaining.empty())
+        return candidates.size();
+
+    // Count each group and find its youngest member.
+    std::map<network::netgroup, std::pair<size_t, size_t>> groups;
+
+    for (const auto index: remaining)
+    {
+        const auto& entry = candidates[index];
+        auto it = groups.find(entry.netgroup);
+
+        if (it == groups.end())
+        {
+            groups.emplace(entry.netgroup, std::make_pair(1, index));
+            continue;
+        }
+
+        auto& group = it->second;
+        ++group.first;
+
+        if (entry.connected_milliseconds <
+            candidates[group.second].connected_milliseconds)
+            group.second = index;
+    }
+
+    // The most populous group, ties to the group of the youngest member.
+    auto selected = groups.begin();
+
+    for (auto it = groups.begin(); it != groups.end(); ++it)
+    {
+        const auto& group = it->second;
+        const auto& best = selected->second;
+
+        if (group.first > best.first || (group.first == best.first &&
+            candidates[group.second].connected_milliseconds <
+            candidates[best.second].connected_milliseconds))
+            selected = it;
+    }
+
+    return selected->second.second;
+}
+
+bool admission::blacklisted(const authority& peer) const
+{
+    const auto& blocked = settings_.blacklists;
+    const auto it = std::find(blocked.begin(), blocked.end(), peer);
+    return it != blocked.end();
+}
+
+bool admission::throttled(const authority& peer)
+{
+    if (settings_.inbound_subnet_accepts == 0)
+        return false;
+
+    const auto now = clock::now();
+    const auto key = to_subnet(peer);
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    auto it = buckets_.find(key);
+
+    if (it == buckets_.end())
+    {
+        if (buckets_.size() >= bucket_limit)
+            safe_purge(now);
+
+        const bucket full{ double(settings_.inbound_subnet_accepts), now };
+        it = buckets_.emplace(key, full).first;
+    }
+
+    auto& entry = it->second;
+    safe_refill(entry, now);
+
+    if (entry.tokens < 1.0)
+        return true;
+
+    entry.tokens -= 1.0;
+    return false;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// Must be called under a unique lock.
+void admission::safe_refill(bucket& entry, clock::time_point now) const
+{
+    typedef std::chrono::duration<double> seconds;
+    const auto elapsed = std::chrono::duration_cast<seconds>(
+        now - entry.updated).count();
+
+    const double capacity = settings_.inbound_subnet_accepts;
+    entry.tokens = std::min(capacity, entry.tokens + elapsed * rate_);
+    entry.updated = now;
+}
+
+// Must be called under a unique lock.
+void admission::safe_purge(clock::time_point now)
+{
+    // Full buckets hold no state beyond that of a new bucket.
+    for (auto it = buckets_.begin(); it != buckets_.end();)
+    {
+        safe_refill(it->second, now);
+
+        if (it->second.tokens >= settings_.inbound_subnet_accepts)
+            it = buckets_.erase(it);
+        else
+            ++it;
+    }
+
+    // A flood of distinct subnets must not grow the table without bound.
+    if (buckets_.size() >= bucket_limit)
+        buckets_.clear();
+}
+
+} // namespace network
+} // namespace libbitcoin
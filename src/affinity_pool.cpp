@@ -0,0 +1,81 @@
+/**
+ * Copyright (c) 2011-2016 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/network/affinity_pool.hpp>
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include <bitcoin/bitcoin.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+static std::vector<std::unique_ptr<threadpool>> create_pools(size_t count)
+{
+    std::vector<std::unique_ptr<threadpool>> pools;
+    pools.reserve(count);
+
+    // Threads are not started until spawn.
+    for (size_t pool = 0; pool < count; ++pool)
+        pools.emplace_back(new threadpool);
+
+    return pools;
+}
+
+affinity_pool::affinity_pool(threadpool& shared, size_t count)
+  : shared_(shared),
+    pools_(create_pools(count)),
+    next_(0)
+{
+}
+
+size_t affinity_pool::size() const
+{
+    return pools_.size();
+}
+
+threadpool& affinity_pool::next()
+{
+    if (pools_.empty())
+        return shared_;
+
+    return *pools_[next_++ % pools_.size()];
+}
+
+void affinity_pool::spawn(thread_priority priority)
+{
+    for (const auto& pool: pools_)
+        pool->spawn(1, priority);
+}
+
+void affinity_pool::shutdown()
+{
+    for (const auto& pool: pools_)
+        pool->shutdown();
+}
+
+void affinity_pool::join()
+{
+    for (const auto& pool: pools_)
+        pool->join();
+}
+
+} // namespace network
+} // namespace libbitcoin
@@ -0,0 +1,82 @@
+/**
+ * Copyright (c) 2011-2016 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/network/anchors.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <boost/filesystem.hpp>
+#include <bitcoin/bitcoin.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+anchors::anchors(const boost::filesystem::path& file, size_t capacity)
+  : file_(file),
+    capacity_(capacity)
+{
+}
+
+code anchors::load(config::authority::list& out) const
+{
+    out.clear();
+
+    if (capacity_ == 0)
+        return error::success;
+
+    bc::ifstream file(file_.string());
+    if (!file.good())
+        return error::success;
+
+    std::string line;
+    while (out.size() < capacity_ && std::getline(file, line))
+    {
+        config::authority host(line);
+        if (host.port() != 0)
+            out.push_back(host);
+    }
+
+    file.close();
+
+    // A crash after restart must not redial anchors that may be stale.
+    boost::system::error_code ec;
+    boost::filesystem::remove(file_, ec);
+    return ec ? error::file_system : error::success;
+}
+
+code anchors::save(const config::authority::list& anchors) const
+{
+    if (capacity_ == 0)
+        return error::success;
+
+    bc::ofstream file(file_.string(), std::ios::trunc);
+    if (!file.good())
+        return error::file_system;
+
+    const auto count = std::min(anchors.size(), capacity_);
+
+    for (size_t index = 0; index < count; ++index)
+        file << anchors[index] << std::endl;
+
+    return file.good() ? error::success : error::file_system;
+}
+
+} // namespace network
+} // namespace libbitcoin
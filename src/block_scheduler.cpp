@@ -0,0 +1,388 @@
+/**
+ * Copyright (c) 2011-2016 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/network/block_scheduler.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/settings.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+// One peer may claim at most this multiple of the base share of the window.
+static constexpr size_t share_limit = 4;
+
+block_scheduler::block_scheduler(const settings& settings)
+  : window_(settings.download_window_blocks),
+    peer_blocks_(settings.download_peer_blocks),
+    stall_(std::chrono::seconds(settings.download_stall_seconds)),
+    active_(false),
+    last_header_(null_hash),
+    claimed_(false),
+    header_peer_(0),
+    header_pending_(false),
+    sequence_(0)
+{
+}
+
+void block_scheduler::reset(const hash_list& locator)
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    // Blocks outstanding from a prior download are not completed when late.
+    active_ = true;
+    locator_ = locator;
+    last_header_ = null_hash;
+    claimed_ = false;
+    header_pending_ = false;
+    header_stalled_.clear();
+    sequence_ = 0;
+    queue_.clear();
+    requests_.clear();
+
+    for (auto& peer: peers_)
+        peer.second.outstanding = 0;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+bool block_scheduler::active() const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    shared_lock lock(mutex_);
+
+    return active_;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+size_t block_scheduler::queued() const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    shared_lock lock(mutex_);
+
+    return queue_.size();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+size_t block_scheduler::outstanding() const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    shared_lock lock(mutex_);
+
+    return requests_.size();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+size_t block_scheduler::outstanding(uint64_t peer) const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    shared_lock lock(mutex_);
+
+    const auto it = peers_.find(peer);
+    return it == peers_.end() ? 0 : it->second.outstanding;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+double block_scheduler::rate(uint64_t peer) const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    shared_lock lock(mutex_);
+
+    const auto it = peers_.find(peer);
+    return it == peers_.end() ? 0.0 : it->second.rate;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// Headers.
+// ----------------------------------------------------------------------------
+
+bool block_scheduler::claim_headers(uint64_t peer)
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    if (!active_ || claimed_ || header_stalled_.count(peer) != 0)
+        return false;
+
+    claimed_ = true;
+    header_peer_ = peer;
+    header_pending_ = false;
+    return true;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+bool block_scheduler::header_peer(uint64_t peer) const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    shared_lock lock(mutex_);
+
+    return claimed_ && header_peer_ == peer;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+hash_list block_scheduler::request_headers(uint64_t peer)
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    if (!claimed_ || header_peer_ != peer)
+        return{};
+
+    header_pending_ = true;
+    header_requested_ = clock::now();
+
+    // Once headers are accepted the download continues from the last.
+    return last_header_ == null_hash ? locator_ : hash_list{ last_header_ };
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+code block_scheduler::store_headers(uint64_t peer,
+    const chain::header::list& headers)
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    if (!claimed_ || header_peer_ != peer)
+        return error::not_found;
+
+    header_pending_ = false;
+
+    if (headers.empty())
+        return error::success;
+
+    // The first header must descend from the locator or the last header.
+    auto previous = headers.front().previous_block_hash;
+    const auto linked = last_header_ == null_hash ?
+        std::find(locator_.begin(), locator_.end(), previous) !=
+            locator_.end() : previous == last_header_;
+
+    hash_list hashes;
+    hashes.reserve(headers.size());
+
+    for (const auto& header: headers)
+    {
+        if (!linked || header.previous_block_hash != previous)
+        {
+            // The peer is not given the header role again.
+            claimed_ = false;
+            header_stalled_.insert(peer);
+            return error::bad_stream;
+        }
+
+        previous = header.hash();
+        hashes.push_back(previous);
+    }
+
+    for (const auto& hash: hashes)
+        queue_.emplace(sequence_++, hash);
+
+    last_header_ = previous;
+    return error::success;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// Blocks.
+// ----------------------------------------------------------------------------
+
+hash_list block_scheduler::allocate(uint64_t peer)
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    if (!active_ || queue_.empty())
+        return{};
+
+    auto& state = peers_[peer];
+    const auto quota = safe_quota(state);
+    const auto capacity = window_ - std::min(window_, requests_.size());
+
+    if (state.outstanding >= quota || capacity == 0)
+        return{};
+
+    const auto count = std::min({ quota - state.outstanding, capacity,
+        queue_.size() });
+
+    hash_list hashes;
+    hashes.reserve(count);
+    const auto now = clock::now();
+
+    // The lowest blocks are requested first, so the window slides upward.
+    while (hashes.size() < count)
+    {
+        const auto next = queue_.begin();
+        requests_[next->second] = { next->first, peer, now };
+        hashes.push_back(next->second);
+        queue_.erase(next);
+    }
+
+    state.outstanding += count;
+    return hashes;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+bool block_scheduler::complete(uint64_t peer, const hash_digest& hash,
+    size_t bytes)
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    const auto it = requests_.find(hash);
+
+    if (it == requests_.end())
+        return false;
+
+    // A block reassigned after a stall may arrive from the original peer.
+    const auto owner = peers_.find(it->second.peer);
+    if (owner != peers_.end() && owner->second.outstanding > 0)
+        --owner->second.outstanding;
+
+    const auto now = clock::now();
+    auto& state = peers_[peer];
+
+    // Pipelined requests are measured from the prior receipt.
+    const auto start = std::max(it->second.time, state.last);
+    const auto seconds = std::chrono::duration<double>(now - start).count();
+    requests_.erase(it);
+    state.last = now;
+
+    if (seconds > 0)
+    {
+        // The rate is an exponential moving average of receipts.
+        const auto sample = bytes / seconds;
+        state.rate = state.rate == 0 ? sample : (3 * state.rate + sample) / 4;
+    }
+
+    return true;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+size_t block_scheduler::expire(uint64_t peer)
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    const auto now = clock::now();
+
+    if (claimed_ && header_peer_ == peer && header_pending_ &&
+        now - header_requested_ >= stall_)
+    {
+        claimed_ = false;
+        header_pending_ = false;
+        header_stalled_.insert(peer);
+    }
+
+    const auto count = safe_return(peer, true, now);
+
+    // A stalled peer is allocated less work until it recovers.
+    if (count > 0)
+        peers_[peer].rate /= 2;
+
+    return count;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void block_scheduler::remove(uint64_t peer)
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    if (claimed_ && header_peer_ == peer)
+        claimed_ = false;
+
+    safe_return(peer, false, clock::now());
+    header_stalled_.erase(peer);
+    peers_.erase(peer);
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// Must be called under a unique lock.
+size_t block_scheduler::safe_quota(const peer_state& peer) const
+{
+    // An unmeasured peer is allocated the base share.
+    if (peer.rate == 0)
+        return peer_blocks_;
+
+    size_t measured = 0;
+    auto total = 0.0;
+
+    for (const auto& entry: peers_)
+    {
+        if (entry.second.rate > 0)
+        {
+            total += entry.second.rate;
+            ++measured;
+        }
+    }
+
+    const auto mean = total / measured;
+    const auto share = static_cast<size_t>(peer_blocks_ * peer.rate / mean);
+    return std::max(size_t(1), std::min(share, share_limit * peer_blocks_));
+}
+
+// Must be called under a unique lock.
+// Returned hashes resume their place in the queue, ahead of later blocks.
+size_t block_scheduler::safe_return(uint64_t peer, bool stalled_only,
+    clock::time_point now)
+{
+    size_t count = 0;
+
+    for (auto it = requests_.begin(); it != requests_.end();)
+    {
+        const auto& entry = it->second;
+
+        if (entry.peer != peer || (stalled_only && now - entry.time < stall_))
+        {
+            ++it;
+            continue;
+        }
+
+        queue_.emplace(entry.sequence, it->first);
+        it = requests_.erase(it);
+        ++count;
+    }
+
+    const auto state = peers_.find(peer);
+    if (state != peers_.end())
+        state->second.outstanding -= std::min(count,
+            state->second.outstanding);
+
+    return count;
+}
+
+} // namespace network
+} // namespace libbitcoin
@@ -0,0 +1,203 @@
+/**
+ * Copyright (c) 2011-2016 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/network/buffer_pool.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <bitcoin/bitcoin.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+using std::placeholders::_1;
+
+// The smallest class holds 256 bytes, the largest holds 16MB (10MB max).
+static constexpr size_t minimum_class_bits = 8;
+static constexpr size_t class_count = 17;
+
+buffer_pool::buffer_pool(size_t class_high_water_bytes)
+  : high_water_(class_high_water_bytes),
+    oversized_(0),
+    classes_(class_count)
+{
+    for (size_t index = 0; index < class_count; ++index)
+        classes_[index].counters = { to_capacity(index), 0, 0, 0, 0, 0 };
+}
+
+// Size classes.
+// ----------------------------------------------------------------------------
+
+// Returns class_count for a size that exceeds the largest class.
+size_t buffer_pool::to_class(size_t size)
+{
+    size_t index = 0;
+    while (index < class_count && to_capacity(index) < size)
+        ++index;
+
+    return index;
+}
+
+size_t buffer_pool::to_capacity(size_t index)
+{
+    return size_t(1) << (minimum_class_bits + index);
+}
+
+// Borrow sequence.
+// ----------------------------------------------------------------------------
+
+buffer_pool::buffer buffer_pool::borrow(size_t size)
+{
+    const auto index = to_class(size);
+
+    // Oversized buffers are not retained by the pool.
+    if (index == class_count)
+    {
+        // Critical Section
+        ///////////////////////////////////////////////////////////////////////
+        unique_lock lock(mutex_);
+        ++oversized_;
+        ///////////////////////////////////////////////////////////////////////
+
+        return std::make_shared<data_chunk>(size);
+    }
+
+    auto chunk = safe_take(index);
+    chunk->resize(size);
+
+    // The deleter holds the pool weakly so buffers may outlive the pool.
+    const std::weak_ptr<buffer_pool> pool = shared_from_this();
+    return buffer(chunk.release(), std::bind(&buffer_pool::release, pool, _1));
+}
+
+buffer_pool::chunk_ptr buffer_pool::safe_take(size_t index)
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    auto& pool = classes_[index];
+    ++pool.counters.borrowed;
+
+    if (pool.free.empty())
+    {
+        lock.unlock();
+        ///////////////////////////////////////////////////////////////////////
+
+        // Allocate outside of the critical section.
+        chunk_ptr chunk(new data_chunk);
+        chunk->reserve(to_capacity(index));
+        return chunk;
+    }
+
+    auto chunk = std::move(pool.free.back());
+    pool.free.pop_back();
+    ++pool.counters.reused;
+    --pool.counters.retained;
+    return chunk;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// Release sequence.
+// ----------------------------------------------------------------------------
+
+// static
+void buffer_pool::release(std::weak_ptr<buffer_pool> pool, data_chunk* chunk)
+{
+    chunk_ptr owned(chunk);
+    const auto self = pool.lock();
+
+    // The pool has been destroyed, so the buffer is freed here.
+    if (!self)
+        return;
+
+    // Restore to the largest class that the chunk capacity satisfies.
+    const auto capacity = owned->capacity();
+    auto index = to_class(capacity);
+
+    if (index == class_count || to_capacity(index) > capacity)
+    {
+        // The chunk may have been grown beyond its class by the borrower.
+        if (index == 0 || index == class_count)
+            return;
+
+        --index;
+    }
+
+    self->safe_restore(index, std::move(owned));
+}
+
+void buffer_pool::safe_restore(size_t index, chunk_ptr chunk)
+{
+    // Never retain less than one buffer unless retention is disabled.
+    const auto capacity = to_capacity(index);
+    const auto limit = high_water_ == 0 ? 0 :
+        std::max(size_t(1), high_water_ / capacity);
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    auto& pool = classes_[index];
+    ++pool.counters.returned;
+
+    if (pool.free.size() >= limit)
+    {
+        ++pool.counters.discarded;
+        lock.unlock();
+        ///////////////////////////////////////////////////////////////////////
+
+        // The chunk is freed outside of the critical section.
+        chunk.reset();
+        return;
+    }
+
+    pool.free.push_back(std::move(chunk));
+    ++pool.counters.retained;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// Properties.
+// ----------------------------------------------------------------------------
+
+buffer_pool::statistics buffer_pool::pool_statistics() const
+{
+    statistics result{ {}, 0, 0 };
+    result.classes.reserve(class_count);
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    shared_lock lock(mutex_);
+
+    for (const auto& pool: classes_)
+    {
+        result.classes.push_back(pool.counters);
+        result.retained_bytes += pool.counters.retained *
+            pool.counters.capacity;
+    }
+
+    result.oversized = oversized_;
+    return result;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+} // namespace network
+} // namespace libbitcoin
@@ -20,11 +20,14 @@
 #include <bitcoin/network/channel.hpp>
 
 #include <atomic>
+#include <chrono>
 #include <cstddef>
 #include <cstdint>
 #include <functional>
 #include <memory>
 #include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/channel_metrics.hpp>
+#include <bitcoin/network/logging.hpp>
 #include <bitcoin/network/proxy.hpp>
 #include <bitcoin/network/settings.hpp>
 #include <bitcoin/network/socket.hpp>
@@ -33,27 +36,47 @@ namespace libbitcoin {
 namespace network {
 
 using std::placeholders::_1;
+using std::placeholders::_2;
 
-// Factory for deadline timer pointer construction.
-static deadline::ptr alarm(threadpool& pool, const asio::duration& duration)
-{
-    return std::make_shared<deadline>(pool, pseudo_randomize(duration));
-}
+// The nonce is cleared once the handshake completes, so it cannot key state
+// that outlives the handshake.
+static std::atomic<uint64_t> identifiers(0);
 
 channel::channel(threadpool& pool, socket::ptr socket,
-    const settings& settings)
-  : proxy(pool, socket, settings.identifier),
+    const settings& settings, buffer_pool::ptr buffers,
+    timer_wheel::ptr timers, token_bucket::ptr uploads,
+    memory_accounts::ptr memory)
+  : proxy(pool, socket, settings, buffers, uploads, memory),
     notify_(false),
+    inbound_(false),
     nonce_(0),
+    identifier_(++identifiers),
     version_({ 0 }),
     own_threshold_(null_hash),
     peer_threshold_(null_hash),
     located_start_(null_hash),
     located_stop_(null_hash),
-    expiration_(alarm(pool, settings.channel_expiration())),
-    inactivity_(alarm(pool, settings.channel_inactivity())),
+    timers_(timers),
+    memory_(memory),
+    expiration_(pseudo_randomize(settings.channel_expiration())),
+    inactivity_(pseudo_randomize(settings.channel_inactivity())),
+    expiration_timer_(0),
+    inactivity_timer_(0),
+    inventory_(settings.channel_known_inventory),
+    minimum_throughput_(settings.channel_minimum_throughput),
+    stall_interval_(std::chrono::seconds(settings.channel_stall_seconds)),
+    outstanding_(0),
+    sample_start_(channel_metrics::clock::now()),
+    sample_bytes_(0),
     CONSTRUCT_TRACK(channel)
 {
+    timeline_.connected = lifecycle_metrics::clock::now();
+    memory_->add(memory_accounts::category::channels, sizeof(channel));
+}
+
+channel::~channel()
+{
+    memory_->remove(memory_accounts::category::channels, sizeof(channel));
 }
 
 // Talk sequence.
@@ -71,7 +94,22 @@ void channel::start(result_handler handler)
 void channel::do_start(const code& ec, result_handler handler)
 {
     start_expiration();
-    start_inactivity();
+    start_inactivity(inactivity_);
+
+    // These mark the inventory known, they do not solicit the messages.
+    subscribe_own<message::inventory>(
+        std::bind(&channel::handle_inventory,
+            shared_from_base<channel>(), _1, _2));
+
+    // Transactions arrive in bursts, so each burst is marked known at once.
+    subscribe_own_batch<message::transaction>(
+        std::bind(&channel::handle_transactions,
+            shared_from_base<channel>(), _1, _2));
+
+    subscribe_own<message::block>(
+        std::bind(&channel::handle_block,
+            shared_from_base<channel>(), _1, _2));
+
     handler(error::success);
 }
 
@@ -88,6 +126,16 @@ void channel::set_notify(bool value)
     notify_ = value;
 }
 
+bool channel::inbound() const
+{
+    return inbound_;
+}
+
+void channel::set_inbound(bool value)
+{
+    inbound_ = value;
+}
+
 uint64_t channel::nonce() const
 {
     return nonce_;
@@ -98,6 +146,11 @@ void channel::set_nonce(uint64_t value)
     nonce_ = value;
 }
 
+uint64_t channel::identifier() const
+{
+    return identifier_;
+}
+
 const message::version& channel::version() const
 {
     return version_;
@@ -134,60 +187,127 @@ void channel::set_peer_threshold(const hash_digest& threshold)
 // It is possible that this may be called multipled times.
 void channel::handle_stopping()
 {
-    expiration_->stop();
-    inactivity_->stop();
+    timers_->cancel(expiration_timer_.load());
+    timers_->cancel(inactivity_timer_.load());
 }
 
+// Activity is timestamped by the metrics, so no timer is restarted here.
 void channel::handle_activity()
 {
-    start_inactivity();
+    check_throughput();
 }
 
 // Timers (these are inherent races, requiring stranding by stop only).
 // ----------------------------------------------------------------------------
+// The timers are coarse, shared by all channels and accurate to a tick.
 
 void channel::start_expiration()
 {
     if (stopped())
         return;
 
-    expiration_->start(
+    expiration_timer_.store(timers_->schedule(expiration_,
         std::bind(&channel::handle_expiration,
-            shared_from_base<channel>(), _1));
+            shared_from_base<channel>(), _1)));
+
+    // A stop between the test and the store did not cancel this timer.
+    if (stopped())
+        timers_->cancel(expiration_timer_.load());
 }
 
 void channel::handle_expiration(const code& ec)
 {
-    if (stopped())
+    if (ec || stopped())
         return;
 
-    log::debug(LOG_NETWORK)
+    LOG_DEBUG(LOG_NETWORK)
         << "Channel lifetime expired [" << authority() << "]";
 
     stop(error::channel_timeout);
 }
 
-void channel::start_inactivity()
+void channel::start_inactivity(const asio::duration& delay)
 {
     if (stopped())
         return;
 
-    inactivity_->start(
+    inactivity_timer_.store(timers_->schedule(delay,
         std::bind(&channel::handle_inactivity,
-            shared_from_base<channel>(), _1));
+            shared_from_base<channel>(), _1)));
+
+    // A stop between the test and the store did not cancel this timer.
+    if (stopped())
+        timers_->cancel(inactivity_timer_.load());
 }
 
+// Activity since the timer was set defers the timeout to its remainder.
 void channel::handle_inactivity(const code& ec)
 {
-    if (stopped())
+    if (ec || stopped())
+        return;
+
+    const auto idle = asio::milliseconds(std::chrono::duration_cast<
+        std::chrono::milliseconds>(metrics().idle()).count());
+
+    if (idle < inactivity_)
+    {
+        start_inactivity(inactivity_ - idle);
         return;
+    }
 
-    log::debug(LOG_NETWORK)
+    LOG_DEBUG(LOG_NETWORK)
         << "Channel inactivity timeout [" << authority() << "]";
 
     stop(error::channel_timeout);
 }
 
+// Stall detection.
+// ----------------------------------------------------------------------------
+
+void channel::set_outstanding(size_t requests)
+{
+    outstanding_.store(requests);
+}
+
+// A peer that trickles small messages is never inactive, so throughput is
+// sampled over each stall interval in which requests remain outstanding.
+void channel::check_throughput()
+{
+    if (minimum_throughput_ == 0 || stall_interval_.count() == 0)
+        return;
+
+    const auto now = channel_metrics::clock::now();
+    const auto received = metrics().received_bytes();
+
+    // A sample begins only once there is something to wait for.
+    if (outstanding_.load() == 0)
+    {
+        sample_start_ = now;
+        sample_bytes_ = received;
+        return;
+    }
+
+    const auto elapsed = now - sample_start_;
+
+    if (elapsed < stall_interval_)
+        return;
+
+    const auto seconds = std::chrono::duration_cast<std::chrono::seconds>(
+        elapsed).count();
+    const auto rate = (received - sample_bytes_) / seconds;
+    sample_start_ = now;
+    sample_bytes_ = received;
+
+    if (rate >= minimum_throughput_)
+        return;
+
+    LOG_DEBUG(LOG_NETWORK)
+        << "Channel stalled [" << authority() << "] (" << rate
+        << " bytes/sec)";
+
+    stop(error::channel_timeout);
+}
+
 // Location tracking (thread unsafe, deprecated).
 // ----------------------------------------------------------------------------
 
@@ -202,5 +322,59 @@ void channel::set_located(const hash_digest& start, const hash_digest& stop)
     located_stop_ = stop;
 }
 
+channel_inventory& channel::inventory()
+{
+    return inventory_;
+}
+
+lifecycle_metrics::timeline& channel::timeline()
+{
+    return timeline_;
+}
+
+// Known inventory sequence.
+// ----------------------------------------------------------------------------
+// What the peer sends it has, so it is never announced back to the peer.
+
+bool channel::handle_inventory(const code& ec,
+    message::inventory::ptr message)
+{
+    if (ec)
+        return false;
+
+    inventory_.add_known(message->inventories);
+    return true;
+}
+
+bool channel::handle_transactions(const code& ec,
+    message_subscriber::batch_ptr<message::transaction> messages)
+{
+    if (ec)
+        return false;
+
+    message::inventory_vector::list items;
+    items.reserve(messages->size());
+
+    for (const auto& message: *messages)
+        items.push_back(
+            { message::inventory_type_id::transaction, message->hash() });
+
+    inventory_.add_known(items);
+    return true;
+}
+
+bool channel::handle_block(const code& ec, message::block::ptr message)
+{
+    if (ec)
+        return false;
+
+    inventory_.add_known(
+    {
+        { message::inventory_type_id::block, message->header.hash() }
+    });
+
+    return true;
+}
+
 } // namespace network
 } // namespace libbitcoin
@@ -0,0 +1,105 @@
+/**
+ * Copyright (c) 2011-2016 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/network/channel_inventory.hpp>
+
+#include <cstddef>
+#include <bitcoin/bitcoin.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+channel_inventory::channel_inventory(size_t known_capacity)
+  : known_(known_capacity)
+{
+}
+
+void channel_inventory::add_known(const list& items)
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    for (const auto& item: items)
+        known_.insert(item.hash);
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+bool channel_inventory::is_known(const message::inventory_vector& item) const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    shared_lock lock(mutex_);
+
+    return known_.contains(item.hash);
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+channel_inventory::list channel_inventory::unknown(const list& items) const
+{
+    list out;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    shared_lock lock(mutex_);
+
+    for (const auto& item: items)
+        if (!known_.contains(item.hash))
+            out.push_back(item);
+
+    return out;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+size_t channel_inventory::queue(const list& items)
+{
+    size_t count = 0;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    for (const auto& item: items)
+    {
+        if (known_.insert(item.hash))
+        {
+            queued_.push_back(item);
+            ++count;
+        }
+    }
+
+    return count;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+channel_inventory::list channel_inventory::take()
+{
+    list out;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    out.swap(queued_);
+    return out;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+} // namespace network
+} // namespace libbitcoin
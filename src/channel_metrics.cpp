@@ -0,0 +1,194 @@
+/**
+ * Copyright (c) 2011-2016 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/network/channel_metrics.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <bitcoin/bitcoin.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+using namespace std::chrono;
+
+static constexpr auto relaxed = std::memory_order_relaxed;
+static constexpr auto no_ping = std::numeric_limits<uint64_t>::max();
+
+// The weight of the newest round trip in the smoothed round trip, as 1/n.
+static constexpr uint64_t smoothing = 8;
+
+static void zeroize(std::atomic<uint64_t>& value)
+{
+    value.store(0, relaxed);
+}
+
+channel_metrics::channel_metrics()
+  : last_activity_(clock::now().time_since_epoch().count()),
+    created_(clock::now())
+{
+    for (auto direction: { &received_, &sent_ })
+    {
+        zeroize(direction->bytes);
+        zeroize(direction->messages);
+
+        for (auto& value: direction->messages_by_type)
+            zeroize(value);
+
+        for (auto& value: direction->bytes_by_type)
+            zeroize(value);
+    }
+
+    zeroize(ping_count_);
+    zeroize(ping_last_);
+    zeroize(ping_total_);
+    zeroize(ping_smoothed_);
+    zeroize(queued_messages_);
+    zeroize(queued_bytes_);
+    zeroize(skipped_messages_);
+    zeroize(skipped_bytes_);
+    ping_minimum_.store(no_ping, relaxed);
+}
+
+// Recording.
+// ----------------------------------------------------------------------------
+
+size_t channel_metrics::to_index(message::message_type type)
+{
+    const auto index = static_cast<size_t>(type);
+    return index < type_count ? index : 0;
+}
+
+void channel_metrics::record(direction& to, message::message_type type,
+    size_t bytes)
+{
+    const auto index = to_index(type);
+    to.bytes.fetch_add(bytes, relaxed);
+    to.messages.fetch_add(1, relaxed);
+    to.bytes_by_type[index].fetch_add(bytes, relaxed);
+    to.messages_by_type[index].fetch_add(1, relaxed);
+}
+
+void channel_metrics::received(message::message_type type, size_t bytes)
+{
+    record(received_, type, bytes);
+}
+
+void channel_metrics::sent(message::message_type type, size_t bytes)
+{
+    record(sent_, type, bytes);
+}
+
+void channel_metrics::ping(const clock::duration& round_trip)
+{
+    const uint64_t value = duration_cast<microseconds>(round_trip).count();
+    ping_last_.store(value, relaxed);
+    ping_total_.fetch_add(value, relaxed);
+
+    // The ping protocol measures one round trip at a time, so the moving
+    // average is not contended.
+    const auto smoothed = ping_smoothed_.load(relaxed);
+    ping_smoothed_.store(ping_count_.fetch_add(1, relaxed) == 0 ? value :
+        smoothed - smoothed / smoothing + value / smoothing, relaxed);
+
+    auto minimum = ping_minimum_.load(relaxed);
+    while (value < minimum &&
+        !ping_minimum_.compare_exchange_weak(minimum, value, relaxed));
+}
+
+void channel_metrics::skipped(size_t bytes)
+{
+    skipped_bytes_.fetch_add(bytes, relaxed);
+    skipped_messages_.fetch_add(1, relaxed);
+}
+
+void channel_metrics::queued(size_t messages, size_t bytes)
+{
+    queued_messages_.store(messages, relaxed);
+    queued_bytes_.store(bytes, relaxed);
+}
+
+void channel_metrics::activity()
+{
+    last_activity_.store(clock::now().time_since_epoch().count(), relaxed);
+}
+
+// Snapshot.
+// ----------------------------------------------------------------------------
+
+channel_metrics::clock::duration channel_metrics::idle() const
+{
+    const auto last = clock::time_point(clock::duration(
+        last_activity_.load(relaxed)));
+    return clock::now() - last;
+}
+
+uint64_t channel_metrics::received_bytes() const
+{
+    return received_.bytes.load(relaxed);
+}
+
+channel_metrics::traffic channel_metrics::copy(const direction& from)
+{
+    traffic result;
+    result.bytes = from.bytes.load(relaxed);
+    result.messages = from.messages.load(relaxed);
+
+    for (size_t index = 0; index < type_count; ++index)
+    {
+        result.bytes_by_type[index] = from.bytes_by_type[index].load(relaxed);
+        result.messages_by_type[index] =
+            from.messages_by_type[index].load(relaxed);
+    }
+
+    return result;
+}
+
+channel_metrics::snapshot channel_metrics::copy() const
+{
+    snapshot result;
+    result.nonce = 0;
+    result.received = copy(received_);
+    result.sent = copy(sent_);
+
+    const auto count = ping_count_.load(relaxed);
+    const auto minimum = ping_minimum_.load(relaxed);
+    result.ping_count = count;
+    result.ping_last_microseconds = ping_last_.load(relaxed);
+    result.ping_minimum_microseconds = minimum == no_ping ? 0 : minimum;
+    result.ping_average_microseconds = count == 0 ? 0 :
+        ping_total_.load(relaxed) / count;
+    result.ping_smoothed_microseconds = ping_smoothed_.load(relaxed);
+
+    result.queued_messages = queued_messages_.load(relaxed);
+    result.queued_bytes = queued_bytes_.load(relaxed);
+    result.skipped_messages = skipped_messages_.load(relaxed);
+    result.skipped_bytes = skipped_bytes_.load(relaxed);
+
+    result.idle_milliseconds = duration_cast<milliseconds>(idle()).count();
+    result.connected_milliseconds = duration_cast<milliseconds>(
+        clock::now() - created_).count();
+
+    return result;
+}
+
+} // namespace network
+} // namespace libbitcoin
@@ -0,0 +1,383 @@
+/**
+ * Copyright (c) 2011-2016 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/network/compact_messages.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <string>
+#include <boost/iostreams/stream.hpp>
+#include <bitcoin/bitcoin.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+typedef boost::iostreams::stream<byte_sink<data_chunk>> data_sink;
+
+// Transaction indexes are 16 bits, which also bounds each list.
+static constexpr uint64_t max_index = 0xffff;
+static constexpr uint64_t short_id_mask = 0xffffffffffff;
+
+// SipHash-2-4.
+// ----------------------------------------------------------------------------
+
+static uint64_t rotate(uint64_t value, size_t bits)
+{
+    return (value << bits) | (value >> (64 - bits));
+}
+
+static uint64_t to_little_endian_uint64(const uint8_t* data, size_t size)
+{
+    uint64_t value = 0;
+
+    for (size_t index = 0; index < size; ++index)
+        value |= uint64_t(data[index]) << (8 * index);
+
+    return value;
+}
+
+static void sip_round(uint64_t& v0, uint64_t& v1, uint64_t& v2, uint64_t& v3)
+{
+    v0 += v1; v1 = rotate(v1, 13); v1 ^= v0; v0 = rotate(v0, 32);
+    v2 += v3; v3 = rotate(v3, 16); v3 ^= v2;
+    v0 += v3; v3 = rotate(v3, 21); v3 ^= v0;
+    v2 += v1; v1 = rotate(v1, 17); v1 ^= v2; v2 = rotate(v2, 32);
+}
+
+static uint64_t siphash(const compact_block::key& key, const uint8_t* data,
+    size_t size)
+{
+    auto v0 = 0x736f6d6570736575 ^ key.first;
+    auto v1 = 0x646f72616e646f6d ^ key.second;
+    auto v2 = 0x6c7967656e657261 ^ key.first;
+    auto v3 = 0x7465646279746573 ^ key.second;
+
+    const auto words = size / sizeof(uint64_t);
+
+    for (size_t word = 0; word < words; ++word)
+    {
+        const auto value = to_little_endian_uint64(data, sizeof(uint64_t));
+        data += sizeof(uint64_t);
+        v3 ^= value;
+        sip_round(v0, v1, v2, v3);
+        sip_round(v0, v1, v2, v3);
+        v0 ^= value;
+    }
+
+    // The final word holds the remaining bytes and the length.
+    const auto remainder = size % sizeof(uint64_t);
+    const auto last = to_little_endian_uint64(data, remainder) |
+        (uint64_t(size) << 56);
+
+    v3 ^= last;
+    sip_round(v0, v1, v2, v3);
+    sip_round(v0, v1, v2, v3);
+    v0 ^= last;
+    v2 ^= 0xff;
+    sip_round(v0, v1, v2, v3);
+    sip_round(v0, v1, v2, v3);
+    sip_round(v0, v1, v2, v3);
+    sip_round(v0, v1, v2, v3);
+    return v0 ^ v1 ^ v2 ^ v3;
+}
+
+// Differentially-encoded indexes.
+// ----------------------------------------------------------------------------
+
+static bool read_index(istream_reader& source, uint64_t& index, bool first)
+{
+    const auto offset = source.read_variable_uint_little_endian();
+
+    if (!source || offset > max_index)
+        return false;
+
+    index = first ? offset : index + offset + 1;
+    return index <= max_index;
+}
+
+static void write_index(ostream_writer& sink, uint64_t index,
+    uint64_t previous, bool first)
+{
+    sink.write_variable_uint_little_endian(first ? index :
+        index - previous - 1);
+}
+
+static bool read_count(istream_reader& source, uint64_t& count)
+{
+    count = source.read_variable_uint_little_endian();
+    return source && count <= max_index + 1;
+}
+
+// send_compact
+// ----------------------------------------------------------------------------
+
+const std::string send_compact::command = "sendcmpct";
+
+send_compact::send_compact()
+  : send_compact(false, 0)
+{
+}
+
+send_compact::send_compact(bool high_bandwidth, uint64_t version)
+  : high_bandwidth(high_bandwidth), version(version)
+{
+}
+
+bool send_compact::from_data(std::istream& stream)
+{
+    istream_reader source(stream);
+    high_bandwidth = source.read_byte() != 0;
+    version = source.read_8_bytes_little_endian();
+    return source;
+}
+
+data_chunk send_compact::to_data() const
+{
+    data_chunk data;
+    data_sink ostream(data);
+    ostream_writer sink(ostream);
+    sink.write_byte(high_bandwidth ? 1 : 0);
+    sink.write_8_bytes_little_endian(version);
+    ostream.flush();
+    return data;
+}
+
+// compact_block
+// ----------------------------------------------------------------------------
+
+const std::string compact_block::command = "cmpctblock";
+
+// static
+compact_block::key compact_block::to_key(const chain::header& header,
+    uint64_t nonce)
+{
+    auto preimage = header.to_data(false);
+
+    for (size_t byte = 0; byte < sizeof(uint64_t); ++byte)
+        preimage.push_back(static_cast<uint8_t>(nonce >> (8 * byte)));
+
+    const auto digest = sha256_hash(preimage);
+    return
+    {
+        to_little_endian_uint64(digest.data(), sizeof(uint64_t)),
+        to_little_endian_uint64(digest.data() + sizeof(uint64_t),
+            sizeof(uint64_t))
+    };
+}
+
+// static
+uint64_t compact_block::short_id(const key& key, const hash_digest& hash)
+{
+    return siphash(key, hash.data(), hash.size()) & short_id_mask;
+}
+
+// static
+compact_block compact_block::factory_from_block(const message::block& block,
+    uint64_t nonce)
+{
+    compact_block instance;
+    instance.header = block.header;
+    instance.nonce = nonce;
+
+    const auto& transactions = block.transactions;
+
+    if (transactions.empty())
+        return instance;
+
+    instance.prefilled.push_back({ 0, transactions.front() });
+    instance.short_ids.reserve(transactions.size() - 1);
+    const auto key = to_key(block.header, nonce);
+
+    for (auto it = transactions.begin() + 1; it != transactions.end(); ++it)
+        instance.short_ids.push_back(short_id(key, it->hash()));
+
+    return instance;
+}
+
+size_t compact_block::transaction_count() const
+{
+    return short_ids.size() + prefilled.size();
+}
+
+bool compact_block::from_data(std::istream& stream)
+{
+    short_ids.clear();
+    prefilled.clear();
+
+    if (!header.from_data(stream, false))
+        return false;
+
+    istream_reader source(stream);
+    nonce = source.read_8_bytes_little_endian();
+
+    uint64_t count;
+    if (!read_count(source, count))
+        return false;
+
+    short_ids.reserve(count);
+
+    for (uint64_t id = 0; id < count; ++id)
+    {
+        uint64_t value = 0;
+
+        for (size_t byte = 0; byte < short_id_size; ++byte)
+            value |= uint64_t(source.read_byte()) << (8 * byte);
+
+        short_ids.push_back(value);
+    }
+
+    if (!read_count(source, count))
+        return false;
+
+    prefilled.reserve(count);
+    uint64_t index = 0;
+
+    for (uint64_t item = 0; item < count; ++item)
+    {
+        if (!read_index(source, index, item == 0))
+            return false;
+
+        prefilled_transaction entry{ index, {} };
+
+        if (!entry.transaction.from_data(stream))
+            return false;
+
+        prefilled.push_back(std::move(entry));
+    }
+
+    return source && transaction_count() <= max_index + 1;
+}
+
+data_chunk compact_block::to_data() const
+{
+    data_chunk data;
+    data_sink ostream(data);
+    ostream_writer sink(ostream);
+    sink.write_data(header.to_data(false));
+    sink.write_8_bytes_little_endian(nonce);
+    sink.write_variable_uint_little_endian(short_ids.size());
+
+    for (const auto id: short_ids)
+        for (size_t byte = 0; byte < short_id_size; ++byte)
+            sink.write_byte(static_cast<uint8_t>(id >> (8 * byte)));
+
+    sink.write_variable_uint_little_endian(prefilled.size());
+    uint64_t previous = 0;
+
+    for (const auto& entry: prefilled)
+    {
+        write_index(sink, entry.index, previous, &entry == &prefilled.front());
+        sink.write_data(entry.transaction.to_data());
+        previous = entry.index;
+    }
+
+    ostream.flush();
+    return data;
+}
+
+// get_block_transactions
+// ----------------------------------------------------------------------------
+
+const std::string get_block_transactions::command = "getblocktxn";
+
+bool get_block_transactions::from_data(std::istream& stream)
+{
+    indexes.clear();
+    istream_reader source(stream);
+    block_hash = source.read_hash();
+
+    uint64_t count;
+    if (!read_count(source, count))
+        return false;
+
+    indexes.reserve(count);
+    uint64_t index = 0;
+
+    for (uint64_t item = 0; item < count; ++item)
+    {
+        if (!read_index(source, index, item == 0))
+            return false;
+
+        indexes.push_back(index);
+    }
+
+    return source;
+}
+
+data_chunk get_block_transactions::to_data() const
+{
+    data_chunk data;
+    data_sink ostream(data);
+    ostream_writer sink(ostream);
+    sink.write_hash(block_hash);
+    sink.write_variable_uint_little_endian(indexes.size());
+    uint64_t previous = 0;
+
+    for (size_t item = 0; item < indexes.size(); ++item)
+    {
+        write_index(sink, indexes[item], previous, item == 0);
+        previous = indexes[item];
+    }
+
+    ostream.flush();
+    return data;
+}
+
+// block_transactions
+// ----------------------------------------------------------------------------
+
+const std::string block_transactions::command = "blocktxn";
+
+bool block_transactions::from_data(std::istream& stream)
+{
+    transactions.clear();
+    istream_reader source(stream);
+    block_hash = source.read_hash();
+
+    uint64_t count;
+    if (!read_count(source, count))
+        return false;
+
+    transactions.resize(count);
+
+    for (auto& transaction: transactions)
+        if (!transaction.from_data(stream))
+            return false;
+
+    return source;
+}
+
+data_chunk block_transactions::to_data() const
+{
+    data_chunk data;
+    data_sink ostream(data);
+    ostream_writer sink(ostream);
+    sink.write_hash(block_hash);
+    sink.write_variable_uint_little_endian(transactions.size());
+
+    for (const auto& transaction: transactions)
+        sink.write_data(transaction.to_data());
+
+    ostream.flush();
+    return data;
+}
+
+} // namespace network
+} // namespace libbitcoin
@@ -20,6 +20,13 @@
 #include <bitcoin/network/connections.hpp>
 
 #include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+#include <boost/functional/hash.hpp>
 #include <bitcoin/bitcoin.hpp>
 #include <bitcoin/network/channel.hpp>
 
@@ -30,68 +37,166 @@ using namespace bc::config;
 
 #define NAME "connections"
 
-connections::connections()
-  : stopped_(false)
+// The number of independently locked partitions of the channel map.
+static constexpr size_t shard_count = 16;
+
+connections::connections(uint32_t magic)
+  : magic_(magic),
+    bytes_saved_(0),
+    shards_(shard_count),
+    count_(0),
+    epoch_(0),
+    stopped_(false)
 {
 }
 
 connections::~connections()
 {
-    BITCOIN_ASSERT_MSG(channels_.empty(), "Connections was not cleared.");
+    BITCOIN_ASSERT_MSG(count_ == 0, "Connections was not cleared.");
+}
+
+// Shards.
+// ----------------------------------------------------------------------------
+
+size_t connections::authority_hash::operator()(const authority& value) const
+{
+    const auto bytes = value.ip().to_bytes();
+    auto seed = boost::hash_range(bytes.begin(), bytes.end());
+    boost::hash_combine(seed, value.port());
+    return seed;
+}
+
+connections::shard& connections::to_shard(const authority& authority)
+{
+    return shards_[authority_hash()(authority) % shards_.size()];
+}
+
+const connections::shard& connections::to_shard(
+    const authority& authority) const
+{
+    return shards_[authority_hash()(authority) % shards_.size()];
+}
+
+// Returns false if already stopped, otherwise sets stopped.
+bool connections::safe_partition(std::vector<list>& out)
+{
+    if (stopped_.exchange(true))
+        return false;
+
+    // Once stopped no shard can change, but must copy to escape each lock.
+    // The exclusive lock waits out any store that preceded the stop flag.
+    for (auto& shard: shards_)
+    {
+        list channels;
+
+        // Critical Section
+        ///////////////////////////////////////////////////////////////////////
+        unique_lock lock(shard.mutex);
+
+        for (const auto& entry: shard.channels)
+            channels.push_back(entry.second);
+        ///////////////////////////////////////////////////////////////////////
+
+        out.push_back(std::move(channels));
+    }
+
+    return true;
 }
 
 // This is idempotent.
 void connections::stop(const code& ec)
 {
-    connections::list channels;
+    std::vector<list> shards;
 
-    // Critical Section
-    ///////////////////////////////////////////////////////////////////////////
-    mutex_.lock_upgrade();
+    if (!safe_partition(shards))
+        return;
 
-    if (!stopped_)
-    {
-        //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
-        mutex_.unlock_upgrade_and_lock();
-        stopped_ = true;
-        mutex_.unlock_and_lock_upgrade(); 
-        //---------------------------------------------------------------------
+    // Channel stop handlers should remove channels from list.
+    for (const auto& channels: shards)
+        for (const auto channel: channels)
+            channel->stop(ec);
+}
+
+// This is idempotent, a repeated stop completes immediately.
+void connections::stop(const code& ec, monitored_dispatcher& dispatch,
+    result_handler handler)
+{
+    std::vector<list> shards;
 
-        // Once stopped this list cannot change, but must copy to escape lock.
-        channels = channels_;
+    if (!safe_partition(shards))
+    {
+        handler(error::success);
+        return;
     }
 
-    mutex_.unlock_upgrade();
-    ///////////////////////////////////////////////////////////////////////////
+    const auto remaining = std::make_shared<std::atomic<size_t>>(
+        shards.size());
 
     // Channel stop handlers should remove channels from list.
-    for (const auto channel: channels)
+    for (auto& channels: shards)
+        dispatch.concurrent(&connections::stop_shard, shared_from_this(), ec,
+            std::make_shared<list>(std::move(channels)), remaining, handler);
+}
+
+void connections::stop_shard(const code& ec, std::shared_ptr<list> channels,
+    counter_ptr remaining, result_handler handler)
+{
+    for (const auto channel: *channels)
         channel->stop(ec);
+
+    if (remaining->fetch_sub(1) == 1)
+        handler(error::success);
 }
 
-connections::list connections::safe_copy() const
+// Snapshot.
+// ----------------------------------------------------------------------------
+// Writers advance the epoch after each change and readers rebuild the
+// snapshot only when it is older than the epoch, so writers never wait on
+// broadcasts. A snapshot built concurrently with a change is tagged with the
+// earlier epoch and is therefore rebuilt by the next reader.
+
+connections::list_ptr connections::safe_copy() const
 {
-    // Critical Section
-    ///////////////////////////////////////////////////////////////////////////
-    shared_lock lock(mutex_);
+    auto current = std::atomic_load(&snapshot_);
+    const auto epoch = epoch_.load();
 
-    return channels_;
-    ///////////////////////////////////////////////////////////////////////////
+    if (!current || current->epoch != epoch)
+    {
+        const auto fresh = std::make_shared<snapshot>();
+        fresh->epoch = epoch;
+        fresh->channels.reserve(count_);
+
+        for (const auto& shard: shards_)
+        {
+            // Critical Section
+            ///////////////////////////////////////////////////////////////////
+            shared_lock lock(shard.mutex);
+
+            for (const auto& entry: shard.channels)
+                fresh->channels.push_back(entry.second);
+            ///////////////////////////////////////////////////////////////////
+        }
+
+        current = fresh;
+        std::atomic_store(&snapshot_, current);
+    }
+
+    // Alias the list within the snapshot, retaining the snapshot.
+    return list_ptr(current, &current->channels);
 }
 
+// Registry.
+// ----------------------------------------------------------------------------
+
 bool connections::safe_exists(const authority& address) const
 {
-    const auto match = [&address](channel::ptr entry)
-    {
-        return entry->authority() == address;
-    };
+    const auto& shard = to_shard(address);
 
     // Critical Section
     ///////////////////////////////////////////////////////////////////////////
-    shared_lock lock(mutex_);
+    shared_lock lock(shard.mutex);
 
-    const auto it = std::find_if(channels_.begin(), channels_.end(), match);
-    return it != channels_.end();
+    return shard.channels.find(address) != shard.channels.end();
     ///////////////////////////////////////////////////////////////////////////
 }
 
@@ -102,24 +207,28 @@ void connections::exists(const authority& address, truth_handler handler) const
 
 bool connections::safe_remove(channel::ptr channel)
 {
+    auto& shard = to_shard(channel->authority());
+
     // Critical Section
     ///////////////////////////////////////////////////////////////////////////
-    mutex_.lock_upgrade();
+    shard.mutex.lock_upgrade();
 
-    const auto it = std::find(channels_.begin(), channels_.end(), channel);
-    const auto found = it != channels_.end();
+    const auto it = shard.channels.find(channel->authority());
+    const auto found = it != shard.channels.end() && it->second == channel;
 
     if (found)
     {
         //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
-        mutex_.unlock_upgrade_and_lock();
-        channels_.erase(it);
-        mutex_.unlock();
+        shard.mutex.unlock_upgrade_and_lock();
+        shard.channels.erase(it);
+        --count_;
+        ++epoch_;
+        shard.mutex.unlock();
         //---------------------------------------------------------------------
         return true;
     }
 
-    mutex_.unlock_upgrade();
+    shard.mutex.unlock_upgrade();
     ///////////////////////////////////////////////////////////////////////////
 
     return false;
@@ -133,34 +242,34 @@ void connections::remove(channel::ptr channel, result_handler handler)
 code connections::safe_store(channel::ptr channel)
 {
     const auto address = channel->authority();
-    const auto match = [&address](channel::ptr entry)
-    {
-        return entry->authority() == address;
-    };
+    auto& shard = to_shard(address);
 
     // Critical Section
     ///////////////////////////////////////////////////////////////////////////
-    mutex_.lock_upgrade();
+    shard.mutex.lock_upgrade();
 
+    // The stop test is made under the shard lock so stop sees the insert.
     const auto stopped = stopped_.load();
 
     if (!stopped)
     {
-        auto it = std::find_if(channels_.begin(), channels_.end(), match);
-        const auto found = it != channels_.end();
+        const auto found = shard.channels.find(address) !=
+            shard.channels.end();
 
         if (!found)
         {
-            //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
-            mutex_.unlock_upgrade_and_lock();
-            channels_.push_back(channel);
-            mutex_.unlock();
-            //---------------------------------------------------------------------
+            //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+            shard.mutex.unlock_upgrade_and_lock();
+            shard.channels.emplace(address, channel);
+            ++count_;
+            ++epoch_;
+            shard.mutex.unlock();
+            //-----------------------------------------------------------------
             return error::success;
         }
     }
 
-    mutex_.unlock_upgrade();
+    shard.mutex.unlock_upgrade();
     ///////////////////////////////////////////////////////////////////////////
 
     // Stopped and found are the only ways to get here.
@@ -174,12 +283,7 @@ void connections::store(channel::ptr channel, result_handler handler)
 
 size_t connections::safe_count() const
 {
-    // Critical Section
-    ///////////////////////////////////////////////////////////////////////////
-    shared_lock lock(mutex_);
-
-    return channels_.size();
-    ///////////////////////////////////////////////////////////////////////////
+    return count_;
 }
 
 void connections::count(count_handler handler) const
@@ -187,5 +291,36 @@ void connections::count(count_handler handler) const
     handler(safe_count());
 }
 
+void connections::metrics(metrics_handler handler) const
+{
+    // The broadcast snapshot is reused, so this does not block writers.
+    const auto channels = safe_copy();
+    channel_metrics::snapshot::list result;
+    result.reserve(channels->size());
+
+    for (const auto channel: *channels)
+    {
+        result.push_back(channel->metrics().copy());
+        result.back().authority = channel->authority();
+        result.back().nonce = channel->nonce();
+    }
+
+    handler(result);
+}
+
+void connections::visit(channel_visitor visitor) const
+{
+    // The broadcast snapshot is reused, so this does not block writers.
+    const auto channels = safe_copy();
+
+    for (const auto channel: *channels)
+        visitor(channel);
+}
+
+uint64_t connections::broadcast_bytes_saved() const
+{
+    return bytes_saved_;
+}
+
 } // namespace network
 } // namespace libbitcoin
@@ -24,8 +24,10 @@
 #include <string>
 #include <bitcoin/bitcoin.hpp>
 #include <bitcoin/network/channel.hpp>
+#include <bitcoin/network/logging.hpp>
 #include <bitcoin/network/proxy.hpp>
 #include <bitcoin/network/settings.hpp>
+#include <bitcoin/network/slab_allocator.hpp>
 #include <bitcoin/network/socket.hpp>
 
 namespace libbitcoin {
@@ -37,14 +39,23 @@ using namespace bc::config;
 using std::placeholders::_1;
 using std::placeholders::_2;
 
-// The resolver_, pending_, and stopped_ members are protected.
+// The pending_ and stopped_ members are protected.
 
-connector::connector(threadpool& pool, const settings& settings)
+connector::connector(threadpool& pool, const settings& settings,
+    buffer_pool::ptr buffers, affinity_pool::ptr affinity,
+    resolver_cache::ptr resolved, timer_wheel::ptr timers,
+    token_bucket::ptr uploads, memory_accounts::ptr memory,
+    dispatch_monitor::ptr dispatches)
   : stopped_(false),
     pool_(pool),
     settings_(settings),
-    dispatch_(pool, NAME),
-    resolver_(std::make_shared<asio::resolver>(pool.service())),
+    buffers_(buffers),
+    affinity_(affinity),
+    dispatch_(pool, NAME, dispatches),
+    resolved_(resolved),
+    timers_(timers),
+    uploads_(uploads),
+    memory_(memory),
     CONSTRUCT_TRACK(connector)
 {
 }
@@ -70,8 +81,7 @@ void connector::safe_stop()
         //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
         mutex_.unlock_upgrade_and_lock();
 
-        // This will asynchronously invoke the handler of each pending resolve.
-        resolver_->cancel();
+        // Pending resolutions observe the stop when they complete.
         stopped_ = true;
 
         mutex_.unlock();
@@ -111,36 +121,120 @@ void connector::connect(const authority& authority, connect_handler handler)
 // public:
 void connector::connect(const std::string& hostname, uint16_t port,
     connect_handler handler)
+{
+    start_resolve(hostname, port, nullptr, handler);
+}
+
+// public:
+void connector::connect(const authority& authority, connect_handler handler,
+    pending_sockets::ptr batch)
+{
+    start_resolve(authority.to_hostname(), authority.port(), batch, handler);
+}
+
+void connector::start_resolve(const std::string& hostname, uint16_t port,
+    pending_sockets::ptr batch, connect_handler handler)
 {
     // Critical Section
     ///////////////////////////////////////////////////////////////////////////
-    mutex_.lock_upgrade();
+    mutex_.lock_shared();
 
     if (stopped_)
     {
-        // We preserve the asynchronous contract of the async_resolve.
+        // We preserve the asynchronous contract of the resolution.
         // Dispatch ensures job does not execute in the current thread.
         dispatch_.concurrent(handler, error::service_stopped, nullptr);
-        mutex_.unlock_upgrade();
+        mutex_.unlock_shared();
         //---------------------------------------------------------------------
         return;
     }
 
-    auto query = std::make_shared<asio::query>(hostname, std::to_string(port));
+    lifecycle_metrics::timeline times;
+    times.resolving = lifecycle_metrics::clock::now();
 
-    //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
-    mutex_.unlock_upgrade_and_lock();
-
-    // async_resolve will not invoke the handler within this function.
-    resolver_->async_resolve(*query,
+    lookup(hostname, port,
         std::bind(&connector::handle_resolve,
-            shared_from_this(), _1, _2, handler));
+            shared_from_this(), _1, _2, batch, times, handler));
 
-    mutex_.unlock();
+    mutex_.unlock_shared();
     ///////////////////////////////////////////////////////////////////////////
 }
 
+// public:
+void connector::resolve(const std::string& hostname, uint16_t port,
+    resolve_handler handler)
+{
+    if (stopped())
+    {
+        dispatch_.concurrent(handler, error::service_stopped,
+            authority::list{});
+        return;
+    }
+
+    lookup(hostname, port,
+        std::bind(&connector::handle_resolve_all,
+            shared_from_this(), _1, _2, handler));
+}
+
+// Cached results are shared by all connectors of the network.
+// Resolution is asynchronous, so that no pool thread blocks on the resolver.
+void connector::lookup(const std::string& hostname, uint16_t port,
+    lookup_handler handler)
+{
+    asio::iterator cached;
+
+    // We preserve the asynchronous contract of the resolution.
+    if (resolved_->find(cached, hostname, port))
+    {
+        dispatch_.concurrent(handler, boost_code(), cached);
+        return;
+    }
+
+    // The resolver is retained by its own handler until it completes.
+    const auto resolver = std::make_shared<asio::resolver>(pool_.service());
+    const asio::query query(hostname, std::to_string(port));
+
+    resolver->async_resolve(query,
+        std::bind(&connector::handle_lookup,
+            shared_from_this(), _1, _2, resolver, hostname, port, handler));
+}
+
+void connector::handle_lookup(const boost_code& ec, asio::iterator iterator,
+    resolver_ptr, const std::string& hostname, uint16_t port,
+    lookup_handler handler)
+{
+    if (!ec)
+        resolved_->store(hostname, port, iterator);
+
+    handler(ec, iterator);
+}
+
+// All A and AAAA results are returned, in resolver order.
+void connector::handle_resolve_all(const boost_code& ec,
+    asio::iterator iterator, resolve_handler handler)
+{
+    if (stopped())
+    {
+        handler(error::service_stopped, {});
+        return;
+    }
+
+    if (ec)
+    {
+        handler(error::resolve_failed, {});
+        return;
+    }
+
+    authority::list authorities;
+
+    for (; iterator != asio::iterator(); ++iterator)
+        authorities.push_back(authority(iterator->endpoint()));
+
+    handler(error::success, authorities);
+}
+
 void connector::handle_resolve(const boost_code& ec, asio::iterator iterator,
+    pending_sockets::ptr batch, lifecycle_metrics::timeline times,
     connect_handler handler)
 {
     // Critical Section
@@ -164,12 +258,18 @@ void connector::handle_resolve(const boost_code& ec, asio::iterator iterator,
     }
 
     const auto timeout = settings_.connect_timeout();
-    const auto timer = std::make_shared<deadline>(pool_, timeout);
-    const auto socket = std::make_shared<network::socket>(pool_);
+    const auto timer = std::allocate_shared<deadline>(
+        slab_allocator<deadline>(), pool_, timeout);
+    // The socket, and then its channel, are assigned to one service thread.
+    const auto socket = std::allocate_shared<network::socket>(
+        slab_allocator<network::socket>(), affinity_->next());
 
     // Retain a socket reference until connected, allowing connect cancelation.
     pending_.store(socket);
 
+    if (batch)
+        batch->store(socket);
+
     // Manage the socket-timer race.
     const auto handle_connect = synchronize(handler, 1, NAME, false);
 
@@ -178,14 +278,16 @@ void connector::handle_resolve(const boost_code& ec, asio::iterator iterator,
         std::bind(&connector::handle_timer,
             shared_from_this(), _1, socket, handle_connect));
 
-    safe_connect(iterator, socket, timer, handle_connect);
+    times.connecting = lifecycle_metrics::clock::now();
+    safe_connect(iterator, socket, timer, batch, times, handle_connect);
 
     mutex_.unlock_shared();
     ///////////////////////////////////////////////////////////////////////////
 }
 
 void connector::safe_connect(asio::iterator iterator, socket::ptr socket,
-    deadline::ptr timer, connect_handler handler)
+    deadline::ptr timer, pending_sockets::ptr batch,
+    lifecycle_metrics::timeline times, connect_handler handler)
 {
     // Critical Section (external)
     /////////////////////////////////////////////////////////////////////////// 
@@ -195,7 +297,8 @@ void connector::safe_connect(asio::iterator iterator, socket::ptr socket,
     using namespace boost::asio;
     async_connect(locked->get(), iterator,
         std::bind(&connector::handle_connect,
-            shared_from_this(), _1, _2, socket, timer, handler));
+            shared_from_this(), _1, _2, socket, timer, batch, times,
+            handler));
     /////////////////////////////////////////////////////////////////////////// 
 }
 
@@ -220,22 +323,46 @@ void connector::handle_timer(const code& ec, socket::ptr socket,
 
 // private:
 void connector::handle_connect(const boost_code& ec, asio::iterator,
-    socket::ptr socket, deadline::ptr timer, connect_handler handler)
+    socket::ptr socket, deadline::ptr timer, pending_sockets::ptr batch,
+    lifecycle_metrics::timeline times, connect_handler handler)
 {
     pending_.remove(socket);
 
-    // This is the end of the connect sequence.
+    if (batch)
+        batch->remove(socket);
+
     if (ec)
+    {
+        // This is the end of the connect sequence.
         handler(error::boost_to_error_code(ec), nullptr);
-    else
-        handler(error::success, new_channel(socket));
+        timer->stop();
+        return;
+    }
+
+    const auto options = socket->set_options(settings_, false);
+
+    // Option failure is not fatal, the connection remains usable.
+    if (options)
+        LOG_DEBUG(LOG_NETWORK)
+            << "Failure setting outbound socket options: "
+            << options.message();
+
+    // The channel is stamped connected, the earlier times are copied to it.
+    const auto created = new_channel(socket);
+    created->timeline().resolving = times.resolving;
+    created->timeline().connecting = times.connecting;
+
+    // This is the end of the connect sequence.
+    handler(error::success, created);
 
     timer->stop();
 }
 
 std::shared_ptr<channel> connector::new_channel(socket::ptr socket)
 {
-    return std::make_shared<channel>(pool_, socket, settings_);
+    return std::allocate_shared<channel>(slab_allocator<channel>(),
+        socket->pool(), socket, settings_, buffers_, timers_, uploads_,
+        memory_);
 }
 
 } // namespace network
@@ -28,26 +28,36 @@ namespace libbitcoin {
 namespace network {
 
 const_buffer::const_buffer()
-  : data_(std::make_shared<data_chunk>(data_chunk{0})),
-    buffer_(boost::asio::buffer(*data_))
+  : const_buffer(std::make_shared<data_chunk>(data_chunk{0}))
 {
 }
 
 const_buffer::const_buffer(data_chunk&& data)
-  : data_(std::make_shared<data_chunk>(std::move(data))),
-    buffer_(boost::asio::buffer(*data_))
+  : const_buffer(std::make_shared<data_chunk>(std::move(data)))
 {
 }
 
 const_buffer::const_buffer(const data_chunk& data)
-  : data_(std::make_shared<data_chunk>(data)),
-    buffer_(boost::asio::buffer(*data_))
+  : const_buffer(std::make_shared<data_chunk>(data))
+{
+}
+
+const_buffer::const_buffer(std::shared_ptr<const void> owner,
+    const uint8_t* data, size_t size)
+  : data_(owner),
+    buffer_(boost::asio::buffer(data, size))
+{
+}
+
+const_buffer::const_buffer(std::shared_ptr<data_chunk> data)
+  : data_(data),
+    buffer_(boost::asio::buffer(*data))
 {
 }
 
 size_t const_buffer::size() const
 {
-    return data_->size();
+    return boost::asio::buffer_size(buffer_);
 }
 
 const_buffer::const_iterator const_buffer::begin() const
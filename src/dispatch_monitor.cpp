@@ -0,0 +1,126 @@
+/**
+ * Copyright (c) 2011-2016 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/network/dispatch_monitor.hpp>
+
+#include <memory>
+#include <string>
+#include <bitcoin/bitcoin.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+dispatch_monitor::counters::counters()
+  : enqueued_(0), started_(0), completed_(0)
+{
+}
+
+dispatch_monitor::clock::time_point dispatch_monitor::counters::enqueue()
+{
+    enqueued_.fetch_add(1, std::memory_order_relaxed);
+    return clock::now();
+}
+
+dispatch_monitor::clock::time_point dispatch_monitor::counters::start(
+    const clock::time_point& enqueued)
+{
+    const auto now = clock::now();
+    started_.fetch_add(1, std::memory_order_relaxed);
+    wait_.record(now - enqueued);
+    return now;
+}
+
+void dispatch_monitor::counters::complete(const clock::time_point& started)
+{
+    execution_.record(clock::now() - started);
+    completed_.fetch_add(1, std::memory_order_relaxed);
+}
+
+dispatch_monitor::dispatch_monitor()
+{
+}
+
+dispatch_monitor::counters::ptr dispatch_monitor::lookup(
+    const std::string& name)
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    mutex_.lock_upgrade();
+
+    const auto it = names_.find(name);
+
+    if (it != names_.end())
+    {
+        const auto found = it->second;
+        mutex_.unlock_upgrade();
+        //---------------------------------------------------------------------
+        return found;
+    }
+
+    mutex_.unlock_upgrade_and_lock();
+    //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+    const auto result = std::make_shared<counters>();
+    names_.emplace(name, result);
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    return result;
+}
+
+// The counters are read completed first, so queued and running do not wrap.
+dispatch_monitor::statistics dispatch_monitor::snapshot() const
+{
+    std::map<std::string, counters::ptr> names;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    mutex_.lock_shared();
+
+    names = names_;
+
+    mutex_.unlock_shared();
+    ///////////////////////////////////////////////////////////////////////////
+
+    statistics out;
+    out.reserve(names.size());
+
+    for (const auto& entry: names)
+    {
+        const auto& source = *entry.second;
+        const auto completed = source.completed_.load();
+        const auto started = source.started_.load();
+        const auto enqueued = source.enqueued_.load();
+
+        summary item;
+        item.name = entry.first;
+        item.enqueued = enqueued;
+        item.queued = enqueued - started;
+        item.running = started - completed;
+        item.completed = completed;
+        item.wait = source.wait_.summarize();
+        item.execution = source.execution_.summarize();
+        out.push_back(item);
+    }
+
+    return out;
+}
+
+} // namespace network
+} // namespace libbitcoin
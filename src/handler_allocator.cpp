@@ -0,0 +1,56 @@
+/**
+ * Copyright (c) 2011-2016 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/network/handler_allocator.hpp>
+
+#include <cstddef>
+#include <new>
+#include <bitcoin/bitcoin.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+constexpr size_t handler_allocator::capacity;
+
+handler_allocator::handler_allocator()
+  : in_use_(false)
+{
+}
+
+void* handler_allocator::allocate(size_t size)
+{
+    if (size <= capacity && !in_use_.exchange(true))
+        return &storage_;
+
+    return ::operator new(size);
+}
+
+void handler_allocator::deallocate(void* block)
+{
+    if (block == &storage_)
+    {
+        in_use_ = false;
+        return;
+    }
+
+    ::operator delete(block);
+}
+
+} // namespace network
+} // namespace libbitcoin
@@ -20,10 +20,21 @@
 #include <bitcoin/network/hosts.hpp>
 
 #include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <functional>
+#include <iterator>
+#include <memory>
 #include <string>
 #include <vector>
+#include <boost/functional/hash.hpp>
 #include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/dispatch_monitor.hpp>
+#include <bitcoin/network/hosts_file.hpp>
+#include <bitcoin/network/logging.hpp>
 #include <bitcoin/network/settings.hpp>
 
 namespace libbitcoin {
@@ -31,23 +42,250 @@ namespace network {
 
 #define NAME "hosts"
 
+using std::placeholders::_1;
+
+// Proven peers are kept in a table of one quarter of the pool capacity.
+static constexpr size_t tried_ratio = 4;
+
+// The number of random candidates from which fetch keeps the best.
+static constexpr size_t fetch_candidates = 4;
+
+// An address attempted this recently is unlikely to be worth a retry.
+static constexpr uint32_t retry_seconds = 10 * 60;
+
+// A new address that has never connected is dropped after this many failures.
+static constexpr uint32_t new_failure_limit = 3;
+
+// A tried address is demoted (and a demoted one dropped) after this many.
+static constexpr uint32_t tried_failure_limit = 10;
+
+// The largest address message is sampled.
+static constexpr size_t sample_size = 1000;
+
+// The slot of an entry that is not persisted.
+static constexpr uint32_t no_slot = max_uint32;
+
 hosts::hosts(threadpool& pool, const settings& settings)
-  : buffer_(std::max(settings.host_pool_capacity, 1u)),
-    dispatch_(pool, NAME),
+  : hosts(pool, settings, std::make_shared<dispatch_monitor>())
+{
+}
+
+hosts::hosts(threadpool& pool, const settings& settings,
+    dispatch_monitor::ptr dispatches)
+  : new_capacity_(std::max(settings.host_pool_capacity, 1u)),
+    tried_capacity_(std::max(new_capacity_ / tried_ratio, size_t(1))),
+    file_(settings.hosts_file),
+    changed_(false),
+    snapshot_(std::make_shared<snapshot>()),
+    timer_(std::make_shared<deadline>(pool, settings.host_pool_flush())),
+    dispatch_(pool, NAME, dispatches),
     file_path_(settings.hosts_file),
-    disabled_(settings.host_pool_capacity == 0)
+    disabled_(settings.host_pool_capacity == 0),
+    magic_(settings.identifier),
+    sample_lifetime_(std::chrono::seconds(settings.host_pool_sample_seconds))
+{
+    index_.reserve(new_capacity_ + tried_capacity_);
+}
+
+hosts::entry::entry(const address& host)
+  : host(host),
+    last_success(0),
+    last_attempt(0),
+    failures(0),
+    latency_milliseconds(0),
+    slot(no_slot),
+    shared(std::make_shared<score_state>())
+{
+}
+
+hosts::entry::entry(const hosts_file::record& record, uint32_t slot)
+  : last_success(record.last_success),
+    last_attempt(record.last_attempt),
+    failures(record.failures),
+    latency_milliseconds(record.latency_milliseconds),
+    slot(slot),
+    shared(std::make_shared<score_state>())
+{
+    host.timestamp = record.timestamp;
+    host.services = record.services;
+    std::copy(std::begin(record.ip), std::end(record.ip), host.ip.begin());
+    host.port = record.port;
+}
+
+hosts_file::record hosts::entry::to_record(bool tried) const
+{
+    hosts_file::record record;
+    std::copy(host.ip.begin(), host.ip.end(), std::begin(record.ip));
+    record.services = host.services;
+    record.timestamp = host.timestamp;
+    record.last_success = last_success;
+    record.last_attempt = last_attempt;
+    record.failures = failures;
+    record.latency_milliseconds = latency_milliseconds;
+    record.port = host.port;
+    record.state = tried ? hosts_file::table::tried : hosts_file::table::fresh;
+    record.reserved = 0;
+    return record;
+}
+
+// The scores are relaxed, fetch requires no ordering among them.
+void hosts::entry::share() const
+{
+    shared->last_attempt.store(last_attempt, std::memory_order_relaxed);
+    shared->failures.store(failures, std::memory_order_relaxed);
+    shared->latency_milliseconds.store(latency_milliseconds,
+        std::memory_order_relaxed);
+}
+
+// Index.
+// ----------------------------------------------------------------------------
+// Addresses are indexed by ip and port only, as in the original linear find.
+
+size_t hosts::address_hash::operator()(const address& host) const
+{
+    auto seed = boost::hash_range(host.ip.begin(), host.ip.end());
+    boost::hash_combine(seed, host.port);
+    return seed;
+}
+
+bool hosts::address_equal::operator()(const address& left,
+    const address& right) const
 {
+    return left.port == right.port && left.ip == right.ip;
 }
 
 // private
-hosts::iterator hosts::find(const address& host)
+// The index holds the table and position of each entry, so nothing is scanned.
+bool hosts::find(list*& table, iterator& it, const address& host)
 {
-    const auto found = [&host](const address& entry)
+    const auto found = index_.find(host);
+
+    if (found == index_.end())
+        return false;
+
+    table = found->second.table;
+    it = found->second.it;
+    return true;
+}
+
+// private
+// Must be called under a unique lock, keeps the index consistent on eviction.
+bool hosts::safe_push(const address& host)
+{
+    return safe_push(entry(host), false);
+}
+
+// private
+// Must be called under a unique lock, keeps the index consistent on eviction.
+bool hosts::safe_push(const entry& host, bool tried)
+{
+    if (index_.find(host.host) != index_.end())
+        return false;
+
+    safe_push(tried ? tried_ : new_, host);
+    return true;
+}
+
+// private
+// Must be called under a unique lock, the host is indexed at its position.
+void hosts::safe_push(list& table, const entry& host)
+{
+    const auto tried = &table == &tried_;
+
+    if (table.size() >= (tried ? tried_capacity_ : new_capacity_))
+    {
+        // The oldest tried entry is demoted, making room in the tried table.
+        if (tried)
+            safe_push(new_, table.front());
+        else
+            safe_release(table.front());
+
+        table.pop_front();
+    }
+
+    changed_ = true;
+    table.push_back(host);
+    const auto pushed = std::prev(table.end());
+    index_[pushed->host] = location{ &table, pushed };
+
+    // An entry keeps its slot as it moves between tables.
+    if (pushed->slot == no_slot && file_.is_open() && !free_.empty())
     {
-        return entry.port == host.port && entry.ip == host.ip;
-    };
+        pushed->slot = free_.back();
+        free_.pop_back();
+    }
 
-    return std::find_if(buffer_.begin(), buffer_.end(), found);
+    safe_write(*pushed, tried);
+}
+
+// private
+// Must be called under a unique lock, the entry is also removed from the index.
+void hosts::safe_erase(list& table, iterator it)
+{
+    safe_release(*it);
+    table.erase(it);
+}
+
+// private
+// Must be called under a unique lock, frees the index entry and file slot.
+void hosts::safe_release(const entry& host)
+{
+    changed_ = true;
+    index_.erase(host.host);
+
+    if (host.slot == no_slot || !file_.is_open())
+        return;
+
+    file_.clear(host.slot);
+    free_.push_back(host.slot);
+}
+
+// private
+// Must be called under a unique lock, overwrites the record of the entry.
+void hosts::safe_write(const entry& host, bool tried)
+{
+    // Every change of an entry passes through here, including each push.
+    host.share();
+
+    if (host.slot != no_slot && file_.is_open())
+        file_.write(host.slot, host.to_record(tried));
+}
+
+// private
+// Must be called under a unique lock.
+void hosts::safe_clear()
+{
+    changed_ = true;
+    new_.clear();
+    tried_.clear();
+    index_.clear();
+    free_.clear();
+}
+
+// Scoring.
+// ----------------------------------------------------------------------------
+
+// static
+uint32_t hosts::now()
+{
+    return static_cast<uint32_t>(std::time(nullptr));
+}
+
+// static
+// The relative likelihood that a connection to the host succeeds quickly.
+double hosts::chance(const score_state& host, uint32_t now)
+{
+    const auto relaxed = std::memory_order_relaxed;
+    auto result = 1.0;
+
+    if (now - host.last_attempt.load(relaxed) < retry_seconds)
+        result *= 0.01;
+
+    // Each failure since the last success reduces the chance by a third.
+    result *= std::pow(0.66, std::min(host.failures.load(relaxed), 8u));
+
+    // Among responsive hosts prefer those that connect faster.
+    return result / (1.0 + host.latency_milliseconds.load(relaxed) / 1000.0);
 }
 
 size_t hosts::count() const
@@ -56,49 +294,395 @@ size_t hosts::count() const
     // Critical Section
     shared_lock lock(mutex_);
 
-    return buffer_.size();
+    return new_.size() + tried_.size();
     ///////////////////////////////////////////////////////////////////////////
 }
 
-code hosts::fetch(address& out)
+// Each table node holds an entry and two links, and the shared scores of the
+// entry and their counts. Each index node holds an address, its location and
+// a link.
+size_t hosts::footprint() const
 {
+    static constexpr auto entry_size = sizeof(entry) + 2 * sizeof(void*) +
+        sizeof(score_state) + 2 * sizeof(void*);
+    static constexpr auto node_size = sizeof(address) + sizeof(location) +
+        sizeof(void*);
+
     ///////////////////////////////////////////////////////////////////////////
     // Critical Section
     shared_lock lock(mutex_);
 
-    if (buffer_.empty())
+    const auto published = std::atomic_load(&snapshot_);
+
+    // The snapshot holds an address and score reference of each entry.
+    return (new_.size() + tried_.size()) * entry_size +
+        index_.size() * node_size + index_.bucket_count() * sizeof(void*) +
+        free_.capacity() * sizeof(uint32_t) + (published->fresh.capacity() +
+        published->tried.capacity()) * sizeof(candidate);
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// Snapshot.
+// ----------------------------------------------------------------------------
+// Each writer that adds, moves or removes entries publishes one snapshot
+// before it releases the lock, so a batch of addresses is published once.
+// Attempts and results change only the shared scores, which fetch reads
+// live, so they do not publish. Fetch never takes the lock.
+
+// private
+// Must be called under a unique lock, publishes only if the tables changed.
+void hosts::safe_publish()
+{
+    if (!changed_)
+        return;
+
+    const auto copy = std::make_shared<snapshot>();
+    copy->fresh.reserve(new_.size());
+    copy->tried.reserve(tried_.size());
+
+    for (const auto& entry: new_)
+        copy->fresh.push_back({ entry.host, entry.shared });
+
+    for (const auto& entry: tried_)
+        copy->tried.push_back({ entry.host, entry.shared });
+
+    std::atomic_store(&snapshot_, snapshot_ptr(copy));
+    changed_ = false;
+}
+
+code hosts::fetch(address& out)
+{
+    // The snapshot is immutable and its scores atomic, so this takes no lock.
+    const auto tables = std::atomic_load(&snapshot_);
+    const auto& fresh = tables->fresh;
+    const auto& tried = tables->tried;
+
+    if (fresh.empty() && tried.empty())
+        return error::not_found;
+
+    // Select the tried table half of the time, when both are populated.
+    const auto use_tried = fresh.empty() ||
+        (!tried.empty() && pseudo_random() % 2 == 0);
+    const auto& table = use_tried ? tried : fresh;
+    const auto time = now();
+
+    // Keep the most promising of a few randomly-selected addresses.
+    auto best = static_cast<size_t>(pseudo_random() % table.size());
+    auto best_chance = chance(*table[best].shared, time);
+
+    for (size_t round = 1; round < fetch_candidates; ++round)
+    {
+        const auto index = static_cast<size_t>(pseudo_random() % table.size());
+        const auto candidate = chance(*table[index].shared, time);
+
+        if (candidate > best_chance)
+        {
+            best = index;
+            best_chance = candidate;
+        }
+    }
+
+    out = table[best].host;
+    return error::success;
+}
+
+code hosts::attempt(const address& host)
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    list* table;
+    iterator it;
+    if (!find(table, it, host))
+        return error::not_found;
+
+    it->last_attempt = now();
+    it->started = clock::now();
+    safe_write(*it, table == &tried_);
+    return error::success;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+code hosts::score(const address& host, const code& result)
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    const auto ec = safe_score(host, result);
+
+    // A promotion, demotion or removal moves the entry.
+    safe_publish();
+    return ec;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// private
+// Must be called under a unique lock.
+code hosts::safe_score(const address& host, const code& result)
+{
+    list* table;
+    iterator it;
+    if (!find(table, it, host))
+        return error::not_found;
+
+    if (!result)
+    {
+        const auto latency = std::chrono::duration_cast<
+            std::chrono::milliseconds>(clock::now() - it->started);
+
+        it->failures = 0;
+        it->last_success = now();
+        it->latency_milliseconds = static_cast<uint32_t>(latency.count());
+
+        // A new address is promoted to the tried table on its first success.
+        if (table == &new_)
+        {
+            const auto promoted = *it;
+            new_.erase(it);
+            safe_push(tried_, promoted);
+            return error::success;
+        }
+
+        safe_write(*it, true);
+        return error::success;
+    }
+
+    ++it->failures;
+
+    if (table == &tried_)
+    {
+        // A tried address that has stopped responding gets a fresh start.
+        if (it->failures >= tried_failure_limit)
+        {
+            auto demoted = *it;
+            demoted.failures = 0;
+            tried_.erase(it);
+            safe_push(new_, demoted);
+            return error::success;
+        }
+
+        safe_write(*it, true);
+        return error::success;
+    }
+
+    const auto limit = it->last_success == 0 ? new_failure_limit :
+        tried_failure_limit;
+
+    if (it->failures >= limit)
+        safe_erase(new_, it);
+    else
+        safe_write(*it, false);
+
+    return error::success;
+}
+
+// Sampling.
+// ----------------------------------------------------------------------------
+
+code hosts::sample(const_buffer& out)
+{
+    const auto time = clock::now();
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    sample_mutex_.lock_shared();
+
+    if (sample_.size() != 0 && time < sample_expiration_)
+    {
+        out = sample_;
+        sample_mutex_.unlock_shared();
+        //---------------------------------------------------------------------
+        return error::success;
+    }
+
+    sample_mutex_.unlock_shared();
+    ///////////////////////////////////////////////////////////////////////////
+
+    const auto packet = safe_sample();
+
+    if (packet.addresses.empty())
         return error::not_found;
 
-    // Randomly select an address from the buffer.
-    const auto index = static_cast<size_t>(pseudo_random() % buffer_.size());
-    out = buffer_[index];
+    const const_buffer buffer(message::serialize(packet, magic_));
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(sample_mutex_);
+
+    // Concurrent refreshes are harmless, the last one is retained.
+    sample_ = buffer;
+    sample_expiration_ = time + sample_lifetime_;
+    out = buffer;
     return error::success;
     ///////////////////////////////////////////////////////////////////////////
 }
 
+// private
+// Tried hosts and new hosts without failures, in random order.
+message::address hosts::safe_sample() const
+{
+    message::address packet;
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    shared_lock lock(mutex_);
+
+    auto& out = packet.addresses;
+    out.reserve(tried_.size() + new_.size());
+
+    for (const auto table: { &tried_, &new_ })
+    {
+        for (const auto& entry: *table)
+        {
+            if (table == &new_ && entry.failures != 0)
+                continue;
+
+            out.push_back(entry.host);
+            auto& host = out.back();
+            host.timestamp = std::max(host.timestamp, entry.last_success);
+        }
+    }
+    ///////////////////////////////////////////////////////////////////////////
+
+    // Partially shuffle, so that only the sampled hosts are selected.
+    const auto count = std::min(out.size(), sample_size);
+
+    for (size_t index = 0; index < count; ++index)
+    {
+        const auto remaining = out.size() - index;
+        const auto other = index + pseudo_random() % remaining;
+        std::swap(out[index], out[static_cast<size_t>(other)]);
+    }
+
+    out.resize(count);
+    return packet;
+}
+
+// Persistence.
+// ----------------------------------------------------------------------------
+
 code hosts::load()
 {
     if (disabled_)
         return error::success;
 
+    const auto capacity = new_capacity_ + tried_capacity_;
+    std::vector<entry> imported;
+    std::vector<bool> tried;
+
     ///////////////////////////////////////////////////////////////////////////
     // Critical Section
     unique_lock lock(mutex_);
 
-    bc::ifstream file(file_path_.string());
-    if (file.bad())
+    // The file replaces the pool, so a restart does not duplicate slots.
+    safe_clear();
+
+    if (file_.open())
+    {
+        // Records are read in place, there is nothing to parse.
+        for (uint32_t slot = 0; slot < file_.capacity(); ++slot)
+        {
+            const auto& record = file_.read(slot);
+
+            if (record.state == hosts_file::table::empty)
+                continue;
+
+            imported.emplace_back(record, slot);
+            tried.push_back(record.state == hosts_file::table::tried);
+        }
+
+        // A file of another capacity is rewritten once, below.
+        if (file_.capacity() != capacity)
+        {
+            for (auto& host: imported)
+                host.slot = no_slot;
+
+            file_.close();
+        }
+    }
+    else
+    {
+        // A file of the earlier line-oriented format is imported once.
+        safe_import(imported);
+        tried.resize(imported.size(), false);
+    }
+
+    if (!file_.is_open() && !file_.create(capacity))
+    {
+        // The cleared pool is published, as it is no longer loaded.
+        safe_publish();
         return error::file_system;
+    }
+
+    std::vector<bool> used(capacity, false);
+    for (const auto& host: imported)
+        if (host.slot != no_slot)
+            used[host.slot] = true;
+
+    // Allocate the lowest slots first.
+    for (auto slot = static_cast<uint32_t>(capacity); slot > 0; --slot)
+        if (!used[slot - 1])
+            free_.push_back(slot - 1);
+
+    for (size_t index = 0; index < imported.size(); ++index)
+    {
+        const auto& host = imported[index];
+
+        // A redundant record is released, as it was never indexed.
+        if (!safe_push(host, tried[index]) && host.slot != no_slot)
+        {
+            file_.clear(host.slot);
+            free_.push_back(host.slot);
+        }
+    }
+
+    safe_publish();
+    timer_->start(std::bind(&hosts::handle_timer, shared_from_this(), _1));
+    return error::success;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// private
+// Must be called under a unique lock, a missing file imports nothing.
+void hosts::safe_import(std::vector<entry>& out)
+{
+    if (hosts_file::recognized(file_path_))
+        return;
+
+    bc::ifstream file(file_path_.string());
+    if (!file.good())
+        return;
 
-    // Formerly each address was randomly-queued for insert here.
     std::string line;
     while (std::getline(file, line))
     {
         config::authority host(line);
         if (host.port() != 0)
-            buffer_.push_back(host.to_network_address());
+            out.emplace_back(host.to_network_address());
     }
+}
+
+// Records are written as they change, this only pushes them to disk.
+void hosts::handle_timer(const code& ec)
+{
+    if (ec)
+        return;
 
-    return error::success;
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    shared_lock lock(mutex_);
+
+    // The file is closed by save, which ends the flush cycle.
+    if (!file_.is_open())
+        return;
+
+    if (!file_.flush(true))
+        LOG_DEBUG(LOG_NETWORK)
+            << "Failed to flush hosts file.";
+
+    timer_->start(std::bind(&hosts::handle_timer, shared_from_this(), _1));
     ///////////////////////////////////////////////////////////////////////////
 }
 
@@ -107,18 +691,14 @@ code hosts::save()
     if (disabled_)
         return error::success;
 
+    timer_->stop();
+
     ///////////////////////////////////////////////////////////////////////////
     // Critical Section
     unique_lock lock(mutex_);
 
-    bc::ofstream file(file_path_.string());
-    if (file.bad())
-        return error::file_system;
-
-    for (const auto& entry: buffer_)
-        file << config::authority(entry) << std::endl;
-
-    return error::success;
+    // The records are current, so save only flushes and closes the file.
+    return file_.close() ? error::success : error::file_system;
     ///////////////////////////////////////////////////////////////////////////
 }
 
@@ -128,12 +708,14 @@ code hosts::remove(const address& host)
     // Critical Section
     mutex_.lock_upgrade();
 
-    auto it = find(host);
-    if (it != buffer_.end())
+    list* table;
+    iterator it;
+    if (find(table, it, host))
     {
         //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
         mutex_.unlock_upgrade_and_lock();
-        buffer_.erase(it);
+        safe_erase(*table, it);
+        safe_publish();
         mutex_.unlock();
         //---------------------------------------------------------------------
         return error::success;
@@ -149,7 +731,7 @@ code hosts::store(const address& host)
 {
     if (!host.is_valid())
     {
-        log::debug(LOG_PROTOCOL)
+        LOG_DEBUG(LOG_PROTOCOL)
             << "Invalid host address from peer";
 
         // We don't treat invalid address as an error, just log it.
@@ -160,11 +742,12 @@ code hosts::store(const address& host)
     // Critical Section
     mutex_.lock_upgrade();
 
-    if (find(host) == buffer_.end())
+    if (index_.find(host) == index_.end())
     {
         //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
         mutex_.unlock_upgrade_and_lock();
-        buffer_.push_back(host);
+        safe_push(host);
+        safe_publish();
         mutex_.unlock();
         //---------------------------------------------------------------------
         return error::success;
@@ -173,24 +756,62 @@ code hosts::store(const address& host)
     mutex_.unlock_upgrade();
     ///////////////////////////////////////////////////////////////////////////
 
-    log::debug(LOG_PROTOCOL)
+    LOG_DEBUG(LOG_PROTOCOL)
         << "Redundant host address from peer";
 
     // We don't treat redundant address as an error, just log it.
     return error::success;
 }
 
-void hosts::do_store(const address& host, result_handler handler)
+void hosts::store(const address::list& hosts, result_handler handler)
 {
-    handler(store(host));
+    // The batch is stored on another thread, taking the lock once.
+    dispatch_.concurrent(&hosts::do_store,
+        shared_from_this(), hosts, handler);
 }
 
-void hosts::store(const address::list& hosts, result_handler handler)
+void hosts::do_store(const address::list& hosts, result_handler handler)
 {
-    // The handler is invoked once all calls to do_store are completed.
-    // We disperse here to allow other addresses messages to interleave hosts.
-    dispatch_.parallel(hosts, "hosts", handler,
-        &hosts::do_store, shared_from_this());
+    size_t invalid = 0;
+    size_t redundant = 0;
+
+    // Validate and de-duplicate the batch before taking the lock.
+    address_set batch;
+    batch.reserve(hosts.size());
+    std::vector<const address*> accepted;
+    accepted.reserve(hosts.size());
+
+    for (const auto& host: hosts)
+    {
+        if (!host.is_valid())
+            ++invalid;
+        else if (!batch.insert(host).second)
+            ++redundant;
+        else
+            accepted.push_back(&host);
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    mutex_.lock();
+
+    for (const auto host: accepted)
+        if (!safe_push(*host))
+            ++redundant;
+
+    // The batch is published once.
+    safe_publish();
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    if (invalid != 0 || redundant != 0)
+        LOG_DEBUG(LOG_PROTOCOL)
+            << "Ignored " << invalid << " invalid and " << redundant
+            << " redundant host addresses from peer";
+
+    // We don't treat invalid or redundant addresses as errors.
+    handler(error::success);
 }
 
 } // namespace network
@@ -0,0 +1,172 @@
+/**
+ * Copyright (c) 2011-2016 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/network/hosts_file.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <boost/filesystem.hpp>
+#include <boost/interprocess/exceptions.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <bitcoin/bitcoin.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+using namespace boost::interprocess;
+
+// The magic is also a byte order marker.
+static constexpr uint32_t magic = 0x74736f68;
+static constexpr uint32_t version = 1;
+
+static_assert(sizeof(hosts_file::record) == 48, "unexpected record size");
+
+// static
+bool hosts_file::read_header(const boost::filesystem::path& path,
+    header& out)
+{
+    bc::ifstream file(path.string(), std::ios::binary);
+    if (!file.good())
+        return false;
+
+    file.read(reinterpret_cast<char*>(&out), sizeof(out));
+    return file.good() && out.magic == magic && out.version == version;
+}
+
+// static
+bool hosts_file::recognized(const boost::filesystem::path& path)
+{
+    header head;
+    return read_header(path, head);
+}
+
+hosts_file::hosts_file(const boost::filesystem::path& path)
+  : capacity_(0), path_(path)
+{
+}
+
+hosts_file::~hosts_file()
+{
+    close();
+}
+
+bool hosts_file::open()
+{
+    close();
+
+    header head;
+    if (!read_header(path_, head))
+        return false;
+
+    boost::system::error_code ec;
+    const auto size = boost::filesystem::file_size(path_, ec);
+    const auto expected = sizeof(header) + head.capacity * sizeof(record);
+
+    // A truncated file is not recognized.
+    if (ec || size != expected)
+        return false;
+
+    try
+    {
+        const file_mapping file(path_.string().c_str(), read_write);
+        mapped_region(file, read_write).swap(region_);
+    }
+    catch (const interprocess_exception&)
+    {
+        return false;
+    }
+
+    capacity_ = head.capacity;
+    return true;
+}
+
+bool hosts_file::create(size_t capacity)
+{
+    close();
+
+    bc::ofstream file(path_.string(), std::ios::binary | std::ios::trunc);
+    if (!file.good())
+        return false;
+
+    const header head{ magic, version, static_cast<uint32_t>(capacity), 0 };
+    file.write(reinterpret_cast<const char*>(&head), sizeof(head));
+    file.close();
+
+    // The extension is zero-filled, so every slot starts out empty.
+    boost::system::error_code ec;
+    const auto size = sizeof(header) + capacity * sizeof(record);
+    boost::filesystem::resize_file(path_, size, ec);
+
+    return !ec && open();
+}
+
+bool hosts_file::close()
+{
+    if (!is_open())
+        return true;
+
+    const auto result = flush(false);
+    mapped_region().swap(region_);
+    capacity_ = 0;
+    return result;
+}
+
+bool hosts_file::flush(bool asynchronous)
+{
+    return !is_open() || region_.flush(0, 0, asynchronous);
+}
+
+bool hosts_file::is_open() const
+{
+    return region_.get_address() != nullptr;
+}
+
+size_t hosts_file::capacity() const
+{
+    return capacity_;
+}
+
+hosts_file::record* hosts_file::records() const
+{
+    const auto start = static_cast<uint8_t*>(region_.get_address());
+    return reinterpret_cast<record*>(start + sizeof(header));
+}
+
+const hosts_file::record& hosts_file::read(size_t slot) const
+{
+    BITCOIN_ASSERT(slot < capacity_);
+    return records()[slot];
+}
+
+void hosts_file::write(size_t slot, const record& value)
+{
+    BITCOIN_ASSERT(slot < capacity_);
+    std::memcpy(&records()[slot], &value, sizeof(record));
+}
+
+void hosts_file::clear(size_t slot)
+{
+    BITCOIN_ASSERT(slot < capacity_);
+    std::memset(&records()[slot], 0, sizeof(record));
+}
+
+} // namespace network
+} // namespace libbitcoin
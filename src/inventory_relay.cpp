@@ -0,0 +1,140 @@
+/**
+ * Copyright (c) 2011-2016 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/network/inventory_relay.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/channel.hpp>
+#include <bitcoin/network/connections.hpp>
+#include <bitcoin/network/logging.hpp>
+#include <bitcoin/network/settings.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+using namespace bc::message;
+using std::placeholders::_1;
+
+// The protocol limit of items in one inventory message.
+static constexpr size_t max_inventory = 50000;
+
+inventory_relay::inventory_relay(threadpool& pool,
+    connections::ptr connections, const settings& settings)
+  : stopped_(true),
+    connections_(connections),
+    timer_(std::make_shared<deadline>(pool, settings.channel_trickle())),
+    interval_(settings.channel_trickle())
+{
+}
+
+void inventory_relay::start()
+{
+    stopped_ = false;
+    start_timer();
+}
+
+void inventory_relay::stop()
+{
+    stopped_ = true;
+    timer_->stop();
+}
+
+void inventory_relay::announce(const inventory_vector::list& items)
+{
+    if (stopped_ || items.empty())
+        return;
+
+    // Items are queued now and sent on the next trickle.
+    const auto queue = [&items](channel::ptr channel)
+    {
+        channel->inventory().queue(items);
+    };
+
+    connections_->visit(queue);
+}
+
+// Trickle sequence.
+// ----------------------------------------------------------------------------
+
+// The interval is randomized so announcement timing is less revealing.
+void inventory_relay::start_timer()
+{
+    if (stopped_)
+        return;
+
+    timer_->start(
+        std::bind(&inventory_relay::handle_timer,
+            shared_from_this(), _1), pseudo_randomize(interval_));
+}
+
+void inventory_relay::handle_timer(const code& ec)
+{
+    if (ec || stopped_)
+        return;
+
+    connections_->visit(
+        std::bind(&inventory_relay::flush,
+            shared_from_this(), _1));
+
+    start_timer();
+}
+
+void inventory_relay::flush(channel::ptr channel)
+{
+    auto items = channel->inventory().take();
+
+    // Transactions are not announced to a peer that declined their relay.
+    if (!channel->version().relay)
+    {
+        const auto transaction = [](const inventory_vector& item)
+        {
+            return item.type == inventory_type_id::transaction;
+        };
+
+        items.erase(std::remove_if(items.begin(), items.end(), transaction),
+            items.end());
+    }
+
+    for (auto it = items.begin(); it != items.end();)
+    {
+        const auto remaining = static_cast<size_t>(items.end() - it);
+        const auto end = it + std::min(remaining, max_inventory);
+
+        channel->send(inventory(inventory_vector::list(it, end)),
+            std::bind(&inventory_relay::handle_send,
+                shared_from_this(), _1, channel));
+
+        it = end;
+    }
+}
+
+void inventory_relay::handle_send(const code& ec, channel::ptr channel)
+{
+    // A failed send stops the channel, so there is nothing to do here.
+    if (ec)
+        LOG_DEBUG(LOG_NETWORK)
+            << "Failure relaying inventory to [" << channel->authority()
+            << "] " << ec.message();
+}
+
+} // namespace network
+} // namespace libbitcoin
@@ -0,0 +1,144 @@
+/**
+ * Copyright (c) 2011-2016 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/network/latency_histogram.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <bitcoin/bitcoin.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+using namespace std::chrono;
+
+constexpr size_t latency_histogram::bucket_count;
+
+// A power of two is divided into (1 << sub_bits) buckets.
+static constexpr size_t sub_bits = 3;
+static constexpr size_t sub_count = 1 << sub_bits;
+
+// static
+// Values below sub_count have a bucket each, the rest share by exponent.
+size_t latency_histogram::to_bucket(uint64_t microseconds)
+{
+    if (microseconds < sub_count)
+        return static_cast<size_t>(microseconds);
+
+    size_t exponent = 0;
+    for (auto value = microseconds; value > 1; value >>= 1)
+        ++exponent;
+
+    const auto shift = exponent - sub_bits;
+    const auto sub = static_cast<size_t>(microseconds >> shift) - sub_count;
+    return (shift + 1) * sub_count + sub;
+}
+
+// static
+uint64_t latency_histogram::to_upper(size_t bucket)
+{
+    if (bucket < sub_count)
+        return bucket;
+
+    const auto shift = bucket / sub_count - 1;
+    const auto sub = bucket % sub_count;
+    const auto lower = uint64_t(sub_count + sub) << shift;
+    return lower + ((uint64_t(1) << shift) - 1);
+}
+
+latency_histogram::latency_histogram()
+  : count_(0), total_(0), maximum_(0)
+{
+    for (auto& bucket: buckets_)
+        bucket.store(0);
+}
+
+void latency_histogram::record(const clock::duration& elapsed)
+{
+    const auto value = duration_cast<microseconds>(elapsed).count();
+    record(value < 0 ? 0 : static_cast<uint64_t>(value));
+}
+
+void latency_histogram::record(uint64_t microseconds)
+{
+    buckets_[to_bucket(microseconds)].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    total_.fetch_add(microseconds, std::memory_order_relaxed);
+
+    auto maximum = maximum_.load(std::memory_order_relaxed);
+    while (microseconds > maximum && !maximum_.compare_exchange_weak(maximum,
+        microseconds, std::memory_order_relaxed))
+    {
+    }
+}
+
+uint64_t latency_histogram::count() const
+{
+    return count_.load(std::memory_order_relaxed);
+}
+
+// The rank is taken from the bucket counts, as count_ may be ahead of them.
+uint64_t latency_histogram::percentile(double fraction) const
+{
+    std::array<uint64_t, bucket_count> counts;
+    uint64_t total = 0;
+
+    for (size_t index = 0; index < bucket_count; ++index)
+    {
+        counts[index] = buckets_[index].load(std::memory_order_relaxed);
+        total += counts[index];
+    }
+
+    if (total == 0)
+        return 0;
+
+    const auto bounded = std::max(0.0, std::min(1.0, fraction));
+    const auto rank = std::max(uint64_t(1),
+        static_cast<uint64_t>(bounded * total + 0.5));
+
+    uint64_t seen = 0;
+    for (size_t index = 0; index < bucket_count; ++index)
+    {
+        seen += counts[index];
+
+        if (seen >= rank)
+            return std::min(to_upper(index), maximum_.load());
+    }
+
+    return maximum_.load();
+}
+
+latency_histogram::summary latency_histogram::summarize() const
+{
+    summary out;
+    out.count = count();
+    out.total_microseconds = total_.load();
+    out.mean_microseconds = out.count == 0 ? 0 :
+        out.total_microseconds / out.count;
+    out.p50_microseconds = percentile(0.5);
+    out.p99_microseconds = percentile(0.99);
+    out.p999_microseconds = percentile(0.999);
+    out.maximum_microseconds = maximum_.load();
+    return out;
+}
+
+} // namespace network
+} // namespace libbitcoin
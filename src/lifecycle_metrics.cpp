@@ -0,0 +1,83 @@
+/**
+ * Copyright (c) 2011-2016 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/network/lifecycle_metrics.hpp>
+
+#include <cstddef>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/latency_histogram.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+constexpr size_t lifecycle_metrics::origin_count;
+constexpr size_t lifecycle_metrics::phase_count;
+
+lifecycle_metrics::lifecycle_metrics()
+{
+}
+
+// An inbound channel has no resolve or connect phase, so the total of a
+// channel begins at its earliest time.
+void lifecycle_metrics::record(origin source, const timeline& times)
+{
+    const clock::time_point unset;
+    const auto first = times.resolving != unset ? times.resolving :
+        times.connecting != unset ? times.connecting : times.connected;
+
+    record(source, phase::resolve, times.resolving, times.connecting);
+    record(source, phase::connect, times.connecting, times.connected);
+    record(source, phase::pend, times.connected, times.handshaking);
+    record(source, phase::handshake, times.handshaking, times.handshaken);
+    record(source, phase::store, times.handshaken, times.started);
+    record(source, phase::total, first, times.started);
+}
+
+void lifecycle_metrics::record(origin source, phase step,
+    const clock::time_point& begin, const clock::time_point& end)
+{
+    const clock::time_point unset;
+
+    if (begin == unset || end == unset)
+        return;
+
+    histograms_[static_cast<size_t>(source)]
+        [static_cast<size_t>(step)].record(end - begin);
+}
+
+latency_histogram::summary lifecycle_metrics::summarize(origin source,
+    phase step) const
+{
+    return histograms_[static_cast<size_t>(source)]
+        [static_cast<size_t>(step)].summarize();
+}
+
+lifecycle_metrics::statistics lifecycle_metrics::snapshot() const
+{
+    statistics out;
+
+    for (size_t source = 0; source < origin_count; ++source)
+        for (size_t step = 0; step < phase_count; ++step)
+            out[source][step] = histograms_[source][step].summarize();
+
+    return out;
+}
+
+} // namespace network
+} // namespace libbitcoin
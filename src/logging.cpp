@@ -19,18 +19,39 @@
  */
 #include <bitcoin/network/logging.hpp>
 
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <iostream>
+#include <memory>
 #include <utility>
 #include <sstream>
 #include <string>
+#include <thread>
 #include <boost/date_time.hpp>
 #include <boost/format.hpp>
 #include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/settings.hpp>
 
 namespace libbitcoin {
 namespace network {
 
+// The runtime minimum log level, relaxed as it only gates formatting.
+static std::atomic<int> minimum_level(static_cast<int>(log::level::debug));
+
+void set_log_level(log::level level)
+{
+    minimum_level.store(static_cast<int>(level), std::memory_order_relaxed);
+}
+
+bool log_enabled(log::level level)
+{
+    return static_cast<int>(level) >=
+        minimum_level.load(std::memory_order_relaxed);
+}
+
 // Guard against concurrent console writes.
 static shared_mutex console_mutex;
 
@@ -38,14 +59,16 @@ static shared_mutex console_mutex;
 static shared_mutex file_mutex;
 
 static std::string make_log_string(log::level level, const std::string& domain,
-    const std::string& body)
+    const std::string& body,
+    const boost::posix_time::ptime& time=
+        boost::posix_time::microsec_clock::local_time())
 {
     if (body.empty())
         return "";
 
     static const auto form = "%1% %2% [%3%] %4%\n";
     const auto message = boost::format(form) %
-        boost::posix_time::microsec_clock::local_time().time_of_day() %
+        time.time_of_day() %
         log::to_text(level) %
         domain %
         body;
@@ -135,6 +158,337 @@ static void error_both(std::ofstream& file, std::ostream& error,
     log_to_both(error, file, level, domain, body);
 }
 
+// Asynchronous logging.
+// ----------------------------------------------------------------------------
+// Each level has a bounded multiple-producer ring (Vyukov sequence cells).
+// Producers never block, a message is counted and dropped if its ring is full.
+// The single writer formats and writes in batches, flushing each device when
+// the batch is drained and the flush interval or byte threshold is reached.
+
+static constexpr size_t level_count = 5;
+static constexpr size_t flush_bytes = 64 * 1024;
+static constexpr auto idle_sleep = std::chrono::milliseconds(5);
+
+struct log_entry
+{
+    log::level level;
+    std::string domain;
+    std::string body;
+    boost::posix_time::ptime time;
+};
+
+class log_ring
+{
+public:
+    log_ring(size_t capacity)
+      : mask_(round_up(capacity) - 1),
+        cells_(new cell[mask_ + 1]),
+        enqueue_(0),
+        dequeue_(0)
+    {
+        for (size_t index = 0; index <= mask_; ++index)
+            cells_[index].sequence.store(index, std::memory_order_relaxed);
+    }
+
+    bool push(log_entry&& entry)
+    {
+        auto position = enqueue_.load(std::memory_order_relaxed);
+
+        while (true)
+        {
+            auto& slot = cells_[position & mask_];
+            const auto sequence = slot.sequence.load(std::memory_order_acquire);
+            const auto difference = static_cast<intptr_t>(sequence) -
+                static_cast<intptr_t>(position);
+
+            if (difference < 0)
+                return false;
+
+            if (difference == 0 && enqueue_.compare_exchange_weak(position,
+                position + 1, std::memory_order_relaxed))
+            {
+                slot.entry = std::move(entry);
+                slot.sequence.store(position + 1, std::memory_order_release);
+                return true;
+            }
+
+            if (difference != 0)
+                position = enqueue_.load(std::memory_order_relaxed);
+        }
+    }
+
+    // Only the writer thread pops.
+    bool pop(log_entry& out)
+    {
+        const auto position = dequeue_.load(std::memory_order_relaxed);
+        auto& slot = cells_[position & mask_];
+        const auto sequence = slot.sequence.load(std::memory_order_acquire);
+
+        if (sequence != position + 1)
+            return false;
+
+        out = std::move(slot.entry);
+        dequeue_.store(position + 1, std::memory_order_relaxed);
+        slot.sequence.store(position + mask_ + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    struct cell
+    {
+        std::atomic<size_t> sequence;
+        log_entry entry;
+    };
+
+    static size_t round_up(size_t capacity)
+    {
+        size_t size = 2;
+        while (size < capacity)
+            size <<= 1;
+
+        return size;
+    }
+
+    const size_t mask_;
+    std::unique_ptr<cell[]> cells_;
+    std::atomic<size_t> enqueue_;
+    std::atomic<size_t> dequeue_;
+};
+
+class log_writer
+{
+public:
+    log_writer(std::ofstream& debug, std::ofstream& error,
+        std::ostream& output_stream, std::ostream& error_stream,
+        size_t capacity, const asio::duration& flush_interval)
+      : debug_(debug),
+        error_(error),
+        output_stream_(output_stream),
+        error_stream_(error_stream),
+        flush_interval_(flush_interval.total_milliseconds()),
+        stopped_(false),
+        dropped_(0),
+        reported_(0)
+    {
+        for (size_t level = 0; level < level_count; ++level)
+            rings_[level].reset(new log_ring(capacity));
+
+        thread_ = std::thread(std::bind(&log_writer::run, this));
+    }
+
+    ~log_writer()
+    {
+        stop();
+    }
+
+    // Drain the queue and join the writer thread, this is not thread safe.
+    void stop()
+    {
+        if (!thread_.joinable())
+            return;
+
+        stopped_ = true;
+        thread_.join();
+    }
+
+    void enqueue(log::level level, const std::string& domain,
+        const std::string& body)
+    {
+        if (body.empty())
+            return;
+
+        const auto time = boost::posix_time::microsec_clock::local_time();
+        auto& ring = *rings_[static_cast<size_t>(level)];
+
+        if (!ring.push({ level, domain, body, time }))
+            ++dropped_;
+    }
+
+    uint64_t dropped() const
+    {
+        return dropped_;
+    }
+
+private:
+    typedef std::chrono::steady_clock clock;
+
+    void run()
+    {
+        auto last_flush = clock::now();
+        size_t unflushed = 0;
+
+        while (true)
+        {
+            const auto stopping = stopped_.load();
+            const auto written = drain();
+            unflushed += written;
+
+            const auto elapsed = clock::now() - last_flush;
+            const auto due = elapsed >= flush_interval_;
+
+            if (unflushed != 0 && (stopping || due || unflushed >= flush_bytes))
+            {
+                flush();
+                unflushed = 0;
+                last_flush = clock::now();
+            }
+
+            // The final drain follows the stop flag, so nothing is lost.
+            if (stopping)
+                break;
+
+            if (written == 0)
+                std::this_thread::sleep_for(idle_sleep);
+        }
+    }
+
+    // Returns the number of bytes written.
+    size_t drain()
+    {
+        size_t bytes = 0;
+        log_entry entry;
+
+        for (size_t level = 0; level < level_count; ++level)
+        {
+            while (rings_[level]->pop(entry))
+            {
+                const auto message = make_log_string(entry.level,
+                    entry.domain, entry.body, entry.time);
+                write(entry.level, message);
+                bytes += message.size();
+            }
+        }
+
+        const uint64_t dropped = dropped_;
+
+        if (dropped != reported_)
+        {
+            const auto message = make_log_string(log::level::warning,
+                LOG_NETWORK, "Dropped " + std::to_string(dropped - reported_) +
+                " log messages.");
+            write(log::level::warning, message);
+            bytes += message.size();
+            reported_ = dropped;
+        }
+
+        return bytes;
+    }
+
+    // This replicates the synchronous level to device mapping.
+    void write(log::level level, const std::string& message)
+    {
+        switch (level)
+        {
+            case log::level::debug:
+                debug_ << message;
+                break;
+            case log::level::info:
+                debug_ << message;
+                write_console(output_stream_, message);
+                break;
+            case log::level::warning:
+                error_ << message;
+                break;
+            case log::level::error:
+            case log::level::fatal:
+                error_ << message;
+                write_console(error_stream_, message);
+                break;
+        }
+    }
+
+    void write_console(std::ostream& device, const std::string& message)
+    {
+        // Critical Section
+        ///////////////////////////////////////////////////////////////////////
+        unique_lock lock_console(console_mutex);
+
+        device << message;
+        device.flush();
+        ///////////////////////////////////////////////////////////////////////
+    }
+
+    void flush()
+    {
+        debug_.flush();
+        error_.flush();
+    }
+
+    std::ofstream& debug_;
+    std::ofstream& error_;
+    std::ostream& output_stream_;
+    std::ostream& error_stream_;
+    const std::chrono::milliseconds flush_interval_;
+
+    std::atomic<bool> stopped_;
+    std::atomic<uint64_t> dropped_;
+    uint64_t reported_;
+    std::unique_ptr<log_ring> rings_[level_count];
+    std::thread thread_;
+};
+
+// This is accessed by atomic load and store, as sinks run on any thread.
+// The sinks sample the writer, so a writer is never destroyed while a sink
+// is using it, and a sink that finds no writer discards the message.
+static std::shared_ptr<log_writer> writer;
+
+static void enqueue_log(log::level level, const std::string& domain,
+    const std::string& body)
+{
+    const auto current = std::atomic_load(&writer);
+
+    if (current)
+        current->enqueue(level, domain, body);
+}
+
+void initialize_logging(std::ofstream& debug, std::ofstream& error,
+    std::ostream& output_stream, std::ostream& error_stream,
+    const settings& settings)
+{
+    stop_logging();
+
+    if (settings.log_queue_capacity == 0)
+    {
+        initialize_logging(debug, error, output_stream, error_stream);
+        return;
+    }
+
+    std::atomic_store(&writer, std::make_shared<log_writer>(debug, error,
+        output_stream, error_stream, settings.log_queue_capacity,
+        settings.log_flush()));
+
+    // The sinks hold no writer reference, the writer is sampled per message.
+    log::debug("").set_output_function(enqueue_log);
+    log::info("").set_output_function(enqueue_log);
+    log::warning("").set_output_function(enqueue_log);
+    log::error("").set_output_function(enqueue_log);
+    log::fatal("").set_output_function(enqueue_log);
+}
+
+// The sinks remain registered, and discard messages once the writer is
+// detached. A message enqueued by a sink that sampled the writer before it
+// was detached may be discarded.
+void stop_logging()
+{
+    const auto detached = std::atomic_exchange(&writer,
+        std::shared_ptr<log_writer>());
+
+    if (!detached)
+        return;
+
+    // This drains the queue and joins the writer thread, after the detach.
+    detached->stop();
+}
+
+uint64_t dropped_log_messages()
+{
+    const auto current = std::atomic_load(&writer);
+    return current ? current->dropped() : 0;
+}
+
+// Synchronous logging.
+// ----------------------------------------------------------------------------
+
 void initialize_logging(std::ofstream& debug, std::ofstream& error,
     std::ostream& output_stream, std::ostream& error_stream)
 {
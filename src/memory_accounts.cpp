@@ -0,0 +1,86 @@
+/**
+ * Copyright (c) 2011-2016 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/network/memory_accounts.hpp>
+
+#include <cstddef>
+#include <bitcoin/bitcoin.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+constexpr size_t memory_accounts::category_count;
+
+memory_accounts::memory_accounts(size_t limit)
+  : limit_(limit)
+{
+    for (auto& count: counts_)
+        count.store(0);
+}
+
+void memory_accounts::add(category account, size_t bytes)
+{
+    counts_[static_cast<size_t>(account)] += bytes;
+}
+
+void memory_accounts::remove(category account, size_t bytes)
+{
+    counts_[static_cast<size_t>(account)] -= bytes;
+}
+
+void memory_accounts::set(category account, size_t bytes)
+{
+    counts_[static_cast<size_t>(account)].store(bytes);
+}
+
+size_t memory_accounts::bytes(category account) const
+{
+    return counts_[static_cast<size_t>(account)].load();
+}
+
+// Categories are read independently, so the total is not a snapshot.
+size_t memory_accounts::total() const
+{
+    size_t sum = 0;
+
+    for (const auto& count: counts_)
+        sum += count.load();
+
+    return sum;
+}
+
+bool memory_accounts::exhausted() const
+{
+    return limit_ != 0 && total() > limit_;
+}
+
+memory_accounts::usage memory_accounts::snapshot() const
+{
+    usage out;
+    out.receive = bytes(category::receive);
+    out.send = bytes(category::send);
+    out.hosts = bytes(category::hosts);
+    out.channels = bytes(category::channels);
+    out.total = out.receive + out.send + out.hosts + out.channels;
+    out.limit = limit_;
+    return out;
+}
+
+} // namespace network
+} // namespace libbitcoin
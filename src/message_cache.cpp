@@ -0,0 +1,120 @@
+/**
+ * Copyright (c) 2011-2016 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/network/message_cache.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/const_buffer.hpp>
+#include <bitcoin/network/message_checksum.hpp>
+#include <bitcoin/network/protocols/protocol_version.hpp>
+#include <bitcoin/network/settings.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+using namespace bc::message;
+
+// The checksum follows the magic, command and payload size of the heading.
+static constexpr size_t checksum_offset = 20;
+
+message_cache::message_cache(const settings& settings)
+  : magic_(settings.identifier),
+    verack_(serialize(message::verack(), magic_)),
+    get_address_(serialize(message::get_address(), magic_)),
+    self_address_(serialize(message::address(
+        { { settings.self.to_network_address() } }), magic_)),
+    template_(protocol_version::template_factory(config::authority(),
+        settings, 0, 0)),
+    version_(serialize(template_, magic_))
+{
+    // Each changed field differs from the template in its first byte. Only
+    // the payload is compared, since the heading checksum changes as well.
+    auto changed = template_;
+    changed.address_you.services = max_uint64;
+    address_offset_ = to_offset(version_, serialize(changed, magic_));
+
+    changed = template_;
+    changed.nonce = max_uint64;
+    nonce_offset_ = to_offset(version_, serialize(changed, magic_));
+
+    changed = template_;
+    changed.start_height = max_uint32;
+    height_offset_ = to_offset(version_, serialize(changed, magic_));
+}
+
+// static
+size_t message_cache::to_offset(const data_chunk& left,
+    const data_chunk& right)
+{
+    const auto heading_size = heading::serialized_size();
+    BITCOIN_ASSERT(left.size() == right.size());
+    BITCOIN_ASSERT(left.size() >= heading_size);
+    const auto payload = left.begin() + heading_size;
+    const auto pair = std::mismatch(payload, left.end(),
+        right.begin() + heading_size);
+    return std::distance(left.begin(), pair.first);
+}
+
+const_buffer message_cache::verack() const
+{
+    return verack_;
+}
+
+const_buffer message_cache::get_address() const
+{
+    return get_address_;
+}
+
+const_buffer message_cache::self_address() const
+{
+    return self_address_;
+}
+
+// The buffer is a new copy, as each channel patches its own fields.
+const_buffer message_cache::version(const config::authority& authority,
+    uint64_t nonce, size_t height) const
+{
+    BITCOIN_ASSERT_MSG(height < max_uint32, "Time to upgrade the protocol.");
+
+    data_chunk out(version_);
+
+    const auto you = authority.to_network_address().to_data(false);
+    std::copy(you.begin(), you.end(), out.begin() + address_offset_);
+
+    const auto nonce_bytes = to_little_endian(nonce);
+    std::copy(nonce_bytes.begin(), nonce_bytes.end(),
+        out.begin() + nonce_offset_);
+
+    const auto start = to_little_endian(static_cast<uint32_t>(height));
+    std::copy(start.begin(), start.end(), out.begin() + height_offset_);
+
+    const auto heading_size = heading::serialized_size();
+    const auto checksum = to_little_endian(message_checksum::compute(
+        out.data() + heading_size, out.size() - heading_size));
+    std::copy(checksum.begin(), checksum.end(), out.begin() + checksum_offset);
+
+    return const_buffer(std::move(out));
+}
+
+} // namespace network
+} // namespace libbitcoin
@@ -0,0 +1,451 @@
+/**
+ * Copyright (c) 2011-2016 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/network/message_checksum.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <bitcoin/bitcoin.hpp>
+
+// The SHA extensions kernel requires x86 intrinsics and target selection.
+#if (defined(__GNUC__) || defined(__clang__)) && \
+    (defined(__x86_64__) || defined(__i386__))
+    #define HAVE_SHA_NI
+    #define SHA_NI_TARGET __attribute__((target("sha,sse4.1,ssse3")))
+    #include <cpuid.h>
+    #include <immintrin.h>
+#elif defined(_MSC_VER) && (_MSC_VER >= 1900) && \
+    (defined(_M_X64) || defined(_M_IX86))
+    #define HAVE_SHA_NI
+    #define SHA_NI_TARGET
+    #include <intrin.h>
+    #include <immintrin.h>
+#endif
+
+namespace libbitcoin {
+namespace network {
+
+// SHA256 (FIPS 180-4) constants.
+// ----------------------------------------------------------------------------
+
+static const uint32_t initial[8] =
+{
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+    0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+static const uint32_t rounds[64] =
+{
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
+    0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+    0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+    0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+    0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+    0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
+    0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5,
+    0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+    0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+static inline uint32_t rotate(uint32_t value, size_t bits)
+{
+    return (value >> bits) | (value << (32 - bits));
+}
+
+static inline uint32_t read_big_endian(const uint8_t* data)
+{
+    return
+        (static_cast<uint32_t>(data[0]) << 24) |
+        (static_cast<uint32_t>(data[1]) << 16) |
+        (static_cast<uint32_t>(data[2]) << 8) |
+        (static_cast<uint32_t>(data[3]));
+}
+
+static inline void write_big_endian(uint8_t* data, uint32_t value)
+{
+    data[0] = static_cast<uint8_t>(value >> 24);
+    data[1] = static_cast<uint8_t>(value >> 16);
+    data[2] = static_cast<uint8_t>(value >> 8);
+    data[3] = static_cast<uint8_t>(value);
+}
+
+// Generic kernel.
+// ----------------------------------------------------------------------------
+
+static void transform_block(uint32_t* state, const uint8_t* block)
+{
+    uint32_t schedule[64];
+
+    for (size_t index = 0; index < 16; ++index)
+        schedule[index] = read_big_endian(block + index * 4);
+
+    for (size_t index = 16; index < 64; ++index)
+    {
+        const auto low = schedule[index - 15];
+        const auto high = schedule[index - 2];
+        const auto sigma0 = rotate(low, 7) ^ rotate(low, 18) ^ (low >> 3);
+        const auto sigma1 = rotate(high, 17) ^ rotate(high, 19) ^ (high >> 10);
+        schedule[index] = schedule[index - 16] + sigma0 +
+            schedule[index - 7] + sigma1;
+    }
+
+    auto a = state[0];
+    auto b = state[1];
+    auto c = state[2];
+    auto d = state[3];
+    auto e = state[4];
+    auto f = state[5];
+    auto g = state[6];
+    auto h = state[7];
+
+    for (size_t index = 0; index < 64; ++index)
+    {
+        const auto sum1 = rotate(e, 6) ^ rotate(e, 11) ^ rotate(e, 25);
+        const auto choose = (e & f) ^ (~e & g);
+        const auto first = h + sum1 + choose + rounds[index] + schedule[index];
+        const auto sum0 = rotate(a, 2) ^ rotate(a, 13) ^ rotate(a, 22);
+        const auto majority = (a & b) ^ (a & c) ^ (b & c);
+        const auto second = sum0 + majority;
+
+        h = g;
+        g = f;
+        f = e;
+        e = d + first;
+        d = c;
+        c = b;
+        b = a;
+        a = first + second;
+    }
+
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+    state[5] += f;
+    state[6] += g;
+    state[7] += h;
+}
+
+static void transform_generic(uint32_t* state, const uint8_t* blocks,
+    size_t count)
+{
+    for (; count > 0; --count, blocks += 64)
+        transform_block(state, blocks);
+}
+
+// SHA extensions kernel.
+// ----------------------------------------------------------------------------
+
+#ifdef HAVE_SHA_NI
+
+static bool cpu_supports_sha_ni()
+{
+    // Leaf 1 ECX: SSSE3 (bit 9) and SSE4.1 (bit 19), leaf 7 EBX: SHA (bit 29).
+    uint32_t features;
+    uint32_t extended;
+
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7)
+        return false;
+
+    __cpuid(info, 1);
+    features = static_cast<uint32_t>(info[2]);
+    __cpuidex(info, 7, 0);
+    extended = static_cast<uint32_t>(info[1]);
+#else
+    if (__get_cpuid_max(0, nullptr) < 7)
+        return false;
+
+    uint32_t eax, ebx, ecx, edx;
+    __cpuid(1, eax, ebx, ecx, edx);
+    features = ecx;
+    __cpuid_count(7, 0, eax, ebx, ecx, edx);
+    extended = ebx;
+#endif
+
+    return ((features >> 9) & 1) != 0 && ((features >> 19) & 1) != 0 &&
+        ((extended >> 29) & 1) != 0;
+}
+
+// Each group computes four rounds with paired sha256rnds2 instructions while
+// the message schedule for later groups is expanded with sha256msg1/2.
+SHA_NI_TARGET
+static void transform_sha_ni(uint32_t* state, const uint8_t* blocks,
+    size_t count)
+{
+    const auto mask = _mm_set_epi64x(0x0c0d0e0f08090a0bull,
+        0x0405060700010203ull);
+
+    // The instructions operate on the state as ABEF and CDGH word pairs.
+    auto cdab = _mm_loadu_si128(reinterpret_cast<const __m128i*>(state));
+    auto state1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(state + 4));
+    cdab = _mm_shuffle_epi32(cdab, 0xb1);
+    state1 = _mm_shuffle_epi32(state1, 0x1b);
+    auto state0 = _mm_alignr_epi8(cdab, state1, 8);
+    state1 = _mm_blend_epi16(state1, cdab, 0xf0);
+
+    for (; count > 0; --count, blocks += 64)
+    {
+        const auto abef = state0;
+        const auto cdgh = state1;
+        __m128i words[4];
+
+        for (size_t group = 0; group < 16; ++group)
+        {
+            auto& current = words[group % 4];
+
+            if (group < 4)
+            {
+                const auto data = reinterpret_cast<const __m128i*>(blocks);
+                current = _mm_shuffle_epi8(_mm_loadu_si128(data + group),
+                    mask);
+            }
+
+            const auto constants = _mm_loadu_si128(
+                reinterpret_cast<const __m128i*>(&rounds[group * 4]));
+            auto message = _mm_add_epi32(current, constants);
+            state1 = _mm_sha256rnds2_epu32(state1, state0, message);
+
+            if (group >= 3 && group < 15)
+            {
+                auto& next = words[(group + 1) % 4];
+                const auto& prior = words[(group + 3) % 4];
+                const auto shifted = _mm_alignr_epi8(current, prior, 4);
+                next = _mm_add_epi32(next, shifted);
+                next = _mm_sha256msg2_epu32(next, current);
+            }
+
+            message = _mm_shuffle_epi32(message, 0x0e);
+            state0 = _mm_sha256rnds2_epu32(state0, state1, message);
+
+            if (group >= 1 && group < 13)
+            {
+                auto& prior = words[(group + 3) % 4];
+                prior = _mm_sha256msg1_epu32(prior, current);
+            }
+        }
+
+        state0 = _mm_add_epi32(state0, abef);
+        state1 = _mm_add_epi32(state1, cdgh);
+    }
+
+    // Restore the word order of the state.
+    const auto feba = _mm_shuffle_epi32(state0, 0x1b);
+    state1 = _mm_shuffle_epi32(state1, 0xb1);
+    state0 = _mm_blend_epi16(feba, state1, 0xf0);
+    state1 = _mm_alignr_epi8(state1, feba, 8);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(state), state0);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(state + 4), state1);
+}
+
+#endif
+
+// Kernel dispatch.
+// ----------------------------------------------------------------------------
+
+typedef void (*transform_function)(uint32_t*, const uint8_t*, size_t);
+
+static transform_function to_function(message_checksum::kernel value)
+{
+    switch (value)
+    {
+#ifdef HAVE_SHA_NI
+        case message_checksum::kernel::sha_ni:
+            return transform_sha_ni;
+#endif
+        case message_checksum::kernel::generic:
+            return transform_generic;
+        default:
+            return nullptr;
+    }
+}
+
+static message_checksum::kernel detect_kernel()
+{
+#ifdef HAVE_SHA_NI
+    if (cpu_supports_sha_ni())
+        return message_checksum::kernel::sha_ni;
+#endif
+
+    return message_checksum::kernel::generic;
+}
+
+// Detection runs once, during static initialization.
+static std::atomic<message_checksum::kernel> active(detect_kernel());
+
+bool message_checksum::supported(kernel value)
+{
+    switch (value)
+    {
+#ifdef HAVE_SHA_NI
+        case kernel::sha_ni:
+            return cpu_supports_sha_ni();
+#endif
+        case kernel::generic:
+            return true;
+        default:
+            return false;
+    }
+}
+
+message_checksum::kernel message_checksum::active_kernel()
+{
+    return active.load(std::memory_order_relaxed);
+}
+
+bool message_checksum::select_kernel(kernel value)
+{
+    if (!supported(value))
+        return false;
+
+    active.store(value, std::memory_order_relaxed);
+    return true;
+}
+
+// Static interface.
+// ----------------------------------------------------------------------------
+
+uint32_t message_checksum::compute(const uint8_t* data, size_t size)
+{
+    message_checksum checksum;
+    checksum.update(data, size);
+    return checksum.finalize();
+}
+
+uint32_t message_checksum::compute(const data_chunk& data)
+{
+    return compute(data.data(), data.size());
+}
+
+// Streaming interface.
+// ----------------------------------------------------------------------------
+
+message_checksum::message_checksum()
+{
+    reset();
+}
+
+void message_checksum::reset()
+{
+    std::copy(std::begin(initial), std::end(initial), state_.begin());
+    buffered_ = 0;
+    length_ = 0;
+}
+
+void message_checksum::update(const uint8_t* data, size_t size)
+{
+    if (size == 0)
+        return;
+
+    length_ += size;
+
+    if (buffered_ != 0)
+    {
+        const auto fill = std::min(size, buffer_.size() - buffered_);
+        std::memcpy(buffer_.data() + buffered_, data, fill);
+        buffered_ += fill;
+        data += fill;
+        size -= fill;
+
+        if (buffered_ < buffer_.size())
+            return;
+
+        transform(state_, buffer_.data(), 1);
+        buffered_ = 0;
+    }
+
+    // Full blocks are hashed in place, without copying.
+    const auto blocks = size / buffer_.size();
+    transform(state_, data, blocks);
+    data += blocks * buffer_.size();
+    size -= blocks * buffer_.size();
+
+    std::memcpy(buffer_.data(), data, size);
+    buffered_ = size;
+}
+
+uint32_t message_checksum::finalize()
+{
+    // The first hash.
+    finalize(state_, buffer_, buffered_, length_);
+
+    block digest;
+    for (size_t word = 0; word < state_.size(); ++word)
+        write_big_endian(&digest[word * 4], state_[word]);
+
+    // The second hash, of the 32 byte first hash.
+    std::copy(std::begin(initial), std::end(initial), state_.begin());
+    finalize(state_, digest, 32, 32);
+
+    // The checksum is the first four hash bytes, read as little-endian.
+    const auto word = state_[0];
+    const uint32_t checksum =
+        ((word >> 24) & 0x000000ff) |
+        ((word >> 8) & 0x0000ff00) |
+        ((word << 8) & 0x00ff0000) |
+        ((word << 24) & 0xff000000);
+
+    reset();
+    return checksum;
+}
+
+// SHA256 implementation.
+// ----------------------------------------------------------------------------
+
+void message_checksum::finalize(state& state, block& buffer, size_t buffered,
+    uint64_t length)
+{
+    buffer[buffered++] = 0x80;
+
+    if (buffered > buffer.size() - 8)
+    {
+        std::fill(buffer.begin() + buffered, buffer.end(), 0);
+        transform(state, buffer.data(), 1);
+        buffered = 0;
+    }
+
+    std::fill(buffer.begin() + buffered, buffer.end() - 8, 0);
+
+    const auto bits = length * 8;
+    write_big_endian(&buffer[56], static_cast<uint32_t>(bits >> 32));
+    write_big_endian(&buffer[60], static_cast<uint32_t>(bits));
+    transform(state, buffer.data(), 1);
+}
+
+void message_checksum::transform(state& state, const uint8_t* blocks,
+    size_t count)
+{
+    to_function(active_kernel())(state.data(), blocks, count);
+}
+
+} // namespace network
+} // namespace libbitcoin
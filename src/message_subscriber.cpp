@@ -19,166 +19,356 @@
  */
 #include <bitcoin/network/message_subscriber.hpp>
 
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
 #include <istream>
 #include <memory>
 #include <string>
+#include <vector>
 #include <bitcoin/bitcoin.hpp>
 
-#define INITIALIZE_SUBSCRIBER(pool, value) \
-    value##_subscriber_(std::make_shared<value##_subscriber_type>( \
-        pool, #value "_sub"))
+// Subscribers that do not yet exist have no subscriptions to notify.
+#define RELAY_CODE(value, command) \
+    if (value##_subscriber_) \
+        value##_subscriber_->relay(ec, nullptr);
 
-#define RELAY_CODE(code, value) \
-    value##_subscriber_->relay(code, nullptr)
+#define CASE_COMMAND_TYPE(value, command) \
+    case command_key(command): \
+        return matches(field, command) ? message_type::value : \
+            message_type::unknown;
 
-#define CASE_HANDLE_MESSAGE(stream, value) \
+#define CASE_LOAD_MESSAGE(value, command) \
     case message_type::value: \
-        return handle<message::value>(stream, value##_subscriber_)
+        return deliver<message::value>(message_type::value, stream, \
+            value##_subscriber_, held);
 
-#define CASE_RELAY_MESSAGE(stream, value) \
+#define CASE_PARSE_MESSAGE(value, command) \
     case message_type::value: \
-        return relay<message::value>(stream, value##_subscriber_)
+        return prepare<message::value>(message_type::value, stream, \
+            value##_subscriber_, held, out);
 
-#define START_SUBSCRIBER(value) \
-    value##_subscriber_->start()
+#define START_SUBSCRIBER(value, command) \
+    if (value##_subscriber_) \
+        value##_subscriber_->start();
 
-#define STOP_SUBSCRIBER(value) \
-    value##_subscriber_->stop()
+#define STOP_SUBSCRIBER(value, command) \
+    if (value##_subscriber_) \
+        value##_subscriber_->stop();
 
 namespace libbitcoin {
 namespace network {
 
 using namespace message;
 
+static constexpr size_t type_count =
+    static_cast<size_t>(message_type::version) + 1;
+
+// FNV-1a parameters for the 64 bit command key.
+static constexpr uint64_t key_basis = 0xcbf29ce484222325;
+static constexpr uint64_t key_prime = 0x100000001b3;
+
+// The key of a command literal, as if zero padded to the field width.
+static constexpr uint64_t command_key(const char* text, size_t index = 0,
+    uint64_t key = key_basis)
+{
+    return index == message_subscriber::command_size ? key :
+        command_key(*text == '\0' ? text : text + 1, index + 1,
+            (key ^ static_cast<uint8_t>(*text)) * key_prime);
+}
+
+// Keys are not unique over all fields, so the matched command is compared.
+static bool matches(const message_subscriber::command_field& field,
+    const char* text)
+{
+    for (const auto byte: field)
+    {
+        if (byte != static_cast<uint8_t>(*text))
+            return false;
+
+        if (*text != '\0')
+            ++text;
+    }
+
+    return true;
+}
+
 message_subscriber::message_subscriber(threadpool& pool)
-  : INITIALIZE_SUBSCRIBER(pool, address),
-    INITIALIZE_SUBSCRIBER(pool, alert),
-    INITIALIZE_SUBSCRIBER(pool, block),
-    INITIALIZE_SUBSCRIBER(pool, filter_add),
-    INITIALIZE_SUBSCRIBER(pool, filter_clear),
-    INITIALIZE_SUBSCRIBER(pool, filter_load),
-    INITIALIZE_SUBSCRIBER(pool, get_address),
-    INITIALIZE_SUBSCRIBER(pool, get_blocks),
-    INITIALIZE_SUBSCRIBER(pool, get_data),
-    INITIALIZE_SUBSCRIBER(pool, get_headers),
-    INITIALIZE_SUBSCRIBER(pool, headers),
-    INITIALIZE_SUBSCRIBER(pool, inventory),
-    INITIALIZE_SUBSCRIBER(pool, memory_pool),
-    INITIALIZE_SUBSCRIBER(pool, merkle_block),
-    INITIALIZE_SUBSCRIBER(pool, not_found),
-    INITIALIZE_SUBSCRIBER(pool, ping),
-    INITIALIZE_SUBSCRIBER(pool, pong),
-    INITIALIZE_SUBSCRIBER(pool, reject),
-    INITIALIZE_SUBSCRIBER(pool, transaction),
-    INITIALIZE_SUBSCRIBER(pool, verack),
-    INITIALIZE_SUBSCRIBER(pool, version)
+  : message_subscriber(pool, { message_type::block })
+{
+}
+
+message_subscriber::message_subscriber(threadpool& pool,
+    const type_list& synchronous)
+  : message_subscriber(pool, synchronous, nullptr)
+{
+}
+
+message_subscriber::message_subscriber(threadpool& pool,
+    const type_list& synchronous, asio::strand& strand)
+  : message_subscriber(pool, synchronous, &strand)
+{
+}
+
+message_subscriber::message_subscriber(threadpool& pool,
+    const type_list& synchronous, asio::strand* strand)
+  : pool_(pool),
+    synchronous_(type_count, false),
+    strand_(strand),
+    subscriptions_(std::make_shared<std::vector<counter>>(type_count)),
+    batches_(type_count),
+    started_(false)
+{
+    for (auto& count: *subscriptions_)
+        count.store(0);
+
+    for (const auto type: synchronous)
+        if (static_cast<size_t>(type) < type_count)
+            synchronous_[static_cast<size_t>(type)] = true;
+}
+
+// static
+// The key of a command field, this equals the key of its literal.
+uint64_t message_subscriber::to_key(const command_field& command)
+{
+    auto key = key_basis;
+
+    for (const auto byte: command)
+        key = (key ^ byte) * key_prime;
+
+    return key;
+}
+
+// static
+// A command longer than the field is truncated, as it would be on the wire.
+message_subscriber::command_field message_subscriber::to_field(
+    const std::string& command)
+{
+    command_field field;
+    field.fill(0);
+    const auto size = std::min(command.size(), field.size());
+    std::copy(command.begin(), command.begin() + size, field.begin());
+    return field;
+}
+
+// static
+// The case keys are constant expressions, so colliding commands cannot build.
+message_type message_subscriber::to_type(const command_field& field)
+{
+    switch (to_key(field))
+    {
+        MESSAGE_SUBSCRIBER_TYPES(CASE_COMMAND_TYPE)
+        default:
+            return message_type::unknown;
+    }
+}
+
+bool message_subscriber::is_synchronous(message_type type) const
+{
+    return synchronous_[static_cast<size_t>(type)];
+}
+
+bool message_subscriber::subscribed(message_type type) const
 {
+    return subscriptions(type) > 0;
+}
+
+size_t message_subscriber::subscriptions(message_type type) const
+{
+    const auto index = static_cast<size_t>(type);
+    return index < type_count ? (*subscriptions_)[index].load() : 0;
+}
+
+message_subscriber::custom::ptr message_subscriber::find(
+    const command_field& command) const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    mutex_.lock_shared();
+
+    const auto it = customs_.find(to_key(command));
+    const auto instance = it == customs_.end() ? nullptr : it->second;
+
+    mutex_.unlock_shared();
+    ///////////////////////////////////////////////////////////////////////////
+
+    return instance && instance->command == command ? instance : nullptr;
+}
+
+bool message_subscriber::registered(const command_field& command) const
+{
+    return find(command) != nullptr;
+}
+
+bool message_subscriber::subscribed(const command_field& command) const
+{
+    const auto instance = find(command);
+    return instance && instance->counts->front() > 0;
 }
 
 void message_subscriber::broadcast(const code& ec)
 {
-    RELAY_CODE(ec, address);
-    RELAY_CODE(ec, alert);
-    RELAY_CODE(ec, block);
-    RELAY_CODE(ec, filter_add);
-    RELAY_CODE(ec, filter_clear);
-    RELAY_CODE(ec, filter_load);
-    RELAY_CODE(ec, get_address);
-    RELAY_CODE(ec, get_blocks);
-    RELAY_CODE(ec, get_data);
-    RELAY_CODE(ec, get_headers);
-    RELAY_CODE(ec, headers);
-    RELAY_CODE(ec, inventory);
-    RELAY_CODE(ec, memory_pool);
-    RELAY_CODE(ec, merkle_block);
-    RELAY_CODE(ec, not_found);
-    RELAY_CODE(ec, ping);
-    RELAY_CODE(ec, pong);
-    RELAY_CODE(ec, reject);
-    RELAY_CODE(ec, transaction);
-    RELAY_CODE(ec, verack);
-    RELAY_CODE(ec, version);
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    mutex_.lock_shared();
+
+    MESSAGE_SUBSCRIBER_TYPES(RELAY_CODE)
+
+    for (const auto& custom: customs_)
+        custom.second->relay(ec);
+
+    for (const auto& batch: batches_)
+        if (batch)
+            batch->relay(ec);
+
+    mutex_.unlock_shared();
+    ///////////////////////////////////////////////////////////////////////////
 }
 
 code message_subscriber::load(message_type type, std::istream& stream) const
+{
+    return load(type, stream, nullptr);
+}
+
+code message_subscriber::load(message_type type, std::istream& stream,
+    ticket held) const
 {
     switch (type)
     {
-        CASE_RELAY_MESSAGE(stream, address);
-        CASE_RELAY_MESSAGE(stream, alert);
-        CASE_HANDLE_MESSAGE(stream, block);
-        CASE_RELAY_MESSAGE(stream, filter_add);
-        CASE_RELAY_MESSAGE(stream, filter_clear);
-        CASE_RELAY_MESSAGE(stream, filter_load);
-        CASE_RELAY_MESSAGE(stream, get_address);
-        CASE_RELAY_MESSAGE(stream, get_blocks);
-        CASE_RELAY_MESSAGE(stream, get_data);
-        CASE_RELAY_MESSAGE(stream, get_headers);
-        CASE_RELAY_MESSAGE(stream, headers);
-        CASE_RELAY_MESSAGE(stream, inventory);
-        CASE_RELAY_MESSAGE(stream, memory_pool);
-        CASE_RELAY_MESSAGE(stream, merkle_block);
-        CASE_RELAY_MESSAGE(stream, not_found);
-        CASE_RELAY_MESSAGE(stream, ping);
-        CASE_RELAY_MESSAGE(stream, pong);
-        CASE_RELAY_MESSAGE(stream, reject);
-        CASE_RELAY_MESSAGE(stream, transaction);
-        CASE_RELAY_MESSAGE(stream, verack);
-        CASE_RELAY_MESSAGE(stream, version);
+        MESSAGE_SUBSCRIBER_TYPES(CASE_LOAD_MESSAGE)
         case message_type::unknown:
         default:
             return error::not_found;
     }
 }
 
+code message_subscriber::load(const command_field& command,
+    std::istream& stream) const
+{
+    return load(command, stream, nullptr);
+}
+
+code message_subscriber::load(const command_field& command,
+    std::istream& stream, ticket held) const
+{
+    const auto instance = find(command);
+
+    if (!instance)
+        return error::not_found;
+
+    // Parse and notify only if the command has a live subscription.
+    if (instance->counts->front() == 0)
+        return error::success;
+
+    return instance->load(*this, stream, held);
+}
+
+bool message_subscriber::batched(message_type type) const
+{
+    return batch_subscriptions(type) > 0;
+}
+
+size_t message_subscriber::batch_subscriptions(message_type type) const
+{
+    const auto index = static_cast<size_t>(type);
+
+    if (index >= type_count)
+        return 0;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    mutex_.lock_shared();
+    const auto instance = batches_[index];
+    mutex_.unlock_shared();
+    ///////////////////////////////////////////////////////////////////////////
+
+    return instance ? instance->counts->front().load() : 0;
+}
+
+// The batches are filled by the loading sequence alone, so are not locked.
+void message_subscriber::flush()
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    mutex_.lock_shared();
+
+    for (const auto& batch: batches_)
+        if (batch)
+            batch->flush(strand_);
+
+    mutex_.unlock_shared();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void message_subscriber::discard()
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    mutex_.lock_shared();
+
+    for (const auto& batch: batches_)
+        if (batch)
+            batch->discard();
+
+    mutex_.unlock_shared();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+code message_subscriber::parse(message_type type, std::istream& stream,
+    ticket held, delivery& out) const
+{
+    switch (type)
+    {
+        MESSAGE_SUBSCRIBER_TYPES(CASE_PARSE_MESSAGE)
+        case message_type::unknown:
+        default:
+            out = nullptr;
+            return error::not_found;
+    }
+}
+
 void message_subscriber::start()
 {
-    START_SUBSCRIBER(address);
-    START_SUBSCRIBER(alert);
-    START_SUBSCRIBER(block);
-    START_SUBSCRIBER(filter_add);
-    START_SUBSCRIBER(filter_clear);
-    START_SUBSCRIBER(filter_load);
-    START_SUBSCRIBER(get_address);
-    START_SUBSCRIBER(get_blocks);
-    START_SUBSCRIBER(get_data);
-    START_SUBSCRIBER(get_headers);
-    START_SUBSCRIBER(headers);
-    START_SUBSCRIBER(inventory);
-    START_SUBSCRIBER(memory_pool);
-    START_SUBSCRIBER(merkle_block);
-    START_SUBSCRIBER(not_found);
-    START_SUBSCRIBER(ping);
-    START_SUBSCRIBER(pong);
-    START_SUBSCRIBER(reject);
-    START_SUBSCRIBER(transaction);
-    START_SUBSCRIBER(verack);
-    START_SUBSCRIBER(version);
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    mutex_.lock();
+
+    // Subscribers created later are started upon creation.
+    started_ = true;
+
+    MESSAGE_SUBSCRIBER_TYPES(START_SUBSCRIBER)
+
+    for (const auto& custom: customs_)
+        custom.second->start();
+
+    for (const auto& batch: batches_)
+        if (batch)
+            batch->start();
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
 }
 
 void message_subscriber::stop()
 {
-    STOP_SUBSCRIBER(address);
-    STOP_SUBSCRIBER(alert);
-    STOP_SUBSCRIBER(block);
-    STOP_SUBSCRIBER(filter_add);
-    STOP_SUBSCRIBER(filter_clear);
-    STOP_SUBSCRIBER(filter_load);
-    STOP_SUBSCRIBER(get_address);
-    STOP_SUBSCRIBER(get_blocks);
-    STOP_SUBSCRIBER(get_data);
-    STOP_SUBSCRIBER(get_headers);
-    STOP_SUBSCRIBER(headers);
-    STOP_SUBSCRIBER(inventory);
-    STOP_SUBSCRIBER(memory_pool);
-    STOP_SUBSCRIBER(merkle_block);
-    STOP_SUBSCRIBER(not_found);
-    STOP_SUBSCRIBER(ping);
-    STOP_SUBSCRIBER(pong);
-    STOP_SUBSCRIBER(reject);
-    STOP_SUBSCRIBER(transaction);
-    STOP_SUBSCRIBER(verack);
-    STOP_SUBSCRIBER(version);
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    mutex_.lock();
+
+    // Subscribers created later are not started, so reject subscription.
+    started_ = false;
+
+    MESSAGE_SUBSCRIBER_TYPES(STOP_SUBSCRIBER)
+
+    for (const auto& custom: customs_)
+        custom.second->stop();
+
+    for (const auto& batch: batches_)
+        if (batch)
+            batch->stop();
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
 }
 
 } // namespace network
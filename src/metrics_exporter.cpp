@@ -0,0 +1,510 @@
+/**
+ * Copyright (c) 2011-2016 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/network/metrics_exporter.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/channel_metrics.hpp>
+#include <bitcoin/network/dispatch_monitor.hpp>
+#include <bitcoin/network/latency_histogram.hpp>
+#include <bitcoin/network/lifecycle_metrics.hpp>
+#include <bitcoin/network/logging.hpp>
+#include <bitcoin/network/message_subscriber.hpp>
+#include <bitcoin/network/p2p.hpp>
+#include <bitcoin/network/pending_sockets.hpp>
+#include <bitcoin/network/settings.hpp>
+#include <bitcoin/network/socket.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+#define NAME "metrics_exporter"
+#define PREFIX "libbitcoin_network_"
+
+#define SET_COMMAND_NAME(value, command) \
+    names[static_cast<size_t>(message::message_type::value)] = command;
+
+using std::placeholders::_1;
+using std::placeholders::_2;
+
+// The request is not interpreted, each is answered with all metrics.
+static constexpr size_t maximum_request = 1024;
+
+// A scrape that is not answered within this time is closed.
+static const auto scrape_timeout = asio::seconds(10);
+
+// An accept failure, such as descriptor exhaustion, is retried after this.
+static const auto accept_retry = asio::seconds(1);
+
+static const auto reuse_address = asio::acceptor::reuse_address(true);
+
+static const char* origins[] =
+{
+    "inbound", "outbound", "manual", "seed"
+};
+
+static const char* phases[] =
+{
+    "resolve", "connect", "pend", "handshake", "store", "total"
+};
+
+static const char* categories[] =
+{
+    "receive", "send", "hosts", "channels"
+};
+
+// The command of each message type, indexed as the channel counters.
+static std::vector<std::string> command_names()
+{
+    std::vector<std::string> names(channel_metrics::type_count, "unknown");
+    MESSAGE_SUBSCRIBER_TYPES(SET_COMMAND_NAME)
+    return names;
+}
+
+// Exact decimal seconds of a count of microseconds.
+static std::string to_seconds(uint64_t microseconds)
+{
+    const auto fraction = std::to_string(microseconds % 1000000);
+    return std::to_string(microseconds / 1000000) + "." +
+        std::string(6 - fraction.size(), '0') + fraction;
+}
+
+static void write_type(std::ostream& out, const std::string& name,
+    const std::string& type, const std::string& help)
+{
+    out << "# HELP " PREFIX << name << " " << help << "\n";
+    out << "# TYPE " PREFIX << name << " " << type << "\n";
+}
+
+template <typename Value>
+static void write_gauge(std::ostream& out, const std::string& name,
+    const std::string& help, Value value)
+{
+    write_type(out, name, "gauge", help);
+    out << PREFIX << name << " " << value << "\n";
+}
+
+static void write_summary(std::ostream& out, const std::string& name,
+    const std::string& labels, const latency_histogram::summary& summary)
+{
+    out << PREFIX << name << "{" << labels << ",quantile=\"0.5\"} "
+        << to_seconds(summary.p50_microseconds) << "\n";
+    out << PREFIX << name << "{" << labels << ",quantile=\"0.99\"} "
+        << to_seconds(summary.p99_microseconds) << "\n";
+    out << PREFIX << name << "{" << labels << ",quantile=\"0.999\"} "
+        << to_seconds(summary.p999_microseconds) << "\n";
+    out << PREFIX << name << "_sum{" << labels << "} "
+        << to_seconds(summary.total_microseconds) << "\n";
+    out << PREFIX << name << "_count{" << labels << "} "
+        << summary.count << "\n";
+}
+
+// static
+// Channel counters are summed over the connected channels, so the sums are
+// gauges, they fall as channels are removed.
+std::string metrics_exporter::render(const snapshot& metrics)
+{
+    std::ostringstream out;
+    const auto names = command_names();
+
+    write_gauge(out, "connections", "Connected channels.",
+        metrics.connections);
+    write_gauge(out, "addresses", "Addresses in the host pool.",
+        metrics.addresses);
+
+    write_type(out, "broadcast_bytes_saved_total", "counter",
+        "Serialization bytes avoided by shared broadcast buffers.");
+    out << PREFIX "broadcast_bytes_saved_total "
+        << metrics.broadcast_bytes_saved << "\n";
+
+    std::vector<uint64_t> received(channel_metrics::type_count, 0);
+    std::vector<uint64_t> sent(channel_metrics::type_count, 0);
+    uint64_t queued_messages = 0;
+    uint64_t queued_bytes = 0;
+    uint64_t skipped_bytes = 0;
+
+    for (const auto& channel: metrics.channels)
+    {
+        for (size_t type = 0; type < channel_metrics::type_count; ++type)
+        {
+            received[type] += channel.received.bytes_by_type[type];
+            sent[type] += channel.sent.bytes_by_type[type];
+        }
+
+        queued_messages += channel.queued_messages;
+        queued_bytes += channel.queued_bytes;
+        skipped_bytes += channel.skipped_bytes;
+    }
+
+    write_type(out, "channel_received_bytes", "gauge",
+        "Bytes received by command over connected channels.");
+    for (size_t type = 0; type < channel_metrics::type_count; ++type)
+        out << PREFIX "channel_received_bytes{command=\"" << names[type]
+            << "\"} " << received[type] << "\n";
+
+    write_type(out, "channel_sent_bytes", "gauge",
+        "Bytes sent by command over connected channels.");
+    for (size_t type = 0; type < channel_metrics::type_count; ++type)
+        out << PREFIX "channel_sent_bytes{command=\"" << names[type]
+            << "\"} " << sent[type] << "\n";
+
+    write_gauge(out, "channel_queued_messages",
+        "Messages queued for send over connected channels.",
+        queued_messages);
+    write_gauge(out, "channel_queued_bytes",
+        "Bytes queued for send over connected channels.", queued_bytes);
+    write_gauge(out, "channel_skipped_bytes",
+        "Received bytes dropped without parsing over connected channels.",
+        skipped_bytes);
+
+    write_type(out, "startup_seconds", "summary",
+        "Channel startup latency by session type and phase.");
+    for (size_t source = 0; source < lifecycle_metrics::origin_count;
+        ++source)
+    {
+        for (size_t step = 0; step < lifecycle_metrics::phase_count; ++step)
+        {
+            const auto labels = std::string("session=\"") + origins[source] +
+                "\",phase=\"" + phases[step] + "\"";
+            write_summary(out, "startup_seconds", labels,
+                metrics.lifecycle[source][step]);
+        }
+    }
+
+    write_type(out, "dispatch_enqueued_total", "counter",
+        "Jobs posted to the threadpool by dispatcher.");
+    for (const auto& dispatch: metrics.dispatches)
+        out << PREFIX "dispatch_enqueued_total{dispatcher=\""
+            << dispatch.name << "\"} " << dispatch.enqueued << "\n";
+
+    write_type(out, "dispatch_queued", "gauge",
+        "Jobs posted and not yet started by dispatcher.");
+    for (const auto& dispatch: metrics.dispatches)
+        out << PREFIX "dispatch_queued{dispatcher=\"" << dispatch.name
+            << "\"} " << dispatch.queued << "\n";
+
+    write_type(out, "dispatch_running", "gauge",
+        "Jobs started and not yet completed by dispatcher.");
+    for (const auto& dispatch: metrics.dispatches)
+        out << PREFIX "dispatch_running{dispatcher=\"" << dispatch.name
+            << "\"} " << dispatch.running << "\n";
+
+    write_type(out, "dispatch_wait_seconds", "summary",
+        "Job wait in the threadpool queue by dispatcher.");
+    for (const auto& dispatch: metrics.dispatches)
+        write_summary(out, "dispatch_wait_seconds",
+            "dispatcher=\"" + dispatch.name + "\"", dispatch.wait);
+
+    write_type(out, "dispatch_execution_seconds", "summary",
+        "Job execution time by dispatcher.");
+    for (const auto& dispatch: metrics.dispatches)
+        write_summary(out, "dispatch_execution_seconds",
+            "dispatcher=\"" + dispatch.name + "\"", dispatch.execution);
+
+    const size_t memory[] =
+    {
+        metrics.memory.receive, metrics.memory.send, metrics.memory.hosts,
+        metrics.memory.channels
+    };
+
+    write_type(out, "memory_bytes", "gauge",
+        "Estimated network memory by category.");
+    for (size_t category = 0; category < 4; ++category)
+        out << PREFIX "memory_bytes{category=\"" << categories[category]
+            << "\"} " << memory[category] << "\n";
+
+    write_gauge(out, "memory_limit_bytes",
+        "Network memory limit, zero if unlimited.", metrics.memory.limit);
+    write_gauge(out, "buffer_pool_retained_bytes",
+        "Payload buffer bytes retained for reuse.",
+        metrics.buffers.retained_bytes);
+    write_gauge(out, "buffer_pool_oversized",
+        "Payload buffers allocated over the largest size class.",
+        metrics.buffers.oversized);
+
+    return out.str();
+}
+
+metrics_exporter::metrics_exporter(p2p& network, threadpool& pool,
+    const settings& settings)
+  : stopped_(true),
+    network_(network),
+    pool_(pool),
+    settings_(settings),
+    timer_(std::make_shared<deadline>(pool, settings.metrics_interval())),
+    retry_(std::make_shared<deadline>(pool, accept_retry)),
+    text_(std::make_shared<const std::string>())
+{
+}
+
+// Start sequence.
+// ----------------------------------------------------------------------------
+
+// This listens on IPv6, which also accepts mapped IPv4 where supported.
+code metrics_exporter::start()
+{
+    if (settings_.metrics_port == 0)
+        return error::success;
+
+    boost_code error;
+    const asio::endpoint endpoint(asio::ipv6(), settings_.metrics_port);
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    mutex_.lock();
+
+    acceptor_ = std::make_shared<asio::acceptor>(pool_.service());
+    acceptor_->open(endpoint.protocol(), error);
+
+    if (!error)
+        acceptor_->set_option(reuse_address, error);
+
+    if (!error)
+        acceptor_->bind(endpoint, error);
+
+    if (!error)
+        acceptor_->listen(asio::max_connections, error);
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    if (error)
+        return error::boost_to_error_code(error);
+
+    stopped_ = false;
+    collect();
+    start_timer();
+    start_accept();
+    return error::success;
+}
+
+void metrics_exporter::stop()
+{
+    stopped_ = true;
+    timer_->stop();
+    retry_->stop();
+
+    // This completes the reads and writes of the open scrapes.
+    scrapes_.clear();
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    if (acceptor_)
+    {
+        boost_code ignore;
+        acceptor_->cancel(ignore);
+        acceptor_->close(ignore);
+    }
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// Collection.
+// ----------------------------------------------------------------------------
+
+// Each source copies under its own lock (if any), and no two are held.
+metrics_exporter::snapshot metrics_exporter::copy()
+{
+    snapshot out;
+    network_.connected_count([&](size_t count) { out.connections = count; });
+    network_.address_count([&](size_t count) { out.addresses = count; });
+    network_.connected_metrics(
+        [&](const channel_metrics::snapshot::list& channels)
+        {
+            out.channels = channels;
+        });
+
+    out.broadcast_bytes_saved = network_.broadcast_bytes_saved();
+    out.lifecycle = network_.lifecycle_statistics();
+    out.dispatches = network_.dispatch_statistics();
+    out.memory = network_.memory_usage();
+    out.buffers = network_.payload_buffer_statistics();
+    return out;
+}
+
+void metrics_exporter::collect()
+{
+    text_.store(std::make_shared<const std::string>(render(copy())));
+}
+
+metrics_exporter::text_ptr metrics_exporter::text() const
+{
+    return text_.load();
+}
+
+void metrics_exporter::start_timer()
+{
+    if (stopped_)
+        return;
+
+    timer_->start(
+        std::bind(&metrics_exporter::handle_timer,
+            shared_from_this(), _1));
+}
+
+void metrics_exporter::handle_timer(const code& ec)
+{
+    if (ec || stopped_)
+        return;
+
+    collect();
+    start_timer();
+}
+
+// Scrape sequence.
+// ----------------------------------------------------------------------------
+
+void metrics_exporter::start_accept()
+{
+    const auto socket = std::make_shared<network::socket>(pool_);
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    if (stopped_)
+        return;
+
+    const auto locked = socket->get_socket();
+
+    acceptor_->async_accept(locked->get(),
+        std::bind(&metrics_exporter::handle_accept,
+            shared_from_this(), _1, socket));
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void metrics_exporter::handle_accept(const boost_code& ec,
+    socket::ptr socket)
+{
+    if (stopped_ || ec == boost::asio::error::operation_aborted)
+        return;
+
+    if (ec)
+    {
+        LOG_DEBUG(LOG_NETWORK)
+            << "Failure accepting metrics scrape: " << ec.message();
+
+        // A persistent failure is not spun on.
+        retry_->start(
+            std::bind(&metrics_exporter::handle_retry,
+                shared_from_this(), _1));
+        return;
+    }
+
+    scrapes_.store(socket);
+
+    // A stop that cleared the scrapes before the store is observed here.
+    if (stopped_)
+    {
+        scrapes_.remove(socket);
+        socket->close();
+        return;
+    }
+
+    const auto timer = std::make_shared<deadline>(pool_, scrape_timeout);
+    timer->start(
+        std::bind(&metrics_exporter::handle_timeout,
+            shared_from_this(), _1, socket));
+
+    // The request is read on the socket strand, ordered with its close.
+    socket->strand().post(
+        std::bind(&metrics_exporter::start_request,
+            shared_from_this(), socket, timer));
+
+    start_accept();
+}
+
+void metrics_exporter::handle_retry(const code& ec)
+{
+    if (ec || stopped_)
+        return;
+
+    start_accept();
+}
+
+void metrics_exporter::handle_timeout(const code& ec, socket::ptr socket)
+{
+    // The timer is stopped when the scrape closes.
+    if (ec)
+        return;
+
+    LOG_DEBUG(LOG_NETWORK)
+        << "Metrics scrape timed out.";
+
+    // This completes the outstanding read or write of the scrape.
+    socket->close();
+}
+
+void metrics_exporter::start_request(socket::ptr socket, deadline::ptr timer)
+{
+    const auto request = std::make_shared<data_chunk>(maximum_request);
+
+    socket->get().async_read_some(boost::asio::buffer(*request),
+        socket->strand().wrap(
+            std::bind(&metrics_exporter::handle_request,
+                shared_from_this(), _1, _2, socket, timer, request)));
+}
+
+void metrics_exporter::handle_request(const boost_code& ec, size_t,
+    socket::ptr socket, deadline::ptr timer, request_ptr)
+{
+    if (ec || stopped_)
+    {
+        close(socket, timer);
+        return;
+    }
+
+    const auto body = text();
+    const auto response = std::make_shared<std::string>(
+        "HTTP/1.0 200 OK\r\n"
+        "Content-Type: text/plain; version=0.0.4\r\n"
+        "Content-Length: " + std::to_string(body->size()) + "\r\n"
+        "Connection: close\r\n\r\n" + *body);
+
+    using namespace boost::asio;
+    async_write(socket->get(), buffer(*response),
+        socket->strand().wrap(
+            std::bind(&metrics_exporter::handle_response,
+                shared_from_this(), _1, socket, timer, response)));
+}
+
+void metrics_exporter::handle_response(const boost_code&, socket::ptr socket,
+    deadline::ptr timer, response_ptr)
+{
+    close(socket, timer);
+}
+
+void metrics_exporter::close(socket::ptr socket, deadline::ptr timer)
+{
+    timer->stop();
+    scrapes_.remove(socket);
+    socket->close();
+}
+
+} // namespace network
+} // namespace libbitcoin
@@ -0,0 +1,52 @@
+/**
+ * Copyright (c) 2011-2016 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/network/netgroup.hpp>
+
+#include <algorithm>
+#include <bitcoin/bitcoin.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+static constexpr uint8_t ipv4_family = 4;
+static constexpr uint8_t ipv6_family = 6;
+
+netgroup to_netgroup(const config::authority& authority)
+{
+    const auto ip = authority.ip();
+    const auto bytes = ip.to_bytes();
+
+    netgroup out;
+    out.fill(0);
+
+    if (ip.is_v4_mapped())
+    {
+        out[0] = ipv4_family;
+        std::copy(bytes.begin() + 12, bytes.begin() + 14, out.begin() + 1);
+        return out;
+    }
+
+    out[0] = ipv6_family;
+    std::copy(bytes.begin(), bytes.begin() + 4, out.begin() + 1);
+    return out;
+}
+
+} // namespace network
+} // namespace libbitcoin
@@ -0,0 +1,107 @@
+/**
+ * Copyright (c) 2011-2016 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/network/outbound_reservations.hpp>
+
+#include <cstddef>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/netgroup.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+using namespace bc::config;
+
+outbound_reservations::outbound_reservations(size_t attempt_limit)
+  : attempt_limit_(attempt_limit),
+    attempts_(0)
+{
+}
+
+bool outbound_reservations::begin_attempt()
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    if (attempt_limit_ != 0 && attempts_ >= attempt_limit_)
+        return false;
+
+    ++attempts_;
+    return true;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void outbound_reservations::end_attempt()
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    BITCOIN_ASSERT(attempts_ > 0);
+    --attempts_;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+bool outbound_reservations::reserve(const authority& host)
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    return hosts_.emplace(to_netgroup(host), host).second;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void outbound_reservations::release(const authority& host)
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    // Another host of the group does not release the reservation.
+    const auto it = hosts_.find(to_netgroup(host));
+
+    if (it != hosts_.end() && it->second == host)
+        hosts_.erase(it);
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+size_t outbound_reservations::attempts() const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    shared_lock lock(mutex_);
+
+    return attempts_;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+size_t outbound_reservations::reserved() const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    shared_lock lock(mutex_);
+
+    return hosts_.size();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+} // namespace network
+} // namespace libbitcoin
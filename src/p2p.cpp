@@ -19,15 +19,21 @@
  */
 #include <bitcoin/network/p2p.hpp>
 
+#include <algorithm>
+#include <chrono>
 #include <cstddef>
 #include <cstdint>
+#include <functional>
+#include <future>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 #include <bitcoin/bitcoin.hpp>
 #include <bitcoin/network/channel.hpp>
 #include <bitcoin/network/connections.hpp>
 #include <bitcoin/network/hosts.hpp>
+#include <bitcoin/network/logging.hpp>
 #include <bitcoin/network/protocols/protocol_address.hpp>
 #include <bitcoin/network/protocols/protocol_ping.hpp>
 #include <bitcoin/network/protocols/protocol_seed.hpp>
@@ -45,14 +51,46 @@ namespace network {
 
 using std::placeholders::_1;
 
+// One revolution of the channel timer wheel, in ticks.
+static constexpr size_t timer_slots = 512;
+
+// BIP152 limits high bandwidth compact relay to three peers.
+static constexpr size_t maximum_compact_announcers = 3;
+
 p2p::p2p(const settings& settings)
   : stopped_(true),
     height_(0),
     settings_(settings),
-    hosts_(std::make_shared<hosts>(threadpool_, settings_)),
-    connections_(std::make_shared<connections>()),
+    anchors_(settings_.anchors_file, settings_.outbound_anchors),
+    dispatches_(std::make_shared<dispatch_monitor>()),
+    dispatch_(threadpool_, NAME "_dispatch", dispatches_),
+    channel_pools_(std::make_shared<affinity_pool>(threadpool_,
+        settings_.thread_affinity ? settings_.threads : 0)),
+    buffers_(std::make_shared<buffer_pool>(settings_.buffer_pool_capacity)),
+    resolved_(std::make_shared<resolver_cache>(
+        settings_.resolve_cache_seconds)),
+    timers_(std::make_shared<timer_wheel>(threadpool_,
+        settings_.channel_timer(), timer_slots)),
+    uploads_(std::make_shared<token_bucket>(settings_.upload_bytes_per_second,
+        settings_.upload_bytes_per_second)),
+    memory_(std::make_shared<memory_accounts>(settings_.memory_limit_bytes)),
+    lifecycle_(std::make_shared<lifecycle_metrics>()),
+    exporter_(std::make_shared<metrics_exporter>(*this, threadpool_,
+        settings_)),
+    messages_(std::make_shared<message_cache>(settings_)),
+    capture_(std::make_shared<traffic_capture>(settings_.capture_file)),
+    hosts_(std::make_shared<hosts>(threadpool_, settings_, dispatches_)),
+    connections_(std::make_shared<connections>(settings_.identifier)),
+    admission_(std::make_shared<admission>(settings_, connections_,
+        memory_)),
+    relay_(std::make_shared<inventory_relay>(threadpool_, connections_,
+        settings_)),
     stop_subscriber_(std::make_shared<stop_subscriber>(threadpool_, NAME "_stop_sub")),
-    channel_subscriber_(std::make_shared<channel_subscriber>(threadpool_, NAME "_sub"))
+    channel_subscriber_(std::make_shared<channel_subscriber>(threadpool_, NAME "_sub")),
+    block_subscriber_(std::make_shared<block_subscriber>(threadpool_, NAME "_block_sub")),
+    compact_announcers_(0),
+    scheduler_(std::make_shared<block_scheduler>(settings_)),
+    work_subscriber_(std::make_shared<work_subscriber>(threadpool_, NAME "_work_sub"))
 {
 }
 
@@ -86,6 +124,194 @@ threadpool& p2p::thread_pool()
     return threadpool_;
 }
 
+affinity_pool::ptr p2p::channel_pools()
+{
+    return channel_pools_;
+}
+
+buffer_pool::ptr p2p::payload_buffers()
+{
+    return buffers_;
+}
+
+resolver_cache::ptr p2p::resolved_names()
+{
+    return resolved_;
+}
+
+timer_wheel::ptr p2p::channel_timers()
+{
+    return timers_;
+}
+
+token_bucket::ptr p2p::upload_budget()
+{
+    return uploads_;
+}
+
+memory_accounts::ptr p2p::memory_budget()
+{
+    return memory_;
+}
+
+// The hosts tables are measured, as their entries are not allocated singly.
+memory_accounts::usage p2p::memory_usage()
+{
+    memory_->set(memory_accounts::category::hosts, hosts_->footprint());
+    return memory_->snapshot();
+}
+
+lifecycle_metrics::ptr p2p::lifecycle_timing()
+{
+    return lifecycle_;
+}
+
+lifecycle_metrics::statistics p2p::lifecycle_statistics() const
+{
+    return lifecycle_->snapshot();
+}
+
+dispatch_monitor::ptr p2p::dispatch_metrics()
+{
+    return dispatches_;
+}
+
+dispatch_monitor::statistics p2p::dispatch_statistics() const
+{
+    return dispatches_->snapshot();
+}
+
+message_cache::ptr p2p::cached_messages()
+{
+    return messages_;
+}
+
+traffic_capture::ptr p2p::captured_traffic()
+{
+    return capture_;
+}
+
+config::authority::list p2p::take_anchors()
+{
+    const auto anchors = anchored_.load();
+    anchored_.store({});
+    return anchors;
+}
+
+admission::ptr p2p::inbound_admission()
+{
+    return admission_;
+}
+
+block_scheduler::ptr p2p::block_download()
+{
+    return scheduler_;
+}
+
+buffer_pool::statistics p2p::payload_buffer_statistics() const
+{
+    return buffers_->pool_statistics();
+}
+
+void p2p::announce(const message::inventory_vector::list& items)
+{
+    relay_->announce(items);
+}
+
+void p2p::relay_block(message::block::ptr block)
+{
+    block_subscriber_->relay(error::success, block);
+}
+
+void p2p::subscribe_block(relay_handler handler)
+{
+    block_subscriber_->subscribe(handler, error::service_stopped, nullptr);
+}
+
+// Compact block reception.
+// ----------------------------------------------------------------------------
+
+void p2p::set_compact_relay(transaction_source source, block_handler handler)
+{
+    compact_handler_.store(handler);
+    compact_source_.store(source);
+}
+
+bool p2p::compact_relay() const
+{
+    return static_cast<bool>(compact_source_.load());
+}
+
+void p2p::visit_candidates(transaction_visitor visitor)
+{
+    const auto source = compact_source_.load();
+
+    if (source)
+        source(visitor);
+}
+
+void p2p::notify_block(message::block::ptr block)
+{
+    const auto handler = compact_handler_.load();
+
+    if (handler)
+        handler(error::success, block);
+}
+
+bool p2p::claim_compact_announcer()
+{
+    auto count = compact_announcers_.load();
+
+    do
+    {
+        if (count >= maximum_compact_announcers)
+            return false;
+    } while (!compact_announcers_.compare_exchange_weak(count, count + 1));
+
+    return true;
+}
+
+void p2p::release_compact_announcer()
+{
+    BITCOIN_ASSERT(compact_announcers_.load() > 0);
+    --compact_announcers_;
+}
+
+// Block download.
+// ----------------------------------------------------------------------------
+
+void p2p::synchronize(const hash_list& locator, block_handler handler)
+{
+    download_handler_.store(handler);
+    scheduler_->reset(locator);
+
+    // Channels claim the header role and block requests when notified.
+    notify_download_work();
+}
+
+void p2p::subscribe_download(work_handler handler)
+{
+    work_subscriber_->subscribe(handler, error::service_stopped);
+}
+
+void p2p::notify_download_work()
+{
+    work_subscriber_->relay(error::success);
+}
+
+void p2p::notify_download(message::block::ptr block)
+{
+    const auto handler = download_handler_.load();
+
+    if (handler)
+        handler(error::success, block);
+}
+
+uint64_t p2p::broadcast_bytes_saved() const
+{
+    return connections_->broadcast_bytes_saved();
+}
+
 // Start sequence.
 // ----------------------------------------------------------------------------
 
@@ -100,9 +326,31 @@ void p2p::start(result_handler handler)
     threadpool_.join();
     threadpool_.spawn(settings_.threads, thread_priority::low);
 
+    // With thread affinity each channel completes on one of these threads.
+    channel_pools_->join();
+    channel_pools_->spawn(thread_priority::low);
+
     stopped_ = false;
     stop_subscriber_->start();
     channel_subscriber_->start();
+    block_subscriber_->start();
+    work_subscriber_->start();
+    relay_->start();
+    timers_->start();
+
+    // The metrics port is optional, so failure to listen is not fatal.
+    const auto exported = exporter_->start();
+
+    if (exported)
+        LOG_ERROR(LOG_NETWORK)
+            << "Error starting metrics exporter: " << exported.message();
+
+    // Capture is a diagnostic, so failure to open the file is not fatal.
+    const auto captured = capture_->start();
+
+    if (captured)
+        LOG_ERROR(LOG_NETWORK)
+            << "Error opening capture file: " << captured.message();
 
     // This instance is retained by stop handler and member references.
     const auto manual = attach<session_manual>();
@@ -124,7 +372,7 @@ void p2p::handle_manual_started(const code& ec, result_handler handler)
 
     if (ec)
     {
-        log::error(LOG_NETWORK)
+        LOG_ERROR(LOG_NETWORK)
             << "Error starting manual session: " << ec.message();
         handler(ec);
         return;
@@ -143,12 +391,16 @@ void p2p::handle_hosts_loaded(const code& ec, result_handler handler)
 
     if (ec)
     {
-        log::error(LOG_NETWORK)
+        LOG_ERROR(LOG_NETWORK)
             << "Error loading host addresses: " << ec.message();
         handler(ec);
         return;
     }
 
+    // The tables are preallocated, so the load sets their footprint.
+    memory_->set(memory_accounts::category::hosts, hosts_->footprint());
+    load_anchors();
+
     // This is invoked on a new thread.
     // The instance is retained by the stop handler (until shutdown).
     attach<session_seed>()->start(
@@ -156,6 +408,26 @@ void p2p::handle_hosts_loaded(const code& ec, result_handler handler)
             this, _1, handler));
 }
 
+// Anchors are also pooled, so an empty pool with anchors does not seed.
+void p2p::load_anchors()
+{
+    config::authority::list anchors;
+    const auto ec = anchors_.load(anchors);
+
+    if (ec)
+        LOG_ERROR(LOG_NETWORK)
+            << "Error loading anchors file: " << ec.message();
+
+    for (const auto& anchor: anchors)
+        hosts_->store(anchor.to_network_address());
+
+    if (!anchors.empty())
+        LOG_INFO(LOG_NETWORK)
+            << "Loaded " << anchors.size() << " anchor peers.";
+
+    anchored_.store(anchors);
+}
+
 void p2p::handle_hosts_seeded(const code& ec, result_handler handler)
 {
     if (stopped())
@@ -166,7 +438,7 @@ void p2p::handle_hosts_seeded(const code& ec, result_handler handler)
 
     if (ec)
     {
-        log::error(LOG_NETWORK)
+        LOG_ERROR(LOG_NETWORK)
             << "Error seeding host addresses: " << ec.message();
         handler(ec);
         return;
@@ -197,7 +469,7 @@ void p2p::handle_inbound_started(const code& ec, result_handler handler)
 {
     if (ec)
     {
-        log::error(LOG_NETWORK)
+        LOG_ERROR(LOG_NETWORK)
             << "Error starting inbound session: " << ec.message();
         handler(ec);
         return;
@@ -214,7 +486,7 @@ void p2p::handle_outbound_started(const code& ec, result_handler handler)
 {
     if (ec)
     {
-        log::error(LOG_NETWORK)
+        LOG_ERROR(LOG_NETWORK)
             << "Error starting outbound session: " << ec.message();
         handler(ec);
         return;
@@ -276,16 +548,12 @@ void p2p::connect(const std::string& hostname, uint16_t port,
 // completes at least once before invoking the handler. This requires a unique
 // lock be taken around the entire section, which poses a deadlock risk.
 // Instead this is thread safe and idempotent, allowing it to be unguarded.
+// Only the first stop after a start saves hosts and stops channels, which
+// it does in parallel, completing the handler asynchronously.
 void p2p::stop(result_handler handler)
 {
-    // Host save is expensive, so minimize repeats.
-    const auto ec = stopped_ ? error::success : hosts_->save();
-
-    if (ec)
-        log::error(LOG_NETWORK)
-            << "Error saving hosts file: " << ec.message();
-
-    stopped_ = true;
+    // Host save and channel stops are expensive, so minimize repeats.
+    const auto started = !stopped_.exchange(true);
 
     // Prevent subscription after stop.
     stop_subscriber_->stop();
@@ -295,14 +563,154 @@ void p2p::stop(result_handler handler)
     channel_subscriber_->stop();
     channel_subscriber_->do_relay(error::service_stopped, nullptr);
 
-    // Stop accepting channels and stop those that exist (self-clearing).
-    connections_->stop(error::service_stopped);
+    // Prevent subscription after stop.
+    block_subscriber_->stop();
+    block_subscriber_->do_relay(error::service_stopped, nullptr);
+
+    // Prevent subscription after stop.
+    work_subscriber_->stop();
+    work_subscriber_->do_relay(error::service_stopped);
+
+    // Queued announcements are abandoned.
+    relay_->stop();
+
+    // Pending channel timers are notified of the stop.
+    timers_->stop();
+    exporter_->stop();
+    capture_->stop();
 
     manual_.store(nullptr);
+
+    if (!started)
+    {
+        // Stop accepting channels and stop those that exist (self-clearing).
+        connections_->stop(error::service_stopped);
+        threadpool_.shutdown();
+        channel_pools_->shutdown();
+
+        // This is the end of the stop sequence.
+        handler(error::success);
+        return;
+    }
+
+    const auto state = std::make_shared<stopping>();
+    state->remaining.store(2);
+    state->completed.store(false);
+    state->started = clock::now();
+    state->timer = std::make_shared<deadline>(threadpool_,
+        settings_.shutdown_timeout());
+    state->handler = handler;
+    state->anchors = select_anchors();
+    connections_->count([state](size_t count) { state->channels = count; });
+
+    LOG_INFO(LOG_NETWORK)
+        << "Stopping " << state->channels << " channels.";
+
+    // The timeout and the completion of the stop race to the handler.
+    state->timer->start(
+        std::bind(&p2p::handle_stop_timeout,
+            this, _1, state));
+
+    // Save hosts while the channels stop, in parallel over the pool.
+    dispatch_.concurrent(&p2p::do_save_hosts, this, state);
+    connections_->stop(error::service_stopped, dispatch_,
+        std::bind(&p2p::handle_stop_part,
+            this, _1, state));
+
+    // Queued jobs and the timer complete before the threads terminate.
     threadpool_.shutdown();
+    channel_pools_->shutdown();
+}
 
-    // This is the end of the stop sequence.
-    handler(ec);
+// The outbound peers that delivered the most are the anchors of the next run.
+config::authority::list p2p::select_anchors() const
+{
+    typedef std::pair<uint64_t, config::authority> ranked;
+    std::vector<ranked> peers;
+
+    const auto visitor = [&peers](channel::ptr channel)
+    {
+        if (!channel->inbound())
+            peers.emplace_back(channel->metrics().received_bytes(),
+                channel->authority());
+    };
+
+    connections_->visit(visitor);
+
+    const auto greater = [](const ranked& left, const ranked& right)
+    {
+        return left.first > right.first;
+    };
+
+    std::sort(peers.begin(), peers.end(), greater);
+
+    config::authority::list anchors;
+    const auto count = std::min(peers.size(),
+        static_cast<size_t>(settings_.outbound_anchors));
+
+    for (size_t index = 0; index < count; ++index)
+        anchors.push_back(peers[index].second);
+
+    return anchors;
+}
+
+void p2p::do_save_hosts(stopping_ptr state)
+{
+    const auto anchored = anchors_.save(state->anchors);
+
+    if (anchored)
+        LOG_ERROR(LOG_NETWORK)
+            << "Error saving anchors file: " << anchored.message();
+
+    const auto ec = hosts_->save();
+
+    if (ec)
+        LOG_ERROR(LOG_NETWORK)
+            << "Error saving hosts file: " << ec.message();
+
+    // The result is read once the remaining count (a barrier) reaches zero.
+    state->result = ec;
+    handle_stop_part(error::success, state);
+}
+
+void p2p::handle_stop_part(const code&, stopping_ptr state)
+{
+    if (state->remaining.fetch_sub(1) != 1)
+        return;
+
+    state->timer->stop();
+
+    const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        clock::now() - state->started).count();
+
+    LOG_INFO(LOG_NETWORK)
+        << "Stopped " << state->channels << " channels in " << elapsed
+        << " ms.";
+
+    complete_stop(state->result, state);
+}
+
+void p2p::handle_stop_timeout(const code& ec, stopping_ptr state)
+{
+    // The timer is canceled when the stop completes.
+    if (ec)
+        return;
+
+    size_t remaining = 0;
+    connections_->count([&remaining](size_t count) { remaining = count; });
+
+    LOG_WARNING(LOG_NETWORK)
+        << "Timed out stopping channels, " << remaining << " of "
+        << state->channels << " remain.";
+
+    complete_stop(error::channel_timeout, state);
+}
+
+// This is the end of the stop sequence.
+void p2p::complete_stop(const code& ec, stopping_ptr state)
+{
+    if (!state->completed.exchange(true))
+        state->handler(ec);
 }
 
 // Destruct sequence.
@@ -314,17 +722,25 @@ p2p::~p2p()
     p2p::close();
 }
 
+// The stop handler may be invoked on a pool thread, which cannot join.
 void p2p::close()
 {
+    std::promise<code> promise;
+
     p2p::stop(
         std::bind(&p2p::handle_stopped,
-            this, _1));
-}
+            this, _1, std::ref(promise)));
+
+    promise.get_future().wait();
 
-void p2p::handle_stopped(const code&)
-{
     // This is the end of the destruct sequence.
     threadpool_.join();
+    channel_pools_->join();
+}
+
+void p2p::handle_stopped(const code& ec, std::promise<code>& promise)
+{
+    promise.set_value(ec);
 }
 
 // Connections collection.
@@ -364,6 +780,11 @@ void p2p::connected_count(count_handler handler)
     connections_->count(handler);
 }
 
+void p2p::connected_metrics(metrics_handler handler)
+{
+    connections_->metrics(handler);
+}
+
 // Hosts collection.
 // ----------------------------------------------------------------------------
 
@@ -373,6 +794,12 @@ void p2p::fetch_address(address_handler handler)
     handler(hosts_->fetch(out), out);
 }
 
+void p2p::fetch_addresses(buffer_handler handler)
+{
+    const_buffer out;
+    handler(hosts_->sample(out), out);
+}
+
 void p2p::store(const address& address, result_handler handler)
 {
     handler(hosts_->store(address));
@@ -389,6 +816,17 @@ void p2p::remove(const address& address, result_handler handler)
     handler(hosts_->remove(address));
 }
 
+void p2p::attempt(const address& address, result_handler handler)
+{
+    handler(hosts_->attempt(address));
+}
+
+void p2p::score(const address& address, const code& result,
+    result_handler handler)
+{
+    handler(hosts_->score(address, result));
+}
+
 void p2p::address_count(count_handler handler)
 {
     handler(hosts_->count());
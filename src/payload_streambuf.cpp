@@ -0,0 +1,91 @@
+/**
+ * Copyright (c) 2011-2016 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/network/payload_streambuf.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <ios>
+#include <bitcoin/bitcoin.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+// The get area is never written, the cast satisfies the streambuf interface.
+payload_streambuf::payload_streambuf(const uint8_t* data, size_t size)
+{
+    const auto begin = reinterpret_cast<char*>(const_cast<uint8_t*>(data));
+    setg(begin, begin, begin + size);
+}
+
+payload_streambuf::payload_streambuf(const data_chunk& data)
+  : payload_streambuf(data.data(), data.size())
+{
+}
+
+size_t payload_streambuf::remaining() const
+{
+    return egptr() - gptr();
+}
+
+std::streamsize payload_streambuf::showmanyc()
+{
+    const auto available = remaining();
+    return available == 0 ? -1 : static_cast<std::streamsize>(available);
+}
+
+payload_streambuf::pos_type payload_streambuf::seekoff(off_type offset,
+    std::ios_base::seekdir direction, std::ios_base::openmode mode)
+{
+    if ((mode & std::ios_base::in) == 0 || (mode & std::ios_base::out) != 0)
+        return pos_type(off_type(-1));
+
+    off_type base;
+    switch (direction)
+    {
+        case std::ios_base::beg:
+            base = 0;
+            break;
+        case std::ios_base::cur:
+            base = gptr() - eback();
+            break;
+        case std::ios_base::end:
+            base = egptr() - eback();
+            break;
+        default:
+            return pos_type(off_type(-1));
+    }
+
+    const auto position = base + offset;
+
+    if (position < 0 || position > egptr() - eback())
+        return pos_type(off_type(-1));
+
+    setg(eback(), eback() + position, egptr());
+    return pos_type(position);
+}
+
+payload_streambuf::pos_type payload_streambuf::seekpos(pos_type position,
+    std::ios_base::openmode mode)
+{
+    return seekoff(off_type(position), std::ios_base::beg, mode);
+}
+
+} // namespace network
+} // namespace libbitcoin
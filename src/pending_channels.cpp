@@ -19,7 +19,7 @@
  */
 #include <bitcoin/network/pending_channels.hpp>
 
-#include <algorithm>
+#include <cstddef>
 #include <cstdint>
 #include <functional>
 #include <bitcoin/bitcoin.hpp>
@@ -40,23 +40,20 @@ pending_channels::~pending_channels()
 bool pending_channels::safe_store(channel::ptr channel)
 {
     const auto version_nonce = channel->nonce();
-    const auto match = [version_nonce](const channel::ptr& entry)
-    {
-        return entry->nonce() == version_nonce;
-    };
 
     // Critical Section
     ///////////////////////////////////////////////////////////////////////////
     mutex_.lock_upgrade();
 
-    const auto it = std::find_if(channels_.begin(), channels_.end(), match);
-    const auto found = it != channels_.end();
+    const auto found = nonces_.find(version_nonce) != nonces_.end() ||
+        channels_.find(channel) != channels_.end();
 
     if (!found)
     {
         //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
         mutex_.unlock_upgrade_and_lock();
-        channels_.push_back(channel);
+        nonces_.emplace(version_nonce, channel);
+        channels_.emplace(channel, version_nonce);
         mutex_.unlock();
         //---------------------------------------------------------------------
         return true;
@@ -79,13 +76,14 @@ bool pending_channels::safe_remove(channel::ptr channel)
     ///////////////////////////////////////////////////////////////////////////
     mutex_.lock_upgrade();
 
-    const auto it = std::find(channels_.begin(), channels_.end(), channel);
+    const auto it = channels_.find(channel);
     const auto found = it != channels_.end();
 
     if (found)
     {
         //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
         mutex_.unlock_upgrade_and_lock();
+        nonces_.erase(it->second);
         channels_.erase(it);
         mutex_.unlock();
         //---------------------------------------------------------------------
@@ -105,17 +103,11 @@ void pending_channels::remove(channel::ptr channel, result_handler handler)
 
 bool pending_channels::safe_exists(uint64_t version_nonce) const
 {
-    const auto match = [version_nonce](channel::ptr entry)
-    {
-        return entry->nonce() == version_nonce;
-    };
-
     // Critical Section
     ///////////////////////////////////////////////////////////////////////////
     shared_lock lock(mutex_);
 
-    const auto it = std::find_if(channels_.begin(), channels_.end(), match);
-    return it != channels_.end();
+    return nonces_.find(version_nonce) != nonces_.end();
     ///////////////////////////////////////////////////////////////////////////
 }
 
@@ -126,5 +118,20 @@ void pending_channels::exists(uint64_t version_nonce,
     handler(version_nonce == 0 ? false : safe_exists(version_nonce));
 }
 
+size_t pending_channels::safe_count() const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    shared_lock lock(mutex_);
+
+    return channels_.size();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void pending_channels::count(count_handler handler) const
+{
+    handler(safe_count());
+}
+
 } // namespace network
 } // namespace libbitcoin
@@ -50,11 +50,21 @@ uint64_t protocol::nonce()
     return channel_->nonce();
 }
 
+uint64_t protocol::identifier()
+{
+    return channel_->identifier();
+}
+
 threadpool& protocol::pool()
 {
     return pool_;
 }
 
+channel_metrics& protocol::metrics()
+{
+    return channel_->metrics();
+}
+
 const message::version& protocol::peer_version()
 {
     return channel_->version();
@@ -66,6 +76,16 @@ void protocol::set_peer_version(const message::version& value)
     channel_->set_version(value);
 }
 
+void protocol::set_outstanding(size_t requests)
+{
+    channel_->set_outstanding(requests);
+}
+
+void protocol::hold_writes()
+{
+    channel_->hold_writes();
+}
+
 // Stop the channel.
 void protocol::stop(const code& ec)
 {
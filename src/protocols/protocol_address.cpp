@@ -22,6 +22,7 @@
 #include <functional>
 #include <bitcoin/bitcoin.hpp>
 #include <bitcoin/network/channel.hpp>
+#include <bitcoin/network/logging.hpp>
 #include <bitcoin/network/p2p.hpp>
 #include <bitcoin/network/protocols/protocol.hpp>
 #include <bitcoin/network/protocols/protocol_events.hpp>
@@ -39,6 +40,9 @@ using std::placeholders::_2;
 protocol_address::protocol_address(p2p& network, channel::ptr channel)
   : protocol_events(network, channel, NAME),
     network_(network),
+    get_address_interval_(std::chrono::seconds(
+        network.network_settings().channel_get_address_seconds)),
+    answered_(false),
     CONSTRUCT_TRACK(protocol_address)
 {
 }
@@ -49,6 +53,7 @@ protocol_address::protocol_address(p2p& network, channel::ptr channel)
 void protocol_address::start()
 {
     const auto& settings = network_.network_settings();
+    const auto messages = network_.cached_messages();
 
     // This protocol doesn't care about stop events.
     const auto unhandled = [](code){};
@@ -57,7 +62,8 @@ void protocol_address::start()
     if (settings.self.port() != 0)
     {
         self_ = address({ { settings.self.to_network_address() } });
-        SEND1(self_, handle_send_address, _1);
+        SEND_BUFFER1(address::command, messages->self_address(),
+            handle_send_address, _1);
     }
 
     // If we can't store addresses we don't ask for or handle them.
@@ -66,7 +72,8 @@ void protocol_address::start()
 
     SUBSCRIBE2(address, handle_receive_address, _1, _2);
     SUBSCRIBE2(get_address, handle_receive_get_address, _1, _2);
-    SEND1(get_address(), handle_send_get_address, _1);
+    SEND_BUFFER1(get_address::command, messages->get_address(),
+        handle_send_get_address, _1);
 }
 
 // Protocol.
@@ -80,14 +87,14 @@ bool protocol_address::handle_receive_address(const code& ec,
 
     if (ec)
     {
-        log::debug(LOG_PROTOCOL)
+        LOG_DEBUG(LOG_PROTOCOL)
             << "Failure receiving address message from ["
             << authority() << "] " << ec.message();
         stop(ec);
         return false;
     }
 
-    log::debug(LOG_PROTOCOL)
+    LOG_DEBUG(LOG_PROTOCOL)
         << "Storing addresses from [" << authority() << "] ("
         << message->addresses.size() << ")";
 
@@ -106,30 +113,61 @@ bool protocol_address::handle_receive_get_address(const code& ec,
 
     if (ec)
     {
-        log::debug(LOG_PROTOCOL)
+        LOG_DEBUG(LOG_PROTOCOL)
             << "Failure receiving get_address message from ["
             << authority() << "] " << ec.message();
         stop(ec);
         return false;
     }
 
-    // TODO: allowing repeated queries can allow a channel to map our history.
-    // TODO: pull active hosts from host cache (currently just resending self).
     // TODO: need to distort for privacy, don't send currently-connected peers.
 
-    if (self_.addresses.empty())
-        return false;
+    // Repeated queries are ignored, as they could map our history.
+    const auto now = clock::now();
+    if (answered_ && now - last_answer_ < get_address_interval_)
+    {
+        LOG_DEBUG(LOG_PROTOCOL)
+            << "Ignoring repeated get_address from [" << authority() << "]";
+        return true;
+    }
 
-    log::debug(LOG_PROTOCOL)
-        << "Sending addresses to [" << authority() << "] ("
-        << self_.addresses.size() << ")";
+    answered_ = true;
+    last_answer_ = now;
 
-    SEND1(self_, handle_send_address, _1);
+    // The sample is serialized once and shared by all channels.
+    network_.fetch_addresses(BIND2(handle_fetch_addresses, _1, _2));
 
     // RESUBSCRIBE
     return true;
 }
 
+void protocol_address::handle_fetch_addresses(const code& ec,
+    const_buffer buffer)
+{
+    if (stopped())
+        return;
+
+    if (!ec)
+    {
+        LOG_DEBUG(LOG_PROTOCOL)
+            << "Sending address sample to [" << authority() << "]";
+
+        SEND_BUFFER1(address::command, buffer, handle_send_address, _1);
+        return;
+    }
+
+    // Fall back to self when the pool is empty.
+    if (self_.addresses.empty())
+        return;
+
+    LOG_DEBUG(LOG_PROTOCOL)
+        << "Sending addresses to [" << authority() << "] ("
+        << self_.addresses.size() << ")";
+
+    SEND_BUFFER1(address::command, network_.cached_messages()->self_address(),
+        handle_send_address, _1);
+}
+
 void protocol_address::handle_send_address(const code& ec)
 {
     if (stopped())
@@ -137,7 +175,7 @@ void protocol_address::handle_send_address(const code& ec)
 
     if (ec)
     {
-        log::debug(LOG_PROTOCOL)
+        LOG_DEBUG(LOG_PROTOCOL)
             << "Failure sending address [" << authority() << "] "
             << ec.message();
         stop(ec);
@@ -151,7 +189,7 @@ void protocol_address::handle_send_get_address(const code& ec)
 
     if (ec)
     {
-        log::debug(LOG_PROTOCOL)
+        LOG_DEBUG(LOG_PROTOCOL)
             << "Failure sending get_address [" << authority() << "] "
             << ec.message();
         stop(ec);
@@ -165,7 +203,7 @@ void protocol_address::handle_store_addresses(const code& ec)
 
     if (ec)
     {
-        log::error(LOG_PROTOCOL)
+        LOG_ERROR(LOG_PROTOCOL)
             << "Failure storing addresses from [" << authority() << "] "
             << ec.message();
         stop(ec);
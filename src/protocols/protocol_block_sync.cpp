@@ -0,0 +1,248 @@
+/**
+ * Copyright (c) 2011-2016 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/network/protocols/protocol_block_sync.hpp>
+
+#include <cstddef>
+#include <functional>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/channel.hpp>
+#include <bitcoin/network/logging.hpp>
+#include <bitcoin/network/p2p.hpp>
+#include <bitcoin/network/protocols/protocol_timer.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+#define NAME "block_sync"
+#define CLASS protocol_block_sync
+
+using namespace bc::message;
+using std::placeholders::_1;
+using std::placeholders::_2;
+
+// A full headers message implies that more headers follow.
+static constexpr size_t max_headers = 2000;
+
+protocol_block_sync::protocol_block_sync(p2p& network, channel::ptr channel)
+  : protocol_timer(network, channel, true, NAME),
+    network_(network),
+    scheduler_(network.block_download()),
+    CONSTRUCT_TRACK(protocol_block_sync)
+{
+}
+
+// Start sequence.
+// ----------------------------------------------------------------------------
+
+void protocol_block_sync::start()
+{
+    // Only full nodes serve blocks.
+    if ((peer_version().services & services::node_network) == 0)
+        return;
+
+    // The timer checks for stalled requests at the stall interval.
+    const auto& settings = network_.network_settings();
+    protocol_timer::start(settings.download_stall(), BIND1(handle_event, _1));
+
+    SUBSCRIBE2(headers, handle_receive_headers, _1, _2);
+    SUBSCRIBE2(block, handle_receive_block, _1, _2);
+    network_.subscribe_download(BIND1(handle_work, _1));
+
+    // Work may already be available if the download is in progress.
+    send_requests();
+}
+
+// Requests.
+// ----------------------------------------------------------------------------
+
+void protocol_block_sync::send_requests()
+{
+    if (stopped())
+        return;
+
+    // Headers are requested only by the first channel to claim the role.
+    if (scheduler_->claim_headers(identifier()))
+    {
+        LOG_DEBUG(LOG_PROTOCOL)
+            << "Downloading headers from [" << authority() << "]";
+        send_get_headers();
+    }
+
+    const auto hashes = scheduler_->allocate(identifier());
+
+    // The channel is stopped if it is slow to answer outstanding requests.
+    set_outstanding(scheduler_->outstanding(identifier()));
+
+    if (hashes.empty())
+        return;
+
+    inventory_vector::list inventories;
+    inventories.reserve(hashes.size());
+
+    for (const auto& hash: hashes)
+        inventories.push_back({ inventory_type_id::block, hash });
+
+    SEND1(get_data(inventories), handle_send, _1);
+}
+
+void protocol_block_sync::send_get_headers()
+{
+    const auto locator = scheduler_->request_headers(identifier());
+
+    if (locator.empty())
+        return;
+
+    get_headers request;
+    request.start_hashes = locator;
+    request.stop_hash = null_hash;
+    SEND1(request, handle_send, _1);
+}
+
+void protocol_block_sync::handle_send(const code& ec)
+{
+    if (stopped())
+        return;
+
+    if (ec)
+    {
+        LOG_DEBUG(LOG_PROTOCOL)
+            << "Failure sending download request to [" << authority() << "] "
+            << ec.message();
+        stop(ec);
+    }
+}
+
+// Events.
+// ----------------------------------------------------------------------------
+
+// This is fired by the callback (i.e. base timer and stop handler).
+void protocol_block_sync::handle_event(const code& ec)
+{
+    if (ec == error::channel_stopped)
+    {
+        // Outstanding work of the channel is reassigned to others.
+        scheduler_->remove(identifier());
+        network_.notify_download_work();
+        return;
+    }
+
+    if (ec && ec != error::channel_timeout)
+    {
+        LOG_DEBUG(LOG_PROTOCOL)
+            << "Failure in block sync timer for [" << authority() << "] "
+            << ec.message();
+        stop(ec);
+        return;
+    }
+
+    const auto header = scheduler_->header_peer(identifier());
+    const auto expired = scheduler_->expire(identifier());
+    const auto released = header && !scheduler_->header_peer(identifier());
+    set_outstanding(scheduler_->outstanding(identifier()));
+
+    if (expired == 0 && !released)
+        return;
+
+    LOG_DEBUG(LOG_PROTOCOL)
+        << "Download stalled on [" << authority() << "] (" << expired
+        << ") blocks reassigned";
+
+    network_.notify_download_work();
+}
+
+bool protocol_block_sync::handle_work(const code& ec)
+{
+    if (stopped() || ec)
+        return false;
+
+    send_requests();
+
+    // RESUBSCRIBE
+    return true;
+}
+
+bool protocol_block_sync::handle_receive_headers(const code& ec,
+    headers::ptr message)
+{
+    if (stopped())
+        return false;
+
+    if (ec)
+    {
+        LOG_DEBUG(LOG_PROTOCOL)
+            << "Failure getting headers from [" << authority() << "] "
+            << ec.message();
+        stop(ec);
+        return false;
+    }
+
+    const auto result = scheduler_->store_headers(identifier(), message->elements);
+
+    // Headers are not requested of channels other than the header peer.
+    if (result == error::not_found)
+        return true;
+
+    if (result)
+    {
+        LOG_WARNING(LOG_PROTOCOL)
+            << "Invalid headers from [" << authority() << "]";
+        stop(error::bad_stream);
+        return false;
+    }
+
+    if (message->elements.size() >= max_headers)
+        send_get_headers();
+
+    if (!message->elements.empty())
+        network_.notify_download_work();
+
+    // RESUBSCRIBE
+    return true;
+}
+
+bool protocol_block_sync::handle_receive_block(const code& ec,
+    block::ptr message)
+{
+    if (stopped())
+        return false;
+
+    if (ec)
+    {
+        LOG_DEBUG(LOG_PROTOCOL)
+            << "Failure getting block from [" << authority() << "] "
+            << ec.message();
+        stop(ec);
+        return false;
+    }
+
+    // Blocks not requested by the download are left to other subscribers.
+    const auto hash = message->header.hash();
+    if (!scheduler_->complete(identifier(), hash, message->satoshi_size()))
+        return true;
+
+    network_.notify_download(message);
+    send_requests();
+
+    // RESUBSCRIBE
+    return true;
+}
+
+} // namespace network
+} // namespace libbitcoin
@@ -0,0 +1,443 @@
+/**
+ * Copyright (c) 2011-2016 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/network/protocols/protocol_compact_block.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/channel.hpp>
+#include <bitcoin/network/compact_messages.hpp>
+#include <bitcoin/network/logging.hpp>
+#include <bitcoin/network/p2p.hpp>
+#include <bitcoin/network/protocols/protocol_events.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+#define NAME "compact_block"
+#define CLASS protocol_compact_block
+
+using namespace bc::message;
+using std::placeholders::_1;
+using std::placeholders::_2;
+
+// The only compact block version without witness transactions.
+static constexpr uint64_t compact_version = 1;
+
+// Transaction indexes are 16 bits, so larger blocks cannot be compact.
+static constexpr size_t maximum_transactions = 0xffff;
+
+const uint32_t protocol_compact_block::version_minimum = 70014;
+
+protocol_compact_block::protocol_compact_block(p2p& network,
+    channel::ptr channel)
+  : protocol_events(network, channel, NAME),
+    network_(network),
+    compact_(false),
+    high_bandwidth_(false),
+    last_sent_(nullptr),
+    announcer_(false),
+    waiting_(false),
+    CONSTRUCT_TRACK(protocol_compact_block)
+{
+}
+
+// Start sequence.
+// ----------------------------------------------------------------------------
+
+void protocol_compact_block::start()
+{
+    protocol_events::start(BIND1(handle_stop, _1));
+
+    if (peer_version().value < version_minimum)
+        return;
+
+    SUBSCRIBE2(send_compact, handle_receive_send_compact, _1, _2);
+    SUBSCRIBE2(get_block_transactions, handle_receive_get_block_transactions,
+        _1, _2);
+    network_.subscribe_block(BIND2(handle_relay_block, _1, _2));
+
+    // Without a transaction source compact blocks cannot be reconstructed.
+    if (!network_.compact_relay())
+        return;
+
+    SUBSCRIBE2(compact_block, handle_receive_compact_block, _1, _2);
+    SUBSCRIBE2(block_transactions, handle_receive_block_transactions, _1, _2);
+
+    // Blocks are announced by inventory until the peer is promoted.
+    SEND1(send_compact(false, compact_version), handle_send, _1);
+}
+
+// A high bandwidth slot is released with the channel.
+void protocol_compact_block::handle_stop(const code& ec)
+{
+    if (ec == error::channel_stopped && announcer_.exchange(false))
+        network_.release_compact_announcer();
+}
+
+// Send.
+// ----------------------------------------------------------------------------
+
+bool protocol_compact_block::handle_relay_block(const code& ec,
+    block::ptr block)
+{
+    if (stopped() || ec)
+        return false;
+
+    // Other peers are sent blocks by announcement.
+    if (!compact_.load() || !high_bandwidth_.load())
+        return true;
+
+    // The block is retained to answer the peer's request for transactions.
+    last_sent_.store(block);
+
+    SEND1(compact_block::factory_from_block(*block, pseudo_random()),
+        handle_send, _1);
+
+    // RESUBSCRIBE
+    return true;
+}
+
+bool protocol_compact_block::handle_receive_send_compact(const code& ec,
+    send_compact::ptr message)
+{
+    if (stopped())
+        return false;
+
+    if (ec)
+    {
+        LOG_DEBUG(LOG_PROTOCOL)
+            << "Failure getting send_compact from [" << authority() << "] "
+            << ec.message();
+        stop(ec);
+        return false;
+    }
+
+    // Other versions are ignored, the peer may announce several.
+    if (message->version != compact_version)
+        return true;
+
+    compact_.store(true);
+    high_bandwidth_.store(message->high_bandwidth);
+
+    // RESUBSCRIBE
+    return true;
+}
+
+bool protocol_compact_block::handle_receive_get_block_transactions(
+    const code& ec, get_block_transactions::ptr message)
+{
+    if (stopped())
+        return false;
+
+    if (ec)
+    {
+        LOG_DEBUG(LOG_PROTOCOL)
+            << "Failure getting get_block_transactions from ["
+            << authority() << "] " << ec.message();
+        stop(ec);
+        return false;
+    }
+
+    // Only the last block sent compact is served, other requests are ignored.
+    const auto block = last_sent_.load();
+
+    if (!block || block->header.hash() != message->block_hash)
+        return true;
+
+    block_transactions response;
+    response.block_hash = message->block_hash;
+    response.transactions.reserve(message->indexes.size());
+
+    for (const auto index: message->indexes)
+    {
+        if (index >= block->transactions.size())
+        {
+            LOG_DEBUG(LOG_PROTOCOL)
+                << "Invalid transaction index requested by ["
+                << authority() << "]";
+            stop(error::bad_stream);
+            return false;
+        }
+
+        response.transactions.push_back(block->transactions[index]);
+    }
+
+    SEND1(response, handle_send, _1);
+
+    // RESUBSCRIBE
+    return true;
+}
+
+void protocol_compact_block::handle_send(const code& ec)
+{
+    if (stopped())
+        return;
+
+    if (ec)
+    {
+        LOG_DEBUG(LOG_PROTOCOL)
+            << "Failure sending compact block message to ["
+            << authority() << "] " << ec.message();
+        stop(ec);
+    }
+}
+
+// Receive.
+// ----------------------------------------------------------------------------
+
+bool protocol_compact_block::handle_receive_compact_block(const code& ec,
+    compact_block::ptr message)
+{
+    if (stopped())
+        return false;
+
+    if (ec)
+    {
+        LOG_DEBUG(LOG_PROTOCOL)
+            << "Failure getting compact_block from [" << authority() << "] "
+            << ec.message();
+        stop(ec);
+        return false;
+    }
+
+    // A new block abandons any incomplete reconstruction.
+    waiting_ = false;
+
+    if (!reconstruct(*message))
+    {
+        request_block(message->header.hash());
+        return true;
+    }
+
+    complete();
+
+    // RESUBSCRIBE
+    return true;
+}
+
+bool protocol_compact_block::handle_receive_block_transactions(
+    const code& ec, block_transactions::ptr message)
+{
+    if (stopped())
+        return false;
+
+    if (ec)
+    {
+        LOG_DEBUG(LOG_PROTOCOL)
+            << "Failure getting block_transactions from [" << authority()
+            << "] " << ec.message();
+        stop(ec);
+        return false;
+    }
+
+    if (!waiting_ || message->block_hash != pending_.header.hash())
+        return true;
+
+    auto transaction = message->transactions.begin();
+    const auto end = message->transactions.end();
+
+    // Missing transactions are sent in the order of their indexes.
+    for (size_t index = 0; index < filled_.size() && transaction != end;
+        ++index)
+    {
+        if (!filled_[index])
+        {
+            pending_.transactions[index] = *transaction++;
+            filled_[index] = true;
+        }
+    }
+
+    // A short response is not requested again, fall back to the full block.
+    if (std::find(filled_.begin(), filled_.end(), false) != filled_.end())
+    {
+        request_block(message->block_hash);
+        return true;
+    }
+
+    complete();
+
+    // RESUBSCRIBE
+    return true;
+}
+
+// Reconstruction.
+// ----------------------------------------------------------------------------
+
+// Returns false if the sketch cannot be reconstructed from short ids.
+bool protocol_compact_block::reconstruct(const compact_block& message)
+{
+    const auto count = message.transaction_count();
+
+    if (count == 0 || count > maximum_transactions)
+        return false;
+
+    pending_.header = message.header;
+    pending_.transactions.assign(count, transaction());
+    filled_.assign(count, false);
+
+    for (const auto& prefilled: message.prefilled)
+    {
+        if (prefilled.index >= count || filled_[prefilled.index])
+            return false;
+
+        pending_.transactions[prefilled.index] = prefilled.transaction;
+        filled_[prefilled.index] = true;
+    }
+
+    // Short ids occupy the positions not prefilled, in order.
+    std::unordered_map<uint64_t, size_t> positions;
+    auto short_id = message.short_ids.begin();
+
+    for (size_t index = 0; index < count; ++index)
+    {
+        if (filled_[index])
+            continue;
+
+        // A collision within the block cannot be resolved by short ids.
+        if (!positions.emplace(*short_id++, index).second)
+            return false;
+    }
+
+    const auto key = compact_block::to_key(message.header, message.nonce);
+    auto& transactions = pending_.transactions;
+    auto& filled = filled_;
+
+    network_.visit_candidates([&](transaction::ptr candidate)
+    {
+        const auto id = compact_block::short_id(key, candidate->hash());
+        const auto it = positions.find(id);
+
+        if (it == positions.end() || filled[it->second])
+            return;
+
+        transactions[it->second] = *candidate;
+        filled[it->second] = true;
+    });
+
+    waiting_ = true;
+    return true;
+}
+
+// Deliver the block if complete, otherwise request the missing transactions.
+void protocol_compact_block::complete()
+{
+    const auto hash = pending_.header.hash();
+    get_block_transactions request;
+    request.block_hash = hash;
+
+    for (size_t index = 0; index < filled_.size(); ++index)
+        if (!filled_[index])
+            request.indexes.push_back(index);
+
+    if (!request.indexes.empty())
+    {
+        LOG_DEBUG(LOG_PROTOCOL)
+            << "Requesting " << request.indexes.size()
+            << " missing transactions from [" << authority() << "]";
+        SEND1(request, handle_send, _1);
+        return;
+    }
+
+    waiting_ = false;
+    const auto root = block::generate_merkle_root(pending_.transactions);
+
+    // A short id collision with an unrelated transaction spoils the root.
+    if (root != pending_.header.merkle)
+    {
+        request_block(hash);
+        return;
+    }
+
+    network_.notify_block(std::make_shared<block>(pending_));
+    promote();
+}
+
+// The first peers to deliver a reconstructed block are asked to send blocks
+// compact, unannounced, within the network wide limit of BIP152.
+void protocol_compact_block::promote()
+{
+    if (announcer_.load() || !network_.claim_compact_announcer())
+        return;
+
+    announcer_.store(true);
+    SEND1(send_compact(true, compact_version), handle_send, _1);
+
+    // A stop that preceded the claim did not release it, so it is here.
+    if (stopped() && announcer_.exchange(false))
+        network_.release_compact_announcer();
+}
+
+void protocol_compact_block::request_block(const hash_digest& hash)
+{
+    waiting_ = false;
+
+    LOG_DEBUG(LOG_PROTOCOL)
+        << "Requesting full block from [" << authority() << "]";
+
+    // Blocks are subscribed only while requested, so others may be skipped.
+    if (std::find(requested_.begin(), requested_.end(), hash) ==
+        requested_.end())
+    {
+        if (requested_.empty())
+            SUBSCRIBE2(block, handle_receive_block, _1, _2);
+
+        requested_.push_back(hash);
+    }
+
+    const get_data request({ { inventory_type_id::block, hash } });
+    SEND1(request, handle_send, _1);
+}
+
+bool protocol_compact_block::handle_receive_block(const code& ec,
+    block::ptr message)
+{
+    if (stopped())
+        return false;
+
+    if (ec)
+    {
+        LOG_DEBUG(LOG_PROTOCOL)
+            << "Failure getting block from [" << authority() << "] "
+            << ec.message();
+        stop(ec);
+        return false;
+    }
+
+    const auto it = std::find(requested_.begin(), requested_.end(),
+        message->header.hash());
+
+    if (it == requested_.end())
+        return true;
+
+    requested_.erase(it);
+    network_.notify_block(message);
+
+    // RESUBSCRIBE while other requested blocks are outstanding.
+    return !requested_.empty();
+}
+
+} // namespace network
+} // namespace libbitcoin
@@ -23,6 +23,7 @@
 #include <string>
 #include <bitcoin/bitcoin.hpp>
 #include <bitcoin/network/channel.hpp>
+#include <bitcoin/network/logging.hpp>
 #include <bitcoin/network/p2p.hpp>
 #include <bitcoin/network/protocols/protocol.hpp>
 
@@ -61,7 +62,7 @@ void protocol_events::start(event_handler handler)
 
 void protocol_events::handle_stopped(const code& ec)
 {
-    log::debug(LOG_PROTOCOL)
+    LOG_DEBUG(LOG_PROTOCOL)
         << "Stop protocol_" << name() << " on [" << authority() << "] "
         << ec.message();
     
@@ -19,10 +19,13 @@
  */
 #include <bitcoin/network/protocols/protocol_ping.hpp>
 
+#include <chrono>
+#include <cstddef>
 #include <functional>
 #include <string>
 #include <bitcoin/bitcoin.hpp>
 #include <bitcoin/network/channel.hpp>
+#include <bitcoin/network/logging.hpp>
 #include <bitcoin/network/p2p.hpp>
 #include <bitcoin/network/protocols/protocol_timer.hpp>
 
@@ -36,9 +39,13 @@ using namespace bc::message;
 using std::placeholders::_1;
 using std::placeholders::_2;
 
+// A ping is sent at least once in this many heartbeats.
+static constexpr size_t maximum_suppressed = 4;
+
 protocol_ping::protocol_ping(p2p& network, channel::ptr channel)
   : protocol_timer(network, channel, true, NAME),
     settings_(network.network_settings()),
+    suppressed_(0),
     CONSTRUCT_TRACK(protocol_ping)
 {
 }
@@ -61,19 +68,39 @@ void protocol_ping::send_ping(const code& ec)
 
     if (ec && ec != error::channel_timeout)
     {
-        log::debug(LOG_PROTOCOL)
+        LOG_DEBUG(LOG_PROTOCOL)
             << "Failure in ping timer for [" << authority() << "] "
             << ec.message();
         stop(ec);
         return;
     }
 
+    // The initial ping (success) is never suppressed.
+    if (ec == error::channel_timeout && suppress())
+        return;
+
     const auto nonce = pseudo_random();
+    const auto sent = channel_metrics::clock::now();
 
-    SUBSCRIBE3(pong, handle_receive_pong, _1, _2, nonce);
+    SUBSCRIBE4(pong, handle_receive_pong, _1, _2, nonce, sent);
     SEND1(ping(nonce), handle_send_ping, _1);
 }
 
+// Receipt of any message within the heartbeat proves the peer is alive.
+bool protocol_ping::suppress()
+{
+    if (suppressed_ >= maximum_suppressed ||
+        metrics().idle() >= std::chrono::seconds(
+            settings_.channel_heartbeat().total_seconds()))
+    {
+        suppressed_ = 0;
+        return false;
+    }
+
+    ++suppressed_;
+    return true;
+}
+
 bool protocol_ping::handle_receive_ping(const code& ec,
     message::ping::ptr message)
 {
@@ -82,7 +109,7 @@ bool protocol_ping::handle_receive_ping(const code& ec,
 
     if (ec)
     {
-        log::debug(LOG_PROTOCOL)
+        LOG_DEBUG(LOG_PROTOCOL)
             << "Failure getting ping from [" << authority() << "] "
             << ec.message();
         stop(ec);
@@ -96,14 +123,15 @@ bool protocol_ping::handle_receive_ping(const code& ec,
 }
 
 bool protocol_ping::handle_receive_pong(const code& ec,
-    message::pong::ptr message, uint64_t nonce)
+    message::pong::ptr message, uint64_t nonce,
+    channel_metrics::clock::time_point sent)
 {
     if (stopped())
         return false;
 
     if (ec)
     {
-        log::debug(LOG_PROTOCOL)
+        LOG_DEBUG(LOG_PROTOCOL)
             << "Failure getting pong from [" << authority() << "] "
             << ec.message();
         stop(ec);
@@ -112,14 +140,17 @@ bool protocol_ping::handle_receive_pong(const code& ec,
 
     if (message->nonce != nonce)
     {
-        log::warning(LOG_PROTOCOL)
+        LOG_WARNING(LOG_PROTOCOL)
             << "Invalid pong nonce from [" << authority() << "]";
 
         // This could result from message overlap due to a short period,
         // but we assume the response is not as expected and terminate.
         stop(error::bad_stream);
+        return false;
     }
 
+    metrics().ping(channel_metrics::clock::now() - sent);
+
     return false;
 }
 
@@ -130,7 +161,7 @@ void protocol_ping::handle_send_ping(const code& ec)
 
     if (ec)
     {
-        log::debug(LOG_PROTOCOL)
+        LOG_DEBUG(LOG_PROTOCOL)
             << "Failure sending ping to [" << authority() << "] "
             << ec.message();
         stop(ec);
@@ -145,7 +176,7 @@ void protocol_ping::handle_send_pong(const code& ec)
 
     if (ec)
     {
-        log::debug(LOG_PROTOCOL)
+        LOG_DEBUG(LOG_PROTOCOL)
             << "Failure sending pong to [" << authority() << "] "
             << ec.message();
         stop(ec);
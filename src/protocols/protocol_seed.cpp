@@ -22,6 +22,7 @@
 #include <functional>
 #include <bitcoin/bitcoin.hpp>
 #include <bitcoin/network/channel.hpp>
+#include <bitcoin/network/logging.hpp>
 #include <bitcoin/network/p2p.hpp>
 #include <bitcoin/network/protocols/protocol_timer.hpp>
 
@@ -63,7 +64,9 @@ void protocol_seed::start(event_handler handler)
 
     SUBSCRIBE2(address, handle_receive_address, _1, _2);
     send_own_address(settings);
-    SEND1(get_address(), handle_send_get_address, _1);
+    SEND_BUFFER1(get_address::command,
+        network_.cached_messages()->get_address(), handle_send_get_address,
+        _1);
 }
 
 // Protocol.
@@ -77,8 +80,8 @@ void protocol_seed::send_own_address(const settings& settings)
         return;
     }
 
-    const address self({ { settings.self.to_network_address() } });
-    SEND1(self, handle_send_address, _1);
+    SEND_BUFFER1(address::command, network_.cached_messages()->self_address(),
+        handle_send_address, _1);
 }
 
 void protocol_seed::handle_seeding_complete(const code& ec,
@@ -96,14 +99,14 @@ bool protocol_seed::handle_receive_address(const code& ec,
 
     if (ec)
     {
-        log::debug(LOG_PROTOCOL)
+        LOG_DEBUG(LOG_PROTOCOL)
             << "Failure receiving addresses from seed [" << authority() << "] "
             << ec.message();
         set_event(ec);
         return false;
     }
 
-    log::debug(LOG_PROTOCOL)
+    LOG_DEBUG(LOG_PROTOCOL)
         << "Storing addresses from seed [" << authority() << "] ("
         << message->addresses.size() << ")";
 
@@ -120,7 +123,7 @@ void protocol_seed::handle_send_address(const code& ec)
 
     if (ec)
     {
-        log::debug(LOG_PROTOCOL)
+        LOG_DEBUG(LOG_PROTOCOL)
             << "Failure sending address to seed [" << authority() << "] "
             << ec.message();
         set_event(ec);
@@ -138,7 +141,7 @@ void protocol_seed::handle_send_get_address(const code& ec)
 
     if (ec)
     {
-        log::debug(LOG_PROTOCOL)
+        LOG_DEBUG(LOG_PROTOCOL)
             << "Failure sending get_address to seed [" << authority() << "] "
             << ec.message();
         set_event(ec);
@@ -156,14 +159,14 @@ void protocol_seed::handle_store_addresses(const code& ec)
 
     if (ec)
     {
-        log::error(LOG_PROTOCOL)
+        LOG_ERROR(LOG_PROTOCOL)
             << "Failure storing addresses from seed [" << authority() << "] "
             << ec.message();
         set_event(ec);
         return;
     }
 
-    log::debug(LOG_PROTOCOL)
+    LOG_DEBUG(LOG_PROTOCOL)
         << "Stopping completed seed [" << authority() << "] ";
 
     // 3 of 3
@@ -24,6 +24,7 @@
 #include <string>
 #include <bitcoin/bitcoin.hpp>
 #include <bitcoin/network/channel.hpp>
+#include <bitcoin/network/logging.hpp>
 #include <bitcoin/network/p2p.hpp>
 #include <bitcoin/network/protocols/protocol_events.hpp>
 
@@ -78,7 +79,7 @@ void protocol_timer::handle_timer(const code& ec)
     if (stopped())
         return;
 
-    log::debug(LOG_PROTOCOL)
+    LOG_DEBUG(LOG_PROTOCOL)
         << "Fired protocol_" << name() << " timer on [" << authority() << "] "
         << ec.message();
 
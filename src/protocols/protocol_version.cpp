@@ -24,6 +24,7 @@
 #include <functional>
 #include <bitcoin/bitcoin.hpp>
 #include <bitcoin/network/channel.hpp>
+#include <bitcoin/network/logging.hpp>
 #include <bitcoin/network/p2p.hpp>
 #include <bitcoin/network/protocols/protocol_timer.hpp>
 #include <bitcoin/network/settings.hpp>
@@ -80,6 +81,8 @@ version protocol_version::template_factory(const config::authority& authority,
 protocol_version::protocol_version(p2p& network, channel::ptr channel)
   : protocol_timer(network, channel, false, NAME),
     network_(network),
+    pipelined_(network.network_settings().channel_pipeline_handshake),
+    acknowledged_(false),
     CONSTRUCT_TRACK(protocol_version)
 {
 }
@@ -93,13 +96,20 @@ void protocol_version::start(event_handler handler)
     const auto& settings = network_.network_settings();
 
     // The handler is invoked in the context of the last message receipt.
-    protocol_timer::start(settings.channel_handshake(),
-        synchronize(handler, 2, NAME, false));
-
-    const auto self = template_factory(authority(), settings, nonce(), height);
+    // A pipelined handshake completes upon version and then awaits verack.
+    if (pipelined_)
+        protocol_timer::start(settings.channel_handshake(),
+            BIND2(handle_pipelined, _1, synchronize(handler, 1, NAME, false)));
+    else
+        protocol_timer::start(settings.channel_handshake(),
+            synchronize(handler, 2, NAME, false));
+
+    // The version is patched from a serialization shared by all channels.
+    const auto self = network_.cached_messages()->version(authority(), nonce(),
+        height);
     SUBSCRIBE2(version, handle_receive_version, _1, _2);
     SUBSCRIBE2(verack, handle_receive_verack, _1, _2);
-    SEND1(self, handle_version_sent, _1);
+    SEND_BUFFER1(version::command, self, handle_version_sent, _1);
 }
 
 // Protocol.
@@ -113,19 +123,26 @@ bool protocol_version::handle_receive_version(const code& ec,
 
     if (ec)
     {
-        log::debug(LOG_PROTOCOL)
+        LOG_DEBUG(LOG_PROTOCOL)
             << "Failure receiving version from [" << authority() << "] "
             << ec.message();
         set_event(ec);
         return false;
     }
 
-    log::debug(LOG_PROTOCOL)
+    LOG_DEBUG(LOG_PROTOCOL)
         << "Peer [" << authority() << "] version (" << message->value
         << ") services (" << message->services << ") " << message->user_agent;
 
     set_peer_version(*message);
-    SEND1(verack(), handle_verack_sent, _1);
+
+    // The session resumes writes once the channel protocols are attached, so
+    // their initial messages are written together with the verack.
+    if (pipelined_)
+        hold_writes();
+
+    SEND_BUFFER1(verack::command, network_.cached_messages()->verack(),
+        handle_verack_sent, _1);
 
     // 1 of 2
     set_event(error::success);
@@ -140,18 +157,34 @@ bool protocol_version::handle_receive_verack(const code& ec,
 
     if (ec)
     {
-        log::debug(LOG_PROTOCOL)
+        LOG_DEBUG(LOG_PROTOCOL)
             << "Failure receiving verack from [" << authority() << "] "
             << ec.message();
         set_event(ec);
         return false;
     }
 
+    // A pipelined handshake has completed, or completes, upon version.
+    acknowledged_ = true;
+    if (pipelined_)
+        return false;
+
     // 2 of 2
     set_event(error::success);
     return false;
 }
 
+// The synchronizer ignores events following completion, so a failure to
+// receive verack within the handshake timeout must stop the channel here.
+void protocol_version::handle_pipelined(const code& ec,
+    event_handler complete)
+{
+    complete(ec);
+
+    if (ec && ec != error::channel_stopped && !acknowledged_)
+        stop(ec);
+}
+
 void protocol_version::handle_version_sent(const code& ec)
 {
     if (stopped())
@@ -159,7 +192,7 @@ void protocol_version::handle_version_sent(const code& ec)
 
     if (ec)
     {
-        log::debug(LOG_PROTOCOL)
+        LOG_DEBUG(LOG_PROTOCOL)
             << "Failure sending version to [" << authority() << "] "
             << ec.message();
         set_event(ec);
@@ -174,7 +207,7 @@ void protocol_version::handle_verack_sent(const code& ec)
 
     if (ec)
     {
-        log::debug(LOG_PROTOCOL)
+        LOG_DEBUG(LOG_PROTOCOL)
             << "Failure sending verack to [" << authority() << "] "
             << ec.message();
         set_event(ec);
@@ -19,14 +19,23 @@
  */
 #include <bitcoin/network/proxy.hpp>
 
+#include <algorithm>
+#include <array>
 #include <cstddef>
 #include <cstdint>
 #include <cstdlib>
 #include <functional>
+#include <istream>
 #include <memory>
+#include <vector>
 #include <boost/iostreams/stream.hpp>
 #include <bitcoin/bitcoin.hpp>
 #include <bitcoin/network/const_buffer.hpp>
+#include <bitcoin/network/logging.hpp>
+#include <bitcoin/network/message_checksum.hpp>
+#include <bitcoin/network/payload_streambuf.hpp>
+#include <bitcoin/network/settings.hpp>
+#include <bitcoin/network/slab_allocator.hpp>
 #include <bitcoin/network/socket.hpp>
 
 namespace libbitcoin {
@@ -40,24 +49,82 @@ using std::placeholders::_2;
 using std::placeholders::_3;
 using std::placeholders::_4;
 
-// TODO: this is made up, configure payload size guard for DoS protection.
-static constexpr size_t max_payload_size = 10 * 1024 * 1024;
-////static const auto nop = [](code){};
+// The payload limits are indexed by message type.
+static constexpr size_t type_count =
+    static_cast<size_t>(message_type::version) + 1;
 
-proxy::proxy(threadpool& pool, socket::ptr socket, uint32_t magic)
+// The payload is read and hashed in chunks of no more than this size.
+static constexpr size_t payload_chunk_size = 64 * 1024;
+
+// The payload size follows the magic and command in the heading.
+static constexpr size_t payload_size_offset = 16;
+
+// Reading is retried at this interval while the network sheds memory.
+static const auto shed_interval = asio::milliseconds(100);
+
+// The heading of a serialized message is within its buffer.
+static const const_buffer no_heading{ data_chunk() };
+
+proxy::proxy(threadpool& pool, socket::ptr socket, const settings& settings,
+    buffer_pool::ptr buffers, token_bucket::ptr uploads,
+    memory_accounts::ptr memory)
   : stopped_(true),
-    magic_(magic),
+    paused_(false),
+    pending_bytes_(0),
+    magic_(settings.identifier),
+    write_limit_(settings.channel_write_bytes),
+    backlog_limit_(settings.channel_backlog_bytes),
+    unsolicited_limit_(settings.channel_unsolicited_bytes),
+    receive_backlog_(settings.channel_receive_backlog_bytes),
+    parallel_limit_(settings.channel_parallel_parse_bytes),
+    payload_limits_(to_limits(settings)),
     authority_(socket->get_authority()),
+    pool_(pool),
     socket_(socket),
-    message_subscriber_(pool),
-    ////send_subscriber_(std::make_shared<send_subscriber>(pool, NAME "_send")),
-    stop_subscriber_(std::make_shared<stop_subscriber>(pool, NAME "_stop"))
+    buffers_(buffers),
+    uploads_(uploads),
+    upload_(settings.channel_upload_bytes_per_second,
+        settings.channel_upload_bytes_per_second),
+    memory_(memory),
+    stop_subscriber_(std::make_shared<stop_subscriber>(pool, NAME "_stop")),
+    pressure_subscriber_(std::make_shared<pressure_subscriber>(pool,
+        NAME "_pressure")),
+    message_subscriber_(pool, to_types(settings.synchronous_messages),
+        socket->strand()),
+    read_buffer_(to_read_ahead(settings)),
+    read_begin_(0),
+    read_end_(0),
+    parsing_(false),
+    resumed_(false),
+    payload_pending_(false),
+    payload_type_(message_type::unknown),
+    partial_offset_(0),
+    next_sequence_(0),
+    next_delivery_(0),
+    writing_(false),
+    holding_(false),
+    pacing_(false),
+    congested_(false),
+    queued_bytes_(0)
 {
+    for (auto& count: own_subscriptions_)
+        count.store(0);
+
+    for (auto& count: own_batches_)
+        count.store(0);
+
+    memory_->add(memory_accounts::category::receive, read_buffer_.size());
 }
 
 proxy::~proxy()
 {
     BITCOIN_ASSERT_MSG(stopped(), "The channel was not stopped.");
+    memory_->remove(memory_accounts::category::receive, read_buffer_.size());
+
+    // A payload read may be abandoned by stop, with its buffer held.
+    if (payload_buffer_)
+        memory_->remove(memory_accounts::category::receive,
+            payload_buffer_->size());
 }
 
 // Properties.
@@ -68,6 +135,102 @@ const config::authority& proxy::authority() const
     return authority_;
 }
 
+void proxy::set_capture(traffic_capture::ptr capture)
+{
+    capture_ = capture;
+}
+
+channel_metrics& proxy::metrics()
+{
+    return metrics_;
+}
+
+const channel_metrics& proxy::metrics() const
+{
+    return metrics_;
+}
+
+// static
+message::message_type proxy::to_type(const std::string& command)
+{
+    heading head;
+    head.command = command;
+    return head.type();
+}
+
+// static
+// Control messages are small and latency sensitive, so they are not paced.
+// Unknown types include compact block relay, so these precede transactions.
+proxy::priority proxy::to_priority(message_type type)
+{
+    switch (type)
+    {
+        case message_type::ping:
+        case message_type::pong:
+        case message_type::reject:
+        case message_type::verack:
+        case message_type::version:
+            return priority::control;
+        case message_type::transaction:
+            return priority::transaction;
+        case message_type::block:
+        case message_type::merkle_block:
+            return priority::bulk;
+        default:
+            return priority::announcement;
+    }
+}
+
+// static
+message_subscriber::type_list proxy::to_types(
+    const std::vector<std::string>& commands)
+{
+    message_subscriber::type_list types;
+    types.reserve(commands.size());
+
+    for (const auto& command: commands)
+        types.push_back(to_type(command));
+
+    return types;
+}
+
+// static
+// Limits are configured as command:bytes, and an invalid entry is ignored.
+// Types not known to the library are limited by the channel payload limit.
+std::vector<size_t> proxy::to_limits(const settings& settings)
+{
+    std::vector<size_t> limits(type_count, settings.channel_payload_bytes);
+
+    for (const auto& entry: settings.payload_limits)
+    {
+        const auto separator = entry.find(':');
+
+        if (separator == std::string::npos)
+            continue;
+
+        const auto type = to_type(entry.substr(0, separator));
+        const auto digits = entry.c_str() + separator + 1;
+        char* end = nullptr;
+        const auto bytes = std::strtoul(digits, &end, 10);
+
+        if (type == message_type::unknown || end == digits || *end != '\0')
+            continue;
+
+        limits[static_cast<size_t>(type)] = bytes;
+    }
+
+    return limits;
+}
+
+// static
+// A zero size disables read-ahead, otherwise the buffer holds a heading.
+size_t proxy::to_read_ahead(const settings& settings)
+{
+    const size_t size = settings.channel_read_ahead_bytes;
+    const auto minimum = static_cast<size_t>(heading::serialized_size());
+    return size == 0 ? 0 : std::max(size, minimum);
+}
+
 // Start sequence.
 // ----------------------------------------------------------------------------
 
@@ -79,21 +242,18 @@ void proxy::start(result_handler handler)
         return;
     }
 
-    const auto sender = 
-        std::bind(&proxy::do_send,
-            shared_from_this(), _1, _2, _3,_4);
-
     stopped_ = false;
     stop_subscriber_->start();
+    pressure_subscriber_->start();
     message_subscriber_.start();
-    ////send_subscriber_->start();
-    ////send_subscriber_->subscribe(sender, error::channel_stopped, {}, {}, nop);
 
     // Allow for subscription before first read, so no messages are missed.
     handler(error::success);
 
-    // Start the read cycle.
-    read_heading();
+    // Start the read cycle within the strand.
+    socket_->strand().dispatch(
+        std::bind(&proxy::read_heading,
+            shared_from_this()));
 }
 
 // Stop subscription.
@@ -104,23 +264,98 @@ void proxy::subscribe_stop(result_handler handler)
     stop_subscriber_->subscribe(handler, error::channel_stopped);
 }
 
+// Pressure subscription.
+// ----------------------------------------------------------------------------
+
+void proxy::subscribe_pressure(pressure_handler handler)
+{
+    pressure_subscriber_->subscribe(handler, error::channel_stopped, false);
+}
+
+bool proxy::congested() const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    shared_lock lock(mutex_);
+
+    return congested_;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
 // Read cycle (read continues until stop).
 // ----------------------------------------------------------------------------
 
+// Reading pauses while queued payloads not yet handled exceed the backlog,
+// and while the network is over its memory limit.
+void proxy::read_next()
+{
+    // A read burst ends when the next message is not buffered, and batched
+    // messages hold pending bytes, so batches are delivered before waiting.
+    if (!buffered() || memory_->exhausted() ||
+        (receive_backlog_ != 0 && pending_bytes_ > receive_backlog_))
+        message_subscriber_.flush();
+
+    if (memory_->exhausted())
+    {
+        shed();
+        return;
+    }
+
+    if (receive_backlog_ != 0 && pending_bytes_ > receive_backlog_)
+    {
+        paused_ = true;
+
+        // A release that preceded the pause has not resumed reading.
+        if (pending_bytes_ > receive_backlog_ || !paused_.exchange(false))
+        {
+            LOG_DEBUG(LOG_NETWORK)
+                << "Pausing reads from [" << authority() << "] ("
+                << pending_bytes_ << " bytes pending)";
+            return;
+        }
+    }
+
+    read_heading();
+}
+
+// The memory limit is shared, so its relief is polled rather than notified.
+void proxy::shed()
+{
+    const auto timer = std::allocate_shared<deadline>(
+        slab_allocator<deadline>(), socket_->pool(), shed_interval);
+
+    timer->start(
+        socket_->strand().wrap(
+            std::bind(&proxy::handle_shed,
+                shared_from_this(), _1)));
+}
+
+void proxy::handle_shed(const code& ec)
+{
+    if (stopped() || ec)
+        return;
+
+    read_next();
+}
+
 void proxy::read_heading()
 {
     if (stopped())
         return;
 
-    // Critical Section (external)
-    ///////////////////////////////////////////////////////////////////////////
-    const auto socket = socket_->get_socket();
+    if (!read_buffer_.empty())
+    {
+        read_buffered();
+        return;
+    }
 
+    // The socket is only used within the strand, so it is not locked.
+    // Reads are sequential, so each reuses the memory of the last.
     using namespace boost::asio;
-    async_read(socket->get(), buffer(heading_buffer_),
-        std::bind(&proxy::handle_read_heading,
-            shared_from_this(), _1, _2));
-    ///////////////////////////////////////////////////////////////////////////
+    async_read(socket_->get(), buffer(heading_buffer_),
+        socket_->strand().wrap(make_allocated_handler(read_allocator_,
+            std::bind(&proxy::handle_read_heading,
+                shared_from_this(), _1, _2))));
 }
 
 void proxy::handle_read_heading(const boost_code& ec, size_t)
@@ -130,121 +365,400 @@ void proxy::handle_read_heading(const boost_code& ec, size_t)
 
     if (ec)
     {
-        log::debug(LOG_NETWORK)
+        LOG_DEBUG(LOG_NETWORK)
             << "Heading read failure [" << authority() << "] "
             << code(error::boost_to_error_code(ec)).message();
         stop(ec);
         return;
     }
 
-    ////log::debug(LOG_NETWORK)
+    ////LOG_DEBUG(LOG_NETWORK)
     ////    << "Read (" << size << ") heading bytes from [" << authority() << "]";
 
-    heading head;
+    if (handle_heading())
+        read_payload();
+}
+
+// Parse and validate the heading buffer, stopping the channel if invalid.
+bool proxy::handle_heading()
+{
+    // The heading is retained for the payload read, without copying.
+    auto& head = payload_heading_;
     heading_stream istream(heading_buffer_);
     const auto parsed = head.from_data(istream);
 
     if (!parsed || head.magic != magic_)
     {
-        log::warning(LOG_NETWORK) 
+        LOG_WARNING(LOG_NETWORK) 
             << "Invalid heading from [" << authority() << "]";
         stop(error::bad_stream);
-        return;
+        return false;
     }
 
-    if (head.payload_size > max_payload_size)
+    // The type is matched on the raw command field, without a string.
+    const auto field = heading_buffer_.begin() + sizeof(uint32_t);
+    std::copy(field, field + payload_command_.size(), payload_command_.begin());
+    payload_type_ = message_subscriber::to_type(payload_command_);
+
+    if (head.payload_size > payload_limits_[static_cast<size_t>(payload_type_)])
     {
-        log::warning(LOG_NETWORK)
+        LOG_WARNING(LOG_NETWORK)
             << "Oversized payload indicated by " << head.command
             << " heading from [" << authority() << "] ("
             << head.payload_size << " bytes)";
         stop(error::bad_stream);
-        return;
+        return false;
     }
 
-    ////log::debug(LOG_NETWORK)
+    if (unsolicited(head))
+    {
+        LOG_WARNING(LOG_NETWORK)
+            << "Unsolicited payload indicated by " << head.command
+            << " heading from [" << authority() << "] ("
+            << head.payload_size << " bytes)";
+        stop(error::bad_stream);
+        return false;
+    }
+
+    ////LOG_DEBUG(LOG_NETWORK)
     ////    << "Valid " << head.command << " heading from ["
     ////    << authority() << "] (" << head.payload_size << " bytes)";
 
-    read_payload(head);
+    metrics_.activity();
     handle_activity();
+    return true;
 }
 
-void proxy::read_payload(const heading& head)
+// Buffered reads parse each complete message from the read-ahead buffer, and
+// refill it with one read of as many bytes as are available when exhausted.
+// A message read invoked by a message of the loop is continued by the loop.
+void proxy::read_buffered()
+{
+    if (parsing_)
+    {
+        resumed_ = true;
+        return;
+    }
+
+    parsing_ = true;
+
+    do
+    {
+        resumed_ = false;
+        parse_buffered();
+    } while (resumed_ && !stopped());
+
+    parsing_ = false;
+}
+
+void proxy::parse_buffered()
+{
+    const auto heading_size = static_cast<size_t>(heading::serialized_size());
+
+    if (!payload_pending_)
+    {
+        if (read_end_ - read_begin_ < heading_size)
+        {
+            fill_buffer();
+            return;
+        }
+
+        const auto start = read_buffer_.begin() + read_begin_;
+        std::copy(start, start + heading_size, heading_buffer_.begin());
+        read_begin_ += heading_size;
+
+        if (!handle_heading())
+            return;
+
+        // A payload that cannot fit the buffer is read into its own.
+        if (payload_heading_.payload_size > read_buffer_.size())
+        {
+            read_payload();
+            return;
+        }
+
+        payload_pending_ = true;
+    }
+
+    const size_t size = payload_heading_.payload_size;
+
+    if (read_end_ - read_begin_ < size)
+    {
+        fill_buffer();
+        return;
+    }
+
+    // The buffer is not compacted until the next fill, which follows parse.
+    const auto payload = read_buffer_.data() + read_begin_;
+    read_begin_ += size;
+    payload_pending_ = false;
+    checksum_.reset();
+    checksum_.update(payload, size);
+    handle_read_payload(boost_code(), payload);
+}
+
+// Unparsed bytes are moved to the front, a partial message at most.
+void proxy::fill_buffer()
+{
+    if (stopped())
+        return;
+
+    const auto begin = read_buffer_.begin();
+    std::copy(begin + read_begin_, begin + read_end_, begin);
+    read_end_ -= read_begin_;
+    read_begin_ = 0;
+
+    const auto data = read_buffer_.data() + read_end_;
+    const auto size = read_buffer_.size() - read_end_;
+
+    using namespace boost::asio;
+    socket_->get().async_read_some(buffer(data, size),
+        socket_->strand().wrap(make_allocated_handler(read_allocator_,
+            std::bind(&proxy::handle_fill_buffer,
+                shared_from_this(), _1, _2))));
+}
+
+void proxy::handle_fill_buffer(const boost_code& ec, size_t size)
 {
     if (stopped())
         return;
 
-    const auto size = head.payload_size;
+    if (ec)
+    {
+        LOG_DEBUG(LOG_NETWORK)
+            << "Read failure [" << authority() << "] "
+            << code(error::boost_to_error_code(ec)).message();
+        stop(ec);
+        return;
+    }
+
+    read_end_ += size;
+    read_buffered();
+}
+
+// Unregistered commands are not skipped, as their load fails.
+// The bookkeeping subscriptions of the proxy itself do not solicit payloads.
+bool proxy::skipped() const
+{
+    if (payload_type_ != message_type::unknown)
+    {
+        const auto index = static_cast<size_t>(payload_type_);
+        return message_subscriber_.subscriptions(payload_type_) <=
+                own_subscriptions_[index] &&
+            message_subscriber_.batch_subscriptions(payload_type_) <=
+                own_batches_[index];
+    }
+
+    return message_subscriber_.registered(payload_command_) &&
+        !message_subscriber_.subscribed(payload_command_);
+}
+
+// True if the read-ahead buffer holds the whole of the next message.
+bool proxy::buffered() const
+{
+    const auto heading_size = static_cast<size_t>(heading::serialized_size());
+    const auto available = read_end_ - read_begin_;
+
+    if (read_buffer_.empty() || available < heading_size)
+        return false;
+
+    const auto size = from_little_endian_unsafe<uint32_t>(
+        read_buffer_.data() + read_begin_ + payload_size_offset);
+
+    return available - heading_size >= size;
+}
+
+// A zero limit disables the disconnection of unsolicited payloads.
+bool proxy::unsolicited(const heading& head) const
+{
+    return unsolicited_limit_ != 0 && head.payload_size > unsolicited_limit_ &&
+        skipped();
+}
+
+void proxy::read_payload()
+{
+    if (stopped())
+        return;
+
+    const size_t size = payload_heading_.payload_size;
 
     // The payload buffer is protected by ordering, not the critial section.
-    payload_buffer_.resize(size);
+    // The buffer is borrowed from the shared pool for the life of the message.
+    payload_buffer_ = buffers_->borrow(size);
+    memory_->add(memory_accounts::category::receive, size);
+    checksum_.reset();
+
+    // Bytes already read ahead into the buffer begin the payload.
+    const auto buffered = std::min(read_end_ - read_begin_, size);
+    const auto begin = read_buffer_.begin() + read_begin_;
+    std::copy(begin, begin + buffered, payload_buffer_->begin());
+    checksum_.update(payload_buffer_->data(), buffered);
+    read_begin_ += buffered;
+    read_payload_chunk(buffered);
+}
 
-    // Critical Section (external)
-    ///////////////////////////////////////////////////////////////////////////
-    const auto socket = socket_->get_socket();
+// The payload is read in chunks, each hashed as it arrives (while in cache),
+// so that the checksum is complete as soon as the last chunk is read.
+void proxy::read_payload_chunk(size_t offset)
+{
+    if (stopped())
+        return;
+
+    const size_t size = payload_heading_.payload_size;
+    const auto chunk = std::min(size - offset, payload_chunk_size);
+    const auto data = payload_buffer_->data() + offset;
 
+    // The socket is only used within the strand, so it is not locked.
     using namespace boost::asio;
-    async_read(socket->get(), buffer(payload_buffer_, size),
-        std::bind(&proxy::handle_read_payload,
-            shared_from_this(), _1, _2, head));
-    ///////////////////////////////////////////////////////////////////////////
+    async_read(socket_->get(), buffer(data, chunk),
+        socket_->strand().wrap(make_allocated_handler(read_allocator_,
+            std::bind(&proxy::handle_read_payload_chunk,
+                shared_from_this(), _1, _2, offset))));
 }
 
-void proxy::handle_read_payload(const boost_code& ec, size_t,
-    const heading& head)
+void proxy::handle_read_payload_chunk(const boost_code& ec, size_t size,
+    size_t offset)
 {
     if (stopped())
         return;
 
+    if (ec)
+    {
+        LOG_DEBUG(LOG_NETWORK)
+            << "Payload read failure [" << authority() << "] "
+            << code(error::boost_to_error_code(ec)).message();
+        stop(ec);
+        return;
+    }
+
+    checksum_.update(payload_buffer_->data() + offset, size);
+    const auto next = offset + size;
+
+    if (next < payload_heading_.payload_size)
+    {
+        read_payload_chunk(next);
+        return;
+    }
+
+    handle_read_payload(ec, payload_buffer_->data());
+}
+
+// The payload is complete, in its own buffer or in the read-ahead buffer.
+void proxy::handle_read_payload(const boost_code& ec, const uint8_t* payload)
+{
+    if (stopped())
+        return;
+
+    const auto& head = payload_heading_;
+
     ////// Ignore read error here, client may have disconnected.
     ////if (ec)
     ////{
-    ////    log::debug(LOG_NETWORK)
+    ////    LOG_DEBUG(LOG_NETWORK)
     ////        << "Payload read failure [" << authority() << "] "
     ////        << code(error::boost_to_error_code(ec)).message();
     ////    stop(ec);
     ////    return;
     ////}
 
-    ////log::debug(LOG_NETWORK)
+    ////LOG_DEBUG(LOG_NETWORK)
     ////    << "Read (" << size << ") payload bytes from [" << authority() << "] ";
 
-    if (head.checksum != bitcoin_checksum(payload_buffer_))
+    if (head.checksum != checksum_.finalize())
     {
-        log::warning(LOG_NETWORK) 
+        LOG_WARNING(LOG_NETWORK) 
             << "Invalid " << head.command << " checksum from ["
             << authority() << "]";
         stop(error::bad_stream);
         return;
     }
 
-    // Parse and publish the payload to message subscribers.
-    payload_source source(payload_buffer_);
-    payload_stream istream(source);
+    // Only validated messages are captured, so that each replays.
+    if (capture_)
+        capture_->write(authority_, head, payload);
 
-    // Notify subscribers of the new message.
-    const auto parse_error = message_subscriber_.load(head.type(), istream);
-    const auto unconsumed = istream.peek() != std::istream::traits_type::eof();
+    code parse_error(error::success);
+    auto unconsumed = false;
+    const auto skip = skipped();
+
+    // A large payload is parsed on the pool while reading continues.
+    if (!skip && parallel(head.payload_size))
+    {
+        // The message is counted as received once it has parsed.
+        parse_parallel();
+        metrics_.activity();
+        handle_activity();
+        read_next();
+        return;
+    }
+
+    if (skip)
+    {
+        // No subscriber would receive the message, so it is not parsed.
+        metrics_.skipped(head.payload_size);
+    }
+    else
+    {
+        // Parse and publish the payload to message subscribers.
+        // The stream reads directly from the payload buffer, without copying.
+        payload_streambuf source(payload, head.payload_size);
+        std::istream istream(&source);
+
+        // Notify subscribers of the new message, holding its size as pending
+        // until the notification is handled.
+        const auto held = hold(head.payload_size);
+
+        // Behind an outstanding parallel parse the delivery is ordered.
+        if (next_sequence_ != next_delivery_ &&
+            payload_type_ != message_type::unknown)
+        {
+            message_subscriber::delivery notify;
+            parse_error = message_subscriber_.parse(payload_type_, istream,
+                held, notify);
+            order(next_sequence_++, notify);
+        }
+        else
+        {
+            parse_error = payload_type_ == message_type::unknown ?
+                message_subscriber_.load(payload_command_, istream, held) :
+                message_subscriber_.load(payload_type_, istream, held);
+        }
+
+        unconsumed = istream.peek() != std::istream::traits_type::eof();
+    }
+
+    // Return the buffer to the pool now that the stream is consumed.
+    if (payload_buffer_)
+    {
+        payload_buffer_.reset();
+        memory_->remove(memory_accounts::category::receive,
+            head.payload_size);
+    }
 
     if (stopped())
         return;
 
-    if (!parse_error)
+    if (skip)
+    {
+        LOG_DEBUG(LOG_NETWORK)
+            << "Skipped " << head.command << " payload from ["
+            << authority() << "] (" << head.payload_size << " bytes)";
+    }
+    else if (!parse_error)
     {
         if (unconsumed)
-            log::warning(LOG_NETWORK)
+            LOG_WARNING(LOG_NETWORK)
             << "Valid " << head.command << " payload from ["
                 << authority() << "] unused bytes remain.";
         else
-            log::debug(LOG_NETWORK)
+            LOG_DEBUG(LOG_NETWORK)
             << "Valid " << head.command << " payload from ["
-                << authority() << "] (" << payload_buffer_.size() << " bytes)";
+                << authority() << "] (" << head.payload_size << " bytes)";
     }
 
     if (ec)
     {
-        log::debug(LOG_NETWORK)
+        LOG_DEBUG(LOG_NETWORK)
             << "Payload read failure [" << authority() << "] "
             << code(error::boost_to_error_code(ec)).message();
         stop(ec);
@@ -253,82 +767,631 @@ void proxy::handle_read_payload(const boost_code& ec, size_t,
 
     if (parse_error)
     {
-        log::warning(LOG_NETWORK)
+        LOG_WARNING(LOG_NETWORK)
             << "Invalid " << head.command << " stream from ["
             << authority() << "] " << parse_error.message();
         stop(parse_error);
+        return;
     }
 
+    // Only a parsed message is counted as received.
+    metrics_.received(payload_type_, heading::serialized_size() +
+        head.payload_size);
+    metrics_.activity();
     handle_activity();
-    read_heading();
+    read_next();
+}
+
+// Parallel parse sequence.
+// ----------------------------------------------------------------------------
+// Each parallel parse takes a sequence number and is delivered on the strand
+// once those before it, so the messages of a channel arrive in read order.
+// Payloads read into the read-ahead buffer are parsed inline, as the buffer
+// is reused by the next read. Messages of types not known to the library are
+// not ordered among parallel parses.
+
+// A zero limit disables parallel parsing.
+bool proxy::parallel(size_t size) const
+{
+    return parallel_limit_ != 0 && size >= parallel_limit_ &&
+        payload_buffer_ && payload_type_ != message_type::unknown;
+}
+
+// The payload buffer and its memory account pass to the parse.
+void proxy::parse_parallel()
+{
+    const auto& head = payload_heading_;
+    const auto held = hold(head.payload_size);
+    const auto buffer = payload_buffer_;
+    payload_buffer_.reset();
+
+    pool_.service().post(
+        std::bind(&proxy::do_parse,
+            shared_from_this(), payload_type_, head.command,
+                head.payload_size, next_sequence_++, buffer, held));
+}
+
+void proxy::do_parse(message_type type, const std::string& command,
+    size_t size, uint64_t sequence, buffer_pool::buffer buffer,
+    message_subscriber::ticket held)
+{
+    message_subscriber::delivery notify;
+    payload_streambuf source(buffer->data(), size);
+    std::istream istream(&source);
+    const auto ec = message_subscriber_.parse(type, istream, held, notify);
+
+    if (!ec && istream.peek() != std::istream::traits_type::eof())
+        LOG_WARNING(LOG_NETWORK)
+            << "Valid " << command << " payload from ["
+            << authority() << "] unused bytes remain.";
+
+    buffer.reset();
+    memory_->remove(memory_accounts::category::receive, size);
+
+    socket_->strand().post(
+        std::bind(&proxy::handle_parse,
+            shared_from_this(), ec, type, command, size, sequence, notify));
+}
+
+void proxy::handle_parse(const code& ec, message_type type,
+    const std::string& command, size_t size, uint64_t sequence,
+    message_subscriber::delivery notify)
+{
+    if (stopped())
+        return;
+
+    if (ec)
+    {
+        LOG_WARNING(LOG_NETWORK)
+            << "Invalid " << command << " stream from ["
+            << authority() << "] " << ec.message();
+        stop(ec);
+        return;
+    }
+
+    metrics_.received(type, heading::serialized_size() + size);
+    order(sequence, notify);
+
+    // The read loop shares the strand, so it is not within a burst here. A
+    // batched message delivered by the parse is flushed, as a read may not
+    // complete (or resume) until the batch is handled.
+    message_subscriber_.flush();
+}
+
+// Deliver each ready message that follows the last delivered.
+void proxy::order(uint64_t sequence, message_subscriber::delivery notify)
+{
+    ready_.emplace(sequence, notify);
+
+    for (auto it = ready_.begin();
+        it != ready_.end() && it->first == next_delivery_;
+        it = ready_.erase(it), ++next_delivery_)
+    {
+        if (it->second)
+            it->second();
+    }
+}
+
+void proxy::clear_ready()
+{
+    ready_.clear();
+    message_subscriber_.discard();
+}
+
+// The ticket is released once its notification is handled, on any thread.
+// The size of the payload estimates that of the parsed message it holds.
+message_subscriber::ticket proxy::hold(size_t size)
+{
+    pending_bytes_ += size;
+    memory_->add(memory_accounts::category::receive, size);
+    const auto self = shared_from_this();
+    return message_subscriber::ticket(nullptr, [self, size](void*)
+    {
+        self->release(size);
+    });
+}
+
+void proxy::release(size_t size)
+{
+    const auto pending = pending_bytes_ -= size;
+    memory_->remove(memory_accounts::category::receive, size);
+
+    // Only one of the pause and the release resumes reading.
+    if (pending <= receive_backlog_ && paused_.exchange(false))
+        socket_->strand().post(
+            std::bind(&proxy::read_heading,
+                shared_from_this()));
 }
 
 // Message send sequence.
 // ----------------------------------------------------------------------------
+// Messages are queued and written by a single outstanding gathered write.
+// Each write takes as many queued messages as fit within the write limit, in
+// priority order, and a message that exceeds the limit is written in chunks.
+
+void proxy::send_buffer(const std::string& command, const_buffer buffer,
+    result_handler handler)
+{
+    do_send(command, buffer, handler);
+}
 
-////// vvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvv
-////// THIS REQUIRES AT LEAST TWO NETWORK THREADS TO PREVENT THREAD STARVATION.
-////// ^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^
-////// The send subscriber pushes queued writes to the writer instead of having
-////// writer pull them from a passive queue. This is less thread-efficient but it
-////// allows us to reuse the subscriber and facilitates bypass of subscriber
-////// queuing for large message types such as blocks, as we do with reads.
-bool proxy::do_send(const code&, const std::string& command,
+// The checksum is computed over the payload in place.
+void proxy::send_payload(const std::string& command, const_buffer payload,
+    result_handler handler)
+{
+    using namespace boost::asio;
+    const auto data = buffer_cast<const uint8_t*>(*payload.begin());
+    const auto checksum = message_checksum::compute(data, payload.size());
+    send_payload(command, payload, checksum, handler);
+}
+
+// Only the heading is serialized, the payload is written from its buffer.
+void proxy::send_payload(const std::string& command, const_buffer payload,
+    uint32_t checksum, result_handler handler)
+{
+    heading head;
+    head.magic = magic_;
+    head.command = command;
+    head.payload_size = static_cast<uint32_t>(payload.size());
+    head.checksum = checksum;
+    do_send(command, const_buffer(head.to_data()), payload, handler);
+}
+
+void proxy::do_send(const std::string& command, const_buffer buffer,
+    result_handler handler)
+{
+    do_send(command, no_heading, buffer, handler);
+}
+
+void proxy::do_send(const std::string& command, const_buffer heading,
     const_buffer buffer, result_handler handler)
 {
     if (stopped())
     {
         handler(error::channel_stopped);
-        return false;
+        return;
     }
 
-    ////if (ec)
-    ////{
-    ////    log::debug(LOG_NETWORK)
-    ////        << "Send dequeue failure [" << authority() << "] " << ec.message();
-    ////    handler(ec);
-    ////    stop(ec);
-    ////    return false;
-    ////}
+    const auto type = to_type(command);
+    const auto level = to_priority(type);
+    const queued_message message{ type, command, heading, buffer, handler };
+    const auto size = message.size();
+
+    LOG_DEBUG(LOG_NETWORK)
+        << "Queueing " << command << " to [" << authority() << "] ("
+        << size << " bytes)";
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    mutex_.lock();
+
+    queues_[static_cast<size_t>(level)].push_back(message);
+    queued_bytes_ += size;
+    metrics_.queued(queued_count(), queued_bytes_);
+
+    // A buffer shared by a broadcast is accounted to each queue holding it.
+    memory_->add(memory_accounts::category::send, size);
+
+    // A control message preempts a paced wait, and the wait is then ignored.
+    // Held messages are not written, not even control, until writes resume.
+    const auto preempt = !holding_ && pacing_ && level == priority::control;
+    const auto start = !holding_ && (!writing_ || preempt);
+    pacing_ = pacing_ && !preempt;
+    const auto congest = !congested_ && queued_bytes_ > backlog_limit_;
+    writing_ = writing_ || start;
+    congested_ = congested_ || congest;
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    if (congest)
+        pressure_subscriber_->relay(error::success, true);
+
+    // Writes are initiated and completed within the strand.
+    if (start)
+        socket_->strand().dispatch(
+            std::bind(&proxy::write_batch,
+                shared_from_this()));
+}
+
+void proxy::hold_writes()
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    holding_ = true;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void proxy::resume_writes()
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    mutex_.lock();
+
+    const auto start = holding_ && !writing_ && queued_count() != 0;
+    holding_ = false;
+    writing_ = writing_ || start;
 
-    log::debug(LOG_NETWORK)
-        << "Sending " << command << " to [" << authority() << "] ("
-        << buffer.size() << " bytes)";
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    // Writes are initiated and completed within the strand.
+    if (start)
+        socket_->strand().dispatch(
+            std::bind(&proxy::write_batch,
+                shared_from_this()));
+}
+
+void proxy::write_batch()
+{
+    if (stopped())
+    {
+        const auto message = partial_;
+        partial_.reset();
+
+        if (message)
+        {
+            memory_->remove(memory_accounts::category::send,
+                message->size());
+            message->handler(error::channel_stopped);
+        }
+
+        clear_queue(error::channel_stopped);
+        return;
+    }
+
+    // A message is contiguous on the wire, so once started it is completed.
+    if (partial_)
+    {
+        write_chunk();
+        return;
+    }
 
-    ////// Critical Section (protect writer)
-    //////\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\
-    ////// The lock must be held until the handler is invoked.
-    ////const auto lock = std::make_shared<scope_lock>(mutex_);
+    size_t bytes = 0;
+    auto full = false;
+    auto paced = false;
+    const auto now = token_bucket::clock::now();
+    const auto batch = std::make_shared<message_queue>();
 
-    // Critical Section (protect socket)
+    // Critical Section
     ///////////////////////////////////////////////////////////////////////////
-    // The socket is locked until async_write returns.
-    const auto socket = socket_->get_socket();
+    mutex_.lock();
+
+    // The write is restarted by resume_writes.
+    if (holding_)
+    {
+        writing_ = false;
+        mutex_.unlock();
+        //---------------------------------------------------------------------
+        return;
+    }
+
+    // Queues are taken in priority order, each in order, and all but control
+    // only while both budgets are available.
+    for (auto& queue: queues_)
+    {
+        const auto control = &queue == &queues_.front();
+
+        while (!full && !paced && !queue.empty())
+        {
+            const auto size = queue.front().size();
+
+            if (!batch->empty() && bytes + size > write_limit_)
+            {
+                full = true;
+                break;
+            }
+
+            if (!control && (!upload_.available(now) ||
+                !uploads_->available(now)))
+            {
+                paced = true;
+                break;
+            }
+
+            // A message over the write limit is written in chunks, alone.
+            if (write_limit_ != 0 && size > write_limit_)
+            {
+                partial_ = std::make_shared<queued_message>(
+                    std::move(queue.front()));
+                partial_offset_ = 0;
+                queue.pop_front();
+                bytes += size;
+                full = true;
+                break;
+            }
+
+            if (!control)
+            {
+                // A large message overdraws the budgets, delaying the next.
+                upload_.consume(size, now);
+                uploads_->consume(size, now);
+            }
+
+            bytes += size;
+            batch->push_back(std::move(queue.front()));
+            queue.pop_front();
+        }
+    }
+
+    queued_bytes_ -= bytes;
+    metrics_.queued(queued_count(), queued_bytes_);
+    const auto chunk = partial_ != nullptr;
+    writing_ = !batch->empty() || chunk || paced;
+    pacing_ = batch->empty() && !chunk && paced;
+    const auto wait = pacing_;
+    const auto relieve = congested_ && queued_bytes_ <= backlog_limit_;
+    congested_ = congested_ && !relieve;
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    if (relieve)
+        pressure_subscriber_->relay(error::success, false);
 
-    // The shared buffer must be kept in scope until the handler is invoked.
+    if (chunk)
+    {
+        write_chunk();
+        return;
+    }
+
+    // The write resumes once the budgets are restored.
+    if (wait)
+    {
+        pace();
+        return;
+    }
+
+    if (batch->empty())
+        return;
+
+    std::vector<asio::const_buffer> buffers;
+    buffers.reserve(2 * batch->size());
+
+    for (const auto& message: *batch)
+    {
+        if (message.heading.size() != 0)
+            buffers.push_back(*message.heading.begin());
+
+        buffers.push_back(*message.buffer.begin());
+    }
+
+    LOG_DEBUG(LOG_NETWORK)
+        << "Sending " << batch->size() << " messages to [" << authority()
+        << "] (" << bytes << " bytes)";
+
+    // The batch holds the shared buffers in scope until the handler is invoked.
     using namespace boost::asio;
-    async_write(socket->get(), buffer,
-        std::bind(&proxy::handle_send,
-            shared_from_this(), _1, buffer, /*lock,*/ handler));
+    async_write(socket_->get(), buffers,
+        socket_->strand().wrap(make_slab_handler(
+            std::bind(&proxy::handle_send,
+                shared_from_this(), _1, batch))));
+}
 
-    return true;
+// Each chunk of a large message is paced, so that its rate is smoothed.
+void proxy::write_chunk()
+{
+    const auto remaining = partial_->size() - partial_offset_;
+    const auto size = std::min(remaining, write_limit_);
+    const auto control = to_priority(partial_->type) == priority::control;
+    const auto now = token_bucket::clock::now();
+
+    if (!control && (!upload_.available(now) || !uploads_->available(now)))
+    {
+        // Critical Section
+        ///////////////////////////////////////////////////////////////////////
+        mutex_.lock();
+
+        pacing_ = true;
+
+        mutex_.unlock();
+        ///////////////////////////////////////////////////////////////////////
+
+        pace();
+        return;
+    }
+
+    if (!control)
+    {
+        upload_.consume(size, now);
+        uploads_->consume(size, now);
+    }
+
+    LOG_DEBUG(LOG_NETWORK)
+        << "Sending " << partial_->command << " chunk to [" << authority()
+        << "] (" << size << " of " << remaining << " bytes)";
+
+    // The message holds the shared buffers in scope until the handler is
+    // invoked. The chunk may span the heading and payload of the message.
+    const auto& message = *partial_;
+    const auto head = slice(message.heading, partial_offset_, size);
+    const auto head_size = boost::asio::buffer_size(head);
+    const auto offset = partial_offset_ -
+        std::min(partial_offset_, message.heading.size());
+    const auto body = slice(message.buffer, offset, size - head_size);
+    const std::array<asio::const_buffer, 2> chunk{ { head, body } };
+
+    using namespace boost::asio;
+    async_write(socket_->get(), chunk,
+        socket_->strand().wrap(make_slab_handler(
+            std::bind(&proxy::handle_chunk,
+                shared_from_this(), _1, size, partial_))));
+}
+
+void proxy::pace()
+{
+    const auto delay = std::max(upload_.delay(), uploads_->delay());
+    const auto timer = std::allocate_shared<deadline>(
+        slab_allocator<deadline>(), socket_->pool(), delay);
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    mutex_.lock();
+
+    // A preempted wait may remain, its handler is then invoked with error.
+    const auto preempted = pace_timer_;
+    pace_timer_ = timer;
+
+    mutex_.unlock();
     ///////////////////////////////////////////////////////////////////////////
+
+    if (preempted)
+        preempted->stop();
+
+    timer->start(
+        socket_->strand().wrap(
+            std::bind(&proxy::handle_pace,
+                shared_from_this(), _1)));
 }
 
-void proxy::handle_send(const boost_code& ec, const_buffer buffer,
-    /*scope_lock::ptr lock,*/ result_handler handler)
+void proxy::handle_pace(const code& ec)
 {
-    ////lock = nullptr;
-    //////\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\
+    // A stopped wait abandons the queues, including any partial message.
+    if (stopped())
+    {
+        write_batch();
+        return;
+    }
+
+    if (ec)
+        return;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    mutex_.lock();
+
+    // A wait preempted by a control message is superseded by its write.
+    const auto resume = pacing_;
+    pacing_ = false;
 
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    if (resume)
+        write_batch();
+}
+
+void proxy::handle_send(const boost_code& ec, message_queue_ptr batch)
+{
     const auto error = code(error::boost_to_error_code(ec));
 
     if (error)
-        log::debug(LOG_NETWORK)
-            << "Failure sending " << buffer.size() << " byte message to ["
+        LOG_DEBUG(LOG_NETWORK)
+            << "Failure sending " << batch->size() << " messages to ["
             << authority() << "] " << error.message();
 
-    handler(error);
+    for (const auto& message: *batch)
+    {
+        if (!error)
+            metrics_.sent(message.type, message.size());
+
+        memory_->remove(memory_accounts::category::send,
+            message.size());
+        message.handler(error);
+    }
+
+    write_batch();
+}
+
+void proxy::handle_chunk(const boost_code& ec, size_t size,
+    queued_message_ptr message)
+{
+    const auto error = code(error::boost_to_error_code(ec));
+
+    // The message was abandoned by a stop.
+    if (message != partial_)
+        return;
+
+    if (error)
+    {
+        LOG_DEBUG(LOG_NETWORK)
+            << "Failure sending " << message->command << " to ["
+            << authority() << "] " << error.message();
+
+        partial_.reset();
+        memory_->remove(memory_accounts::category::send,
+            message->size());
+        message->handler(error);
+        write_batch();
+        return;
+    }
+
+    partial_offset_ += size;
+
+    if (partial_offset_ == message->size())
+    {
+        partial_.reset();
+        metrics_.sent(message->type, message->size());
+        memory_->remove(memory_accounts::category::send,
+            message->size());
+        message->handler(error::success);
+    }
+
+    write_batch();
+}
+
+// This is invoked from the strand, or from stop, which cannot safely abandon
+// a partial message, so that is abandoned by the next write in the strand.
+void proxy::clear_queue(const code& ec)
+{
+    message_queues cleared;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    mutex_.lock();
+
+    cleared.swap(queues_);
+    queued_bytes_ = 0;
+    metrics_.queued(0, 0);
+    writing_ = false;
+    pacing_ = false;
+    congested_ = false;
+    const auto timer = pace_timer_;
+    pace_timer_.reset();
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    if (timer)
+        timer->stop();
+
+    for (const auto& queue: cleared)
+    {
+        for (const auto& message: queue)
+        {
+            memory_->remove(memory_accounts::category::send,
+                message.size());
+            message.handler(ec);
+        }
+    }
+}
+
+// static
+// The part of the buffer within the range, empty if the range is beyond it.
+asio::const_buffer proxy::slice(const const_buffer& buffer, size_t offset,
+    size_t size)
+{
+    const auto start = std::min(offset, buffer.size());
+    const auto length = std::min(size, buffer.size() - start);
+    return boost::asio::buffer(*buffer.begin() + start, length);
+}
+
+size_t proxy::queued_message::size() const
+{
+    return heading.size() + buffer.size();
+}
+
+// The queued message count is the sum over priorities.
+size_t proxy::queued_count() const
+{
+    size_t count = 0;
+
+    for (const auto& queue: queues_)
+        count += queue.size();
+
+    return count;
 }
 
 // Stop sequence.
@@ -348,9 +1411,9 @@ void proxy::stop(const code& ec)
     message_subscriber_.stop();
     message_subscriber_.broadcast(error::channel_stopped);
 
-    ////// Prevent subscription after stop.
-    ////send_subscriber_->stop();
-    ////send_subscriber_->relay(ec, {}, {}, nop);
+    // Prevent subscription after stop.
+    pressure_subscriber_->stop();
+    pressure_subscriber_->relay(ec, false);
 
     // Prevent subscription after stop.
     stop_subscriber_->stop();
@@ -359,8 +1422,16 @@ void proxy::stop(const code& ec)
     // Give channel opportunity to terminate timers.
     handle_stopping();
 
-    // The socket_ is internally guarded against concurrent use.
+    // The socket is closed within its strand.
     socket_->close();
+
+    // Queued messages that have not been written are abandoned.
+    clear_queue(error::channel_stopped);
+
+    // Ordered deliveries hold the proxy, so are abandoned within the strand.
+    socket_->strand().post(
+        std::bind(&proxy::clear_ready,
+            shared_from_this()));
 }
 
 void proxy::stop(const boost_code& ec)
@@ -0,0 +1,88 @@
+/**
+ * Copyright (c) 2011-2016 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/network/reconnect_backoff.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <bitcoin/bitcoin.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+reconnect_backoff::reconnect_backoff(const asio::duration& initial,
+    const asio::duration& maximum)
+  : initial_(initial),
+    maximum_(std::max(initial, maximum)),
+    failures_(0)
+{
+}
+
+// static
+// Doubling stops at the maximum, so a large failure count cannot overflow.
+asio::duration reconnect_backoff::delay(const asio::duration& initial,
+    const asio::duration& maximum, size_t failures)
+{
+    auto result = initial;
+
+    for (size_t count = 0; count < failures && result < maximum; ++count)
+        result = result * 2;
+
+    return std::min(result, maximum);
+}
+
+asio::duration reconnect_backoff::next()
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    mutex_.lock();
+
+    const auto failures = failures_++;
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    const auto base = delay(initial_, maximum_, failures);
+
+    // Jitter spreads the retries of loops that failed together.
+    return base.is_zero() ? base : pseudo_randomize(base);
+}
+
+void reconnect_backoff::reset()
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    failures_ = 0;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+size_t reconnect_backoff::failures() const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    shared_lock lock(mutex_);
+
+    return failures_;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+} // namespace network
+} // namespace libbitcoin
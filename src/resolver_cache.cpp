@@ -0,0 +1,110 @@
+/**
+ * Copyright (c) 2011-2016 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/network/resolver_cache.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <bitcoin/bitcoin.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+resolver_cache::resolver_cache(uint32_t lifetime_seconds)
+  : lifetime_(std::chrono::seconds(lifetime_seconds))
+{
+}
+
+// static
+bool resolver_cache::is_numeric(const std::string& hostname)
+{
+    // An IPv6 host may be bracketed.
+    const auto bracketed = hostname.size() > 2 && hostname.front() == '[' &&
+        hostname.back() == ']';
+    const auto host = bracketed ? hostname.substr(1, hostname.size() - 2) :
+        hostname;
+
+    boost_code ec;
+    asio::address::from_string(host, ec);
+    return !ec;
+}
+
+// static
+std::string resolver_cache::to_key(const std::string& hostname, uint16_t port)
+{
+    return hostname + ":" + std::to_string(port);
+}
+
+bool resolver_cache::find(asio::iterator& out, const std::string& hostname,
+    uint16_t port) const
+{
+    if (lifetime_ == clock::duration::zero())
+        return false;
+
+    const auto key = to_key(hostname, port);
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    shared_lock lock(mutex_);
+
+    const auto it = entries_.find(key);
+
+    if (it == entries_.end() || it->second.expiration <= clock::now())
+        return false;
+
+    // The iterator is a shared reference to the immutable results.
+    out = it->second.results;
+    return true;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void resolver_cache::store(const std::string& hostname, uint16_t port,
+    asio::iterator results)
+{
+    if (lifetime_ == clock::duration::zero() || is_numeric(hostname) ||
+        results == asio::iterator())
+        return;
+
+    const auto key = to_key(hostname, port);
+    const auto now = clock::now();
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    safe_purge(now);
+    entries_[key] = { results, now + lifetime_ };
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// Names are few (seeds and manual peers), so a full scan is inexpensive.
+void resolver_cache::safe_purge(clock::time_point now)
+{
+    for (auto it = entries_.begin(); it != entries_.end();)
+    {
+        if (it->second.expiration <= now)
+            it = entries_.erase(it);
+        else
+            ++it;
+    }
+}
+
+} // namespace network
+} // namespace libbitcoin
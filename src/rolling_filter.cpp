@@ -0,0 +1,157 @@
+/**
+ * Copyright (c) 2011-2016 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/network/rolling_filter.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <bitcoin/bitcoin.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+// A block is one 64 byte cache line of 512 bits, as 8 words.
+static constexpr size_t block_words = 8;
+static constexpr size_t block_bytes = block_words * sizeof(uint64_t);
+
+// Sixteen bits per hash with eight probes is about 1/1000 false positives.
+static constexpr size_t bits_per_hash = 16;
+static constexpr size_t probes = 8;
+
+// The splitmix64 finalizer, a cheap and well-distributed keyed mix.
+static uint64_t mix(uint64_t value)
+{
+    value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ull;
+    value = (value ^ (value >> 27)) * 0x94d049bb133111ebull;
+    return value ^ (value >> 31);
+}
+
+static size_t to_blocks(size_t capacity)
+{
+    const auto generation = std::max(capacity / 2, size_t(1));
+    const auto bits = generation * bits_per_hash;
+    return (bits + block_words * 64 - 1) / (block_words * 64);
+}
+
+rolling_filter::rolling_filter(size_t capacity)
+  : salt_(pseudo_random()),
+    blocks_(to_blocks(capacity)),
+    generation_size_(std::max(capacity / 2, size_t(1))),
+    count_(0),
+    storage_(2 * blocks_ * block_words + block_words - 1, 0)
+{
+    // Align the generations to the cache line.
+    const auto address = reinterpret_cast<uintptr_t>(storage_.data());
+    const auto padding = (block_bytes - address % block_bytes) % block_bytes;
+    current_ = storage_.data() + padding / sizeof(word);
+    previous_ = current_ + blocks_ * block_words;
+}
+
+rolling_filter::position rolling_filter::to_position(
+    const hash_digest& hash) const
+{
+    uint64_t words[4];
+    std::memcpy(words, hash.data(), sizeof(words));
+
+    // Every word contributes, so hashes need not be uniform.
+    auto digest = salt_;
+    for (const auto value: words)
+        digest = mix(digest ^ value);
+
+    position out;
+    out.block = static_cast<size_t>(digest % blocks_);
+    std::fill(std::begin(out.bits), std::end(out.bits), 0);
+
+    // Double hashing selects the probed bits within the block.
+    const auto first = mix(digest + 1);
+    const auto second = mix(digest + 2) | 1;
+
+    for (size_t probe = 0; probe < probes; ++probe)
+    {
+        const auto bit = (first + probe * second) % (block_words * 64);
+        out.bits[bit / 64] |= word(1) << (bit % 64);
+    }
+
+    return out;
+}
+
+bool rolling_filter::contains(const word* generation,
+    const position& at) const
+{
+    const auto block = generation + at.block * block_words;
+
+    for (size_t index = 0; index < block_words; ++index)
+        if ((block[index] & at.bits[index]) != at.bits[index])
+            return false;
+
+    return true;
+}
+
+void rolling_filter::insert(word* generation, const position& at)
+{
+    const auto block = generation + at.block * block_words;
+
+    for (size_t index = 0; index < block_words; ++index)
+        block[index] |= at.bits[index];
+}
+
+bool rolling_filter::insert(const hash_digest& hash)
+{
+    const auto at = to_position(hash);
+
+    if (contains(current_, at))
+        return false;
+
+    // Refresh a hash of the previous generation, so it is retained.
+    const auto present = contains(previous_, at);
+
+    if (count_ == generation_size_)
+    {
+        std::swap(current_, previous_);
+        std::fill(current_, current_ + blocks_ * block_words, 0);
+        count_ = 0;
+    }
+
+    insert(current_, at);
+    ++count_;
+    return !present;
+}
+
+bool rolling_filter::contains(const hash_digest& hash) const
+{
+    const auto at = to_position(hash);
+    return contains(current_, at) || contains(previous_, at);
+}
+
+void rolling_filter::clear()
+{
+    std::fill(storage_.begin(), storage_.end(), 0);
+    count_ = 0;
+}
+
+size_t rolling_filter::footprint() const
+{
+    return storage_.size() * sizeof(word);
+}
+
+} // namespace network
+} // namespace libbitcoin
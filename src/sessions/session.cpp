@@ -28,6 +28,7 @@
 #include <bitcoin/network/acceptor.hpp>
 #include <bitcoin/network/channel.hpp>
 #include <bitcoin/network/connector.hpp>
+#include <bitcoin/network/logging.hpp>
 #include <bitcoin/network/p2p.hpp>
 #include <bitcoin/network/proxy.hpp>
 #include <bitcoin/network/protocols/protocol_address.hpp>
@@ -62,7 +63,7 @@ session::session(p2p& network, bool outgoing, bool persistent)
     network_(network),
     settings_(network.network_settings()),
     pool_(network.thread_pool()),
-    dispatch_(pool_, NAME)
+    dispatch_(pool_, NAME, network.dispatch_metrics())
 {
 }
 
@@ -86,12 +87,49 @@ void session::fetch_address(host_handler handler)
     network_.fetch_address(handler);
 }
 
+// protected:
+void session::store_addresses(const authority::list& hosts,
+    result_handler handler)
+{
+    message::network_address::list addresses;
+    addresses.reserve(hosts.size());
+
+    for (const auto& host: hosts)
+        addresses.push_back(host.to_network_address());
+
+    network_.store(addresses, handler);
+}
+
+// protected:
+void session::attempt_address(const authority& host)
+{
+    network_.attempt(host.to_network_address(), BIND_1(handle_scored, _1));
+}
+
+// protected:
+void session::score_address(const authority& host, const code& result)
+{
+    network_.score(host.to_network_address(), result,
+        BIND_1(handle_scored, _1));
+}
+
 // protected:
 void session::connection_count(count_handler handler)
 {
     network_.connected_count(handler);
 }
 
+void session::pending_count(count_handler handler) const
+{
+    pending_.count(handler);
+}
+
+// protected:
+session::authority::list session::take_anchors()
+{
+    return network_.take_anchors();
+}
+
 // protected:
 bool session::blacklisted(const authority& authority) const
 {
@@ -107,7 +145,11 @@ bool session::blacklisted(const authority& authority) const
 // protected:
 acceptor::ptr session::create_acceptor()
 {
-    const auto accept = std::make_shared<acceptor>(pool_, settings_);
+    const auto accept = std::make_shared<acceptor>(pool_, settings_,
+        network_.payload_buffers(), network_.channel_pools(),
+        network_.inbound_admission(), network_.channel_timers(),
+        network_.upload_budget(), network_.memory_budget(),
+        network_.dispatch_metrics());
     subscribe_stop(BIND_2(do_stop_acceptor, _1, accept));
     return accept;
 }
@@ -120,7 +162,11 @@ void session::do_stop_acceptor(const code&, acceptor::ptr accept)
 // protected:
 connector::ptr session::create_connector()
 {
-    const auto connect = std::make_shared<connector>(pool_, settings_);
+    const auto connect = std::make_shared<connector>(pool_, settings_,
+        network_.payload_buffers(), network_.channel_pools(),
+        network_.resolved_names(), network_.channel_timers(),
+        network_.upload_budget(), network_.memory_budget(),
+        network_.dispatch_metrics());
     subscribe_stop(BIND_2(do_stop_connector, _1, connect));
     return connect;
 }
@@ -161,6 +207,13 @@ bool session::stopped() const
     return stopped_;
 }
 
+// protected:
+// Outbound and batch sessions use the default.
+lifecycle_metrics::origin session::origin() const
+{
+    return lifecycle_metrics::origin::outbound;
+}
+
 // Subscribe Stop sequence.
 // ----------------------------------------------------------------------------
 
@@ -189,6 +242,11 @@ void session::register_channel(channel::ptr channel,
         return;
     }
 
+    // The nonce detects connections to self until the handshake completes.
+    channel->set_inbound(incoming_);
+    channel->set_nonce(nonzero_pseudo_random());
+    channel->set_capture(network_.captured_traffic());
+
     if (incoming_)
     {
         handle_pend(error::success, channel, start_handler);
@@ -196,7 +254,6 @@ void session::register_channel(channel::ptr channel,
     }
 
     channel->set_notify(notify_);
-    channel->set_nonce(nonzero_pseudo_random());
 
     result_handler unpend_handler =
         BIND_3(do_unpend, _1, channel, start_handler);
@@ -222,6 +279,8 @@ void session::handle_pend(const code& ec, channel::ptr channel,
 void session::handle_channel_start(const code& ec, channel::ptr channel,
     result_handler handle_started)
 {
+    channel->timeline().handshaking = lifecycle_metrics::clock::now();
+
     attach<protocol_version>(channel)->start(
         BIND_3(handle_handshake, _1, channel, handle_started));
 }
@@ -231,13 +290,15 @@ void session::handle_handshake(const code& ec, channel::ptr channel,
 {
     if (ec)
     {
-        log::debug(LOG_NETWORK)
+        LOG_DEBUG(LOG_NETWORK)
             << "Failure in handshake with [" << channel->authority()
             << "] " << ec.message();
         handle_started(ec);
         return;
     }
 
+    channel->timeline().handshaken = lifecycle_metrics::clock::now();
+
     truth_handler handler = 
         BIND_3(handle_is_pending, _1, channel, handle_started);
 
@@ -253,7 +314,7 @@ void session::handle_is_pending(bool pending, channel::ptr channel,
 {
     if (pending)
     {
-        log::debug(LOG_NETWORK)
+        LOG_DEBUG(LOG_NETWORK)
             << "Rejected connection from [" << channel->authority()
             << "] as loopback.";
         handle_started(error::accept_failed);
@@ -263,7 +324,7 @@ void session::handle_is_pending(bool pending, channel::ptr channel,
     const auto version = channel->version();
     if (version.value < bc::peer_minimum_version)
     {
-        log::debug(LOG_NETWORK)
+        LOG_DEBUG(LOG_NETWORK)
             << "Peer version (" << version.value << ") below minimum ("
             << bc::peer_minimum_version << ") [" 
             << channel->authority() << "]";
@@ -283,8 +344,19 @@ void session::handle_start(const code& ec, channel::ptr channel,
     else
         channel->subscribe_stop(handle_stopped);
 
+    // Only channels that complete startup are timed.
+    if (!ec)
+    {
+        channel->timeline().started = lifecycle_metrics::clock::now();
+        network_.lifecycle_timing()->record(origin(), channel->timeline());
+    }
+
     // This is the end of the registration sequence.
     handle_started(ec);
+
+    // Writes held by a pipelined handshake include those of the protocols
+    // attached by the handler.
+    channel->resume_writes();
 }
 
 void session::do_unpend(const code& ec, channel::ptr channel,
@@ -305,16 +377,24 @@ void session::do_remove(const code& ec, channel::ptr channel,
 void session::handle_unpend(const code& ec)
 {
     if (ec)
-        log::debug(LOG_NETWORK)
+        LOG_DEBUG(LOG_NETWORK)
             << "Failed to unpend a channel: " << ec.message();
 }
 
 void session::handle_remove(const code& ec)
 {
     if (ec)
-        log::debug(LOG_NETWORK)
+        LOG_DEBUG(LOG_NETWORK)
             << "Failed to remove a channel: " << ec.message();
 }
 
+// Addresses that are not in the pool, such as seeds, are not scored.
+void session::handle_scored(const code& ec)
+{
+    if (ec && ec != error::not_found)
+        LOG_DEBUG(LOG_NETWORK)
+            << "Failed to score an address: " << ec.message();
+}
+
 } // namespace network
 } // namespace libbitcoin
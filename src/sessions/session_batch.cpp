@@ -19,11 +19,14 @@
  */
 #include <bitcoin/network/sessions/session_batch.hpp>
 
+#include <algorithm>
 #include <atomic>
 #include <cstdint>
 #include <memory>
+#include <vector>
 #include <bitcoin/bitcoin.hpp>
 #include <bitcoin/network/connector.hpp>
+#include <bitcoin/network/logging.hpp>
 #include <bitcoin/network/p2p.hpp>
 
 namespace libbitcoin {
@@ -38,28 +41,70 @@ using std::placeholders::_2;
 
 session_batch::session_batch(p2p& network, bool persistent)
   : session(network, true, persistent),
-    batch_size_(std::max(settings_.connect_batch_size, 1u))
+    batch_size_(std::max(settings_.connect_batch_size, 1u)),
+    reservations_(settings_.connect_attempt_limit)
+{
+}
+
+// Start sequence.
+// ----------------------------------------------------------------------------
+
+void session_batch::start(result_handler handler)
+{
+    session::start(BIND2(handle_started, _1, handler));
+}
+
+// Subscribed after the base, so the session is stopped before the timers.
+void session_batch::handle_started(const code& ec, result_handler handler)
+{
+    if (!ec)
+        subscribe_stop(BIND1(do_stop_retries, _1));
+
+    handler(ec);
+}
+
+void session_batch::do_stop_retries(const code&)
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(retry_mutex_);
+
+    // This will asynchronously invoke the handler of each retry.
+    for (auto timer: retries_)
+        timer->stop();
+
+    retries_.clear();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+session_batch::batch::batch(threadpool& pool, const asio::duration& stagger)
+  : started(0),
+    completed(0),
+    pending(std::make_shared<pending_sockets>()),
+    timer(std::make_shared<deadline>(pool, stagger))
 {
 }
 
 void session_batch::converge(const code& ec, channel::ptr channel,
-     atomic_counter_ptr counter, upgrade_mutex_ptr mutex,
-     channel_handler handler)
+     batch_ptr batch, channel_handler handler)
 {
     ///////////////////////////////////////////////////////////////////////////
     // Critical Section
-    mutex->lock_upgrade();
+    batch->mutex.lock_upgrade();
 
-    const auto initial_count = counter->load();
+    const auto initial_count = batch->completed.load();
     BITCOIN_ASSERT(initial_count <= batch_size_);
 
     // Already completed, don't call handler.
     if (initial_count == batch_size_)
     {
-        mutex->unlock_upgrade();
+        batch->mutex.unlock_upgrade();
         //-----------------------------------------------------------------
         if (!ec)
+        {
+            release_address(channel->authority());
             channel->stop(error::channel_stopped);
+        }
 
         return;
     }
@@ -68,19 +113,106 @@ void session_batch::converge(const code& ec, channel::ptr channel,
     const auto cleared = count == batch_size_;
 
     //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
-    mutex->unlock_upgrade_and_lock();
-    counter->store(count);
-    mutex->unlock();
+    batch->mutex.unlock_upgrade_and_lock();
+    batch->completed.store(count);
+    batch->mutex.unlock();
     ///////////////////////////////////////////////////////////////////////
 
     if (cleared)
     {
+        // Cancel the stagger and close the sockets of all losing attempts.
+        batch->timer->stop();
+        batch->pending->clear();
+
         // If the last connection attempt is an error, normalize the code.
         const auto result = ec ? error::operation_failed : error::success;
         handler(result, channel);
     }
 }
 
+// Reconnect sequence.
+// ----------------------------------------------------------------------------
+// Failed connection loops wait out an exponential delay before retrying, so
+// that an unreachable network or an exhausted address pool is not spun on.
+
+reconnect_backoff::ptr session_batch::create_backoff() const
+{
+    return std::make_shared<reconnect_backoff>(settings_.connect_backoff(),
+        settings_.connect_backoff_maximum());
+}
+
+// The handler observes the stop of the session, and reports it if required.
+void session_batch::retry(reconnect_backoff::ptr backoff,
+    retry_handler handler)
+{
+    if (stopped())
+    {
+        handler();
+        return;
+    }
+
+    const auto delay = backoff->next();
+
+    if (delay.is_zero())
+    {
+        handler();
+        return;
+    }
+
+    LOG_DEBUG(LOG_NETWORK)
+        << "Retrying connection in " << delay.total_milliseconds()
+        << " ms, after " << backoff->failures() << " failures.";
+
+    const auto timer = std::make_shared<deadline>(pool_, delay);
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    retry_mutex_.lock();
+
+    // The stop of the timers follows the stop of the session.
+    if (stopped())
+    {
+        retry_mutex_.unlock();
+        //---------------------------------------------------------------------
+        handler();
+        return;
+    }
+
+    retries_.push_back(timer);
+    timer->start(BIND3(handle_retry, _1, timer, handler));
+
+    retry_mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// A stopped timer is cancelled, and the handler reports the stopped session.
+void session_batch::handle_retry(const code&, deadline::ptr timer,
+    retry_handler handler)
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    retry_mutex_.lock_upgrade();
+
+    auto it = std::find(retries_.begin(), retries_.end(), timer);
+
+    // The stop clears the timers, so the entry may not be found.
+    if (it != retries_.end())
+    {
+        //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+        retry_mutex_.unlock_upgrade_and_lock();
+        retries_.erase(it);
+        retry_mutex_.unlock();
+        //---------------------------------------------------------------------
+    }
+    else
+    {
+        retry_mutex_.unlock_upgrade();
+    }
+    ///////////////////////////////////////////////////////////////////////////
+
+    handler();
+}
+
 // Connect sequence.
 // ----------------------------------------------------------------------------
 
@@ -88,41 +220,76 @@ void session_batch::converge(const code& ec, channel::ptr channel,
 void session_batch::connect(connector::ptr connect, channel_handler handler)
 {
     // synchronizer state.
-    const auto mutex = std::make_shared<upgrade_mutex>();
-    const auto counter = std::make_shared<atomic_counter>(0);
-    const auto singular = BIND5(converge, _1, _2, counter, mutex, handler);
+    const auto stagger = settings_.connect_stagger();
+    const auto state = std::make_shared<batch>(pool_, stagger);
+    const channel_handler singular = BIND4(converge, _1, _2, state, handler);
 
-    for (uint32_t host = 0; host < batch_size_; ++host)
-        new_connect(connect, counter, singular);
+    // The first attempt starts now, and each stagger period starts another.
+    new_connect(connect, state, singular);
+
+    if (batch_size_ > 1)
+        state->timer->start(
+            BIND4(handle_stagger, _1, connect, state, singular));
 }
 
-void session_batch::new_connect(connector::ptr connect,
-    atomic_counter_ptr counter, channel_handler handler)
+void session_batch::handle_stagger(const code& ec, connector::ptr connect,
+    batch_ptr batch, channel_handler handler)
+{
+    // The timer is stopped when the batch completes.
+    if (ec || batch->completed.load() == batch_size_)
+        return;
+
+    new_connect(connect, batch, handler);
+
+    if (batch->started.load() < batch_size_)
+        batch->timer->start(
+            BIND4(handle_stagger, _1, connect, batch, handler));
+}
+
+void session_batch::new_connect(connector::ptr connect, batch_ptr batch,
+    channel_handler handler)
 {
     if (stopped())
     {
-        log::debug(LOG_NETWORK)
+        LOG_DEBUG(LOG_NETWORK)
             << "Suspended batch connection.";
         return;
     }
 
-    if (counter->load() == batch_size_)
+    if (batch->completed.load() == batch_size_)
         return;
 
-    fetch_address(BIND5(start_connect, _1, _2, connect, counter, handler));
+    // Failures and the stagger timer race to start the remaining attempts.
+    if (++batch->started > batch_size_)
+        return;
+
+    // At the limit of attempts in flight the stagger retries the attempt.
+    if (!reservations_.begin_attempt())
+    {
+        --batch->started;
+        batch->timer->start(
+            BIND4(handle_stagger, _1, connect, batch, handler));
+        return;
+    }
+
+    fetch_address(BIND5(start_connect, _1, _2, connect, batch, handler));
 }
 
 void session_batch::start_connect(const code& ec, const authority& host,
-    connector::ptr connect, atomic_counter_ptr counter, channel_handler handler)
+    connector::ptr connect, batch_ptr batch, channel_handler handler)
 {
-    if (counter->load() == batch_size_)
+    if (batch->completed.load() == batch_size_)
+    {
+        reservations_.end_attempt();
         return;
+    }
 
     // This termination prevents a tight loop in the empty address pool case.
     if (ec)
     {
-        log::error(LOG_NETWORK)
+        LOG_ERROR(LOG_NETWORK)
             << "Failure fetching new address: " << ec.message();
+        reservations_.end_attempt();
         handler(ec, nullptr);
         return;
     }
@@ -130,42 +297,107 @@ void session_batch::start_connect(const code& ec, const authority& host,
     // This creates a tight loop in the case of a small address pool.
     if (blacklisted(host))
     {
-        log::debug(LOG_NETWORK)
+        LOG_DEBUG(LOG_NETWORK)
             << "Fetched blacklisted address [" << host << "] ";
+        reservations_.end_attempt();
         handler(error::address_blocked, nullptr);
         return;
     }
 
-    log::debug(LOG_NETWORK)
+    // Another slot is attempting or connected to the host or its group.
+    if (!reservations_.reserve(host))
+    {
+        LOG_DEBUG(LOG_NETWORK)
+            << "Fetched reserved address group [" << host << "] ";
+        reservations_.end_attempt();
+        handler(error::address_blocked, nullptr);
+        return;
+    }
+
+    LOG_DEBUG(LOG_NETWORK)
         << "Connecting to [" << host << "]";
 
+    // The pool measures connect latency from the attempt.
+    attempt_address(host);
+
     // CONNECT
     connect->connect(host, BIND6(handle_connect, _1, _2, host, connect,
-        counter, handler));
+        batch, handler), batch->pending);
 }
 
 void session_batch::handle_connect(const code& ec, channel::ptr channel,
-    const authority& host, connector::ptr connect, atomic_counter_ptr counter,
+    const authority& host, connector::ptr connect, batch_ptr batch,
     channel_handler handler)
 {
-    if (counter->load() == batch_size_)
+    reservations_.end_attempt();
+
+    // A losing attempt is released, and a late connection is stopped.
+    if (batch->completed.load() == batch_size_)
+    {
+        reservations_.release(host);
+
+        if (!ec)
+            channel->stop(error::channel_stopped);
+
         return;
+    }
+
+    // Timeouts and refusals count against the host, shutdown does not.
+    if (ec != error::service_stopped)
+        score_address(host, ec);
 
     if (ec)
     {
-        log::debug(LOG_NETWORK)
+        LOG_DEBUG(LOG_NETWORK)
             << "Failure connecting to [" << host << "] "
             << ec.message();
+
+        reservations_.release(host);
+
+        // Don't wait out the stagger when an attempt fails.
+        new_connect(connect, batch, handler);
         handler(ec, nullptr);
         return;
     }
 
-    log::debug(LOG_NETWORK)
+    LOG_DEBUG(LOG_NETWORK)
         << "Connected to [" << channel->authority() << "]";
 
     // This is the end of the connect sequence.
     handler(error::success, channel);
 }
 
+// Direct connect sequence.
+// ----------------------------------------------------------------------------
+
+void session_batch::connect_direct(connector::ptr connect,
+    const authority& host, channel_handler handler)
+{
+    if (!reservations_.reserve(host))
+    {
+        handler(error::address_blocked, nullptr);
+        return;
+    }
+
+    LOG_DEBUG(LOG_NETWORK)
+        << "Connecting directly to [" << host << "]";
+
+    connect->connect(host, BIND4(handle_direct, _1, _2, host, handler));
+}
+
+void session_batch::handle_direct(const code& ec, channel::ptr channel,
+    const authority& host, channel_handler handler)
+{
+    if (ec)
+        reservations_.release(host);
+
+    handler(ec, channel);
+}
+
+void session_batch::release_address(const authority& host)
+{
+    reservations_.release(host);
+}
+
 } // namespace network
 } // namespace libbitcoin
@@ -19,12 +19,16 @@
  */
 #include <bitcoin/network/sessions/session_inbound.hpp>
 
+#include <algorithm>
 #include <cstddef>
 #include <functional>
 #include <bitcoin/bitcoin.hpp>
 #include <bitcoin/network/connector.hpp>
+#include <bitcoin/network/logging.hpp>
 #include <bitcoin/network/p2p.hpp>
 #include <bitcoin/network/protocols/protocol_address.hpp>
+#include <bitcoin/network/protocols/protocol_block_sync.hpp>
+#include <bitcoin/network/protocols/protocol_compact_block.hpp>
 #include <bitcoin/network/protocols/protocol_ping.hpp>
 
 namespace libbitcoin {
@@ -41,14 +45,22 @@ session_inbound::session_inbound(p2p& network)
 {
 }
 
+// protected:
+lifecycle_metrics::origin session_inbound::origin() const
+{
+    return lifecycle_metrics::origin::inbound;
+}
+
 // Start sequence.
 // ----------------------------------------------------------------------------
 
 void session_inbound::start(result_handler handler)
 {
-    if (settings_.inbound_port == 0 || settings_.inbound_connections == 0)
+    const auto bound = settings_.inbound_port != 0 || !settings_.binds.empty();
+
+    if (!bound || settings_.inbound_connections == 0)
     {
-        log::info(LOG_NETWORK)
+        LOG_INFO(LOG_NETWORK)
             << "Not configured for accepting incoming connections.";
         handler(error::success);
         return;
@@ -65,31 +77,74 @@ void session_inbound::handle_started(const code& ec, result_handler handler)
         return;
     }
 
-    const auto accept = create_acceptor();
-    const auto port = settings_.inbound_port;
+    // Without configured bindings all interfaces are bound.
+    const auto binds = settings_.binds.empty() ?
+        authority::list{ { asio::ipv6(), settings_.inbound_port } } :
+        settings_.binds;
 
-    // START LISTENING ON PORT
-    accept->listen(port, BIND2(start_accept, _1, accept));
+    // Several listeners share each binding, balanced by the kernel.
+    const auto acceptors = std::max(settings_.inbound_acceptors, 1u);
+    const auto reuse_port = acceptors > 1;
+
+    for (const auto& binding: binds)
+    {
+        // A binding without a port uses the configured inbound port.
+        const auto port = binding.port() == 0 ? settings_.inbound_port :
+            binding.port();
+
+        for (size_t listener = 0; listener < acceptors; ++listener)
+            start_listen({ binding.ip(), port }, reuse_port);
+    }
 
     // This is the end of the start sequence.
     handler(error::success);
 }
 
+void session_inbound::start_listen(const authority& binding, bool reuse_port)
+{
+    const auto accept = create_acceptor();
+
+    // START LISTENING ON PORT
+    accept->listen(binding, reuse_port,
+        BIND3(start_accepts, _1, binding, accept));
+}
+
 // Accept sequence.
 // ----------------------------------------------------------------------------
 
+void session_inbound::start_accepts(const code& ec,
+    const authority& binding, acceptor::ptr accept)
+{
+    if (ec)
+    {
+        LOG_ERROR(LOG_NETWORK)
+            << "Error starting listener [" << binding << "] " << ec.message();
+        return;
+    }
+
+    LOG_DEBUG(LOG_NETWORK)
+        << "Listening for incoming connections on [" << binding << "]";
+
+    // Several accepts are outstanding, each restarted upon its completion, so
+    // that a connection flood is not serialized on a single accept.
+    const auto accepts = std::max(settings_.inbound_accepts, 1u);
+
+    for (size_t accepted = 0; accepted < accepts; ++accepted)
+        start_accept(error::success, accept);
+}
+
 void session_inbound::start_accept(const code& ec, acceptor::ptr accept)
 {
     if (stopped())
     {
-        log::debug(LOG_NETWORK)
+        LOG_DEBUG(LOG_NETWORK)
             << "Suspended inbound connection.";
         return;
     }
 
     if (ec)
     {
-        log::error(LOG_NETWORK)
+        LOG_ERROR(LOG_NETWORK)
             << "Error starting listener: " << ec.message();
         return;
     }
@@ -103,7 +158,7 @@ void session_inbound::handle_accept(const code& ec, channel::ptr channel,
 {
     if (stopped())
     {
-        log::debug(LOG_NETWORK)
+        LOG_DEBUG(LOG_NETWORK)
             << "Suspended inbound connection.";
         return;
     }
@@ -112,37 +167,13 @@ void session_inbound::handle_accept(const code& ec, channel::ptr channel,
 
     if (ec)
     {
-        log::debug(LOG_NETWORK)
+        LOG_DEBUG(LOG_NETWORK)
             << "Failure accepting connection: " << ec.message();
         return;
     }
 
-    if (blacklisted(channel->authority()))
-    {
-        log::debug(LOG_NETWORK)
-            << "Rejected inbound connection from ["
-            << channel->authority() << "] due to blacklisted address.";
-        return;
-    }
-
-    connection_count(BIND2(handle_connection_count, _1, channel));
-}
-
-void session_inbound::handle_connection_count(size_t connections,
-    channel::ptr channel)
-{
-    const auto connection_limit = settings_.inbound_connections + 
-        settings_.outbound_connections;
-
-    if (connections >= connection_limit)
-    {
-        log::debug(LOG_NETWORK)
-            << "Rejected inbound connection from ["
-            << channel->authority() << "] due to connection limit.";
-        return;
-    }
-   
-    log::info(LOG_NETWORK)
+    // The acceptor has applied the blacklist and connection limit.
+    LOG_INFO(LOG_NETWORK)
         << "Connected inbound channel [" << channel->authority() << "]";
 
     register_channel(channel, 
@@ -156,7 +187,7 @@ void session_inbound::handle_channel_start(const code& ec,
     
     if (ec)
     {
-        log::info(LOG_NETWORK)
+        LOG_INFO(LOG_NETWORK)
             << "Inbound channel failed to start [" << channel->authority()
             << "] " << ec.message();
         return;
@@ -164,11 +195,13 @@ void session_inbound::handle_channel_start(const code& ec,
 
     attach<protocol_ping>(channel)->start();
     attach<protocol_address>(channel)->start();
+    attach<protocol_compact_block>(channel)->start();
+    attach<protocol_block_sync>(channel)->start();
 }
 
 void session_inbound::handle_channel_stop(const code& ec)
 {
-    log::debug(LOG_NETWORK)
+    LOG_DEBUG(LOG_NETWORK)
         << "Inbound channel stopped: " << ec.message();
 }
 
@@ -24,8 +24,11 @@
 #include <functional>
 #include <string>
 #include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/logging.hpp>
 #include <bitcoin/network/p2p.hpp>
 #include <bitcoin/network/protocols/protocol_address.hpp>
+#include <bitcoin/network/protocols/protocol_block_sync.hpp>
+#include <bitcoin/network/protocols/protocol_compact_block.hpp>
 #include <bitcoin/network/protocols/protocol_ping.hpp>
 
 namespace libbitcoin {
@@ -42,13 +45,19 @@ session_manual::session_manual(p2p& network)
 {
 }
 
+// protected:
+lifecycle_metrics::origin session_manual::origin() const
+{
+    return lifecycle_metrics::origin::manual;
+}
+
 // Start sequence.
 // ----------------------------------------------------------------------------
 // Manual connections are always enabled.
 
 void session_manual::start(result_handler handler)
 {
-    session::start(CONCURRENT2(handle_started, _1, handler));
+    session_batch::start(CONCURRENT2(handle_started, _1, handler));
 }
 
 void session_manual::handle_started(const code& ec, result_handler handler)
@@ -77,16 +86,17 @@ void session_manual::connect(const std::string& hostname, uint16_t port)
 void session_manual::connect(const std::string& hostname, uint16_t port,
     channel_handler handler)
 {
-    start_connect(hostname, port, handler, settings_.manual_attempt_limit);
+    start_connect(hostname, port, handler, settings_.manual_attempt_limit,
+        create_backoff());
 }
 
 // The first connect is a sequence, which then spawns a cycle.
 void session_manual::start_connect(const std::string& hostname, uint16_t port,
-    channel_handler handler, uint32_t retries)
+    channel_handler handler, uint32_t retries, reconnect_backoff::ptr backoff)
 {
     if (stopped())
     {
-        log::debug(LOG_NETWORK)
+        LOG_DEBUG(LOG_NETWORK)
             << "Suspended manual connection.";
 
         connector_.store(nullptr);
@@ -99,47 +109,51 @@ void session_manual::start_connect(const std::string& hostname, uint16_t port,
 
     // MANUAL CONNECT OUTBOUND
     connector->connect(hostname, port,
-        BIND6(handle_connect, _1, _2, hostname, port, handler, retries));
+        BIND7(handle_connect, _1, _2, hostname, port, handler, retries,
+            backoff));
 }
 
 void session_manual::handle_connect(const code& ec, channel::ptr channel,
     const std::string& hostname, uint16_t port, channel_handler handler,
-    uint32_t retries)
+    uint32_t retries, reconnect_backoff::ptr backoff)
 {
     if (ec)
     {
-        log::warning(LOG_NETWORK)
+        LOG_WARNING(LOG_NETWORK)
             << "Failure connecting [" << config::endpoint(hostname, port)
             << "] manually: " << ec.message();
 
-        // Retry logic.
+        // Retry logic, an unlimited loop must not retry without delay.
         if (settings_.manual_attempt_limit == 0)
-            start_connect(hostname, port, handler, 0);
+            retry(backoff, BIND5(start_connect, hostname, port, handler, 0,
+                backoff));
         else if (retries > 0)
-            start_connect(hostname, port, handler, retries - 1);
+            retry(backoff, BIND5(start_connect, hostname, port, handler,
+                retries - 1, backoff));
         else
             handler(ec, nullptr);
 
         return;
     }
 
-    log::info(LOG_NETWORK)
+    LOG_INFO(LOG_NETWORK)
         << "Connected manual channel [" << config::endpoint(hostname, port)
         << "] as [" << channel->authority() << "]";
 
     register_channel(channel, 
-        BIND5(handle_channel_start, _1, hostname, port, channel, handler),
-        BIND3(handle_channel_stop, _1, hostname, port));
+        BIND6(handle_channel_start, _1, hostname, port, channel, handler,
+            backoff),
+        BIND4(handle_channel_stop, _1, hostname, port, backoff));
 }
 
 void session_manual::handle_channel_start(const code& ec,
     const std::string& hostname, uint16_t port, channel::ptr channel,
-    channel_handler handler)
+    channel_handler handler, reconnect_backoff::ptr backoff)
 {
     // Treat a start failure just like a stop, but preserve the start handler.
     if (ec)
     {
-        log::info(LOG_NETWORK)
+        LOG_INFO(LOG_NETWORK)
             << "Manual channel failed to start [" << channel->authority()
             << "] " << ec.message();
 
@@ -150,26 +164,34 @@ void session_manual::handle_channel_start(const code& ec,
             return;
         }
 
-        connect(hostname, port, handler);
+        retry(backoff, BIND5(start_connect, hostname, port, handler,
+            settings_.manual_attempt_limit, backoff));
         return;
     }
 
+    // A started channel ends the run of failures of its connection loop.
+    backoff->reset();
+
     // This is the end of the connect sequence (the handler goes out of scope).
     handler(error::success, channel);
 
     // This is the beginning of the connect cycle.
     attach<protocol_ping>(channel)->start();
     attach<protocol_address>(channel)->start();
+    attach<protocol_compact_block>(channel)->start();
+    attach<protocol_block_sync>(channel)->start();
 }
 
 // After a stop we don't use the caller's start handler, but keep connecting.
 void session_manual::handle_channel_stop(const code& ec,
-    const std::string& hostname, uint16_t port)
+    const std::string& hostname, uint16_t port, reconnect_backoff::ptr backoff)
 {
-    log::debug(LOG_NETWORK)
+    LOG_DEBUG(LOG_NETWORK)
         << "Manual channel stopped: " << ec.message();
 
-    connect(hostname, port);
+    const auto unhandled = [](code, channel::ptr) {};
+    retry(backoff, BIND5(start_connect, hostname, port, unhandled,
+        settings_.manual_attempt_limit, backoff));
 }
 
 } // namespace network
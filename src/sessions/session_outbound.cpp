@@ -19,11 +19,16 @@
  */
 #include <bitcoin/network/sessions/session_outbound.hpp>
 
+#include <algorithm>
 #include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/logging.hpp>
 #include <bitcoin/network/p2p.hpp>
 #include <bitcoin/network/protocols/protocol_address.hpp>
+#include <bitcoin/network/protocols/protocol_block_sync.hpp>
+#include <bitcoin/network/protocols/protocol_compact_block.hpp>
 #include <bitcoin/network/protocols/protocol_ping.hpp>
 
 namespace libbitcoin {
@@ -36,6 +41,7 @@ using std::placeholders::_2;
 
 session_outbound::session_outbound(p2p& network)
   : session_batch(network, true),
+    eviction_(std::make_shared<deadline>(pool_, settings_.outbound_eviction())),
     CONSTRUCT_TRACK(session_outbound)
 {
 }
@@ -47,13 +53,13 @@ void session_outbound::start(result_handler handler)
 {
     if (settings_.outbound_connections == 0)
     {
-        log::info(LOG_NETWORK)
+        LOG_INFO(LOG_NETWORK)
             << "Not configured for generating outbound connections.";
         handler(error::success);
         return;
     }
 
-    session::start(CONCURRENT2(handle_started, _1, handler));
+    session_batch::start(CONCURRENT2(handle_started, _1, handler));
 }
 
 void session_outbound::handle_started(const code& ec, result_handler handler)
@@ -65,8 +71,26 @@ void session_outbound::handle_started(const code& ec, result_handler handler)
     }
 
     const auto connect = create_connector();
+    const auto anchors = take_anchors();
+
+    // The anchors of the last run are dialed first, in parallel, each by the
+    // slot that it occupies, a failed anchor falls back to the address pool.
     for (size_t peer = 0; peer < settings_.outbound_connections; ++peer)
-        new_connection(connect);
+    {
+        const auto backoff = create_backoff();
+
+        if (peer < anchors.size())
+            connect_direct(connect, anchors[peer],
+                BIND4(handle_connect, _1, _2, connect, backoff));
+        else
+            new_connection(connect, backoff);
+    }
+
+    if (settings_.outbound_eviction_minutes != 0)
+    {
+        subscribe_stop(BIND1(handle_stop, _1));
+        start_eviction();
+    }
 
     // This is the end of the start sequence.
     handler(error::success);
@@ -75,63 +99,188 @@ void session_outbound::handle_started(const code& ec, result_handler handler)
 // Connnect cycle.
 // ----------------------------------------------------------------------------
 
-void session_outbound::new_connection(connector::ptr connect)
+void session_outbound::new_connection(connector::ptr connect,
+    reconnect_backoff::ptr backoff)
 {
     if (stopped())
     {
-        log::debug(LOG_NETWORK)
+        LOG_DEBUG(LOG_NETWORK)
             << "Suspended outbound connection.";
         return;
     }
 
-    this->connect(connect, BIND3(handle_connect, _1, _2, connect));
+    this->connect(connect, BIND4(handle_connect, _1, _2, connect, backoff));
 }
 
 void session_outbound::handle_connect(const code& ec, channel::ptr channel,
-    connector::ptr connect)
+    connector::ptr connect, reconnect_backoff::ptr backoff)
 {
     if (ec)
     {
-        log::debug(LOG_NETWORK)
+        LOG_DEBUG(LOG_NETWORK)
             << "Failure connecting outbound: " << ec.message();
-        new_connection(connect);
+        retry(backoff, BIND2(new_connection, connect, backoff));
         return;
     }
 
-    log::info(LOG_NETWORK)
+    LOG_INFO(LOG_NETWORK)
         << "Connected to outbound channel [" << channel->authority() << "]";
 
     register_channel(channel, 
-        BIND3(handle_channel_start, _1, connect, channel),
-        BIND3(handle_channel_stop, _1, connect, channel));
+        BIND4(handle_channel_start, _1, connect, backoff, channel),
+        BIND4(handle_channel_stop, _1, connect, backoff, channel));
 }
 
 void session_outbound::handle_channel_start(const code& ec,
-    connector::ptr connect, channel::ptr channel)
+    connector::ptr connect, reconnect_backoff::ptr backoff,
+    channel::ptr channel)
 {
     // Treat a start failure just like a stop.
     if (ec)
     {
-        log::debug(LOG_NETWORK)
+        LOG_DEBUG(LOG_NETWORK)
             << "Outbound channel failed to start ["
             << channel->authority() << "] " << ec.message();
 
-        new_connection(connect);
+        release_address(channel->authority());
+        retry(backoff, BIND2(new_connection, connect, backoff));
         return;
     }
 
+    // A started channel ends the run of failures of its connection loop.
+    backoff->reset();
+    store_channel(channel);
     attach<protocol_ping>(channel)->start();
     attach<protocol_address>(channel)->start();
+    attach<protocol_compact_block>(channel)->start();
+    attach<protocol_block_sync>(channel)->start();
 }
 
 void session_outbound::handle_channel_stop(const code& ec,
-    connector::ptr connect, channel::ptr channel)
+    connector::ptr connect, reconnect_backoff::ptr backoff,
+    channel::ptr channel)
 {
-    log::debug(LOG_NETWORK)
+    LOG_DEBUG(LOG_NETWORK)
         << "Outbound channel stopped [" << channel->authority() << "] "
         << ec.message();
 
-    new_connection(connect);
+    remove_channel(channel);
+    release_address(channel->authority());
+    retry(backoff, BIND2(new_connection, connect, backoff));
+}
+
+// Eviction cycle.
+// ----------------------------------------------------------------------------
+// The slowest outbound peer is periodically replaced, so that the session
+// does not settle on peers that are connected but of little use.
+
+void session_outbound::start_eviction()
+{
+    if (stopped())
+        return;
+
+    eviction_->start(BIND1(handle_eviction, _1));
+}
+
+void session_outbound::handle_stop(const code&)
+{
+    eviction_->stop();
+}
+
+void session_outbound::handle_eviction(const code& ec)
+{
+    if (stopped() || ec)
+        return;
+
+    const auto channel = select_eviction();
+
+    if (channel)
+    {
+        LOG_DEBUG(LOG_NETWORK)
+            << "Evicting slowest outbound channel [" << channel->authority()
+            << "]";
+
+        // The stop handler replaces the channel with a new connection.
+        channel->stop(error::channel_timeout);
+    }
+
+    start_eviction();
+}
+
+void session_outbound::store_channel(channel::ptr channel)
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    channels_.push_back({ channel, channel->metrics().received_bytes(),
+        false });
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void session_outbound::remove_channel(channel::ptr channel)
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    const auto match = [&channel](const sample& entry)
+    {
+        return entry.peer == channel;
+    };
+
+    channels_.erase(std::remove_if(channels_.begin(), channels_.end(), match),
+        channels_.end());
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// Throughput is the bytes received over the interval. A channel connected
+// within the interval is not measured, and a channel is evicted only when
+// all slots are filled and it is well below the mean of the others.
+channel::ptr session_outbound::select_eviction()
+{
+    channel::ptr slowest;
+    uint64_t slowest_bytes = 0;
+    uint64_t total_bytes = 0;
+    size_t measured = 0;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    mutex_.lock();
+
+    for (auto& entry: channels_)
+    {
+        const auto received = entry.peer->metrics().received_bytes();
+        const auto bytes = received - entry.received;
+        entry.received = received;
+
+        if (!entry.measured)
+        {
+            entry.measured = true;
+            continue;
+        }
+
+        total_bytes += bytes;
+        ++measured;
+
+        if (!slowest || bytes < slowest_bytes)
+        {
+            slowest = entry.peer;
+            slowest_bytes = bytes;
+        }
+    }
+
+    const auto full = channels_.size() >= settings_.outbound_connections;
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    if (!full || measured < 2)
+        return nullptr;
+
+    // A peer within a quarter of the mean is not worth the reconnection.
+    const auto mean = total_bytes / measured;
+    return slowest_bytes * 4 < mean ? slowest : nullptr;
 }
 
 } // namespace network
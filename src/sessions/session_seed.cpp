@@ -19,10 +19,13 @@
  */
 #include <bitcoin/network/sessions/session_seed.hpp>
 
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
 #include <functional>
+#include <vector>
 #include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/logging.hpp>
 #include <bitcoin/network/p2p.hpp>
 #include <bitcoin/network/protocols/protocol_ping.hpp>
 #include <bitcoin/network/protocols/protocol_seed.hpp>
@@ -39,10 +42,17 @@ using std::placeholders::_2;
 
 session_seed::session_seed(p2p& network)
   : session(network, true, false),
+    completed_(false),
     CONSTRUCT_TRACK(session_seed)
 {
 }
 
+// protected:
+lifecycle_metrics::origin session_seed::origin() const
+{
+    return lifecycle_metrics::origin::seed;
+}
+
 // Start sequence.
 // ----------------------------------------------------------------------------
 
@@ -50,7 +60,7 @@ void session_seed::start(result_handler handler)
 {
     if (settings_.host_pool_capacity == 0)
     {
-        log::info(LOG_NETWORK)
+        LOG_INFO(LOG_NETWORK)
             << "Not configured to populate an address pool.";
         handler(error::success);
         return;
@@ -74,7 +84,7 @@ void session_seed::handle_count(size_t start_size, result_handler handler)
 {
     if (start_size != 0)
     {
-        log::debug(LOG_NETWORK)
+        LOG_DEBUG(LOG_NETWORK)
             << "Seeding is not required because there are " 
             << start_size << " cached addresses.";
         handler(error::success);
@@ -83,7 +93,7 @@ void session_seed::handle_count(size_t start_size, result_handler handler)
 
     if (settings_.seeds.empty())
     {
-        log::error(LOG_NETWORK)
+        LOG_ERROR(LOG_NETWORK)
             << "Seeding is required but no seeds are configured.";
         handler(error::operation_failed);
         return;
@@ -100,41 +110,112 @@ void session_seed::handle_count(size_t start_size, result_handler handler)
 void session_seed::start_seeding(size_t start_size, connector::ptr connect,
     result_handler handler)
 {
-    // When all seeds are synchronized call session_seed::handle_complete.
-    auto all = BIND2(handle_complete, start_size, handler);
+    // Seeding completes once, upon reaching the host threshold or when all
+    // seeds are complete, so the slowest seed cannot delay the start.
+    auto complete = synchronize(BIND3(handle_complete, start_size, connect,
+        handler), 1, NAME, false);
 
     // Synchronize each individual seed before calling handle_complete.
-    auto each = synchronize(all, settings_.seeds.size(), NAME, true);
+    auto each = synchronize(complete, settings_.seeds.size(), NAME, true);
 
     // We don't use parallel here because connect is itself asynchronous.
     for (const auto& seed: settings_.seeds)
-        start_seed(seed, connect, each);
+        start_seed(seed, connect, each, complete);
 }
 
 void session_seed::start_seed(const config::endpoint& seed,
-    connector::ptr connect, result_handler handler)
+    connector::ptr connect, result_handler handler, result_handler complete)
 {
     if (stopped())
     {
-        log::debug(LOG_NETWORK)
+        LOG_DEBUG(LOG_NETWORK)
             << "Suspended seed connection";
         handler(error::channel_stopped);
         return;
     }
 
-    log::info(LOG_NETWORK)
-        << "Contacting seed [" << seed << "]";
+    LOG_INFO(LOG_NETWORK)
+        << "Resolving seed [" << seed << "]";
 
-    // OUTBOUND CONNECT
-    connect->connect(seed, BIND4(handle_connect, _1, _2, seed, handler));
+    // All seeds resolve concurrently.
+    connect->resolve(seed.host(), seed.port(),
+        BIND6(handle_resolve, _1, _2, seed, connect, handler, complete));
+}
+
+// Several addresses of a seed are contacted at once, up to the batch size, as
+// a single seed name commonly resolves to many independent nodes.
+void session_seed::handle_resolve(const code& ec,
+    const config::authority::list& authorities, const config::endpoint& seed,
+    connector::ptr connect, result_handler handler, result_handler complete)
+{
+    if (ec || authorities.empty())
+    {
+        LOG_INFO(LOG_NETWORK)
+            << "Failure resolving seed [" << seed << "] "
+            << (ec ? ec.message() : "no addresses");
+        handler(ec ? ec : error::resolve_failed);
+        return;
+    }
+
+    // The resolved nodes are themselves pooled, as with a DNS seed, so that
+    // the pool grows while the seed connections are pending.
+    config::authority::list hosts;
+    hosts.reserve(authorities.size());
+
+    for (const auto& authority: authorities)
+        if (!blacklisted(authority))
+            hosts.push_back(authority);
+
+    if (hosts.empty())
+    {
+        LOG_INFO(LOG_NETWORK)
+            << "Seed [" << seed << "] resolves only to blacklisted addresses.";
+        handler(error::address_blocked);
+        return;
+    }
+
+    store_addresses(hosts, BIND3(handle_stored, _1, seed, complete));
+
+    const auto count = std::max(size_t(1), std::min(hosts.size(),
+        static_cast<size_t>(settings_.connect_batch_size)));
+
+    // The seed is complete when each of its connections is complete.
+    auto each = synchronize(handler, count, NAME, true);
+
+    for (size_t index = 0; index < count; ++index)
+    {
+        const auto& address = hosts[index];
+
+        LOG_INFO(LOG_NETWORK)
+            << "Contacting seed [" << seed << "] at [" << address << "]";
+
+        // OUTBOUND CONNECT
+        connect->connect(address,
+            BIND5(handle_connect, _1, _2, seed, each, complete));
+    }
+}
+
+void session_seed::handle_stored(const code& ec, const config::endpoint& seed,
+    result_handler complete)
+{
+    if (ec)
+    {
+        LOG_DEBUG(LOG_NETWORK)
+            << "Failure storing addresses of seed [" << seed << "] "
+            << ec.message();
+        return;
+    }
+
+    check_threshold(complete);
 }
 
 void session_seed::handle_connect(const code& ec, channel::ptr channel,
-    const config::endpoint& seed, result_handler handler)
+    const config::endpoint& seed, result_handler handler,
+    result_handler complete)
 {
     if (ec)
     {
-        log::info(LOG_NETWORK)
+        LOG_INFO(LOG_NETWORK)
             << "Failure contacting seed [" << seed << "] " << ec.message();
         handler(ec);
         return;
@@ -142,23 +223,33 @@ void session_seed::handle_connect(const code& ec, channel::ptr channel,
 
     if (blacklisted(channel->authority()))
     {
-        log::debug(LOG_NETWORK)
+        LOG_DEBUG(LOG_NETWORK)
             << "Seed [" << seed << "] on blacklisted address ["
             << channel->authority() << "]";
         handler(error::address_blocked);
         return;
     }
 
-    log::info(LOG_NETWORK)
+    // A connection that completes after seeding is no longer useful.
+    if (!safe_store(channel))
+    {
+        LOG_DEBUG(LOG_NETWORK)
+            << "Seeding completed before seed [" << seed << "] connected.";
+        channel->stop(error::channel_stopped);
+        handler(error::channel_stopped);
+        return;
+    }
+
+    LOG_INFO(LOG_NETWORK)
         << "Connected seed [" << seed << "] as " << channel->authority();
 
     register_channel(channel, 
-        BIND3(handle_channel_start, _1, channel, handler),
-        BIND1(handle_channel_stop, _1));
+        BIND4(handle_channel_start, _1, channel, handler, complete),
+        BIND2(handle_channel_stop, _1, channel));
 }
 
 void session_seed::handle_channel_start(const code& ec, channel::ptr channel,
-    result_handler handler)
+    result_handler handler, result_handler complete)
 {
     if (ec)
     {
@@ -167,18 +258,57 @@ void session_seed::handle_channel_start(const code& ec, channel::ptr channel,
     }
 
     attach<protocol_ping>(channel)->start();
-    attach<protocol_seed>(channel)->start(handler);
+    attach<protocol_seed>(channel)->start(
+        BIND3(handle_seeded, _1, handler, complete));
 };
 
-void session_seed::handle_channel_stop(const code& ec)
+void session_seed::handle_channel_stop(const code& ec, channel::ptr channel)
 {
-    log::debug(LOG_NETWORK)
+    LOG_DEBUG(LOG_NETWORK)
         << "Seed channel stopped: " << ec.message();
+
+    safe_remove(channel);
+}
+
+// The channel stops itself once its addresses are stored.
+void session_seed::handle_seeded(const code& ec, result_handler handler,
+    result_handler complete)
+{
+    check_threshold(complete);
+    handler(ec);
+}
+
+// Threshold sequence.
+// ----------------------------------------------------------------------------
+
+void session_seed::check_threshold(result_handler complete)
+{
+    if (settings_.host_pool_seed_threshold == 0)
+        return;
+
+    address_count(BIND2(handle_threshold, _1, complete));
+}
+
+void session_seed::handle_threshold(size_t current_size,
+    result_handler complete)
+{
+    if (current_size < settings_.host_pool_seed_threshold)
+        return;
+
+    // Additional invocations are ignored by the synchronizer.
+    complete(error::success);
 }
 
 // This accepts no error code because individual seed errors are suppressed.
-void session_seed::handle_complete(size_t start_size, result_handler handler)
+void session_seed::handle_complete(size_t start_size, connector::ptr connect,
+    result_handler handler)
 {
+    // Cancel the seed resolutions and connections that remain pending.
+    connect->stop();
+
+    for (const auto channel: safe_clear())
+        channel->stop(error::channel_stopped);
+
     address_count(BIND3(handle_final_count, _1, start_size, handler));
 }
 
@@ -193,5 +323,48 @@ void session_seed::handle_final_count(size_t current_size, size_t start_size,
     handler(result);
 }
 
+// Seed channels.
+// ----------------------------------------------------------------------------
+
+bool session_seed::safe_store(channel::ptr channel)
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    if (completed_)
+        return false;
+
+    channels_.push_back(channel);
+    return true;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void session_seed::safe_remove(channel::ptr channel)
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    const auto it = std::find(channels_.begin(), channels_.end(), channel);
+
+    if (it != channels_.end())
+        channels_.erase(it);
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+std::vector<channel::ptr> session_seed::safe_clear()
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    completed_ = true;
+    std::vector<channel::ptr> channels;
+    channels.swap(channels_);
+    return channels;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
 } // namespace network
 } // namespace libbitcoin
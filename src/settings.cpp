@@ -30,22 +30,86 @@ using namespace asio;
 settings::settings()
   : threads(50),
     inbound_connections(8),
+    inbound_acceptors(1),
+    inbound_accepts(4),
+    inbound_subnet_accepts(10),
     outbound_connections(8),
     manual_attempt_limit(0),
     connect_batch_size(5),
+    connect_attempt_limit(16),
     connect_timeout_seconds(5),
+    connect_stagger_milliseconds(250),
+    connect_backoff_milliseconds(500),
+    connect_backoff_maximum_seconds(60),
     channel_handshake_seconds(30),
     channel_heartbeat_minutes(5),
     channel_inactivity_minutes(10),
     channel_expiration_minutes(1440),
     channel_germination_seconds(30),
+    channel_get_address_seconds(600),
+    channel_trickle_milliseconds(5000),
+    channel_known_inventory(5000),
+    channel_unsolicited_bytes(0),
+    channel_payload_bytes(10 * 1024 * 1024),
+    channel_stall_seconds(60),
+    channel_timer_milliseconds(1000),
+    channel_minimum_throughput(1024),
+    outbound_eviction_minutes(10),
+    outbound_anchors(4),
+    shutdown_timeout_seconds(30),
     host_pool_capacity(1000),
+    host_pool_flush_seconds(60),
+    host_pool_sample_seconds(60),
+    host_pool_seed_threshold(100),
+    log_queue_capacity(0),
+    log_flush_milliseconds(500),
+    buffer_pool_capacity(16 * 1024 * 1024),
+    channel_write_bytes(1024 * 1024),
+    channel_backlog_bytes(16 * 1024 * 1024),
+    channel_receive_backlog_bytes(8 * 1024 * 1024),
+    channel_read_ahead_bytes(64 * 1024),
+    channel_parallel_parse_bytes(0),
+    inbound_send_buffer_bytes(0),
+    inbound_receive_buffer_bytes(0),
+    outbound_send_buffer_bytes(0),
+    outbound_receive_buffer_bytes(0),
+    inbound_fast_open_queue(0),
+    channel_upload_bytes_per_second(0),
+    upload_bytes_per_second(0),
+    memory_limit_bytes(0),
+    resolve_cache_seconds(300),
+    download_window_blocks(1024),
+    download_peer_blocks(16),
+    download_stall_seconds(10),
+    metrics_port(0),
+    metrics_interval_seconds(10),
     relay_transactions(true),
+    thread_affinity(false),
+    inbound_eviction(true),
+    socket_no_delay(true),
+    socket_keep_alive(true),
+    channel_pipeline_handshake(false),
     hosts_file("hosts.cache"),
+    anchors_file("anchors.cache"),
     debug_file("debug.log"),
     error_file("error.log"),
     self(unspecified_network_address)
 {
+    // Large, latency-critical messages are delivered in the read completion.
+    synchronous_messages.reserve(2);
+    synchronous_messages.push_back("block");
+    synchronous_messages.push_back("headers");
+
+    // Tighter limits by command, from the protocol bounds of each payload.
+    payload_limits.reserve(8);
+    payload_limits.push_back("addr:30003");
+    payload_limits.push_back("getdata:1800009");
+    payload_limits.push_back("headers:162003");
+    payload_limits.push_back("inv:1800009");
+    payload_limits.push_back("notfound:1800009");
+    payload_limits.push_back("ping:8");
+    payload_limits.push_back("pong:8");
+    payload_limits.push_back("verack:0");
 }
 
 // Use push_back due to initializer_list bug:
@@ -96,6 +160,21 @@ duration settings::connect_timeout() const
     return seconds(connect_timeout_seconds);
 }
 
+duration settings::connect_stagger() const
+{
+    return milliseconds(connect_stagger_milliseconds);
+}
+
+duration settings::connect_backoff() const
+{
+    return milliseconds(connect_backoff_milliseconds);
+}
+
+duration settings::connect_backoff_maximum() const
+{
+    return seconds(connect_backoff_maximum_seconds);
+}
+
 duration settings::channel_handshake() const
 {
     return seconds(channel_handshake_seconds);
@@ -119,7 +198,47 @@ duration settings::channel_expiration() const
 duration settings::channel_germination() const
 {
     return seconds(channel_germination_seconds);
-} 
+}
+
+duration settings::channel_trickle() const
+{
+    return milliseconds(channel_trickle_milliseconds);
+}
+
+duration settings::channel_timer() const
+{
+    return milliseconds(channel_timer_milliseconds);
+}
+
+duration settings::outbound_eviction() const
+{
+    return minutes(outbound_eviction_minutes);
+}
+
+duration settings::shutdown_timeout() const
+{
+    return seconds(shutdown_timeout_seconds);
+}
+
+duration settings::host_pool_flush() const
+{
+    return seconds(host_pool_flush_seconds);
+}
+
+duration settings::download_stall() const
+{
+    return seconds(download_stall_seconds);
+}
+
+duration settings::log_flush() const
+{
+    return milliseconds(log_flush_milliseconds);
+}
+
+duration settings::metrics_interval() const
+{
+    return seconds(metrics_interval_seconds);
+}
 
 } // namespace network
 } // namespace libbitcoin
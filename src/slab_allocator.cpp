@@ -0,0 +1,106 @@
+/**
+ * Copyright (c) 2011-2016 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/network/slab_allocator.hpp>
+
+#include <array>
+#include <cstddef>
+#include <new>
+#include <vector>
+#include <boost/thread/tss.hpp>
+#include <bitcoin/bitcoin.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+// Blocks are classed in steps of a cache line, up to 4KiB.
+static constexpr size_t block_step = 64;
+static constexpr size_t class_count = 64;
+
+// The number of free blocks retained by each thread for each class.
+static constexpr size_t class_retained = 64;
+
+// The free blocks of one thread, released to the heap at thread exit.
+struct slab_cache
+{
+    ~slab_cache()
+    {
+        for (const auto& blocks: free)
+            for (const auto block: blocks)
+                ::operator delete(block);
+    }
+
+    std::array<std::vector<void*>, class_count> free;
+};
+
+// A thread that has exited has no cache, so its releases use the heap.
+static boost::thread_specific_ptr<slab_cache> caches;
+
+static size_t to_class(size_t size)
+{
+    return size == 0 ? 0 : (size - 1) / block_step;
+}
+
+void* slab::allocate(size_t size)
+{
+    const auto index = to_class(size);
+
+    if (index >= class_count)
+        return ::operator new(size);
+
+    auto cache = caches.get();
+
+    if (cache == nullptr)
+    {
+        cache = new slab_cache;
+        caches.reset(cache);
+    }
+
+    auto& blocks = cache->free[index];
+
+    if (blocks.empty())
+        return ::operator new((index + 1) * block_step);
+
+    const auto block = blocks.back();
+    blocks.pop_back();
+    return block;
+}
+
+void slab::deallocate(void* block, size_t size)
+{
+    const auto index = to_class(size);
+    const auto cache = caches.get();
+
+    if (index >= class_count || cache == nullptr ||
+        cache->free[index].size() >= class_retained)
+    {
+        ::operator delete(block);
+        return;
+    }
+
+    auto& blocks = cache->free[index];
+
+    if (blocks.capacity() == 0)
+        blocks.reserve(class_retained);
+
+    blocks.push_back(block);
+}
+
+} // namespace network
+} // namespace libbitcoin
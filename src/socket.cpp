@@ -19,16 +19,20 @@
  */
 #include <bitcoin/network/socket.hpp>
 
+#include <functional>
 #include <memory>
 #include <boost/asio.hpp>
 #include <bitcoin/bitcoin.hpp>
 #include <bitcoin/network/locked_socket.hpp>
+#include <bitcoin/network/settings.hpp>
 
 namespace libbitcoin {
 namespace network {
 
 socket::socket(threadpool& pool)
-  : socket_(pool.service()),
+  : pool_(pool),
+    socket_(pool.service()),
+    strand_(pool.service()),
     CONSTRUCT_TRACK(socket)
 {
 }
@@ -45,12 +49,75 @@ locked_socket::ptr socket::get_socket()
     return std::make_shared<locked_socket>(socket_, mutex_);
 }
 
+asio::socket& socket::get()
+{
+    return socket_;
+}
+
+asio::strand& socket::strand()
+{
+    return strand_;
+}
+
+threadpool& socket::pool()
+{
+    return pool_;
+}
+
+// A zero buffer size retains the kernel default, which may be autotuned.
+// Accepted sockets also inherit the receive buffer of the listener, which
+// must be set before the listen in order to affect the window scale.
+code socket::set_options(const settings& settings, bool inbound)
+{
+    typedef asio::socket::send_buffer_size send_buffer_size;
+    typedef asio::socket::receive_buffer_size receive_buffer_size;
+
+    const auto send_bytes = inbound ? settings.inbound_send_buffer_bytes :
+        settings.outbound_send_buffer_bytes;
+    const auto receive_bytes = inbound ?
+        settings.inbound_receive_buffer_bytes :
+        settings.outbound_receive_buffer_bytes;
+
+    boost_code ec;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    mutex_.lock();
+
+    // Nagle would otherwise delay the small ping and inventory messages.
+    socket_.set_option(asio::tcp::no_delay(settings.socket_no_delay), ec);
+
+    if (!ec)
+        socket_.set_option(asio::socket::keep_alive(
+            settings.socket_keep_alive), ec);
+
+    if (!ec && send_bytes != 0)
+        socket_.set_option(send_buffer_size(send_bytes), ec);
+
+    if (!ec && receive_bytes != 0)
+        socket_.set_option(receive_buffer_size(receive_bytes), ec);
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    return error::boost_to_error_code(ec);
+}
+
 // BUGBUG: socket::cancel fails with error::operation_not_supported
 // on Windows XP and Windows Server 2003, but handler invocation is required.
 // We should enable BOOST_ASIO_ENABLE_CANCELIO and BOOST_ASIO_DISABLE_IOCP
 // on these platforms only. See: bit.ly/1YC0p9e
 void socket::close()
 {
+    // Close within the strand so that it cannot overlap a socket operation.
+    strand_.dispatch(
+        std::bind(&socket::do_close,
+            shared_from_base<socket>()));
+}
+
+void socket::do_close()
+{
+    // The lock excludes connect and accept, which do not use the strand.
     // Critical Section
     ///////////////////////////////////////////////////////////////////////////
     mutex_.lock_upgrade();
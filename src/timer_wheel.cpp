@@ -0,0 +1,205 @@
+/**
+ * Copyright (c) 2011-2016 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/network/timer_wheel.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include <bitcoin/bitcoin.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+using std::placeholders::_1;
+
+timer_wheel::timer_wheel(threadpool& pool, const asio::duration& tick,
+    size_t slots)
+  : stopped_(true),
+    timer_(std::make_shared<deadline>(pool, tick)),
+    tick_milliseconds_(std::max(tick.total_milliseconds(), int64_t(1))),
+    slots_(std::max(slots, size_t(1))),
+    cursor_(0),
+    last_identifier_(0)
+{
+}
+
+void timer_wheel::start()
+{
+    stopped_ = false;
+    start_timer();
+}
+
+void timer_wheel::stop()
+{
+    stopped_ = true;
+    timer_->stop();
+
+    std::vector<handler> handlers;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    mutex_.lock();
+
+    for (auto& slot: slots_)
+    {
+        for (auto& entry: slot)
+            handlers.push_back(entry.second.notify);
+
+        slot.clear();
+    }
+
+    index_.clear();
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    for (const auto& notify: handlers)
+        notify(error::service_stopped);
+}
+
+uint64_t timer_wheel::schedule(const asio::duration& delay, handler handler)
+{
+    if (stopped_)
+    {
+        handler(error::service_stopped);
+        return 0;
+    }
+
+    // A timer always waits at least one full tick.
+    const auto milliseconds = std::max(delay.total_milliseconds(),
+        int64_t(0));
+    const auto ticks = std::max(static_cast<uint64_t>(
+        (milliseconds + tick_milliseconds_ - 1) / tick_milliseconds_),
+        uint64_t(1));
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    mutex_.lock();
+
+    // A stop that clears the slots while this waits is observed here, as the
+    // stopped flag is set before the slots are cleared.
+    if (stopped_)
+    {
+        mutex_.unlock();
+        //---------------------------------------------------------------------
+        handler(error::service_stopped);
+        return 0;
+    }
+
+    const auto size = slots_.size();
+    const auto index = static_cast<size_t>((cursor_ + ticks) % size);
+    const auto rounds = static_cast<size_t>((ticks - 1) / size);
+    const auto identifier = ++last_identifier_;
+
+    slots_[index].emplace(identifier, timer{ rounds, handler });
+    index_.emplace(identifier, index);
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    return identifier;
+}
+
+bool timer_wheel::cancel(uint64_t identifier)
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    const auto it = index_.find(identifier);
+
+    if (it == index_.end())
+        return false;
+
+    slots_[it->second].erase(identifier);
+    index_.erase(it);
+    return true;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void timer_wheel::advance()
+{
+    std::vector<handler> expired;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    mutex_.lock();
+
+    cursor_ = (cursor_ + 1) % slots_.size();
+    auto& slot = slots_[cursor_];
+
+    for (auto it = slot.begin(); it != slot.end();)
+    {
+        if (it->second.rounds > 0)
+        {
+            --it->second.rounds;
+            ++it;
+            continue;
+        }
+
+        expired.push_back(it->second.notify);
+        index_.erase(it->first);
+        it = slot.erase(it);
+    }
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    // Handlers may schedule or cancel timers, so the lock is not held.
+    for (const auto& notify: expired)
+        notify(error::success);
+}
+
+size_t timer_wheel::pending() const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    shared_lock lock(mutex_);
+
+    return index_.size();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// Sweep sequence.
+// ----------------------------------------------------------------------------
+
+void timer_wheel::start_timer()
+{
+    if (stopped_)
+        return;
+
+    timer_->start(
+        std::bind(&timer_wheel::handle_timer,
+            shared_from_this(), _1));
+}
+
+void timer_wheel::handle_timer(const code& ec)
+{
+    if (ec || stopped_)
+        return;
+
+    advance();
+    start_timer();
+}
+
+} // namespace network
+} // namespace libbitcoin
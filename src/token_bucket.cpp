@@ -0,0 +1,140 @@
+/**
+ * Copyright (c) 2011-2016 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/network/token_bucket.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <bitcoin/bitcoin.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+using namespace std::chrono;
+
+static constexpr int64_t micro_per_second = 1000000;
+
+token_bucket::token_bucket(size_t rate, size_t burst)
+  : rate_(static_cast<int64_t>(rate)),
+    burst_(static_cast<int64_t>(std::max(burst, size_t(1)))),
+    tokens_(burst_),
+    updated_(clock::now())
+{
+}
+
+bool token_bucket::unlimited() const
+{
+    return rate_ == 0;
+}
+
+bool token_bucket::available()
+{
+    return available(clock::now());
+}
+
+bool token_bucket::available(clock::time_point now)
+{
+    if (unlimited())
+        return true;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    refill(now);
+    return tokens_ > 0;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void token_bucket::consume(size_t bytes)
+{
+    consume(bytes, clock::now());
+}
+
+void token_bucket::consume(size_t bytes, clock::time_point now)
+{
+    if (unlimited())
+        return;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    refill(now);
+    tokens_ -= static_cast<int64_t>(bytes);
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+asio::duration token_bucket::delay()
+{
+    return delay(clock::now());
+}
+
+// The delay is rounded up, so that tokens are available upon its expiration.
+asio::duration token_bucket::delay(clock::time_point now)
+{
+    if (unlimited())
+        return asio::duration();
+
+    int64_t deficit;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    mutex_.lock();
+
+    refill(now);
+    deficit = tokens_ > 0 ? 0 : 1 - tokens_;
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    if (deficit == 0)
+        return asio::duration();
+
+    const auto micro = (deficit * micro_per_second + rate_ - 1) / rate_;
+    return asio::microseconds(micro);
+}
+
+// Only whole tokens are added, the remainder of the interval is retained.
+void token_bucket::refill(clock::time_point now)
+{
+    if (now <= updated_)
+        return;
+
+    const auto elapsed = duration_cast<microseconds>(now - updated_).count();
+    const auto added = elapsed * rate_ / micro_per_second;
+
+    if (added == 0)
+        return;
+
+    if (tokens_ + added >= burst_)
+    {
+        tokens_ = burst_;
+        updated_ = now;
+        return;
+    }
+
+    tokens_ += added;
+    updated_ += microseconds(added * micro_per_second / rate_);
+}
+
+} // namespace network
+} // namespace libbitcoin
@@ -0,0 +1,213 @@
+/**
+ * Copyright (c) 2011-2016 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/network/traffic_capture.hpp>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <tuple>
+#include <boost/filesystem.hpp>
+#include <bitcoin/bitcoin.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+using namespace bc::message;
+using namespace std::chrono;
+
+// The magic is "bcnc" as read from the file.
+const uint32_t traffic_capture::file_magic = 0x636e6362;
+const uint32_t traffic_capture::file_version = 1;
+
+// Timestamp, ipv6 address and port.
+static constexpr size_t ip_offset = sizeof(uint64_t);
+static constexpr size_t port_offset = ip_offset + 16;
+static constexpr size_t record_prefix_size = port_offset + sizeof(uint16_t);
+const size_t traffic_capture::prefix_size = record_prefix_size;
+
+static const size_t header_size = 2 * sizeof(uint32_t);
+static const size_t heading_size = std::tuple_size<heading::buffer>::value;
+static const size_t payload_size_offset = 16;
+
+// The protocol bound of a serialized payload, as a guard on foreign files.
+static const uint32_t maximum_payload_size = 32 * 1024 * 1024;
+
+template <typename Integer>
+static void append(data_chunk& out, Integer value)
+{
+    const auto bytes = to_little_endian(value);
+    out.insert(out.end(), bytes.begin(), bytes.end());
+}
+
+// static
+bool traffic_capture::read_header(std::istream& stream)
+{
+    uint8_t header[header_size];
+    stream.read(reinterpret_cast<char*>(header), header_size);
+
+    if (!stream)
+        return false;
+
+    return from_little_endian_unsafe<uint32_t>(header) == file_magic &&
+        from_little_endian_unsafe<uint32_t>(header + sizeof(uint32_t)) ==
+            file_version;
+}
+
+// static
+bool traffic_capture::read(std::istream& stream, record& out)
+{
+    uint8_t prefix[record_prefix_size];
+    stream.read(reinterpret_cast<char*>(prefix), prefix_size);
+    stream.read(reinterpret_cast<char*>(out.heading.data()), heading_size);
+
+    if (!stream)
+        return false;
+
+    asio::ipv6::bytes_type ip;
+    std::copy(prefix + ip_offset, prefix + port_offset, ip.begin());
+
+    out.timestamp = from_little_endian_unsafe<uint64_t>(prefix);
+    out.authority = config::authority(asio::ipv6(ip),
+        from_little_endian_unsafe<uint16_t>(prefix + port_offset));
+
+    // A truncated or foreign file may claim any size, so it is bounded.
+    const auto size = from_little_endian_unsafe<uint32_t>(
+        out.heading.data() + payload_size_offset);
+
+    if (size > maximum_payload_size)
+        return false;
+
+    out.payload.resize(size);
+
+    if (size == 0)
+        return true;
+
+    stream.read(reinterpret_cast<char*>(out.payload.data()), size);
+    return static_cast<bool>(stream);
+}
+
+traffic_capture::traffic_capture(const boost::filesystem::path& file)
+  : file_(file),
+    capturing_(false),
+    count_(0)
+{
+}
+
+code traffic_capture::start()
+{
+    if (file_.empty())
+        return error::success;
+
+    boost::system::error_code ec;
+    const auto created = !boost::filesystem::exists(file_, ec);
+
+    const auto stream = std::make_shared<bc::ofstream>(file_.string(),
+        std::ios::binary | std::ios::app);
+
+    if (!stream->good())
+        return error::file_system;
+
+    if (created)
+    {
+        data_chunk header;
+        header.reserve(header_size);
+        append(header, file_magic);
+        append(header, file_version);
+        stream->write(reinterpret_cast<const char*>(header.data()),
+            header.size());
+    }
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    mutex_.lock();
+    stream_ = stream;
+    capturing_ = true;
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    return stream->good() ? error::success : error::file_system;
+}
+
+void traffic_capture::stop()
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    mutex_.lock();
+    capturing_ = false;
+
+    if (stream_)
+        stream_->close();
+
+    stream_.reset();
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+bool traffic_capture::capturing() const
+{
+    return capturing_;
+}
+
+// The record is assembled outside of the lock and written in one call.
+void traffic_capture::write(const config::authority& authority,
+    const heading& head, const uint8_t* payload)
+{
+    if (!capturing_)
+        return;
+
+    const auto now = duration_cast<microseconds>(
+        system_clock::now().time_since_epoch()).count();
+    const auto ip = authority.ip().to_bytes();
+    const auto raw = head.to_data();
+
+    data_chunk record;
+    record.reserve(prefix_size + raw.size() + head.payload_size);
+    append(record, static_cast<uint64_t>(now));
+    record.insert(record.end(), ip.begin(), ip.end());
+    append(record, authority.port());
+    record.insert(record.end(), raw.begin(), raw.end());
+    record.insert(record.end(), payload, payload + head.payload_size);
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    mutex_.lock();
+
+    if (stream_)
+    {
+        stream_->write(reinterpret_cast<const char*>(record.data()),
+            record.size());
+        ++count_;
+    }
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+size_t traffic_capture::count() const
+{
+    return count_;
+}
+
+} // namespace network
+} // namespace libbitcoin
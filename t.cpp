@@ -0,0 +1,20 @@
+#include <bitcoin/network/message_checksum.hpp>
+#include <openssl/sha.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+using namespace libbitcoin::network;
+static uint32_t ref(const uint8_t* d, size_t n){ uint8_t h[32],h2[32]; SHA256(d,n,h); SHA256(h,32,h2); return h2[0]|(h2[1]<<8)|(h2[2]<<16)|((uint32_t)h2[3]<<24);}
+int main(){
+  std::vector<uint8_t> buf(300000); for(auto&b:buf) b=rand();
+  int bad=0;
+  for (auto k : {message_checksum::kernel::generic, message_checksum::kernel::sha_ni}) {
+    if(!message_checksum::select_kernel(k)){printf("kernel %d unsupported\n",(int)k);continue;}
+    for(size_t n : {0,1,55,56,63,64,65,119,120,128,1000,65536,299999}) {
+      if (message_checksum::compute(buf.data(),n)!=ref(buf.data(),n)) {printf("mismatch k=%d n=%zu\n",(int)k,n);bad++;}
+      message_checksum c; size_t off=0; while(off<n){size_t s=std::min<size_t>(n-off,1+rand()%200); c.update(buf.data()+off,s); off+=s;}
+      if (c.finalize()!=ref(buf.data(),n)) {printf("chunk mismatch k=%d n=%zu\n",(int)k,n);bad++;}
+    }
+  }
+  printf("bad=%d\n",bad);
+}
@@ -0,0 +1,140 @@
+/**
+ * Copyright (c) 2011-2016 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <memory>
+#include <boost/test/unit_test.hpp>
+#include <bitcoin/network.hpp>
+
+using namespace bc;
+using namespace bc::network;
+
+static connections::ptr make_connections()
+{
+    return std::make_shared<connections>(0);
+}
+
+// A zero limit does not shed load.
+static memory_accounts::ptr make_memory()
+{
+    return std::make_shared<memory_accounts>(0);
+}
+
+static admission::candidate make_candidate(uint8_t group, uint64_t ping,
+    uint64_t useful, uint64_t age)
+{
+    admission::candidate out;
+    out.netgroup.fill(0);
+    out.netgroup[1] = group;
+    out.ping_microseconds = ping;
+    out.useful_bytes = useful;
+    out.connected_milliseconds = age;
+    return out;
+}
+
+BOOST_AUTO_TEST_SUITE(admission_tests)
+
+BOOST_AUTO_TEST_CASE(admission__admit__default__success)
+{
+    const network::settings configuration;
+    admission instance(configuration, make_connections(), make_memory());
+    const config::authority peer("1.2.3.4:8333");
+    BOOST_REQUIRE_EQUAL(instance.admit(peer), error::success);
+}
+
+BOOST_AUTO_TEST_CASE(admission__admit__blacklisted__address_blocked)
+{
+    network::settings configuration;
+    const config::authority peer("1.2.3.4:8333");
+    configuration.blacklists.push_back(peer);
+    admission instance(configuration, make_connections(), make_memory());
+    BOOST_REQUIRE_EQUAL(instance.admit(peer), error::address_blocked);
+}
+
+BOOST_AUTO_TEST_CASE(admission__admit__no_connections__accept_failed)
+{
+    network::settings configuration;
+    configuration.inbound_connections = 0;
+    configuration.outbound_connections = 0;
+    admission instance(configuration, make_connections(), make_memory());
+    const config::authority peer("1.2.3.4:8333");
+    BOOST_REQUIRE_EQUAL(instance.admit(peer), error::accept_failed);
+}
+
+BOOST_AUTO_TEST_CASE(admission__admit__subnet_exhausted__address_blocked)
+{
+    network::settings configuration;
+    configuration.inbound_subnet_accepts = 2;
+    admission instance(configuration, make_connections(), make_memory());
+    BOOST_REQUIRE_EQUAL(instance.admit({ "1.2.3.4:8333" }), error::success);
+    BOOST_REQUIRE_EQUAL(instance.admit({ "1.2.3.5:8333" }), error::success);
+    BOOST_REQUIRE_EQUAL(instance.admit({ "1.2.3.6:8333" }), error::address_blocked);
+
+    // Another /24 has its own allowance.
+    BOOST_REQUIRE_EQUAL(instance.admit({ "1.2.4.4:8333" }), error::success);
+}
+
+BOOST_AUTO_TEST_CASE(admission__admit__rate_disabled__success)
+{
+    network::settings configuration;
+    configuration.inbound_subnet_accepts = 0;
+    admission instance(configuration, make_connections(), make_memory());
+
+    for (auto count = 0; count < 100; ++count)
+        BOOST_REQUIRE_EQUAL(instance.admit({ "1.2.3.4:8333" }), error::success);
+}
+
+BOOST_AUTO_TEST_CASE(admission__select_eviction__empty__none)
+{
+    BOOST_REQUIRE_EQUAL(admission::select_eviction({}), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(admission__select_eviction__all_protected__none)
+{
+    admission::candidate::list candidates;
+
+    // Four are protected by ping and four by useful bytes.
+    for (uint8_t index = 0; index < 8; ++index)
+        candidates.push_back(make_candidate(index, 100 + index, index, 1000));
+
+    BOOST_REQUIRE_EQUAL(admission::select_eviction(candidates), 8u);
+}
+
+BOOST_AUTO_TEST_CASE(admission__select_eviction__crowded_netgroup__youngest)
+{
+    admission::candidate::list candidates;
+
+    // Protected by ping.
+    for (uint8_t index = 0; index < 4; ++index)
+        candidates.push_back(make_candidate(index, 10, 0, 1000));
+
+    // Protected by useful bytes.
+    for (uint8_t index = 4; index < 8; ++index)
+        candidates.push_back(make_candidate(index, 0, 1000, 1000));
+
+    // Two old peers protected by age, leaving a crowded group and a loner.
+    candidates.push_back(make_candidate(20, 0, 0, 900));
+    candidates.push_back(make_candidate(21, 0, 0, 900));
+    candidates.push_back(make_candidate(30, 0, 0, 50));
+    candidates.push_back(make_candidate(31, 0, 0, 20));
+    candidates.push_back(make_candidate(31, 0, 0, 40));
+
+    BOOST_REQUIRE_EQUAL(admission::select_eviction(candidates), 11u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
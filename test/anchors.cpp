@@ -0,0 +1,96 @@
+/**
+ * Copyright (c) 2011-2016 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/filesystem.hpp>
+#include <boost/test/unit_test.hpp>
+#include <bitcoin/network.hpp>
+
+using namespace bc;
+using namespace bc::network;
+
+#define TEST_FILE "anchors_tests.cache"
+
+struct anchors_fixture
+{
+    anchors_fixture()
+    {
+        boost::filesystem::remove(TEST_FILE);
+    }
+
+    ~anchors_fixture()
+    {
+        boost::filesystem::remove(TEST_FILE);
+    }
+};
+
+BOOST_FIXTURE_TEST_SUITE(anchors_tests, anchors_fixture)
+
+BOOST_AUTO_TEST_CASE(anchors__load__missing_file__success_empty)
+{
+    const anchors instance(TEST_FILE, 4);
+    config::authority::list out{ config::authority("1.2.3.4:8333") };
+    BOOST_REQUIRE_EQUAL(instance.load(out), error::success);
+    BOOST_REQUIRE(out.empty());
+}
+
+BOOST_AUTO_TEST_CASE(anchors__load__saved__round_trip_and_removed)
+{
+    const anchors instance(TEST_FILE, 4);
+    const config::authority::list saved
+    {
+        config::authority("1.2.3.4:8333"),
+        config::authority("5.6.7.8:18333")
+    };
+
+    BOOST_REQUIRE_EQUAL(instance.save(saved), error::success);
+
+    config::authority::list out;
+    BOOST_REQUIRE_EQUAL(instance.load(out), error::success);
+    BOOST_REQUIRE_EQUAL(out.size(), 2u);
+    BOOST_REQUIRE(out[0] == saved[0]);
+    BOOST_REQUIRE(out[1] == saved[1]);
+    BOOST_REQUIRE(!boost::filesystem::exists(TEST_FILE));
+}
+
+BOOST_AUTO_TEST_CASE(anchors__save__over_capacity__truncated)
+{
+    const anchors instance(TEST_FILE, 1);
+    const config::authority::list saved
+    {
+        config::authority("1.2.3.4:8333"),
+        config::authority("5.6.7.8:8333")
+    };
+
+    BOOST_REQUIRE_EQUAL(instance.save(saved), error::success);
+
+    config::authority::list out;
+    BOOST_REQUIRE_EQUAL(instance.load(out), error::success);
+    BOOST_REQUIRE_EQUAL(out.size(), 1u);
+    BOOST_REQUIRE(out[0] == saved[0]);
+}
+
+BOOST_AUTO_TEST_CASE(anchors__save__zero_capacity__no_file)
+{
+    const anchors instance(TEST_FILE, 0);
+    const config::authority::list saved{ config::authority("1.2.3.4:8333") };
+    BOOST_REQUIRE_EQUAL(instance.save(saved), error::success);
+    BOOST_REQUIRE(!boost::filesystem::exists(TEST_FILE));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,65 @@
+/**
+ * Copyright (c) 2011-2016 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NETWORK_BENCHMARK_HPP
+#define LIBBITCOIN_NETWORK_BENCHMARK_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace libbitcoin {
+namespace network {
+namespace benchmark {
+
+/// The benchmark body, returns a value that must not be optimized away.
+typedef std::function<uint64_t()> body;
+
+/// Run the body repeatedly for at least a minimum wall time and write one
+/// result line of iterations, nanoseconds per iteration and throughput.
+void measure(const std::string& name, size_t bytes_per_iteration,
+    body function);
+
+/// Write one result line of item count, item rate, throughput and the
+/// median, 99th percentile and maximum of the latency samples.
+void report(const std::string& name, size_t bytes_per_item,
+    std::vector<uint64_t>& latency_nanoseconds, uint64_t elapsed_nanoseconds);
+
+/// Checksum kernels compared to bitcoin_checksum.
+void checksum();
+
+/// Heading parse, payload checksum, subscriber dispatch and loopback send.
+void pipeline();
+
+/// Subscriber load of each message of a capture file, by command.
+void replay(const std::string& file);
+
+/// Handshakes and message rounds with up to 10,000 in-process peers.
+void scale();
+
+/// Handshakes and pings with in-process peers over simulated links.
+void simulate();
+
+} // namespace benchmark
+} // namespace network
+} // namespace libbitcoin
+
+#endif
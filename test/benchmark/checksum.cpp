@@ -0,0 +1,84 @@
+/**
+ * Copyright (c) 2011-2016 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "benchmark.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network.hpp>
+
+namespace libbitcoin {
+namespace network {
+namespace benchmark {
+
+typedef message_checksum::kernel kernel;
+
+static const std::string to_name(kernel value)
+{
+    switch (value)
+    {
+        case kernel::sha_ni:
+            return "sha_ni";
+        case kernel::generic:
+        default:
+            return "generic";
+    }
+}
+
+// Payload sizes of ping, a single entry inv, a typical tx and a full block.
+void checksum()
+{
+    const size_t sizes[] = { 8, 37, 250, 1000000 };
+    const kernel kernels[] = { kernel::generic, kernel::sha_ni };
+    const auto original = message_checksum::active_kernel();
+
+    for (const auto size: sizes)
+    {
+        data_chunk payload(size);
+        for (size_t index = 0; index < size; ++index)
+            payload[index] = static_cast<uint8_t>(index);
+
+        const auto suffix = " " + std::to_string(size) + "B";
+
+        measure("bitcoin_checksum" + suffix, size, [&payload]()
+        {
+            return bitcoin_checksum(payload);
+        });
+
+        for (const auto value: kernels)
+        {
+            if (!message_checksum::select_kernel(value))
+                continue;
+
+            measure("message_checksum/" + to_name(value) + suffix, size,
+                [&payload]()
+                {
+                    return message_checksum::compute(payload);
+                });
+        }
+    }
+
+    message_checksum::select_kernel(original);
+}
+
+} // namespace benchmark
+} // namespace network
+} // namespace libbitcoin
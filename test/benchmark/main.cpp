@@ -0,0 +1,150 @@
+/**
+ * Copyright (c) 2011-2016 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "benchmark.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace libbitcoin {
+namespace network {
+namespace benchmark {
+
+using namespace std::chrono;
+
+// Each result is taken over at least this much wall time.
+static const auto minimum_duration = milliseconds(500);
+
+// The sum of all body results, so that no body is optimized away.
+static volatile uint64_t sink = 0;
+
+void measure(const std::string& name, size_t bytes_per_iteration,
+    body function)
+{
+    // Warm up caches and allow lazy initialization.
+    sink = sink + function();
+
+    size_t iterations = 0;
+    const auto start = steady_clock::now();
+    auto elapsed = steady_clock::duration::zero();
+
+    // Batches amortize the clock reads over short bodies.
+    for (size_t batch = 1; elapsed < minimum_duration; batch *= 2)
+    {
+        for (size_t count = 0; count < batch; ++count)
+            sink = sink + function();
+
+        iterations += batch;
+        elapsed = steady_clock::now() - start;
+    }
+
+    const auto nanoseconds = duration_cast<std::chrono::nanoseconds>(
+        elapsed).count();
+    const auto per_iteration = static_cast<double>(nanoseconds) / iterations;
+    const auto megabytes_per_second = per_iteration == 0.0 ? 0.0 :
+        bytes_per_iteration * 1000.0 / per_iteration;
+
+    std::cout << std::left << std::setw(40) << name << std::right
+        << std::setw(12) << iterations << " iterations "
+        << std::fixed << std::setprecision(1)
+        << std::setw(12) << per_iteration << " ns/op ";
+
+    if (bytes_per_iteration != 0)
+        std::cout << std::setw(10) << megabytes_per_second << " MB/s";
+
+    std::cout << std::endl;
+}
+
+void report(const std::string& name, size_t bytes_per_item,
+    std::vector<uint64_t>& latency_nanoseconds, uint64_t elapsed_nanoseconds)
+{
+    auto& samples = latency_nanoseconds;
+    std::sort(samples.begin(), samples.end());
+
+    const auto count = samples.size();
+    const auto percentile = [&samples, count](size_t percent)
+    {
+        return count == 0 ? 0.0 :
+            samples[(count - 1) * percent / 100] / 1000.0;
+    };
+
+    const auto seconds = elapsed_nanoseconds / 1e9;
+    const auto per_second = seconds == 0.0 ? 0.0 : count / seconds;
+    const auto megabytes_per_second = per_second * bytes_per_item / 1e6;
+
+    std::cout << std::left << std::setw(40) << name << std::right
+        << std::setw(12) << count << " messages "
+        << std::fixed << std::setprecision(1)
+        << std::setw(12) << per_second << " msg/s "
+        << std::setw(10) << megabytes_per_second << " MB/s"
+        << " p50 " << percentile(50) << "us"
+        << " p99 " << percentile(99) << "us"
+        << " max " << percentile(100) << "us" << std::endl;
+}
+
+} // namespace benchmark
+} // namespace network
+} // namespace libbitcoin
+
+// Run the default benchmarks, or only those named on the command line.
+// The scale and simulate benchmarks open thousands of sockets and run only
+// when named.
+int main(int argc, char* argv[])
+{
+    using namespace libbitcoin::network;
+
+    const auto named = [argc, argv](const std::string& name)
+    {
+        for (auto arg = 1; arg < argc; ++arg)
+            if (name == argv[arg])
+                return true;
+
+        return false;
+    };
+
+    const auto selected = [argc, &named](const std::string& name)
+    {
+        return argc < 2 || named(name);
+    };
+
+    if (selected("checksum"))
+        benchmark::checksum();
+
+    if (selected("pipeline"))
+        benchmark::pipeline();
+
+    // The replay benchmark reads the capture file that follows its name.
+    for (auto arg = 1; arg + 1 < argc; ++arg)
+        if (std::string(argv[arg]) == "replay")
+            benchmark::replay(argv[arg + 1]);
+
+    if (named("scale"))
+        benchmark::scale();
+
+    if (named("simulate"))
+        benchmark::simulate();
+
+    return 0;
+}
@@ -0,0 +1,340 @@
+/**
+ * Copyright (c) 2011-2016 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "benchmark.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <istream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include <boost/iostreams/stream.hpp>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+using namespace bc::message;
+using namespace std::chrono;
+
+namespace benchmark {
+
+typedef std::pair<network::socket::ptr, network::socket::ptr> socket_pair;
+typedef byte_source<heading::buffer> heading_source;
+typedef boost::iostreams::stream<heading_source> heading_stream;
+
+// The proxy reads payloads in chunks of this size.
+static const size_t chunk_size = 64 * 1024;
+
+// Representative messages.
+// ----------------------------------------------------------------------------
+
+static void write_variable(data_chunk& out, uint64_t value)
+{
+    const auto write = [&out](uint64_t bytes, size_t size)
+    {
+        for (size_t index = 0; index < size; ++index)
+            out.push_back(static_cast<uint8_t>(bytes >> (8 * index)));
+    };
+
+    if (value < 0xfd)
+        write(value, 1);
+    else if (value <= 0xffff)
+    {
+        out.push_back(0xfd);
+        write(value, 2);
+    }
+    else
+    {
+        out.push_back(0xfe);
+        write(value, 4);
+    }
+}
+
+static inventory make_inventory(size_t count)
+{
+    inventory_vector::list inventories(count);
+
+    for (size_t index = 0; index < count; ++index)
+    {
+        inventories[index].type = inventory_type_id::transaction;
+        inventories[index].hash = null_hash;
+        inventories[index].hash[0] = static_cast<uint8_t>(index);
+        inventories[index].hash[1] = static_cast<uint8_t>(index >> 8);
+    }
+
+    return inventory(inventories);
+}
+
+// A block of one coinbase transaction with a single large output script
+// composed of maximal data pushes, serialized to approximately size bytes.
+static block make_block(size_t size)
+{
+    static const size_t push = 520;
+    const auto pushes = size / (push + 3);
+
+    data_chunk data;
+    data.reserve(size + 256);
+
+    // Header: version, previous, merkle root, timestamp, bits and nonce.
+    data.insert(data.end(), { 0x01, 0x00, 0x00, 0x00 });
+    data.insert(data.end(), 64, 0x00);
+    data.insert(data.end(), { 0x29, 0xab, 0x5f, 0x49 });
+    data.insert(data.end(), { 0xff, 0xff, 0x00, 0x1d });
+    data.insert(data.end(), { 0x1d, 0xac, 0x2b, 0x7c });
+    write_variable(data, 1);
+
+    // Transaction version and the coinbase input.
+    data.insert(data.end(), { 0x01, 0x00, 0x00, 0x00 });
+    write_variable(data, 1);
+    data.insert(data.end(), 32, 0x00);
+    data.insert(data.end(), 4, 0xff);
+    write_variable(data, 5);
+    data.insert(data.end(), { 0x04, 0xff, 0xff, 0x00, 0x1d });
+    data.insert(data.end(), 4, 0xff);
+
+    // The output value and script.
+    write_variable(data, 1);
+    data.insert(data.end(), { 0x00, 0xf2, 0x05, 0x2a, 0x01, 0x00, 0x00, 0x00 });
+    write_variable(data, pushes * (push + 3));
+
+    for (size_t index = 0; index < pushes; ++index)
+    {
+        // OP_PUSHDATA2 with a little-endian length.
+        data.insert(data.end(), { 0x4d, static_cast<uint8_t>(push),
+            static_cast<uint8_t>(push >> 8) });
+        data.insert(data.end(), push, static_cast<uint8_t>(index));
+    }
+
+    // Transaction locktime.
+    data.insert(data.end(), 4, 0x00);
+
+    block instance;
+    instance.from_data(data);
+    return instance;
+}
+
+// Parse, checksum and dispatch.
+// ----------------------------------------------------------------------------
+
+static void heading_parse()
+{
+    const auto packet = serialize(ping(42), settings(bc::settings::mainnet)
+        .identifier);
+    heading::buffer buffer;
+    std::copy(packet.begin(), packet.begin() + buffer.size(), buffer.begin());
+
+    measure("heading/from_data", buffer.size(), [&buffer]()
+    {
+        heading head;
+        heading_stream istream(buffer);
+        head.from_data(istream);
+        return static_cast<uint64_t>(head.payload_size);
+    });
+}
+
+static void payload_checksum(const std::string& name, const data_chunk& payload)
+{
+    message_checksum checksum;
+
+    measure("checksum/" + name, payload.size(), [&payload, &checksum]()
+    {
+        for (size_t offset = 0; offset < payload.size(); offset += chunk_size)
+        {
+            const auto size = std::min(chunk_size, payload.size() - offset);
+            checksum.update(payload.data() + offset, size);
+        }
+
+        return static_cast<uint64_t>(checksum.finalize());
+    });
+}
+
+template <class Message>
+static void subscriber_load(const std::string& name, message_type type,
+    const Message& packet)
+{
+    // Inline delivery measures parse and dispatch without queueing.
+    threadpool pool(1);
+    message_subscriber subscriber(pool, { type });
+    subscriber.start();
+
+    size_t delivered = 0;
+    subscriber.subscribe<Message>(
+        [&delivered](const code& ec, std::shared_ptr<Message>)
+        {
+            ++delivered;
+            return !ec;
+        });
+
+    const auto payload = packet.to_data();
+    measure("load/" + name, payload.size(), [&subscriber, &payload, type]()
+    {
+        payload_streambuf source(payload);
+        std::istream istream(&source);
+        return static_cast<uint64_t>(subscriber.load(type, istream).value());
+    });
+
+    subscriber.stop();
+    subscriber.broadcast(error::channel_stopped);
+    pool.shutdown();
+    pool.join();
+}
+
+// Loopback channels.
+// ----------------------------------------------------------------------------
+
+static socket_pair connect_pair(threadpool& pool)
+{
+    const asio::endpoint loopback(asio::ipv4::loopback(), 0);
+    asio::acceptor acceptor(pool.service(), loopback);
+
+    const auto outbound = std::make_shared<network::socket>(pool);
+    const auto inbound = std::make_shared<network::socket>(pool);
+
+    outbound->get_socket()->get().connect(acceptor.local_endpoint());
+    acceptor.accept(inbound->get_socket()->get());
+    return { outbound, inbound };
+}
+
+// The sender keeps a window of messages in flight, sending one more as each
+// arrives, latency is measured from send to receipt by the subscriber.
+template <class Message>
+static void channel_send(const std::string& name, const Message& packet,
+    size_t count)
+{
+    static const size_t window = 16;
+
+    threadpool pool(2);
+    settings configuration(bc::settings::mainnet);
+    configuration.synchronous_messages.clear();
+    configuration.synchronous_messages.push_back(Message::command);
+    const auto buffers = std::make_shared<buffer_pool>(
+        configuration.buffer_pool_capacity);
+    const auto timers = std::make_shared<timer_wheel>(pool,
+        configuration.channel_timer(), 512);
+    timers->start();
+    const auto uploads = std::make_shared<token_bucket>(0, 0);
+    const auto memory = std::make_shared<memory_accounts>(0);
+
+    const auto sockets = connect_pair(pool);
+    const auto sender = std::make_shared<channel>(pool, sockets.first,
+        configuration, buffers, timers, uploads, memory);
+    const auto receiver = std::make_shared<channel>(pool, sockets.second,
+        configuration, buffers, timers, uploads, memory);
+
+    const auto ignore = [](const code&) {};
+    sender->start(ignore);
+    receiver->start(ignore);
+
+    // Inline delivery orders receipt on the read thread, matching send order.
+    // The window is opened here while receipts send, so each claims its index.
+    std::atomic<size_t> next(0);
+    std::atomic<bool> complete(false);
+    std::vector<std::atomic<steady_clock::rep>> sent(count);
+    std::vector<uint64_t> latency;
+    latency.reserve(count);
+    std::promise<void> finished;
+
+    const auto send_next = [&]()
+    {
+        const auto index = next.fetch_add(1);
+
+        if (index >= count)
+            return;
+
+        sent[index].store(steady_clock::now().time_since_epoch().count());
+        sender->send(packet, ignore);
+    };
+
+    receiver->subscribe<Message>([&](const code& ec, std::shared_ptr<Message>)
+    {
+        if (complete)
+            return false;
+
+        if (ec)
+        {
+            if (!complete.exchange(true))
+                finished.set_value();
+
+            return false;
+        }
+
+        const steady_clock::duration since(sent[latency.size()].load());
+        const auto elapsed = steady_clock::now().time_since_epoch() - since;
+        latency.push_back(duration_cast<nanoseconds>(elapsed).count());
+        send_next();
+
+        if (latency.size() < count)
+            return true;
+
+        if (!complete.exchange(true))
+            finished.set_value();
+
+        return false;
+    });
+
+    const auto start = steady_clock::now();
+
+    while (next < std::min(window, count))
+        send_next();
+
+    finished.get_future().wait();
+    const auto elapsed = duration_cast<nanoseconds>(steady_clock::now() - start);
+    report("send/" + name, serialize(packet, configuration.identifier).size(),
+        latency, elapsed.count());
+
+    sender->stop(error::channel_stopped);
+    receiver->stop(error::channel_stopped);
+    timers->stop();
+    pool.shutdown();
+    pool.join();
+}
+
+// Ping, an inventory of the maximum announcement size and a 1MB block.
+void pipeline()
+{
+    const ping small(42);
+    const auto medium = make_inventory(500);
+    const auto large = make_block(1000000);
+
+    heading_parse();
+
+    payload_checksum("ping", small.to_data());
+    payload_checksum("inv500", medium.to_data());
+    payload_checksum("block1MB", large.to_data());
+
+    subscriber_load("ping", message_type::ping, small);
+    subscriber_load("inv500", message_type::inventory, medium);
+    subscriber_load("block1MB", message_type::block, large);
+
+    channel_send("ping", small, 100000);
+    channel_send("inv500", medium, 20000);
+    channel_send("block1MB", large, 200);
+}
+
+} // namespace benchmark
+} // namespace network
+} // namespace libbitcoin
@@ -0,0 +1,214 @@
+/**
+ * Copyright (c) 2011-2016 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "benchmark.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <new>
+#include <string>
+#include <vector>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network.hpp>
+
+// The allocations made on each thread, counted by the replaced global
+// operator new. This applies to the whole benchmark program.
+static thread_local size_t thread_allocations = 0;
+
+void* operator new(std::size_t size)
+{
+    ++thread_allocations;
+    const auto memory = std::malloc(size == 0 ? 1 : size);
+
+    if (memory == nullptr)
+        throw std::bad_alloc();
+
+    return memory;
+}
+
+void operator delete(void* memory) noexcept
+{
+    std::free(memory);
+}
+
+namespace libbitcoin {
+namespace network {
+
+using namespace bc::message;
+using namespace std::chrono;
+
+namespace benchmark {
+
+// The number of times the whole capture is replayed, after one warm up.
+static const size_t replay_passes = 5;
+
+// The command follows the magic in the heading.
+static const size_t command_offset = 4;
+
+#define SUBSCRIBE_COUNTER(value, command) \
+    subscriber.subscribe<message::value>( \
+        [&delivered](const code& ec, message::value::ptr) \
+        { \
+            ++delivered; \
+            return !ec; \
+        });
+
+#define SYNCHRONOUS_TYPE(value, command) \
+    message_type::value,
+
+// The totals of one command over all passes.
+struct command_totals
+{
+    size_t messages;
+    size_t bytes;
+    size_t allocations;
+    size_t failures;
+    uint64_t nanoseconds;
+};
+
+static message_subscriber::command_field to_command(
+    const heading::buffer& heading)
+{
+    message_subscriber::command_field command;
+    const auto begin = heading.begin() + command_offset;
+    std::copy(begin, begin + command.size(), command.begin());
+    return command;
+}
+
+static std::string to_text(const message_subscriber::command_field& command)
+{
+    std::string text(command.begin(), command.end());
+    return text.substr(0, text.find('\0'));
+}
+
+// Feed each captured payload through the subscriber load of its command
+// type, with every type subscribed and delivered inline.
+void replay(const std::string& file)
+{
+    bc::ifstream stream(file, std::ios::binary);
+    if (!stream.good() || !traffic_capture::read_header(stream))
+    {
+        std::cout << "replay " << file << " is not a capture file"
+            << std::endl;
+        return;
+    }
+
+    // The capture is read first, so that the file is not measured.
+    std::vector<traffic_capture::record> records;
+    traffic_capture::record record;
+    while (traffic_capture::read(stream, record))
+        records.push_back(record);
+
+    threadpool pool(1);
+    message_subscriber subscriber(pool,
+        { MESSAGE_SUBSCRIBER_TYPES(SYNCHRONOUS_TYPE) });
+    subscriber.start();
+
+    size_t delivered = 0;
+    MESSAGE_SUBSCRIBER_TYPES(SUBSCRIBE_COUNTER)
+
+    std::map<std::string, command_totals> totals;
+    uint64_t elapsed = 0;
+
+    for (size_t pass = 0; pass <= replay_passes; ++pass)
+    {
+        for (const auto& captured: records)
+        {
+            const auto command = to_command(captured.heading);
+            const auto type = message_subscriber::to_type(command);
+            const auto allocations = thread_allocations;
+            const auto start = steady_clock::now();
+
+            payload_streambuf source(captured.payload);
+            std::istream istream(&source);
+            const auto ec = type == message_type::unknown ?
+                subscriber.load(command, istream) :
+                subscriber.load(type, istream);
+
+            const auto nanoseconds = duration_cast<std::chrono::nanoseconds>(
+                steady_clock::now() - start).count();
+            const auto allocated = thread_allocations - allocations;
+
+            // The first pass warms caches and allows lazy initialization.
+            if (pass == 0)
+                continue;
+
+            auto& entry = totals[to_text(command)];
+            ++entry.messages;
+            entry.bytes += captured.payload.size();
+            entry.allocations += allocated;
+            entry.failures += ec ? 1 : 0;
+            entry.nanoseconds += nanoseconds;
+            elapsed += nanoseconds;
+        }
+    }
+
+    std::cout << "replay " << file << " records " << records.size()
+        << " passes " << replay_passes << " delivered " << delivered
+        << std::endl;
+
+    size_t messages = 0;
+    size_t bytes = 0;
+
+    for (const auto& entry: totals)
+    {
+        const auto& value = entry.second;
+        const auto seconds = value.nanoseconds / 1e9;
+        messages += value.messages;
+        bytes += value.bytes;
+
+        std::cout << std::left << std::setw(40) << "replay/" + entry.first
+            << std::right << std::setw(12) << value.messages << " messages "
+            << std::fixed << std::setprecision(1)
+            << std::setw(12) << (seconds == 0.0 ? 0.0 :
+                value.messages / seconds) << " msg/s "
+            << std::setw(10) << (seconds == 0.0 ? 0.0 :
+                value.bytes / seconds / 1e6) << " MB/s "
+            << std::setw(8) << static_cast<double>(value.allocations) /
+                value.messages << " allocs/msg"
+            << " failed " << value.failures << std::endl;
+    }
+
+    const auto seconds = elapsed / 1e9;
+    std::cout << std::left << std::setw(40) << "replay/total" << std::right
+        << std::setw(12) << messages << " messages "
+        << std::fixed << std::setprecision(1)
+        << std::setw(12) << (seconds == 0.0 ? 0.0 : messages / seconds)
+        << " msg/s "
+        << std::setw(10) << (seconds == 0.0 ? 0.0 : bytes / seconds / 1e6)
+        << " MB/s" << std::endl;
+
+    subscriber.stop();
+    subscriber.broadcast(error::channel_stopped);
+    pool.shutdown();
+    pool.join();
+}
+
+#undef SUBSCRIBE_COUNTER
+#undef SYNCHRONOUS_TYPE
+
+} // namespace benchmark
+} // namespace network
+} // namespace libbitcoin
@@ -0,0 +1,403 @@
+/**
+ * Copyright (c) 2011-2016 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "benchmark.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <fstream>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <boost/filesystem.hpp>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network.hpp>
+
+#ifdef __linux__
+    #include <unistd.h>
+#endif
+
+namespace libbitcoin {
+namespace network {
+
+using namespace bc::message;
+using namespace std::chrono;
+using std::placeholders::_1;
+
+namespace benchmark {
+
+#define NAME "scale"
+
+// The node listens here, each phase reuses the address.
+static const uint16_t benchmark_port = 28444;
+
+// The number of peer connections that may be incomplete at one time.
+static const size_t connect_window = 256;
+
+// The number of ping/inv rounds each peer sends after its handshake.
+static const size_t rounds_per_peer = 10;
+
+// Each round is a ping and inv from the peer and a pong from the node.
+static const size_t messages_per_round = 3;
+
+// The rounds of a phase are abandoned if not complete within this time.
+static const seconds rounds_timeout(120);
+
+// The resident set size of this process, zero where unavailable.
+static size_t resident_bytes()
+{
+#ifdef __linux__
+    size_t total = 0;
+    size_t resident = 0;
+    std::ifstream statm("/proc/self/statm");
+    statm >> total >> resident;
+    return resident * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#else
+    return 0;
+#endif
+}
+
+static double cpu_seconds()
+{
+    return static_cast<double>(std::clock()) / CLOCKS_PER_SEC;
+}
+
+static code wait(std::function<void(p2p::result_handler)> call)
+{
+    std::promise<code> promise;
+    call([&promise](const code& ec) { promise.set_value(ec); });
+    return promise.get_future().get();
+}
+
+// The state shared by all synthetic peers of a phase.
+struct swarm
+{
+    size_t count;
+    uint16_t port;
+    connector::ptr connect;
+    std::atomic<size_t> next;
+    std::atomic<size_t> handshaken;
+    std::atomic<size_t> failed;
+    std::atomic<size_t> finished;
+    std::atomic<size_t> connected;
+    std::promise<void> handshakes_done;
+    std::promise<void> rounds_done;
+    std::vector<uint64_t> handshake_latency;
+    std::vector<channel::ptr> peers;
+    mutable shared_mutex mutex;
+};
+
+typedef std::shared_ptr<swarm> swarm_ptr;
+
+static version make_version(uint64_t nonce)
+{
+    version self;
+    self.value = bc::protocol_version;
+    self.services = 0;
+    self.timestamp = 0;
+    self.address_me = bc::unspecified_network_address;
+    self.address_you = bc::unspecified_network_address;
+    self.nonce = nonce;
+    self.user_agent = "/libbitcoin-network-benchmark/";
+    self.start_height = 0;
+    self.relay = false;
+    return self;
+}
+
+static void connect_next(swarm_ptr peers);
+
+// True if the peer completed its handshake, and so trades rounds.
+static bool joined(swarm_ptr peers, channel::ptr peer)
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    shared_lock lock(peers->mutex);
+    const auto& list = peers->peers;
+    return std::find(list.begin(), list.end(), peer) != list.end();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// The count of connected peers is set before the first round is sent.
+static void finish_rounds(swarm_ptr peers)
+{
+    if (++peers->finished == peers->connected)
+        peers->rounds_done.set_value();
+}
+
+static void handshake_complete(swarm_ptr peers, const code& ec,
+    channel::ptr peer, steady_clock::time_point start)
+{
+    if (ec)
+        ++peers->failed;
+    else
+    {
+        const auto elapsed = steady_clock::now() - start;
+
+        ///////////////////////////////////////////////////////////////////////
+        // Critical Section
+        unique_lock lock(peers->mutex);
+        peers->handshake_latency.push_back(
+            duration_cast<nanoseconds>(elapsed).count());
+        peers->peers.push_back(peer);
+        ///////////////////////////////////////////////////////////////////////
+    }
+
+    if (++peers->handshaken == peers->count)
+        peers->handshakes_done.set_value();
+
+    connect_next(peers);
+}
+
+static void send_round(channel::ptr peer, uint64_t nonce)
+{
+    const auto ignore = [](const code&) {};
+    inventory_vector::list inventories(1);
+    inventories.front().type = inventory_type_id::transaction;
+    inventories.front().hash = null_hash;
+
+    peer->send(inventory(inventories), ignore);
+    peer->send(ping(nonce), ignore);
+}
+
+static void start_peer(swarm_ptr peers, const code& ec, channel::ptr peer,
+    uint64_t nonce, steady_clock::time_point start)
+{
+    if (ec)
+    {
+        handshake_complete(peers, ec, nullptr, start);
+        return;
+    }
+
+    const auto ignore = [](const code&) {};
+    const proxy::result_handler handshake = synchronize(
+        std::bind(handshake_complete, peers, _1, peer, start), 2, NAME, false);
+
+    peer->subscribe<version>(
+        [peer, handshake](const code& ec, version::ptr)
+        {
+            if (!ec)
+                peer->send(verack(), [](const code&) {});
+
+            handshake(ec);
+            return false;
+        });
+
+    peer->subscribe<verack>(
+        [handshake](const code& ec, verack::ptr)
+        {
+            handshake(ec);
+            return false;
+        });
+
+    // The node may ping on its heartbeat.
+    peer->subscribe<ping>(
+        [peer](const code& ec, ping::ptr message)
+        {
+            if (ec)
+                return false;
+
+            peer->send(pong(message->nonce), [](const code&) {});
+            return true;
+        });
+
+    // Each pong completes a round, the next round is sent until done. A
+    // connected peer that drops is done, so that the phase completes.
+    const auto rounds = std::make_shared<size_t>(0);
+    peer->subscribe<pong>(
+        [peers, peer, rounds](const code& ec, pong::ptr message)
+        {
+            if (ec)
+            {
+                if (joined(peers, peer))
+                    finish_rounds(peers);
+
+                return false;
+            }
+
+            if (++(*rounds) < rounds_per_peer)
+            {
+                send_round(peer, message->nonce + 1);
+                return true;
+            }
+
+            finish_rounds(peers);
+            return false;
+        });
+
+    peer->start(ignore);
+    peer->send(make_version(nonce), ignore);
+}
+
+static void connect_next(swarm_ptr peers)
+{
+    const auto index = peers->next++;
+    if (index >= peers->count)
+        return;
+
+    // The nonce must not match the node's own connection nonce.
+    const auto nonce = (uint64_t(0x5ca1e) << 32) | index;
+    const auto start = steady_clock::now();
+    peers->connect->connect("127.0.0.1", peers->port,
+        std::bind(start_peer, peers, _1, std::placeholders::_2, nonce, start));
+}
+
+// Connect count peers to a fresh node, handshake, then trade rounds.
+static void phase(size_t count)
+{
+    const auto threads = std::max(1u, std::thread::hardware_concurrency());
+
+    settings configuration(bc::settings::mainnet);
+    configuration.threads = threads;
+    configuration.inbound_port = benchmark_port;
+    configuration.inbound_connections = static_cast<uint32_t>(count);
+    configuration.outbound_connections = 0;
+    configuration.manual_attempt_limit = 0;
+    configuration.host_pool_capacity = 0;
+    configuration.channel_handshake_seconds = 60;
+    configuration.connect_timeout_seconds = 60;
+    configuration.seeds.clear();
+    configuration.hosts_file = "benchmark.hosts";
+
+    p2p node(configuration);
+    if (wait(std::bind(&p2p::start, &node, _1)) ||
+        wait(std::bind(&p2p::run, &node, _1)))
+    {
+        std::cout << "scale/" << count << " failed to start node" << std::endl;
+        return;
+    }
+
+    threadpool pool(threads);
+    const auto buffers = std::make_shared<buffer_pool>(
+        configuration.buffer_pool_capacity);
+
+    const auto peers = std::make_shared<swarm>();
+    peers->count = count;
+    peers->port = benchmark_port;
+    const auto affinity = std::make_shared<affinity_pool>(pool, 0);
+    const auto resolved = std::make_shared<resolver_cache>(0);
+    const auto timers = std::make_shared<timer_wheel>(pool,
+        configuration.channel_timer(), 512);
+    timers->start();
+    const auto uploads = std::make_shared<token_bucket>(0, 0);
+    const auto memory = std::make_shared<memory_accounts>(0);
+    const auto dispatches = std::make_shared<dispatch_monitor>();
+    peers->connect = std::make_shared<connector>(pool, configuration, buffers,
+        affinity, resolved, timers, uploads, memory, dispatches);
+    peers->next = 0;
+    peers->handshaken = 0;
+    peers->failed = 0;
+    peers->finished = 0;
+    peers->connected = 0;
+    peers->handshake_latency.reserve(count);
+    peers->peers.reserve(count);
+
+    const auto resident_start = resident_bytes();
+    const auto accept_start = steady_clock::now();
+
+    for (size_t peer = 0; peer < std::min(connect_window, count); ++peer)
+        connect_next(peers);
+
+    peers->handshakes_done.get_future().wait();
+    const auto accept_elapsed = duration_cast<nanoseconds>(
+        steady_clock::now() - accept_start).count();
+    const auto resident = resident_bytes() - resident_start;
+
+    std::vector<channel::ptr> connected_peers;
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    peers->mutex.lock_shared();
+    connected_peers = peers->peers;
+    peers->mutex.unlock_shared();
+    ///////////////////////////////////////////////////////////////////////////
+
+    // Trade rounds on every connected peer, measuring CPU per message.
+    const auto connected = connected_peers.size();
+    peers->connected = connected;
+    const auto cpu_start = cpu_seconds();
+    const auto rounds_start = steady_clock::now();
+
+    if (connected == 0)
+        peers->rounds_done.set_value();
+
+    for (size_t index = 0; index < connected; ++index)
+        send_round(connected_peers[index], index);
+
+    const auto done = peers->rounds_done.get_future().wait_for(
+        rounds_timeout) == std::future_status::ready;
+
+    if (!done)
+        std::cout << "scale/" << count << " rounds timed out" << std::endl;
+
+    const auto rounds_elapsed = duration_cast<nanoseconds>(
+        steady_clock::now() - rounds_start).count();
+    const auto messages = connected * rounds_per_peer * messages_per_round;
+    const auto cpu = cpu_seconds() - cpu_start;
+
+    const auto accept_seconds = accept_elapsed / 1e9;
+    const auto rounds_seconds = rounds_elapsed / 1e9;
+    const auto per_connection = connected == 0 ? 0.0 :
+        static_cast<double>(resident) / connected / 1024;
+    const auto cpu_per_message = messages == 0 ? 0.0 : cpu * 1e6 / messages;
+    std::cout << std::fixed << std::setprecision(1)
+        << "scale/" << count << " connected " << connected
+        << " failed " << peers->failed
+        << " accept " << connected / accept_seconds << "/s"
+        << " messages " << messages / rounds_seconds << "/s"
+        << " rss/connection " << per_connection << "KB"
+        << " cpu/message " << cpu_per_message << "us"
+        << " (both ends, in process)" << std::endl;
+
+    report("scale/" + std::to_string(count) + "/handshake", 0,
+        peers->handshake_latency, accept_elapsed);
+
+    for (const auto peer: connected_peers)
+        peer->stop(error::channel_stopped);
+
+    peers->connect->stop();
+    timers->stop();
+    wait(std::bind(&p2p::stop, &node, _1));
+    pool.shutdown();
+    pool.join();
+    boost::filesystem::remove(configuration.hosts_file);
+}
+
+// Connection counts from 100 to 10,000, each phase requires two file
+// descriptors per connection (ulimit -n).
+void scale()
+{
+    const size_t counts[] = { 100, 300, 1000, 3000, 10000 };
+
+    for (const auto count: counts)
+        phase(count);
+}
+
+#undef NAME
+
+} // namespace benchmark
+} // namespace network
+} // namespace libbitcoin
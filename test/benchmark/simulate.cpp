@@ -0,0 +1,359 @@
+/**
+ * Copyright (c) 2011-2016 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "benchmark.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <boost/filesystem.hpp>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network.hpp>
+#include "simulator.hpp"
+
+namespace libbitcoin {
+namespace network {
+
+using namespace bc::message;
+using namespace std::chrono;
+using std::placeholders::_1;
+
+namespace benchmark {
+
+#define NAME "simulate"
+
+// The number of pings each peer sends after its handshake.
+static const size_t rounds_per_peer = 10;
+
+// The seed of the first link, each link adds its index.
+static const uint64_t simulation_seed = 42;
+
+static code wait(std::function<void(p2p::result_handler)> call)
+{
+    std::promise<code> promise;
+    call([&promise](const code& ec) { promise.set_value(ec); });
+    return promise.get_future().get();
+}
+
+// The state shared by all simulated peers of a phase.
+struct simulation
+{
+    size_t count;
+    std::atomic<size_t> handshaken;
+    std::atomic<size_t> failed;
+    std::atomic<size_t> finished;
+    std::promise<void> handshakes_done;
+    std::promise<void> rounds_done;
+    std::vector<uint64_t> handshake_latency;
+    std::vector<uint64_t> ping_latency;
+    std::vector<channel::ptr> peers;
+    std::vector<channel::ptr> nodes;
+    std::vector<simulated_link::ptr> links;
+    link_totals totals;
+    mutable shared_mutex mutex;
+};
+
+typedef std::shared_ptr<simulation> simulation_ptr;
+
+static version make_version(uint64_t nonce)
+{
+    version self;
+    self.value = bc::protocol_version;
+    self.services = 0;
+    self.timestamp = 0;
+    self.address_me = bc::unspecified_network_address;
+    self.address_you = bc::unspecified_network_address;
+    self.nonce = nonce;
+    self.user_agent = "/libbitcoin-network-simulator/";
+    self.start_height = 0;
+    self.relay = false;
+    return self;
+}
+
+static void handshake_complete(simulation_ptr state, const code& ec,
+    channel::ptr peer, steady_clock::time_point start)
+{
+    if (ec)
+        ++state->failed;
+    else
+    {
+        const auto elapsed = steady_clock::now() - start;
+
+        ///////////////////////////////////////////////////////////////////////
+        // Critical Section
+        unique_lock lock(state->mutex);
+        state->handshake_latency.push_back(
+            duration_cast<nanoseconds>(elapsed).count());
+        state->peers.push_back(peer);
+        ///////////////////////////////////////////////////////////////////////
+    }
+
+    if (++state->handshaken == state->count)
+        state->handshakes_done.set_value();
+}
+
+// The node end runs the library handshake and ping protocols.
+static void start_node(p2p& node, simulation_ptr state, channel::ptr local,
+    channel::ptr peer, steady_clock::time_point start)
+{
+    const auto handshake = [&node, state, local, peer, start](const code& ec)
+    {
+        if (!ec)
+            std::make_shared<protocol_ping>(node, local)->start();
+
+        handshake_complete(state, ec, peer, start);
+    };
+
+    local->set_inbound(true);
+    local->set_nonce(nonzero_pseudo_random());
+    local->start(
+        [&node, local, handshake](const code& ec)
+        {
+            if (ec)
+            {
+                handshake(ec);
+                return;
+            }
+
+            std::make_shared<protocol_version>(node, local)->start(handshake);
+        });
+}
+
+// The peer end answers the handshake and pings, and times its own pings.
+static void start_peer(simulation_ptr state, channel::ptr peer,
+    uint64_t nonce)
+{
+    const auto ignore = [](const code&) {};
+
+    peer->subscribe<version>(
+        [peer](const code& ec, version::ptr)
+        {
+            if (!ec)
+                peer->send(verack(), [](const code&) {});
+
+            return false;
+        });
+
+    peer->subscribe<ping>(
+        [peer](const code& ec, ping::ptr message)
+        {
+            if (ec)
+                return false;
+
+            peer->send(pong(message->nonce), [](const code&) {});
+            return true;
+        });
+
+    peer->start(ignore);
+    peer->send(make_version(nonce), ignore);
+}
+
+static void send_ping(simulation_ptr state, channel::ptr peer,
+    uint64_t nonce, size_t round)
+{
+    const auto sent = steady_clock::now();
+
+    peer->subscribe<pong>(
+        [state, peer, nonce, round, sent](const code& ec, pong::ptr)
+        {
+            if (ec)
+                return false;
+
+            const auto elapsed = steady_clock::now() - sent;
+
+            ///////////////////////////////////////////////////////////////////
+            // Critical Section
+            unique_lock lock(state->mutex);
+            state->ping_latency.push_back(
+                duration_cast<nanoseconds>(elapsed).count());
+            lock.unlock();
+            ///////////////////////////////////////////////////////////////////
+
+            if (round + 1 < rounds_per_peer)
+                send_ping(state, peer, nonce + 1, round + 1);
+            else if (++state->finished == state->peers.size())
+                state->rounds_done.set_value();
+
+            return false;
+        });
+
+    peer->send(ping(nonce), [](const code&) {});
+}
+
+// Link count peers to a fresh node over simulated links, handshake, then
+// time ping rounds.
+static void phase(const link_profile& profile, size_t count)
+{
+    const auto threads = std::max(1u, std::thread::hardware_concurrency());
+
+    // The node accepts no connections, all channels arrive over links.
+    settings configuration(bc::settings::mainnet);
+    configuration.threads = threads;
+    configuration.inbound_port = 0;
+    configuration.inbound_connections = 0;
+    configuration.outbound_connections = 0;
+    configuration.manual_attempt_limit = 0;
+    configuration.host_pool_capacity = 0;
+    configuration.channel_handshake_seconds = 60;
+    configuration.seeds.clear();
+    configuration.hosts_file = "simulate.hosts";
+
+    const auto name = "simulate/" + profile.name + "/" +
+        std::to_string(count);
+
+    p2p node(configuration);
+    if (wait(std::bind(&p2p::start, &node, _1)) ||
+        wait(std::bind(&p2p::run, &node, _1)))
+    {
+        std::cout << name << " failed to start node" << std::endl;
+        return;
+    }
+
+    threadpool pool(threads);
+    const auto buffers = std::make_shared<buffer_pool>(
+        configuration.buffer_pool_capacity);
+    const auto timers = std::make_shared<timer_wheel>(pool,
+        configuration.channel_timer(), 512);
+    timers->start();
+    const auto uploads = std::make_shared<token_bucket>(0, 0);
+    const auto memory = std::make_shared<memory_accounts>(0);
+
+    const auto state = std::make_shared<simulation>();
+    state->count = count;
+    state->handshaken = 0;
+    state->failed = 0;
+    state->finished = 0;
+    state->totals.messages = 0;
+    state->totals.bytes = 0;
+    state->totals.retransmissions = 0;
+    state->handshake_latency.reserve(count);
+    state->ping_latency.reserve(count * rounds_per_peer);
+    state->peers.reserve(count);
+    state->nodes.reserve(count);
+    state->links.reserve(count);
+
+    const auto start = steady_clock::now();
+
+    for (size_t index = 0; index < count; ++index)
+    {
+        auto& local_pool = node.channel_pools()->next();
+        const auto local_socket = std::make_shared<socket>(local_pool);
+        const auto peer_socket = std::make_shared<socket>(pool);
+        const auto link = simulated_link::create(pool, local_socket,
+            peer_socket, profile, simulation_seed + index, state->totals);
+
+        if (!link)
+        {
+            handshake_complete(state, error::operation_failed, nullptr,
+                start);
+            continue;
+        }
+
+        const auto local = std::make_shared<channel>(local_pool,
+            local_socket, configuration, node.payload_buffers(),
+            node.channel_timers(), node.upload_budget(),
+            node.memory_budget());
+        const auto peer = std::make_shared<channel>(pool, peer_socket,
+            configuration, buffers, timers, uploads, memory);
+
+        state->links.push_back(link);
+        state->nodes.push_back(local);
+
+        // The nonce must not match the node's own connection nonce.
+        const auto nonce = (uint64_t(0x5105e) << 32) | index;
+        start_peer(state, peer, nonce);
+        start_node(node, state, local, peer, steady_clock::now());
+    }
+
+    state->handshakes_done.get_future().wait();
+    const auto handshake_elapsed = duration_cast<nanoseconds>(
+        steady_clock::now() - start).count();
+
+    const auto connected = state->peers.size();
+    const auto rounds_start = steady_clock::now();
+
+    if (connected == 0)
+        state->rounds_done.set_value();
+
+    for (size_t index = 0; index < connected; ++index)
+        send_ping(state, state->peers[index], uint64_t(index) << 32, 0);
+
+    state->rounds_done.get_future().wait();
+    const auto rounds_elapsed = duration_cast<nanoseconds>(
+        steady_clock::now() - rounds_start).count();
+
+    std::cout << name << " handshaken " << connected
+        << " failed " << state->failed
+        << " messages " << state->totals.messages
+        << " bytes " << state->totals.bytes
+        << " retransmitted " << state->totals.retransmissions
+        << " (latency " << profile.latency.count() << "us"
+        << " rate " << profile.bytes_per_second << "B/s"
+        << " loss " << profile.loss << ")" << std::endl;
+
+    report(name + "/handshake", 0, state->handshake_latency,
+        handshake_elapsed);
+    report(name + "/ping", 0, state->ping_latency, rounds_elapsed);
+
+    for (const auto peer: state->peers)
+        peer->stop(error::channel_stopped);
+
+    for (const auto local: state->nodes)
+        local->stop(error::channel_stopped);
+
+    for (const auto link: state->links)
+        link->stop();
+
+    timers->stop();
+    wait(std::bind(&p2p::stop, &node, _1));
+    pool.shutdown();
+    pool.join();
+    boost::filesystem::remove(configuration.hosts_file);
+}
+
+// Each link requires four file descriptors (ulimit -n).
+void simulate()
+{
+    const link_profile profiles[] =
+    {
+        { "lan", microseconds(200), 0, 0.0 },
+        { "broadband", milliseconds(20), 2500000, 0.001 },
+        { "lossy", milliseconds(100), 125000, 0.02 }
+    };
+
+    const size_t counts[] = { 100, 1000, 3000 };
+
+    for (const auto& profile: profiles)
+        for (const auto count: counts)
+            phase(profile, count);
+}
+
+#undef NAME
+
+} // namespace benchmark
+} // namespace network
+} // namespace libbitcoin
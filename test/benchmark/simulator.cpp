@@ -0,0 +1,313 @@
+/**
+ * Copyright (c) 2011-2016 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "simulator.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network.hpp>
+
+namespace libbitcoin {
+namespace network {
+namespace benchmark {
+
+using namespace std::chrono;
+using std::placeholders::_1;
+
+// The heading is magic, command, payload size and checksum.
+static const size_t heading_size = 24;
+static const size_t payload_size_offset = 16;
+
+// A larger payload is taken as a corrupt stream.
+static const size_t maximum_payload = 32 * 1024 * 1024;
+
+// The minimum tcp retransmission timeout (rfc 6298, as in linux).
+static const auto retransmission_timeout = milliseconds(200);
+
+link_pump::link_pump(threadpool& pool, socket::ptr from, socket::ptr to,
+    const link_profile& profile, uint64_t seed, link_totals& totals)
+  : profile_(profile),
+    random_(seed),
+    lost_(profile.loss),
+    link_free_(clock::now()),
+    heading_(heading_size),
+    from_(from),
+    to_(to),
+    timer_(std::make_shared<deadline>(pool, asio::seconds(0))),
+    totals_(totals),
+    sending_(false)
+{
+}
+
+void link_pump::start()
+{
+    read_heading();
+}
+
+void link_pump::stop()
+{
+    timer_->stop();
+    from_->close();
+    to_->close();
+}
+
+// Read sequence.
+// ----------------------------------------------------------------------------
+
+void link_pump::read_heading()
+{
+    using namespace boost::asio;
+    async_read(from_->get(), buffer(heading_),
+        std::bind(&link_pump::handle_heading,
+            shared_from_this(), _1));
+}
+
+void link_pump::handle_heading(const boost_code& ec)
+{
+    if (ec)
+        return;
+
+    const auto size = static_cast<size_t>(heading_[payload_size_offset]) |
+        static_cast<size_t>(heading_[payload_size_offset + 1]) << 8 |
+        static_cast<size_t>(heading_[payload_size_offset + 2]) << 16 |
+        static_cast<size_t>(heading_[payload_size_offset + 3]) << 24;
+
+    if (size > maximum_payload)
+    {
+        stop();
+        return;
+    }
+
+    payload_.resize(size);
+
+    if (size == 0)
+    {
+        handle_payload(boost_code());
+        return;
+    }
+
+    using namespace boost::asio;
+    async_read(from_->get(), buffer(payload_),
+        std::bind(&link_pump::handle_payload,
+            shared_from_this(), _1));
+}
+
+void link_pump::handle_payload(const boost_code& ec)
+{
+    if (ec)
+        return;
+
+    data_chunk message;
+    message.reserve(heading_.size() + payload_.size());
+    message.insert(message.end(), heading_.begin(), heading_.end());
+    message.insert(message.end(), payload_.begin(), payload_.end());
+    schedule(std::move(message));
+    read_heading();
+}
+
+// The message occupies the link for its serialization time, then arrives
+// after the propagation delay, or after a timeout and round trip if lost.
+void link_pump::schedule(data_chunk&& message)
+{
+    const auto now = clock::now();
+    const auto rate = profile_.bytes_per_second;
+    const auto transmit = rate == 0 ? microseconds(0) :
+        microseconds(message.size() * 1000000 / rate);
+
+    link_free_ = std::max(now, link_free_) + transmit;
+    auto due = link_free_ + profile_.latency;
+
+    if (lost_(random_))
+    {
+        ++totals_.retransmissions;
+        due += retransmission_timeout + 2 * profile_.latency;
+    }
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    mutex_.lock();
+
+    // The stream is ordered, no message overtakes another.
+    if (!queue_.empty())
+        due = std::max(due, queue_.back().due);
+
+    queue_.push_back({ due, std::move(message) });
+    const auto idle = !sending_;
+    sending_ = true;
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    if (idle)
+        send_next();
+}
+
+// Write sequence.
+// ----------------------------------------------------------------------------
+
+void link_pump::send_next()
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    mutex_.lock();
+
+    if (queue_.empty())
+    {
+        sending_ = false;
+        mutex_.unlock();
+        //---------------------------------------------------------------------
+        return;
+    }
+
+    const auto wait = queue_.front().due - clock::now();
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    if (wait <= clock::duration::zero())
+    {
+        write_front();
+        return;
+    }
+
+    const auto delay = duration_cast<microseconds>(wait).count();
+    timer_->start(
+        std::bind(&link_pump::handle_timer,
+            shared_from_this(), _1), asio::microseconds(delay));
+}
+
+void link_pump::handle_timer(const code& ec)
+{
+    if (ec)
+        return;
+
+    write_front();
+}
+
+// Only the sequence writes, and pushes do not move the front element.
+void link_pump::write_front()
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    mutex_.lock_shared();
+    const auto& message = queue_.front().message;
+    mutex_.unlock_shared();
+    ///////////////////////////////////////////////////////////////////////////
+
+    using namespace boost::asio;
+    async_write(to_->get(), buffer(message),
+        std::bind(&link_pump::handle_write,
+            shared_from_this(), _1));
+}
+
+void link_pump::handle_write(const boost_code& ec)
+{
+    if (ec)
+        return;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    mutex_.lock();
+    const auto size = queue_.front().message.size();
+    queue_.pop_front();
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    ++totals_.messages;
+    totals_.bytes += size;
+    send_next();
+}
+
+// Link.
+// ----------------------------------------------------------------------------
+
+// Give each socket one end of a local stream pair, opened as a tcp socket.
+static bool join(socket::ptr first, socket::ptr second)
+{
+    int descriptors[2];
+    if (::socketpair(AF_UNIX, SOCK_STREAM, 0, descriptors) != 0)
+        return false;
+
+    boost_code ec;
+    first->get().assign(asio::tcp::v6(), descriptors[0], ec);
+
+    if (ec)
+    {
+        ::close(descriptors[0]);
+        ::close(descriptors[1]);
+        return false;
+    }
+
+    // The first descriptor is now closed with its socket.
+    second->get().assign(asio::tcp::v6(), descriptors[1], ec);
+
+    if (ec)
+    {
+        ::close(descriptors[1]);
+        return false;
+    }
+
+    return true;
+}
+
+// static
+simulated_link::ptr simulated_link::create(threadpool& pool,
+    socket::ptr first, socket::ptr second, const link_profile& profile,
+    uint64_t seed, link_totals& totals)
+{
+    const auto near = std::make_shared<socket>(pool);
+    const auto far = std::make_shared<socket>(pool);
+
+    if (!join(first, near) || !join(second, far))
+        return nullptr;
+
+    // Each direction draws its own sequence of losses.
+    const auto forward = std::make_shared<link_pump>(pool, near, far,
+        profile, seed, totals);
+    const auto reverse = std::make_shared<link_pump>(pool, far, near,
+        profile, ~seed, totals);
+
+    forward->start();
+    reverse->start();
+    return std::make_shared<simulated_link>(forward, reverse);
+}
+
+simulated_link::simulated_link(link_pump::ptr forward,
+    link_pump::ptr reverse)
+  : forward_(forward),
+    reverse_(reverse)
+{
+}
+
+void simulated_link::stop()
+{
+    forward_->stop();
+    reverse_->stop();
+}
+
+} // namespace benchmark
+} // namespace network
+} // namespace libbitcoin
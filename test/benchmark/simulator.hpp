@@ -0,0 +1,153 @@
+/**
+ * Copyright (c) 2011-2016 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NETWORK_BENCHMARK_SIMULATOR_HPP
+#define LIBBITCOIN_NETWORK_BENCHMARK_SIMULATOR_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <random>
+#include <string>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network.hpp>
+
+namespace libbitcoin {
+namespace network {
+namespace benchmark {
+
+/// The shape of a simulated link, applied to each direction.
+struct link_profile
+{
+    std::string name;
+
+    /// The one way propagation delay.
+    std::chrono::microseconds latency;
+
+    /// The serialization rate, zero is unlimited.
+    size_t bytes_per_second;
+
+    /// The probability that a message is lost and must be retransmitted.
+    double loss;
+};
+
+/// The totals over all links of a simulation.
+struct link_totals
+{
+    std::atomic<size_t> messages;
+    std::atomic<size_t> bytes;
+    std::atomic<size_t> retransmissions;
+};
+
+/// Relays whole messages from one socket to another, each delayed by the
+/// serialization and propagation time of the link. A lost message is
+/// delivered after a retransmission timeout and, as with tcp, holds back
+/// those behind it. Loss is drawn from a seeded generator, so the sequence
+/// of losses on a link is the same on each run.
+class link_pump
+  : public std::enable_shared_from_this<link_pump>
+{
+public:
+    typedef std::shared_ptr<link_pump> ptr;
+
+    /// Construct a pump, the seed determines the sequence of losses.
+    link_pump(threadpool& pool, socket::ptr from, socket::ptr to,
+        const link_profile& profile, uint64_t seed, link_totals& totals);
+
+    /// This class is not copyable.
+    link_pump(const link_pump&) = delete;
+    void operator=(const link_pump&) = delete;
+
+    /// Start relaying messages.
+    void start();
+
+    /// Stop relaying and close both sockets.
+    void stop();
+
+private:
+    typedef std::chrono::steady_clock clock;
+
+    struct delivery
+    {
+        clock::time_point due;
+        data_chunk message;
+    };
+
+    void read_heading();
+    void handle_heading(const boost_code& ec);
+    void handle_payload(const boost_code& ec);
+    void schedule(data_chunk&& message);
+    void send_next();
+    void handle_timer(const code& ec);
+    void write_front();
+    void handle_write(const boost_code& ec);
+
+    // These are accessed only by the read sequence.
+    const link_profile profile_;
+    std::mt19937_64 random_;
+    std::bernoulli_distribution lost_;
+    clock::time_point link_free_;
+    data_chunk heading_;
+    data_chunk payload_;
+
+    // These are thread safe.
+    socket::ptr from_;
+    socket::ptr to_;
+    deadline::ptr timer_;
+    link_totals& totals_;
+
+    // These are protected by mutex.
+    std::deque<delivery> queue_;
+    bool sending_;
+    mutable shared_mutex mutex_;
+};
+
+/// An in-memory transport between the sockets of two channels.
+/// Each socket is given one end of a connected local stream pair, so the
+/// proxy reads and writes it unchanged, and the far ends are joined by a
+/// pump in each direction.
+class simulated_link
+{
+public:
+    typedef std::shared_ptr<simulated_link> ptr;
+
+    /// Join the unopened sockets, null if descriptors are exhausted.
+    static ptr create(threadpool& pool, socket::ptr first,
+        socket::ptr second, const link_profile& profile, uint64_t seed,
+        link_totals& totals);
+
+    /// Construct a link of started pumps.
+    simulated_link(link_pump::ptr forward, link_pump::ptr reverse);
+
+    /// Stop both directions.
+    void stop();
+
+private:
+    link_pump::ptr forward_;
+    link_pump::ptr reverse_;
+};
+
+} // namespace benchmark
+} // namespace network
+} // namespace libbitcoin
+
+#endif
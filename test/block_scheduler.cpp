@@ -0,0 +1,193 @@
+/**
+ * Copyright (c) 2011-2016 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+#include <bitcoin/network.hpp>
+
+using namespace bc;
+using namespace bc::network;
+
+static const hash_digest genesis_hash = hash_literal(
+    "000000000019d6689c085ae165831e934ff763ae46a2a6c172b3f1b60a8ce26f");
+
+static chain::header::list make_headers(const hash_digest& parent,
+    size_t count)
+{
+    chain::header::list headers;
+    auto previous = parent;
+
+    for (size_t index = 0; index < count; ++index)
+    {
+        chain::header header;
+        header.version = 1;
+        header.previous_block_hash = previous;
+        header.merkle = null_hash;
+        header.timestamp = static_cast<uint32_t>(index);
+        header.bits = 0;
+        header.nonce = 0;
+        header.transaction_count = 0;
+        headers.push_back(header);
+        previous = header.hash();
+    }
+
+    return headers;
+}
+
+static network::settings make_settings(uint32_t window, uint32_t peer_blocks,
+    uint32_t stall_seconds)
+{
+    network::settings configuration;
+    configuration.download_window_blocks = window;
+    configuration.download_peer_blocks = peer_blocks;
+    configuration.download_stall_seconds = stall_seconds;
+    return configuration;
+}
+
+BOOST_AUTO_TEST_SUITE(block_scheduler_tests)
+
+BOOST_AUTO_TEST_CASE(block_scheduler__claim_headers__inactive__false)
+{
+    block_scheduler instance(make_settings(16, 4, 10));
+    BOOST_REQUIRE(!instance.active());
+    BOOST_REQUIRE(!instance.claim_headers(1));
+    BOOST_REQUIRE(instance.allocate(1).empty());
+}
+
+BOOST_AUTO_TEST_CASE(block_scheduler__claim_headers__claimed__false)
+{
+    block_scheduler instance(make_settings(16, 4, 10));
+    instance.reset({ genesis_hash });
+    BOOST_REQUIRE(instance.claim_headers(1));
+    BOOST_REQUIRE(!instance.claim_headers(2));
+    BOOST_REQUIRE(instance.header_peer(1));
+    BOOST_REQUIRE(!instance.header_peer(2));
+}
+
+BOOST_AUTO_TEST_CASE(block_scheduler__request_headers__stored__continue_from_last)
+{
+    block_scheduler instance(make_settings(16, 4, 10));
+    instance.reset({ genesis_hash });
+    BOOST_REQUIRE(instance.claim_headers(1));
+    BOOST_REQUIRE(instance.request_headers(1) == hash_list{ genesis_hash });
+
+    const auto headers = make_headers(genesis_hash, 3);
+    BOOST_REQUIRE_EQUAL(instance.store_headers(2, headers), error::not_found);
+    BOOST_REQUIRE_EQUAL(instance.store_headers(1, headers), error::success);
+    BOOST_REQUIRE_EQUAL(instance.queued(), 3u);
+
+    const hash_list expected{ headers.back().hash() };
+    BOOST_REQUIRE(instance.request_headers(1) == expected);
+}
+
+BOOST_AUTO_TEST_CASE(block_scheduler__store_headers__unlinked__bad_stream_released)
+{
+    block_scheduler instance(make_settings(16, 4, 10));
+    instance.reset({ genesis_hash });
+    BOOST_REQUIRE(instance.claim_headers(1));
+
+    const auto headers = make_headers(null_hash, 2);
+    BOOST_REQUIRE_EQUAL(instance.store_headers(1, headers), error::bad_stream);
+    BOOST_REQUIRE_EQUAL(instance.queued(), 0u);
+    BOOST_REQUIRE(!instance.header_peer(1));
+    BOOST_REQUIRE(!instance.claim_headers(1));
+    BOOST_REQUIRE(instance.claim_headers(2));
+}
+
+BOOST_AUTO_TEST_CASE(block_scheduler__allocate__peer_and_window_limits)
+{
+    block_scheduler instance(make_settings(6, 4, 10));
+    instance.reset({ genesis_hash });
+    BOOST_REQUIRE(instance.claim_headers(1));
+    const auto headers = make_headers(genesis_hash, 10);
+    BOOST_REQUIRE_EQUAL(instance.store_headers(1, headers), error::success);
+
+    const auto first = instance.allocate(1);
+    BOOST_REQUIRE_EQUAL(first.size(), 4u);
+    BOOST_REQUIRE(first.front() == headers.front().hash());
+    BOOST_REQUIRE(instance.allocate(1).empty());
+
+    // The window of six leaves two for the second peer.
+    BOOST_REQUIRE_EQUAL(instance.allocate(2).size(), 2u);
+    BOOST_REQUIRE_EQUAL(instance.outstanding(), 6u);
+    BOOST_REQUIRE_EQUAL(instance.outstanding(1), 4u);
+    BOOST_REQUIRE_EQUAL(instance.outstanding(2), 2u);
+    BOOST_REQUIRE_EQUAL(instance.queued(), 4u);
+}
+
+BOOST_AUTO_TEST_CASE(block_scheduler__complete__outstanding__true_once)
+{
+    block_scheduler instance(make_settings(16, 4, 10));
+    instance.reset({ genesis_hash });
+    BOOST_REQUIRE(instance.claim_headers(1));
+    const auto headers = make_headers(genesis_hash, 2);
+    BOOST_REQUIRE_EQUAL(instance.store_headers(1, headers), error::success);
+
+    const auto hashes = instance.allocate(1);
+    BOOST_REQUIRE_EQUAL(hashes.size(), 2u);
+    BOOST_REQUIRE(!instance.complete(1, null_hash, 100));
+    BOOST_REQUIRE(instance.complete(1, hashes.front(), 100));
+    BOOST_REQUIRE(!instance.complete(1, hashes.front(), 100));
+    BOOST_REQUIRE_EQUAL(instance.outstanding(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(block_scheduler__expire__stalled__requeued_in_order)
+{
+    block_scheduler instance(make_settings(16, 2, 0));
+    instance.reset({ genesis_hash });
+    BOOST_REQUIRE(instance.claim_headers(1));
+    const auto headers = make_headers(genesis_hash, 3);
+    BOOST_REQUIRE_EQUAL(instance.store_headers(1, headers), error::success);
+
+    const auto first = instance.allocate(1);
+    BOOST_REQUIRE_EQUAL(first.size(), 2u);
+    BOOST_REQUIRE_EQUAL(instance.expire(1), 2u);
+    BOOST_REQUIRE_EQUAL(instance.outstanding(), 0u);
+
+    // The stalled blocks are reassigned ahead of the later block.
+    BOOST_REQUIRE(instance.allocate(2) == first);
+}
+
+BOOST_AUTO_TEST_CASE(block_scheduler__expire__header_stall__role_released)
+{
+    block_scheduler instance(make_settings(16, 2, 0));
+    instance.reset({ genesis_hash });
+    BOOST_REQUIRE(instance.claim_headers(1));
+    BOOST_REQUIRE(!instance.request_headers(1).empty());
+    BOOST_REQUIRE_EQUAL(instance.expire(1), 0u);
+    BOOST_REQUIRE(!instance.header_peer(1));
+    BOOST_REQUIRE(instance.claim_headers(2));
+}
+
+BOOST_AUTO_TEST_CASE(block_scheduler__remove__outstanding__requeued)
+{
+    block_scheduler instance(make_settings(16, 4, 10));
+    instance.reset({ genesis_hash });
+    BOOST_REQUIRE(instance.claim_headers(1));
+    const auto headers = make_headers(genesis_hash, 4);
+    BOOST_REQUIRE_EQUAL(instance.store_headers(1, headers), error::success);
+
+    BOOST_REQUIRE_EQUAL(instance.allocate(1).size(), 4u);
+    instance.remove(1);
+    BOOST_REQUIRE(!instance.header_peer(1));
+    BOOST_REQUIRE_EQUAL(instance.outstanding(), 0u);
+    BOOST_REQUIRE_EQUAL(instance.queued(), 4u);
+    BOOST_REQUIRE(instance.claim_headers(2));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,93 @@
+/**
+ * Copyright (c) 2011-2015 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+#include <bitcoin/network.hpp>
+
+using namespace bc;
+using namespace bc::network;
+
+BOOST_AUTO_TEST_SUITE(buffer_pool_tests)
+
+BOOST_AUTO_TEST_CASE(buffer_pool__borrow__small__sized_to_request)
+{
+    const auto pool = std::make_shared<buffer_pool>(1024);
+    const auto buffer = pool->borrow(42);
+    BOOST_REQUIRE_EQUAL(buffer->size(), 42u);
+    BOOST_REQUIRE_GE(buffer->capacity(), 256u);
+}
+
+BOOST_AUTO_TEST_CASE(buffer_pool__borrow__released__reused)
+{
+    const auto pool = std::make_shared<buffer_pool>(1024);
+    auto buffer = pool->borrow(100);
+    const auto data = buffer->data();
+    buffer.reset();
+
+    buffer = pool->borrow(200);
+    BOOST_REQUIRE(buffer->data() == data);
+
+    const auto statistics = pool->pool_statistics();
+    BOOST_REQUIRE_EQUAL(statistics.classes[0].borrowed, 2u);
+    BOOST_REQUIRE_EQUAL(statistics.classes[0].reused, 1u);
+    BOOST_REQUIRE_EQUAL(statistics.classes[0].retained, 0u);
+}
+
+BOOST_AUTO_TEST_CASE(buffer_pool__borrow__high_water__discards_excess)
+{
+    const auto pool = std::make_shared<buffer_pool>(256);
+    auto buffer1 = pool->borrow(10);
+    auto buffer2 = pool->borrow(10);
+    buffer1.reset();
+    buffer2.reset();
+
+    const auto statistics = pool->pool_statistics();
+    BOOST_REQUIRE_EQUAL(statistics.classes[0].returned, 2u);
+    BOOST_REQUIRE_EQUAL(statistics.classes[0].discarded, 1u);
+    BOOST_REQUIRE_EQUAL(statistics.classes[0].retained, 1u);
+    BOOST_REQUIRE_EQUAL(statistics.retained_bytes, 256u);
+}
+
+BOOST_AUTO_TEST_CASE(buffer_pool__borrow__zero_high_water__retains_nothing)
+{
+    const auto pool = std::make_shared<buffer_pool>(0);
+    pool->borrow(1000).reset();
+
+    const auto statistics = pool->pool_statistics();
+    BOOST_REQUIRE_EQUAL(statistics.classes[2].discarded, 1u);
+    BOOST_REQUIRE_EQUAL(statistics.retained_bytes, 0u);
+}
+
+BOOST_AUTO_TEST_CASE(buffer_pool__borrow__oversized__unpooled)
+{
+    const auto pool = std::make_shared<buffer_pool>(1024);
+    const auto buffer = pool->borrow(32 * 1024 * 1024);
+    BOOST_REQUIRE_EQUAL(buffer->size(), 32u * 1024u * 1024u);
+    BOOST_REQUIRE_EQUAL(pool->pool_statistics().oversized, 1u);
+}
+
+BOOST_AUTO_TEST_CASE(buffer_pool__release__pool_destroyed__safe)
+{
+    auto pool = std::make_shared<buffer_pool>(1024);
+    auto buffer = pool->borrow(10);
+    pool.reset();
+    buffer.reset();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,65 @@
+/**
+ * Copyright (c) 2011-2016 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+#include <bitcoin/network.hpp>
+
+using namespace bc;
+using namespace bc::network;
+using namespace bc::message;
+
+static inventory_vector make_item(uint8_t seed)
+{
+    hash_digest hash = null_hash;
+    hash[0] = seed;
+    return inventory_vector{ inventory_type_id::transaction, hash };
+}
+
+BOOST_AUTO_TEST_SUITE(channel_inventory_tests)
+
+BOOST_AUTO_TEST_CASE(channel_inventory__queue__duplicates__queued_once)
+{
+    channel_inventory instance(10);
+    const inventory_vector::list items{ make_item(1), make_item(2), make_item(1) };
+    BOOST_REQUIRE_EQUAL(instance.queue(items), 2u);
+    BOOST_REQUIRE_EQUAL(instance.queue(items), 0u);
+    BOOST_REQUIRE_EQUAL(instance.take().size(), 2u);
+    BOOST_REQUIRE(instance.take().empty());
+}
+
+BOOST_AUTO_TEST_CASE(channel_inventory__queue__known__not_queued)
+{
+    channel_inventory instance(10);
+    instance.add_known({ make_item(1) });
+    BOOST_REQUIRE(instance.is_known(make_item(1)));
+    BOOST_REQUIRE(!instance.is_known(make_item(2)));
+    BOOST_REQUIRE_EQUAL(instance.queue({ make_item(1), make_item(2) }), 1u);
+    BOOST_REQUIRE(instance.is_known(make_item(2)));
+}
+
+BOOST_AUTO_TEST_CASE(channel_inventory__add_known__over_capacity__oldest_forgotten)
+{
+    channel_inventory instance(2);
+    instance.add_known({ make_item(1), make_item(2), make_item(3) });
+    BOOST_REQUIRE(!instance.is_known(make_item(1)));
+    BOOST_REQUIRE(instance.is_known(make_item(2)));
+    BOOST_REQUIRE(instance.is_known(make_item(3)));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
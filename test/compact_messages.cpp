@@ -0,0 +1,80 @@
+/**
+ * Copyright (c) 2011-2016 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <cstdint>
+#include <boost/iostreams/stream.hpp>
+#include <boost/test/unit_test.hpp>
+#include <bitcoin/network.hpp>
+
+using namespace bc;
+using namespace bc::network;
+
+typedef boost::iostreams::stream<byte_source<data_chunk>> data_source;
+
+BOOST_AUTO_TEST_SUITE(compact_messages_tests)
+
+BOOST_AUTO_TEST_CASE(compact_messages__send_compact__round_trip__expected)
+{
+    const send_compact expected(true, 1);
+    const auto data = expected.to_data();
+    BOOST_REQUIRE_EQUAL(data.size(), 9u);
+
+    data_source stream(data);
+    send_compact instance;
+    BOOST_REQUIRE(instance.from_data(stream));
+    BOOST_REQUIRE(instance.high_bandwidth);
+    BOOST_REQUIRE_EQUAL(instance.version, 1u);
+}
+
+BOOST_AUTO_TEST_CASE(compact_messages__get_block_transactions__round_trip__absolute_indexes)
+{
+    get_block_transactions expected;
+    expected.block_hash = null_hash;
+    expected.indexes = { 1, 2, 7, 300 };
+    const auto data = expected.to_data();
+
+    data_source stream(data);
+    get_block_transactions instance;
+    BOOST_REQUIRE(instance.from_data(stream));
+    BOOST_REQUIRE(instance.indexes == expected.indexes);
+}
+
+BOOST_AUTO_TEST_CASE(compact_messages__get_block_transactions__unordered__fails)
+{
+    get_block_transactions expected;
+    expected.block_hash = null_hash;
+    expected.indexes = { 2, 1 };
+    const auto data = expected.to_data();
+
+    data_source stream(data);
+    get_block_transactions instance;
+    BOOST_REQUIRE(!instance.from_data(stream));
+}
+
+BOOST_AUTO_TEST_CASE(compact_messages__short_id__distinct_keys__differ_within_width)
+{
+    const hash_digest hash = null_hash;
+    const auto first = compact_block::short_id({ 0, 1 }, hash);
+    const auto second = compact_block::short_id({ 1, 0 }, hash);
+    BOOST_REQUIRE_NE(first, second);
+    BOOST_REQUIRE_EQUAL(first >> (8 * compact_block::short_id_size), 0u);
+    BOOST_REQUIRE_EQUAL(second >> (8 * compact_block::short_id_size), 0u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,89 @@
+/**
+ * Copyright (c) 2011-2016 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <chrono>
+#include <future>
+#include <boost/test/unit_test.hpp>
+#include <bitcoin/network.hpp>
+
+using namespace bc;
+using namespace bc::network;
+
+BOOST_AUTO_TEST_SUITE(dispatch_monitor_tests)
+
+BOOST_AUTO_TEST_CASE(dispatch_monitor__lookup__same_name__shared)
+{
+    dispatch_monitor instance;
+    const auto first = instance.lookup("hosts");
+    const auto second = instance.lookup("hosts");
+    const auto other = instance.lookup("session");
+    BOOST_REQUIRE(first == second);
+    BOOST_REQUIRE(first != other);
+}
+
+BOOST_AUTO_TEST_CASE(dispatch_monitor__snapshot__counters__by_name)
+{
+    using std::chrono::milliseconds;
+    dispatch_monitor instance;
+    const auto counters = instance.lookup("session");
+    instance.lookup("hosts");
+
+    const auto enqueued = counters->enqueue();
+    counters->enqueue();
+    counters->start(enqueued - milliseconds(2));
+    counters->complete(dispatch_monitor::clock::now() - milliseconds(1));
+
+    const auto statistics = instance.snapshot();
+    BOOST_REQUIRE_EQUAL(statistics.size(), 2u);
+    BOOST_REQUIRE_EQUAL(statistics[0].name, "hosts");
+    BOOST_REQUIRE_EQUAL(statistics[0].enqueued, 0u);
+
+    const auto& session = statistics[1];
+    BOOST_REQUIRE_EQUAL(session.name, "session");
+    BOOST_REQUIRE_EQUAL(session.enqueued, 2u);
+    BOOST_REQUIRE_EQUAL(session.queued, 1u);
+    BOOST_REQUIRE_EQUAL(session.running, 0u);
+    BOOST_REQUIRE_EQUAL(session.completed, 1u);
+    BOOST_REQUIRE_EQUAL(session.wait.count, 1u);
+    BOOST_REQUIRE_GE(session.wait.maximum_microseconds, 2000u);
+    BOOST_REQUIRE_GE(session.execution.maximum_microseconds, 1000u);
+}
+
+BOOST_AUTO_TEST_CASE(dispatch_monitor__monitored_dispatcher__concurrent__counted)
+{
+    threadpool pool(1);
+    const auto monitor = std::make_shared<dispatch_monitor>();
+    monitored_dispatcher dispatch(pool, "test", monitor);
+
+    std::promise<int> promise;
+    dispatch.concurrent([&promise](int value) { promise.set_value(value); },
+        42);
+    BOOST_REQUIRE_EQUAL(promise.get_future().get(), 42);
+
+    pool.shutdown();
+    pool.join();
+
+    const auto statistics = monitor->snapshot();
+    BOOST_REQUIRE_EQUAL(statistics.size(), 1u);
+    BOOST_REQUIRE_EQUAL(statistics[0].enqueued, 1u);
+    BOOST_REQUIRE_EQUAL(statistics[0].completed, 1u);
+    BOOST_REQUIRE_EQUAL(statistics[0].wait.count, 1u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,92 @@
+/**
+ * Copyright (c) 2011-2016 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+#include <bitcoin/network.hpp>
+
+using namespace bc;
+using namespace bc::network;
+
+BOOST_AUTO_TEST_SUITE(handler_allocator_tests)
+
+BOOST_AUTO_TEST_CASE(handler_allocator__allocate__sequential__reused)
+{
+    handler_allocator instance;
+    const auto first = instance.allocate(100);
+    instance.deallocate(first);
+    const auto second = instance.allocate(200);
+    BOOST_REQUIRE(first == second);
+    instance.deallocate(second);
+}
+
+BOOST_AUTO_TEST_CASE(handler_allocator__allocate__overlapped__distinct)
+{
+    handler_allocator instance;
+    const auto first = instance.allocate(100);
+    const auto second = instance.allocate(100);
+    BOOST_REQUIRE(first != second);
+    instance.deallocate(second);
+    instance.deallocate(first);
+
+    // The block is again free once the overlapping use is released.
+    const auto third = instance.allocate(100);
+    BOOST_REQUIRE(first == third);
+    instance.deallocate(third);
+}
+
+BOOST_AUTO_TEST_CASE(handler_allocator__allocate__oversized__heap)
+{
+    handler_allocator instance;
+    const auto large = instance.allocate(handler_allocator::capacity + 1);
+    const auto small = instance.allocate(1);
+    BOOST_REQUIRE(large != small);
+    instance.deallocate(large);
+    instance.deallocate(small);
+}
+
+BOOST_AUTO_TEST_CASE(allocated_handler__hooks__use_allocator)
+{
+    handler_allocator instance;
+    auto handler = make_allocated_handler(instance, [](){});
+    const auto block = asio_handler_allocate(64, &handler);
+
+    // The hook took the block, so a direct allocation overlaps it.
+    const auto other = instance.allocate(64);
+    BOOST_REQUIRE(block != other);
+    instance.deallocate(other);
+    asio_handler_deallocate(block, 64, &handler);
+    BOOST_REQUIRE(instance.allocate(64) == block);
+    instance.deallocate(block);
+}
+
+BOOST_AUTO_TEST_CASE(allocated_handler__invoke__forwards_arguments)
+{
+    size_t sum = 0;
+    handler_allocator instance;
+    auto handler = make_allocated_handler(instance,
+        [&sum](size_t left, size_t right)
+        {
+            sum = left + right;
+        });
+
+    handler(40, 2);
+    BOOST_REQUIRE_EQUAL(sum, 42u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
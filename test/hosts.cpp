@@ -0,0 +1,210 @@
+/**
+ * Copyright (c) 2011-2016 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <future>
+#include <string>
+#include <boost/test/unit_test.hpp>
+#include <bitcoin/network.hpp>
+
+using namespace bc;
+using namespace bc::network;
+
+static hosts::address make_address(const std::string& authority)
+{
+    return config::authority(authority).to_network_address();
+}
+
+BOOST_AUTO_TEST_SUITE(hosts_tests)
+
+BOOST_AUTO_TEST_CASE(hosts__fetch__empty__not_found)
+{
+    threadpool pool;
+    const network::settings configuration;
+    hosts instance(pool, configuration);
+    hosts::address out;
+    BOOST_REQUIRE_EQUAL(instance.fetch(out), error::not_found);
+}
+
+BOOST_AUTO_TEST_CASE(hosts__score__unknown__not_found)
+{
+    threadpool pool;
+    const network::settings configuration;
+    hosts instance(pool, configuration);
+    const auto host = make_address("1.2.3.4:8333");
+    BOOST_REQUIRE_EQUAL(instance.attempt(host), error::not_found);
+    BOOST_REQUIRE_EQUAL(instance.score(host, error::success), error::not_found);
+}
+
+BOOST_AUTO_TEST_CASE(hosts__score__success__promoted_and_fetched)
+{
+    threadpool pool;
+    const network::settings configuration;
+    hosts instance(pool, configuration);
+    const auto host = make_address("1.2.3.4:8333");
+    BOOST_REQUIRE_EQUAL(instance.store(host), error::success);
+    BOOST_REQUIRE_EQUAL(instance.attempt(host), error::success);
+    BOOST_REQUIRE_EQUAL(instance.score(host, error::success), error::success);
+    BOOST_REQUIRE_EQUAL(instance.count(), 1u);
+
+    hosts::address out;
+    BOOST_REQUIRE_EQUAL(instance.fetch(out), error::success);
+    BOOST_REQUIRE_EQUAL(out.port, host.port);
+    BOOST_REQUIRE(out.ip == host.ip);
+}
+
+BOOST_AUTO_TEST_CASE(hosts__score__new_failures__removed)
+{
+    threadpool pool;
+    const network::settings configuration;
+    hosts instance(pool, configuration);
+    const auto host = make_address("1.2.3.4:8333");
+    BOOST_REQUIRE_EQUAL(instance.store(host), error::success);
+    BOOST_REQUIRE_EQUAL(instance.score(host, error::channel_timeout), error::success);
+    BOOST_REQUIRE_EQUAL(instance.score(host, error::channel_timeout), error::success);
+    BOOST_REQUIRE_EQUAL(instance.count(), 1u);
+    BOOST_REQUIRE_EQUAL(instance.score(host, error::channel_timeout), error::success);
+    BOOST_REQUIRE_EQUAL(instance.count(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(hosts__score__tried_failures__demoted_not_removed)
+{
+    threadpool pool;
+    const network::settings configuration;
+    hosts instance(pool, configuration);
+    const auto host = make_address("1.2.3.4:8333");
+    BOOST_REQUIRE_EQUAL(instance.store(host), error::success);
+    BOOST_REQUIRE_EQUAL(instance.score(host, error::success), error::success);
+
+    for (size_t failure = 0; failure < 10; ++failure)
+        BOOST_REQUIRE_EQUAL(instance.score(host, error::channel_timeout), error::success);
+
+    BOOST_REQUIRE_EQUAL(instance.count(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(hosts__remove__tried__removed)
+{
+    threadpool pool;
+    const network::settings configuration;
+    hosts instance(pool, configuration);
+    const auto host = make_address("1.2.3.4:8333");
+    BOOST_REQUIRE_EQUAL(instance.store(host), error::success);
+    BOOST_REQUIRE_EQUAL(instance.score(host, error::success), error::success);
+    BOOST_REQUIRE_EQUAL(instance.remove(host), error::success);
+    BOOST_REQUIRE_EQUAL(instance.count(), 0u);
+    BOOST_REQUIRE_EQUAL(instance.store(host), error::success);
+    BOOST_REQUIRE_EQUAL(instance.count(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(hosts__fetch__after_remove__not_found)
+{
+    threadpool pool;
+    const network::settings configuration;
+    hosts instance(pool, configuration);
+    const auto host = make_address("1.2.3.4:8333");
+    BOOST_REQUIRE_EQUAL(instance.store(host), error::success);
+
+    hosts::address out;
+    BOOST_REQUIRE_EQUAL(instance.fetch(out), error::success);
+
+    // The removal publishes the snapshot from which fetch selects.
+    BOOST_REQUIRE_EQUAL(instance.remove(host), error::success);
+    BOOST_REQUIRE_EQUAL(instance.fetch(out), error::not_found);
+}
+
+BOOST_AUTO_TEST_CASE(hosts__store__batch_with_duplicates__stored_once)
+{
+    threadpool pool(1);
+    const network::settings configuration;
+    const auto instance = std::make_shared<hosts>(pool, configuration);
+    const auto host1 = make_address("1.2.3.4:8333");
+    auto host2 = host1;
+    host2.port = 8334;
+
+    // The second host is redundant within the batch, the first with the pool.
+    BOOST_REQUIRE_EQUAL(instance->store(host1), error::success);
+    const hosts::address::list batch{ host1, host2, host2 };
+
+    std::promise<code> stored;
+    instance->store(batch, [&stored](const code& ec)
+    {
+        stored.set_value(ec);
+    });
+
+    BOOST_REQUIRE_EQUAL(stored.get_future().get(), error::success);
+    BOOST_REQUIRE_EQUAL(instance->count(), 2u);
+    pool.shutdown();
+    pool.join();
+}
+
+BOOST_AUTO_TEST_CASE(hosts__sample__empty__not_found)
+{
+    threadpool pool;
+    const network::settings configuration;
+    hosts instance(pool, configuration);
+    const_buffer out;
+    BOOST_REQUIRE_EQUAL(instance.sample(out), error::not_found);
+}
+
+BOOST_AUTO_TEST_CASE(hosts__sample__repeated__shared)
+{
+    threadpool pool;
+    const network::settings configuration;
+    hosts instance(pool, configuration);
+    BOOST_REQUIRE_EQUAL(instance.store(make_address("1.2.3.4:8333")), error::success);
+
+    const_buffer first;
+    const_buffer second;
+    BOOST_REQUIRE_EQUAL(instance.sample(first), error::success);
+    BOOST_REQUIRE_EQUAL(instance.sample(second), error::success);
+    BOOST_REQUIRE_GT(first.size(), 0u);
+
+    using boost::asio::buffer_cast;
+    BOOST_REQUIRE(buffer_cast<const void*>(*first.begin()) ==
+        buffer_cast<const void*>(*second.begin()));
+}
+
+BOOST_AUTO_TEST_CASE(hosts__load__saved__scores_restored)
+{
+    threadpool pool;
+    network::settings configuration;
+    configuration.hosts_file = "hosts__load__saved__scores_restored.cache";
+    boost::filesystem::remove(configuration.hosts_file);
+    const auto host = make_address("1.2.3.4:8333");
+
+    const auto writer = std::make_shared<hosts>(pool, configuration);
+    BOOST_REQUIRE_EQUAL(writer->load(), error::success);
+    BOOST_REQUIRE_EQUAL(writer->store(host), error::success);
+    BOOST_REQUIRE_EQUAL(writer->score(host, error::success), error::success);
+    BOOST_REQUIRE_EQUAL(writer->save(), error::success);
+    BOOST_REQUIRE(hosts_file::recognized(configuration.hosts_file));
+
+    const auto reader = std::make_shared<hosts>(pool, configuration);
+    BOOST_REQUIRE_EQUAL(reader->load(), error::success);
+    BOOST_REQUIRE_EQUAL(reader->count(), 1u);
+
+    // The address was restored to the tried table, where failures demote it.
+    for (size_t failure = 0; failure < 10; ++failure)
+        BOOST_REQUIRE_EQUAL(reader->score(host, error::channel_timeout), error::success);
+
+    BOOST_REQUIRE_EQUAL(reader->count(), 1u);
+    BOOST_REQUIRE_EQUAL(reader->save(), error::success);
+    boost::filesystem::remove(configuration.hosts_file);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
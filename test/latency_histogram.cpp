@@ -0,0 +1,95 @@
+/**
+ * Copyright (c) 2011-2016 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <chrono>
+#include <cstdint>
+#include <boost/test/unit_test.hpp>
+#include <bitcoin/network.hpp>
+
+using namespace bc;
+using namespace bc::network;
+
+BOOST_AUTO_TEST_SUITE(latency_histogram_tests)
+
+BOOST_AUTO_TEST_CASE(latency_histogram__construct__empty_summary)
+{
+    latency_histogram instance;
+    const auto summary = instance.summarize();
+    BOOST_REQUIRE_EQUAL(summary.count, 0u);
+    BOOST_REQUIRE_EQUAL(summary.mean_microseconds, 0u);
+    BOOST_REQUIRE_EQUAL(summary.p50_microseconds, 0u);
+    BOOST_REQUIRE_EQUAL(summary.maximum_microseconds, 0u);
+}
+
+BOOST_AUTO_TEST_CASE(latency_histogram__to_bucket__small_values__exact)
+{
+    for (uint64_t value = 0; value < 16; ++value)
+    {
+        BOOST_REQUIRE_EQUAL(latency_histogram::to_bucket(value), value);
+        BOOST_REQUIRE_EQUAL(latency_histogram::to_upper(value), value);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(latency_histogram__to_upper__bucket__contains_value)
+{
+    const uint64_t values[] = { 16, 17, 100, 1000, 123456, 1ull << 40,
+        max_uint64 };
+
+    for (const auto value: values)
+    {
+        const auto bucket = latency_histogram::to_bucket(value);
+        BOOST_REQUIRE_LT(bucket, latency_histogram::bucket_count);
+        BOOST_REQUIRE_GE(latency_histogram::to_upper(bucket), value);
+        BOOST_REQUIRE_LE(latency_histogram::to_upper(bucket) - value,
+            value / 8);
+
+        if (bucket > 0)
+            BOOST_REQUIRE_LT(latency_histogram::to_upper(bucket - 1), value);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(latency_histogram__summarize__uniform__percentiles)
+{
+    latency_histogram instance;
+
+    for (uint64_t value = 1; value <= 1000; ++value)
+        instance.record(value);
+
+    const auto summary = instance.summarize();
+    BOOST_REQUIRE_EQUAL(summary.count, 1000u);
+    BOOST_REQUIRE_EQUAL(summary.mean_microseconds, 500u);
+    BOOST_REQUIRE_EQUAL(summary.maximum_microseconds, 1000u);
+    BOOST_REQUIRE_GE(summary.p50_microseconds, 500u);
+    BOOST_REQUIRE_LE(summary.p50_microseconds, 500u + 500u / 8);
+    BOOST_REQUIRE_GE(summary.p99_microseconds, 990u);
+    BOOST_REQUIRE_LE(summary.p99_microseconds, 1000u);
+    BOOST_REQUIRE_EQUAL(summary.p999_microseconds, 1000u);
+}
+
+BOOST_AUTO_TEST_CASE(latency_histogram__record__duration__microseconds)
+{
+    latency_histogram instance;
+    instance.record(std::chrono::milliseconds(3));
+    instance.record(latency_histogram::clock::duration(-1));
+    BOOST_REQUIRE_EQUAL(instance.count(), 2u);
+    BOOST_REQUIRE_EQUAL(instance.summarize().maximum_microseconds, 3000u);
+    BOOST_REQUIRE_EQUAL(instance.percentile(0.0), 0u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,80 @@
+/**
+ * Copyright (c) 2011-2016 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <chrono>
+#include <boost/test/unit_test.hpp>
+#include <bitcoin/network.hpp>
+
+using namespace bc;
+using namespace bc::network;
+
+BOOST_AUTO_TEST_SUITE(lifecycle_metrics_tests)
+
+typedef lifecycle_metrics::origin origin;
+typedef lifecycle_metrics::phase phase;
+
+BOOST_AUTO_TEST_CASE(lifecycle_metrics__record__outbound__all_phases)
+{
+    using std::chrono::milliseconds;
+    lifecycle_metrics instance;
+    lifecycle_metrics::timeline times;
+    times.resolving = lifecycle_metrics::clock::now();
+    times.connecting = times.resolving + milliseconds(1);
+    times.connected = times.connecting + milliseconds(2);
+    times.handshaking = times.connected + milliseconds(3);
+    times.handshaken = times.handshaking + milliseconds(4);
+    times.started = times.handshaken + milliseconds(5);
+    instance.record(origin::outbound, times);
+
+    const auto maximum = [&](phase step)
+    {
+        return instance.summarize(origin::outbound, step).maximum_microseconds;
+    };
+
+    BOOST_REQUIRE_EQUAL(maximum(phase::resolve), 1000u);
+    BOOST_REQUIRE_EQUAL(maximum(phase::connect), 2000u);
+    BOOST_REQUIRE_EQUAL(maximum(phase::pend), 3000u);
+    BOOST_REQUIRE_EQUAL(maximum(phase::handshake), 4000u);
+    BOOST_REQUIRE_EQUAL(maximum(phase::store), 5000u);
+    BOOST_REQUIRE_EQUAL(maximum(phase::total), 15000u);
+    BOOST_REQUIRE_EQUAL(instance.summarize(origin::inbound,
+        phase::total).count, 0u);
+}
+
+BOOST_AUTO_TEST_CASE(lifecycle_metrics__record__inbound__no_resolve_or_connect)
+{
+    using std::chrono::milliseconds;
+    lifecycle_metrics instance;
+    lifecycle_metrics::timeline times;
+    times.connected = lifecycle_metrics::clock::now();
+    times.handshaking = times.connected + milliseconds(1);
+    times.handshaken = times.handshaking + milliseconds(1);
+    times.started = times.handshaken + milliseconds(1);
+    instance.record(origin::inbound, times);
+
+    const auto statistics = instance.snapshot();
+    const auto& inbound = statistics[static_cast<size_t>(origin::inbound)];
+    BOOST_REQUIRE_EQUAL(inbound[static_cast<size_t>(phase::resolve)].count, 0u);
+    BOOST_REQUIRE_EQUAL(inbound[static_cast<size_t>(phase::connect)].count, 0u);
+    BOOST_REQUIRE_EQUAL(inbound[static_cast<size_t>(phase::handshake)].count, 1u);
+    BOOST_REQUIRE_EQUAL(inbound[static_cast<size_t>(phase::total)]
+        .maximum_microseconds, 3000u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,90 @@
+/**
+ * Copyright (c) 2011-2016 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+#include <bitcoin/network.hpp>
+
+using namespace bc;
+using namespace bc::network;
+
+BOOST_AUTO_TEST_SUITE(memory_accounts_tests)
+
+BOOST_AUTO_TEST_CASE(memory_accounts__construct__zero_total)
+{
+    memory_accounts instance(0);
+    BOOST_REQUIRE_EQUAL(instance.total(), 0u);
+    BOOST_REQUIRE(!instance.exhausted());
+}
+
+BOOST_AUTO_TEST_CASE(memory_accounts__add_remove__by_category)
+{
+    memory_accounts instance(0);
+    instance.add(memory_accounts::category::receive, 100);
+    instance.add(memory_accounts::category::send, 20);
+    instance.add(memory_accounts::category::receive, 5);
+    instance.remove(memory_accounts::category::receive, 50);
+    BOOST_REQUIRE_EQUAL(instance.bytes(memory_accounts::category::receive), 55u);
+    BOOST_REQUIRE_EQUAL(instance.bytes(memory_accounts::category::send), 20u);
+    BOOST_REQUIRE_EQUAL(instance.bytes(memory_accounts::category::hosts), 0u);
+    BOOST_REQUIRE_EQUAL(instance.total(), 75u);
+}
+
+BOOST_AUTO_TEST_CASE(memory_accounts__set__replaces)
+{
+    memory_accounts instance(0);
+    instance.set(memory_accounts::category::hosts, 1000);
+    instance.set(memory_accounts::category::hosts, 400);
+    BOOST_REQUIRE_EQUAL(instance.bytes(memory_accounts::category::hosts), 400u);
+}
+
+BOOST_AUTO_TEST_CASE(memory_accounts__exhausted__over_limit)
+{
+    memory_accounts instance(100);
+    instance.add(memory_accounts::category::channels, 100);
+    BOOST_REQUIRE(!instance.exhausted());
+    instance.add(memory_accounts::category::send, 1);
+    BOOST_REQUIRE(instance.exhausted());
+    instance.remove(memory_accounts::category::send, 1);
+    BOOST_REQUIRE(!instance.exhausted());
+}
+
+BOOST_AUTO_TEST_CASE(memory_accounts__exhausted__zero_limit__unlimited)
+{
+    memory_accounts instance(0);
+    instance.add(memory_accounts::category::receive, 1u << 30);
+    BOOST_REQUIRE(!instance.exhausted());
+}
+
+BOOST_AUTO_TEST_CASE(memory_accounts__snapshot__all_categories)
+{
+    memory_accounts instance(42);
+    instance.add(memory_accounts::category::receive, 1);
+    instance.add(memory_accounts::category::send, 2);
+    instance.add(memory_accounts::category::hosts, 3);
+    instance.add(memory_accounts::category::channels, 4);
+    const auto usage = instance.snapshot();
+    BOOST_REQUIRE_EQUAL(usage.receive, 1u);
+    BOOST_REQUIRE_EQUAL(usage.send, 2u);
+    BOOST_REQUIRE_EQUAL(usage.hosts, 3u);
+    BOOST_REQUIRE_EQUAL(usage.channels, 4u);
+    BOOST_REQUIRE_EQUAL(usage.total, 10u);
+    BOOST_REQUIRE_EQUAL(usage.limit, 42u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,88 @@
+/**
+ * Copyright (c) 2011-2016 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+#include <bitcoin/network.hpp>
+
+using namespace bc;
+using namespace bc::message;
+using namespace bc::network;
+
+BOOST_AUTO_TEST_SUITE(message_cache_tests)
+
+static data_chunk to_chunk(const const_buffer& buffer)
+{
+    const auto data = boost::asio::buffer_cast<const uint8_t*>(
+        *buffer.begin());
+    return data_chunk(data, data + buffer.size());
+}
+
+BOOST_AUTO_TEST_CASE(message_cache__verack__serialized)
+{
+    const network::settings configuration(bc::settings::mainnet);
+    const message_cache instance(configuration);
+    const auto expected = serialize(verack(), configuration.identifier);
+    BOOST_REQUIRE(to_chunk(instance.verack()) == expected);
+}
+
+BOOST_AUTO_TEST_CASE(message_cache__get_address__serialized)
+{
+    const network::settings configuration(bc::settings::mainnet);
+    const message_cache instance(configuration);
+    const auto expected = serialize(get_address(), configuration.identifier);
+    BOOST_REQUIRE(to_chunk(instance.get_address()) == expected);
+}
+
+BOOST_AUTO_TEST_CASE(message_cache__self_address__serialized)
+{
+    network::settings configuration(bc::settings::mainnet);
+    configuration.self = config::authority("1.2.3.4:8333");
+    const message_cache instance(configuration);
+    const address self({ { configuration.self.to_network_address() } });
+    const auto expected = serialize(self, configuration.identifier);
+    BOOST_REQUIRE(to_chunk(instance.self_address()) == expected);
+}
+
+BOOST_AUTO_TEST_CASE(message_cache__version__patched__equals_serialized)
+{
+    network::settings configuration(bc::settings::mainnet);
+    configuration.self = config::authority("1.2.3.4:8333");
+    const message_cache instance(configuration);
+    const config::authority peer("[2001:db8::1]:18333");
+    const uint64_t nonce = 0x0123456789abcdef;
+    const size_t height = 420000;
+
+    const auto version = protocol_version::template_factory(peer,
+        configuration, nonce, height);
+    const auto expected = serialize(version, configuration.identifier);
+    BOOST_REQUIRE(to_chunk(instance.version(peer, nonce, height)) == expected);
+}
+
+BOOST_AUTO_TEST_CASE(message_cache__version__distinct_channels__independent)
+{
+    const network::settings configuration(bc::settings::mainnet);
+    const message_cache instance(configuration);
+    const config::authority peer("10.0.0.1:8333");
+    const auto first = to_chunk(instance.version(peer, 1, 100));
+    const auto second = to_chunk(instance.version(peer, 2, 100));
+    BOOST_REQUIRE(first != second);
+    BOOST_REQUIRE(to_chunk(instance.version(peer, 1, 100)) == first);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,109 @@
+/**
+ * Copyright (c) 2011-2015 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <string>
+#include <vector>
+#include <boost/test/unit_test.hpp>
+#include <bitcoin/network.hpp>
+
+using namespace bc;
+using namespace bc::network;
+
+BOOST_AUTO_TEST_SUITE(message_checksum_tests)
+
+BOOST_AUTO_TEST_CASE(message_checksum__compute__empty__verack_checksum)
+{
+    BOOST_REQUIRE_EQUAL(message_checksum::compute(data_chunk{}), 0xe2e0f65du);
+}
+
+BOOST_AUTO_TEST_CASE(message_checksum__compute__hello__expected)
+{
+    const std::string text("hello");
+    const data_chunk data(text.begin(), text.end());
+    BOOST_REQUIRE_EQUAL(message_checksum::compute(data), 0xdfc99595u);
+}
+
+BOOST_AUTO_TEST_CASE(message_checksum__update__chunked__equals_whole)
+{
+    const data_chunk data(1000, 'a');
+    message_checksum checksum;
+
+    // Uneven chunks exercise the partial block buffer.
+    checksum.update(data.data(), 1);
+    checksum.update(data.data() + 1, 63);
+    checksum.update(data.data() + 64, 100);
+    checksum.update(data.data() + 164, 836);
+
+    const auto expected = message_checksum::compute(data);
+    BOOST_REQUIRE_EQUAL(checksum.finalize(), expected);
+    BOOST_REQUIRE_EQUAL(expected, 0x3cfdb6f2u);
+}
+
+BOOST_AUTO_TEST_CASE(message_checksum__finalize__resets)
+{
+    message_checksum checksum;
+    checksum.update(nullptr, 0);
+    BOOST_REQUIRE_EQUAL(checksum.finalize(), 0xe2e0f65du);
+    BOOST_REQUIRE_EQUAL(checksum.finalize(), 0xe2e0f65du);
+}
+
+BOOST_AUTO_TEST_CASE(message_checksum__select_kernel__generic__supported)
+{
+    const auto original = message_checksum::active_kernel();
+    BOOST_REQUIRE(message_checksum::supported(message_checksum::kernel::generic));
+    BOOST_REQUIRE(message_checksum::select_kernel(message_checksum::kernel::generic));
+    BOOST_REQUIRE(message_checksum::active_kernel() == message_checksum::kernel::generic);
+    BOOST_REQUIRE(message_checksum::select_kernel(original));
+}
+
+BOOST_AUTO_TEST_CASE(message_checksum__compute__all_supported_kernels__equal)
+{
+    const auto original = message_checksum::active_kernel();
+    const message_checksum::kernel kernels[] =
+    {
+        message_checksum::kernel::generic,
+        message_checksum::kernel::sha_ni
+    };
+
+    // Sizes around the block and padding boundaries.
+    const size_t sizes[] = { 0, 1, 55, 56, 63, 64, 65, 128, 1000 };
+
+    data_chunk data(1000);
+    for (size_t index = 0; index < data.size(); ++index)
+        data[index] = static_cast<uint8_t>(index * 7);
+
+    std::vector<uint32_t> expected;
+    BOOST_REQUIRE(message_checksum::select_kernel(kernels[0]));
+    for (const auto size: sizes)
+        expected.push_back(message_checksum::compute(data.data(), size));
+
+    for (const auto kernel: kernels)
+    {
+        if (!message_checksum::select_kernel(kernel))
+            continue;
+
+        for (size_t index = 0; index < expected.size(); ++index)
+            BOOST_REQUIRE_EQUAL(message_checksum::compute(data.data(),
+                sizes[index]), expected[index]);
+    }
+
+    BOOST_REQUIRE(message_checksum::select_kernel(original));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
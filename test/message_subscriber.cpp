@@ -0,0 +1,305 @@
+/**
+ * Copyright (c) 2011-2016 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <future>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <boost/test/unit_test.hpp>
+#include <bitcoin/network.hpp>
+
+using namespace bc;
+using namespace bc::network;
+using namespace bc::message;
+
+static message_subscriber::command_field make_field(const std::string& text)
+{
+    message_subscriber::command_field field;
+    field.fill(0);
+    std::memcpy(field.data(), text.data(), std::min(text.size(), field.size()));
+    return field;
+}
+
+// A message type that is not known to the library.
+struct custom_message
+{
+    typedef std::shared_ptr<custom_message> ptr;
+    static const std::string command;
+
+    bool from_data(std::istream& stream)
+    {
+        value = stream.get();
+        return stream.good();
+    }
+
+    int value;
+};
+
+const std::string custom_message::command = "custom";
+
+// A message type that claims the command of a known type.
+struct impostor_message
+  : public custom_message
+{
+    typedef std::shared_ptr<impostor_message> ptr;
+    static const std::string command;
+};
+
+const std::string impostor_message::command = "tx";
+
+BOOST_AUTO_TEST_SUITE(message_subscriber_tests)
+
+BOOST_AUTO_TEST_CASE(message_subscriber__to_type__commands__expected)
+{
+    BOOST_REQUIRE(message_subscriber::to_type(make_field("addr")) == message_type::address);
+    BOOST_REQUIRE(message_subscriber::to_type(make_field("block")) == message_type::block);
+    BOOST_REQUIRE(message_subscriber::to_type(make_field("getheaders")) == message_type::get_headers);
+    BOOST_REQUIRE(message_subscriber::to_type(make_field("inv")) == message_type::inventory);
+    BOOST_REQUIRE(message_subscriber::to_type(make_field("merkleblock")) == message_type::merkle_block);
+    BOOST_REQUIRE(message_subscriber::to_type(make_field("tx")) == message_type::transaction);
+    BOOST_REQUIRE(message_subscriber::to_type(make_field("version")) == message_type::version);
+}
+
+BOOST_AUTO_TEST_CASE(message_subscriber__to_type__unknown__unknown)
+{
+    BOOST_REQUIRE(message_subscriber::to_type(make_field("")) == message_type::unknown);
+    BOOST_REQUIRE(message_subscriber::to_type(make_field("foo")) == message_type::unknown);
+    BOOST_REQUIRE(message_subscriber::to_type(make_field("tx2")) == message_type::unknown);
+}
+
+BOOST_AUTO_TEST_CASE(message_subscriber__to_type__trailing_garbage__unknown)
+{
+    // Bytes after the terminator are part of the field.
+    auto field = make_field("tx");
+    field[11] = 'x';
+    BOOST_REQUIRE(message_subscriber::to_type(field) == message_type::unknown);
+}
+
+BOOST_AUTO_TEST_CASE(message_subscriber__load__unregistered__not_found)
+{
+    threadpool pool(1);
+    message_subscriber instance(pool);
+    std::istringstream stream("x");
+    BOOST_REQUIRE_EQUAL(instance.load(make_field("custom"), stream), error::not_found);
+    BOOST_REQUIRE(!instance.registered(make_field("custom")));
+    pool.shutdown();
+    pool.join();
+}
+
+BOOST_AUTO_TEST_CASE(message_subscriber__subscribe__custom__registered_and_delivered)
+{
+    threadpool pool(1);
+    message_subscriber instance(pool);
+    instance.start();
+
+    std::promise<int> promise;
+    instance.subscribe<custom_message>(
+        [&promise](const code& ec, custom_message::ptr message)
+        {
+            promise.set_value(ec ? -1 : message->value);
+            return false;
+        });
+
+    const auto command = make_field("custom");
+    BOOST_REQUIRE(instance.registered(command));
+    BOOST_REQUIRE(instance.subscribed(command));
+
+    std::istringstream stream("x");
+    BOOST_REQUIRE_EQUAL(instance.load(command, stream), error::success);
+    BOOST_REQUIRE_EQUAL(promise.get_future().get(), 'x');
+
+    instance.stop();
+    pool.shutdown();
+    pool.join();
+}
+
+BOOST_AUTO_TEST_CASE(message_subscriber__load__strand_ticket__released_once_handled)
+{
+    threadpool pool(1);
+    asio::strand strand(pool.service());
+    message_subscriber instance(pool, {}, strand);
+    instance.start();
+
+    const auto handled = std::make_shared<std::atomic<bool>>(false);
+    instance.subscribe<custom_message>(
+        [handled](const code&, custom_message::ptr)
+        {
+            handled->store(true);
+            return false;
+        });
+
+    // The ticket is held by the queued notification alone.
+    std::promise<bool> released;
+    std::istringstream stream("x");
+    BOOST_REQUIRE_EQUAL(instance.load(make_field("custom"), stream,
+        message_subscriber::ticket(nullptr, [&released, handled](void*)
+        {
+            released.set_value(handled->load());
+        })), error::success);
+
+    BOOST_REQUIRE(released.get_future().get());
+
+    instance.stop();
+    pool.shutdown();
+    pool.join();
+}
+
+BOOST_AUTO_TEST_CASE(message_subscriber__subscribe__known_command__operation_failed)
+{
+    threadpool pool(1);
+    message_subscriber instance(pool);
+    instance.start();
+
+    code result;
+    instance.subscribe<impostor_message>(
+        [&result](const code& ec, impostor_message::ptr)
+        {
+            result = ec;
+            return false;
+        });
+
+    BOOST_REQUIRE_EQUAL(result, error::operation_failed);
+    BOOST_REQUIRE(!instance.registered(make_field("tx")));
+
+    instance.stop();
+    pool.shutdown();
+    pool.join();
+}
+
+BOOST_AUTO_TEST_CASE(message_subscriber__parse__subscribed__notified_when_delivered)
+{
+    threadpool pool(1);
+    message_subscriber instance(pool);
+    instance.start();
+
+    uint64_t nonce = 0;
+    instance.subscribe<ping>(
+        [&nonce](const code& ec, ping::ptr message)
+        {
+            nonce = ec ? 0 : message->nonce;
+            return false;
+        });
+
+    const auto payload = ping(42).to_data();
+    const std::string text(payload.begin(), payload.end());
+    std::istringstream stream(text);
+
+    message_subscriber::delivery delivery;
+    BOOST_REQUIRE_EQUAL(instance.parse(message_type::ping, stream, nullptr,
+        delivery), error::success);
+    BOOST_REQUIRE(delivery);
+    BOOST_REQUIRE_EQUAL(nonce, 0u);
+
+    delivery();
+    BOOST_REQUIRE_EQUAL(nonce, 42u);
+
+    instance.stop();
+    pool.shutdown();
+    pool.join();
+}
+
+BOOST_AUTO_TEST_CASE(message_subscriber__parse__unsubscribed__empty_delivery)
+{
+    threadpool pool(1);
+    message_subscriber instance(pool);
+    instance.start();
+
+    std::istringstream stream("x");
+    message_subscriber::delivery delivery = [](){};
+    BOOST_REQUIRE_EQUAL(instance.parse(message_type::ping, stream, nullptr,
+        delivery), error::success);
+    BOOST_REQUIRE(!delivery);
+    BOOST_REQUIRE_EQUAL(instance.parse(message_type::unknown, stream, nullptr,
+        delivery), error::not_found);
+    BOOST_REQUIRE(!delivery);
+
+    instance.stop();
+    pool.shutdown();
+    pool.join();
+}
+
+BOOST_AUTO_TEST_CASE(message_subscriber__flush__batched__one_notification)
+{
+    threadpool pool(1);
+    message_subscriber instance(pool, {});
+    instance.start();
+
+    std::promise<size_t> count;
+    instance.subscribe_batch<ping>(
+        [&count](const code& ec,
+            message_subscriber::batch_ptr<ping> messages)
+        {
+            count.set_value(ec ? 0 : messages->size());
+            return false;
+        });
+
+    BOOST_REQUIRE(instance.batched(message_type::ping));
+    BOOST_REQUIRE(!instance.batched(message_type::pong));
+
+    const auto payload = ping(42).to_data();
+    const std::string text(payload.begin(), payload.end());
+    std::istringstream first(text);
+    std::istringstream second(text);
+    BOOST_REQUIRE_EQUAL(instance.load(message_type::ping, first),
+        error::success);
+    BOOST_REQUIRE_EQUAL(instance.load(message_type::ping, second),
+        error::success);
+
+    instance.flush();
+    BOOST_REQUIRE_EQUAL(count.get_future().get(), 2u);
+
+    instance.stop();
+    pool.shutdown();
+    pool.join();
+}
+
+BOOST_AUTO_TEST_CASE(message_subscriber__subscriptions__each_live__counted)
+{
+    threadpool pool(1);
+    message_subscriber instance(pool, {});
+    instance.start();
+
+    const auto handler = [](const code&, ping::ptr)
+    {
+        return true;
+    };
+
+    const auto batch_handler = [](const code&,
+        message_subscriber::batch_ptr<ping>)
+    {
+        return true;
+    };
+
+    BOOST_REQUIRE_EQUAL(instance.subscriptions(message_type::ping), 0u);
+    instance.subscribe<ping>(handler);
+    instance.subscribe<ping>(handler);
+    instance.subscribe_batch<ping>(batch_handler);
+    BOOST_REQUIRE_EQUAL(instance.subscriptions(message_type::ping), 2u);
+    BOOST_REQUIRE_EQUAL(instance.batch_subscriptions(message_type::ping), 1u);
+    BOOST_REQUIRE_EQUAL(instance.batch_subscriptions(message_type::pong), 0u);
+
+    instance.stop();
+    pool.shutdown();
+    pool.join();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,119 @@
+/**
+ * Copyright (c) 2011-2016 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <string>
+#include <boost/test/unit_test.hpp>
+#include <bitcoin/network.hpp>
+
+using namespace bc;
+using namespace bc::network;
+
+BOOST_AUTO_TEST_SUITE(metrics_exporter_tests)
+
+static metrics_exporter::snapshot empty_snapshot()
+{
+    metrics_exporter::snapshot metrics;
+    metrics.connections = 0;
+    metrics.addresses = 0;
+    metrics.broadcast_bytes_saved = 0;
+    metrics.memory = { 0, 0, 0, 0, 0, 0 };
+    metrics.buffers.oversized = 0;
+    metrics.buffers.retained_bytes = 0;
+
+    for (auto& phases: metrics.lifecycle)
+        for (auto& summary: phases)
+            summary = { 0, 0, 0, 0, 0, 0, 0 };
+
+    return metrics;
+}
+
+static bool contains(const std::string& text, const std::string& line)
+{
+    return text.find(line + "\n") != std::string::npos;
+}
+
+BOOST_AUTO_TEST_CASE(metrics_exporter__render__counts__gauges)
+{
+    auto metrics = empty_snapshot();
+    metrics.connections = 8;
+    metrics.addresses = 1000;
+    metrics.broadcast_bytes_saved = 42;
+    const auto text = metrics_exporter::render(metrics);
+    BOOST_REQUIRE(contains(text, "# TYPE libbitcoin_network_connections gauge"));
+    BOOST_REQUIRE(contains(text, "libbitcoin_network_connections 8"));
+    BOOST_REQUIRE(contains(text, "libbitcoin_network_addresses 1000"));
+    BOOST_REQUIRE(contains(text,
+        "libbitcoin_network_broadcast_bytes_saved_total 42"));
+}
+
+BOOST_AUTO_TEST_CASE(metrics_exporter__render__startup__seconds_summary)
+{
+    auto metrics = empty_snapshot();
+    auto& handshake = metrics.lifecycle
+        [static_cast<size_t>(lifecycle_metrics::origin::outbound)]
+        [static_cast<size_t>(lifecycle_metrics::phase::handshake)];
+    handshake.count = 2;
+    handshake.total_microseconds = 3000500;
+    handshake.p50_microseconds = 1250;
+    const auto text = metrics_exporter::render(metrics);
+    BOOST_REQUIRE(contains(text,
+        "libbitcoin_network_startup_seconds{session=\"outbound\","
+        "phase=\"handshake\",quantile=\"0.5\"} 0.001250"));
+    BOOST_REQUIRE(contains(text,
+        "libbitcoin_network_startup_seconds_sum{session=\"outbound\","
+        "phase=\"handshake\"} 3.000500"));
+    BOOST_REQUIRE(contains(text,
+        "libbitcoin_network_startup_seconds_count{session=\"outbound\","
+        "phase=\"handshake\"} 2"));
+}
+
+BOOST_AUTO_TEST_CASE(metrics_exporter__render__memory__by_category)
+{
+    auto metrics = empty_snapshot();
+    metrics.memory.send = 77;
+    metrics.memory.limit = 100;
+    const auto text = metrics_exporter::render(metrics);
+    BOOST_REQUIRE(contains(text,
+        "libbitcoin_network_memory_bytes{category=\"send\"} 77"));
+    BOOST_REQUIRE(contains(text, "libbitcoin_network_memory_limit_bytes 100"));
+}
+
+BOOST_AUTO_TEST_CASE(metrics_exporter__render__dispatches__by_name)
+{
+    auto metrics = empty_snapshot();
+    dispatch_monitor::summary hosts;
+    hosts.name = "hosts";
+    hosts.enqueued = 9;
+    hosts.queued = 3;
+    hosts.running = 1;
+    hosts.completed = 5;
+    hosts.wait = { 5, 500, 100, 90, 200, 200, 200 };
+    hosts.execution = { 5, 50, 10, 10, 20, 20, 20 };
+    metrics.dispatches.push_back(hosts);
+    const auto text = metrics_exporter::render(metrics);
+    BOOST_REQUIRE(contains(text,
+        "libbitcoin_network_dispatch_enqueued_total{dispatcher=\"hosts\"} 9"));
+    BOOST_REQUIRE(contains(text,
+        "libbitcoin_network_dispatch_queued{dispatcher=\"hosts\"} 3"));
+    BOOST_REQUIRE(contains(text,
+        "libbitcoin_network_dispatch_wait_seconds{dispatcher=\"hosts\","
+        "quantile=\"0.99\"} 0.000200"));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
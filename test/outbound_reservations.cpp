@@ -0,0 +1,92 @@
+/**
+ * Copyright (c) 2011-2016 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+#include <bitcoin/network.hpp>
+
+using namespace bc;
+using namespace bc::network;
+
+BOOST_AUTO_TEST_SUITE(outbound_reservations_tests)
+
+BOOST_AUTO_TEST_CASE(outbound_reservations__begin_attempt__limit__false)
+{
+    outbound_reservations instance(2);
+    BOOST_REQUIRE(instance.begin_attempt());
+    BOOST_REQUIRE(instance.begin_attempt());
+    BOOST_REQUIRE(!instance.begin_attempt());
+    BOOST_REQUIRE_EQUAL(instance.attempts(), 2u);
+}
+
+BOOST_AUTO_TEST_CASE(outbound_reservations__end_attempt__limit__true)
+{
+    outbound_reservations instance(1);
+    BOOST_REQUIRE(instance.begin_attempt());
+    instance.end_attempt();
+    BOOST_REQUIRE(instance.begin_attempt());
+    BOOST_REQUIRE_EQUAL(instance.attempts(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(outbound_reservations__begin_attempt__zero_limit__unbounded)
+{
+    outbound_reservations instance(0);
+
+    for (auto count = 0; count < 100; ++count)
+        BOOST_REQUIRE(instance.begin_attempt());
+
+    BOOST_REQUIRE_EQUAL(instance.attempts(), 100u);
+}
+
+BOOST_AUTO_TEST_CASE(outbound_reservations__reserve__duplicate__false)
+{
+    outbound_reservations instance(0);
+    const config::authority host("1.2.3.4:8333");
+    BOOST_REQUIRE(instance.reserve(host));
+    BOOST_REQUIRE(!instance.reserve(host));
+    BOOST_REQUIRE_EQUAL(instance.reserved(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(outbound_reservations__reserve__same_group__false)
+{
+    outbound_reservations instance(0);
+    BOOST_REQUIRE(instance.reserve(config::authority("1.2.3.4:8333")));
+    BOOST_REQUIRE(!instance.reserve(config::authority("1.2.200.1:8333")));
+    BOOST_REQUIRE(instance.reserve(config::authority("1.3.3.4:8333")));
+    BOOST_REQUIRE_EQUAL(instance.reserved(), 2u);
+}
+
+BOOST_AUTO_TEST_CASE(outbound_reservations__release__reserved__reservable)
+{
+    outbound_reservations instance(0);
+    const config::authority host("1.2.3.4:8333");
+    BOOST_REQUIRE(instance.reserve(host));
+    instance.release(host);
+    BOOST_REQUIRE_EQUAL(instance.reserved(), 0u);
+    BOOST_REQUIRE(instance.reserve(config::authority("1.2.200.1:8333")));
+}
+
+BOOST_AUTO_TEST_CASE(outbound_reservations__release__other_group_host__reserved)
+{
+    outbound_reservations instance(0);
+    BOOST_REQUIRE(instance.reserve(config::authority("1.2.3.4:8333")));
+    instance.release(config::authority("1.2.200.1:8333"));
+    BOOST_REQUIRE_EQUAL(instance.reserved(), 1u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,65 @@
+/**
+ * Copyright (c) 2011-2015 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <istream>
+#include <boost/test/unit_test.hpp>
+#include <bitcoin/network.hpp>
+
+using namespace bc;
+using namespace bc::network;
+
+BOOST_AUTO_TEST_SUITE(payload_streambuf_tests)
+
+BOOST_AUTO_TEST_CASE(payload_streambuf__read__all__eof)
+{
+    const data_chunk data{ 0x01, 0x02, 0x03 };
+    payload_streambuf buffer(data);
+    std::istream stream(&buffer);
+
+    char out[3];
+    BOOST_REQUIRE(stream.read(out, 3));
+    BOOST_REQUIRE_EQUAL(out[2], 0x03);
+    BOOST_REQUIRE_EQUAL(buffer.remaining(), 0u);
+    BOOST_REQUIRE(stream.peek() == std::istream::traits_type::eof());
+}
+
+BOOST_AUTO_TEST_CASE(payload_streambuf__read__overflow__fails)
+{
+    const data_chunk data{ 0x01, 0x02 };
+    payload_streambuf buffer(data);
+    std::istream stream(&buffer);
+
+    char out[3];
+    BOOST_REQUIRE(!stream.read(out, 3));
+    BOOST_REQUIRE_EQUAL(stream.gcount(), 2);
+}
+
+BOOST_AUTO_TEST_CASE(payload_streambuf__seekg__tellg__expected)
+{
+    const data_chunk data{ 0x01, 0x02, 0x03, 0x04 };
+    payload_streambuf buffer(data);
+    std::istream stream(&buffer);
+
+    BOOST_REQUIRE(stream.seekg(3));
+    BOOST_REQUIRE_EQUAL(stream.tellg(), 3);
+    BOOST_REQUIRE_EQUAL(stream.get(), 0x04);
+    BOOST_REQUIRE(!stream.seekg(5));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
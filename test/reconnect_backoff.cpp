@@ -0,0 +1,81 @@
+/**
+ * Copyright (c) 2011-2016 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+#include <bitcoin/network.hpp>
+
+using namespace bc;
+using namespace bc::network;
+
+static const asio::duration initial = asio::milliseconds(500);
+static const asio::duration maximum = asio::seconds(60);
+
+BOOST_AUTO_TEST_SUITE(reconnect_backoff_tests)
+
+BOOST_AUTO_TEST_CASE(reconnect_backoff__delay__no_failures__initial)
+{
+    BOOST_REQUIRE(reconnect_backoff::delay(initial, maximum, 0) == initial);
+}
+
+BOOST_AUTO_TEST_CASE(reconnect_backoff__delay__failures__doubled)
+{
+    BOOST_REQUIRE(reconnect_backoff::delay(initial, maximum, 1) == asio::seconds(1));
+    BOOST_REQUIRE(reconnect_backoff::delay(initial, maximum, 3) == asio::seconds(4));
+}
+
+BOOST_AUTO_TEST_CASE(reconnect_backoff__delay__many_failures__maximum)
+{
+    BOOST_REQUIRE(reconnect_backoff::delay(initial, maximum, 7) == maximum);
+    BOOST_REQUIRE(reconnect_backoff::delay(initial, maximum, 1000000) == maximum);
+}
+
+BOOST_AUTO_TEST_CASE(reconnect_backoff__next__jitter__within_half_of_delay)
+{
+    reconnect_backoff instance(initial, maximum);
+
+    for (size_t failures = 0; failures < 10; ++failures)
+    {
+        const auto expected = reconnect_backoff::delay(initial, maximum,
+            failures);
+        const auto delay = instance.next();
+        BOOST_REQUIRE(delay <= expected);
+        BOOST_REQUIRE(delay >= expected / 2);
+    }
+
+    BOOST_REQUIRE_EQUAL(instance.failures(), 10u);
+}
+
+BOOST_AUTO_TEST_CASE(reconnect_backoff__reset__failures__initial)
+{
+    reconnect_backoff instance(initial, maximum);
+    instance.next();
+    instance.next();
+    instance.reset();
+    BOOST_REQUIRE_EQUAL(instance.failures(), 0u);
+    BOOST_REQUIRE(instance.next() <= initial);
+}
+
+BOOST_AUTO_TEST_CASE(reconnect_backoff__next__zero_initial__zero)
+{
+    reconnect_backoff instance(asio::duration(), maximum);
+    BOOST_REQUIRE(instance.next().is_zero());
+    BOOST_REQUIRE(instance.next().is_zero());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
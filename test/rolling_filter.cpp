@@ -0,0 +1,102 @@
+/**
+ * Copyright (c) 2011-2016 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <cstddef>
+#include <cstdint>
+#include <boost/test/unit_test.hpp>
+#include <bitcoin/network.hpp>
+
+using namespace bc;
+using namespace bc::network;
+
+static hash_digest make_hash(uint32_t seed, uint32_t salt)
+{
+    hash_digest hash = null_hash;
+
+    // Spread the seed over the hash, as real hashes are uniform.
+    for (size_t index = 0; index < hash.size(); ++index)
+        hash[index] = static_cast<uint8_t>((seed * 2654435761u + salt) >>
+            ((index % 4) * 8)) ^ static_cast<uint8_t>(index * 31 + seed);
+
+    return hash;
+}
+
+BOOST_AUTO_TEST_SUITE(rolling_filter_tests)
+
+BOOST_AUTO_TEST_CASE(rolling_filter__insert__new__contained)
+{
+    rolling_filter instance(100);
+    const auto hash = make_hash(42, 0);
+    BOOST_REQUIRE(!instance.contains(hash));
+    BOOST_REQUIRE(instance.insert(hash));
+    BOOST_REQUIRE(instance.contains(hash));
+    BOOST_REQUIRE(!instance.insert(hash));
+}
+
+BOOST_AUTO_TEST_CASE(rolling_filter__insert__half_capacity__all_retained)
+{
+    const size_t capacity = 1000;
+    rolling_filter instance(capacity);
+
+    // Insert more than a generation, the most recent half are retained.
+    for (uint32_t seed = 0; seed < capacity; ++seed)
+        instance.insert(make_hash(seed, 0));
+
+    for (uint32_t seed = capacity / 2; seed < capacity; ++seed)
+        BOOST_REQUIRE(instance.contains(make_hash(seed, 0)));
+}
+
+BOOST_AUTO_TEST_CASE(rolling_filter__contains__unknown__rare_false_positives)
+{
+    const size_t capacity = 1000;
+    rolling_filter instance(capacity);
+
+    for (uint32_t seed = 0; seed < capacity; ++seed)
+        instance.insert(make_hash(seed, 0));
+
+    size_t false_positives = 0;
+    for (uint32_t seed = 0; seed < 10000; ++seed)
+        if (instance.contains(make_hash(seed, 1)))
+            ++false_positives;
+
+    BOOST_REQUIRE_LT(false_positives, 100u);
+}
+
+BOOST_AUTO_TEST_CASE(rolling_filter__footprint__fixed)
+{
+    rolling_filter instance(5000);
+    const auto footprint = instance.footprint();
+
+    for (uint32_t seed = 0; seed < 50000; ++seed)
+        instance.insert(make_hash(seed, 0));
+
+    BOOST_REQUIRE_EQUAL(instance.footprint(), footprint);
+    BOOST_REQUIRE_LT(footprint, 16u * 1024u);
+}
+
+BOOST_AUTO_TEST_CASE(rolling_filter__clear__inserted__not_contained)
+{
+    rolling_filter instance(100);
+    const auto hash = make_hash(42, 0);
+    instance.insert(hash);
+    instance.clear();
+    BOOST_REQUIRE(!instance.contains(hash));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
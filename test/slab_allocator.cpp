@@ -0,0 +1,88 @@
+/**
+ * Copyright (c) 2011-2016 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <memory>
+#include <string>
+#include <boost/test/unit_test.hpp>
+#include <bitcoin/network.hpp>
+
+using namespace bc;
+using namespace bc::network;
+
+BOOST_AUTO_TEST_SUITE(slab_allocator_tests)
+
+BOOST_AUTO_TEST_CASE(slab__allocate__released__reused)
+{
+    const auto first = slab::allocate(100);
+    slab::deallocate(first, 100);
+
+    // The block is of the same class, so it is taken from the thread cache.
+    const auto second = slab::allocate(120);
+    BOOST_REQUIRE(first == second);
+    slab::deallocate(second, 120);
+}
+
+BOOST_AUTO_TEST_CASE(slab__allocate__other_class__distinct)
+{
+    const auto small = slab::allocate(32);
+    slab::deallocate(small, 32);
+
+    const auto large = slab::allocate(1000);
+    BOOST_REQUIRE(small != large);
+    slab::deallocate(large, 1000);
+}
+
+BOOST_AUTO_TEST_CASE(slab__allocate__oversized__usable)
+{
+    const size_t size = 1024 * 1024;
+    const auto block = static_cast<uint8_t*>(slab::allocate(size));
+    BOOST_REQUIRE(block != nullptr);
+    block[0] = 42;
+    block[size - 1] = 42;
+    slab::deallocate(block, size);
+}
+
+BOOST_AUTO_TEST_CASE(slab_allocator__allocate_shared__constructs)
+{
+    const auto value = std::allocate_shared<std::string>(
+        slab_allocator<std::string>(), "slab");
+    BOOST_REQUIRE_EQUAL(*value, "slab");
+}
+
+BOOST_AUTO_TEST_CASE(slab_allocator__equal__rebound)
+{
+    const slab_allocator<int> first;
+    const slab_allocator<std::string> second(first);
+    BOOST_REQUIRE(first == second);
+    BOOST_REQUIRE(!(first != second));
+}
+
+BOOST_AUTO_TEST_CASE(slab_handler__invoke__forwards_arguments)
+{
+    size_t sum = 0;
+    auto handler = make_slab_handler([&sum](size_t left, size_t right)
+    {
+        sum = left + right;
+    });
+
+    handler(40, 2);
+    BOOST_REQUIRE_EQUAL(sum, 42u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
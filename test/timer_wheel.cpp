@@ -0,0 +1,127 @@
+/**
+ * Copyright (c) 2011-2016 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <cstddef>
+#include <memory>
+#include <boost/test/unit_test.hpp>
+#include <bitcoin/network.hpp>
+
+using namespace bc;
+using namespace bc::network;
+
+// The tests advance the wheel directly, so the pool has no threads.
+struct timer_wheel_fixture
+{
+    timer_wheel_fixture()
+      : pool(0),
+        wheel(std::make_shared<timer_wheel>(pool, asio::seconds(1), 4))
+    {
+        wheel->start();
+    }
+
+    ~timer_wheel_fixture()
+    {
+        wheel->stop();
+    }
+
+    threadpool pool;
+    timer_wheel::ptr wheel;
+};
+
+BOOST_FIXTURE_TEST_SUITE(timer_wheel_tests, timer_wheel_fixture)
+
+BOOST_AUTO_TEST_CASE(timer_wheel__advance__delay_elapsed__expired)
+{
+    size_t count = 0;
+    const auto handler = [&count](const code& ec)
+    {
+        BOOST_REQUIRE_EQUAL(ec, error::success);
+        ++count;
+    };
+
+    BOOST_REQUIRE_NE(wheel->schedule(asio::seconds(2), handler), 0u);
+    wheel->advance();
+    BOOST_REQUIRE_EQUAL(count, 0u);
+    wheel->advance();
+    BOOST_REQUIRE_EQUAL(count, 1u);
+    BOOST_REQUIRE_EQUAL(wheel->pending(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(timer_wheel__advance__partial_tick__rounded_up)
+{
+    size_t count = 0;
+    const auto handler = [&count](const code&) { ++count; };
+
+    wheel->schedule(asio::milliseconds(1500), handler);
+    wheel->advance();
+    BOOST_REQUIRE_EQUAL(count, 0u);
+    wheel->advance();
+    BOOST_REQUIRE_EQUAL(count, 1u);
+}
+
+BOOST_AUTO_TEST_CASE(timer_wheel__advance__beyond_revolution__waits_rounds)
+{
+    size_t count = 0;
+    const auto handler = [&count](const code&) { ++count; };
+
+    // Nine ticks is two revolutions of four slots and one more tick.
+    wheel->schedule(asio::seconds(9), handler);
+
+    for (size_t tick = 0; tick < 8; ++tick)
+        wheel->advance();
+
+    BOOST_REQUIRE_EQUAL(count, 0u);
+    wheel->advance();
+    BOOST_REQUIRE_EQUAL(count, 1u);
+}
+
+BOOST_AUTO_TEST_CASE(timer_wheel__cancel__pending__not_invoked)
+{
+    size_t count = 0;
+    const auto handler = [&count](const code&) { ++count; };
+
+    const auto identifier = wheel->schedule(asio::seconds(1), handler);
+    BOOST_REQUIRE(wheel->cancel(identifier));
+    BOOST_REQUIRE(!wheel->cancel(identifier));
+    wheel->advance();
+    BOOST_REQUIRE_EQUAL(count, 0u);
+}
+
+BOOST_AUTO_TEST_CASE(timer_wheel__stop__pending__service_stopped)
+{
+    code result;
+    const auto handler = [&result](const code& ec) { result = ec; };
+
+    wheel->schedule(asio::seconds(3), handler);
+    wheel->stop();
+    BOOST_REQUIRE_EQUAL(result, error::service_stopped);
+    BOOST_REQUIRE_EQUAL(wheel->pending(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(timer_wheel__schedule__stopped__service_stopped)
+{
+    code result;
+    const auto handler = [&result](const code& ec) { result = ec; };
+
+    wheel->stop();
+    BOOST_REQUIRE_EQUAL(wheel->schedule(asio::seconds(1), handler), 0u);
+    BOOST_REQUIRE_EQUAL(result, error::service_stopped);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,83 @@
+/**
+ * Copyright (c) 2011-2016 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <chrono>
+#include <boost/test/unit_test.hpp>
+#include <bitcoin/network.hpp>
+
+using namespace bc;
+using namespace bc::network;
+using namespace std::chrono;
+
+BOOST_AUTO_TEST_SUITE(token_bucket_tests)
+
+BOOST_AUTO_TEST_CASE(token_bucket__available__zero_rate__unlimited)
+{
+    token_bucket instance(0, 0);
+    instance.consume(1000000);
+    BOOST_REQUIRE(instance.unlimited());
+    BOOST_REQUIRE(instance.available());
+    BOOST_REQUIRE(instance.delay().is_zero());
+}
+
+BOOST_AUTO_TEST_CASE(token_bucket__available__full__true)
+{
+    token_bucket instance(1000, 1000);
+    BOOST_REQUIRE(!instance.unlimited());
+    BOOST_REQUIRE(instance.available(token_bucket::clock::now()));
+}
+
+BOOST_AUTO_TEST_CASE(token_bucket__consume__overdrawn__unavailable_until_repaid)
+{
+    token_bucket instance(1000, 1000);
+    const auto now = token_bucket::clock::now();
+
+    // A message larger than the burst is admitted and repaid by refill.
+    instance.consume(1500, now);
+    BOOST_REQUIRE(!instance.available(now));
+    BOOST_REQUIRE_EQUAL(instance.delay(now).total_milliseconds(), 501);
+    BOOST_REQUIRE(!instance.available(now + milliseconds(500)));
+    BOOST_REQUIRE(instance.available(now + milliseconds(501)));
+}
+
+BOOST_AUTO_TEST_CASE(token_bucket__refill__long_idle__capped_at_burst)
+{
+    token_bucket instance(1000, 100);
+    const auto now = token_bucket::clock::now();
+
+    // The idle interval does not accumulate beyond the burst.
+    instance.consume(100, now + seconds(10));
+    BOOST_REQUIRE(!instance.available(now + seconds(10)));
+    BOOST_REQUIRE(instance.available(now + seconds(10) + milliseconds(1)));
+}
+
+BOOST_AUTO_TEST_CASE(token_bucket__refill__fractional_intervals__retained)
+{
+    token_bucket instance(1000, 1000);
+    const auto now = token_bucket::clock::now();
+    instance.consume(1001, now);
+
+    // Intervals shorter than a token are not lost to rounding.
+    for (auto offset = 1; offset <= 4; ++offset)
+        BOOST_REQUIRE(!instance.available(now + microseconds(offset * 400)));
+
+    BOOST_REQUIRE(instance.available(now + microseconds(2000)));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
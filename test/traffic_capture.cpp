@@ -0,0 +1,150 @@
+/**
+ * Copyright (c) 2011-2016 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * libbitcoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <boost/filesystem.hpp>
+#include <boost/test/unit_test.hpp>
+#include <bitcoin/network.hpp>
+
+using namespace bc;
+using namespace bc::network;
+
+#define TEST_FILE "traffic_capture_tests.capture"
+
+struct traffic_capture_fixture
+{
+    traffic_capture_fixture()
+    {
+        boost::filesystem::remove(TEST_FILE);
+    }
+
+    ~traffic_capture_fixture()
+    {
+        boost::filesystem::remove(TEST_FILE);
+    }
+};
+
+static message::heading make_heading(const std::string& command,
+    uint32_t size)
+{
+    message::heading head;
+    head.magic = 0xd9b4bef9;
+    head.command = command;
+    head.payload_size = size;
+    head.checksum = 0x12345678;
+    return head;
+}
+
+BOOST_FIXTURE_TEST_SUITE(traffic_capture_tests, traffic_capture_fixture)
+
+BOOST_AUTO_TEST_CASE(traffic_capture__write__empty_path__ignored)
+{
+    traffic_capture instance("");
+    BOOST_REQUIRE_EQUAL(instance.start(), error::success);
+    BOOST_REQUIRE(!instance.capturing());
+
+    const data_chunk payload{ 1, 2, 3, 4, 5, 6, 7, 8 };
+    const config::authority peer(asio::ipv6::loopback(), 8333);
+    instance.write(peer, make_heading("ping", 8), payload.data());
+    BOOST_REQUIRE_EQUAL(instance.count(), 0u);
+    BOOST_REQUIRE(!boost::filesystem::exists(TEST_FILE));
+}
+
+BOOST_AUTO_TEST_CASE(traffic_capture__read__written__round_trip)
+{
+    const data_chunk payload{ 1, 2, 3, 4, 5, 6, 7, 8 };
+    const config::authority peer(asio::ipv6::loopback(), 8333);
+    const auto ping = make_heading("ping", 8);
+    const auto verack = make_heading("verack", 0);
+
+    traffic_capture instance(TEST_FILE);
+    BOOST_REQUIRE_EQUAL(instance.start(), error::success);
+    BOOST_REQUIRE(instance.capturing());
+    instance.write(peer, ping, payload.data());
+    instance.write(peer, verack, nullptr);
+    instance.stop();
+    BOOST_REQUIRE(!instance.capturing());
+    BOOST_REQUIRE_EQUAL(instance.count(), 2u);
+
+    bc::ifstream file(TEST_FILE, std::ios::binary);
+    BOOST_REQUIRE(traffic_capture::read_header(file));
+
+    traffic_capture::record record;
+    BOOST_REQUIRE(traffic_capture::read(file, record));
+    BOOST_REQUIRE(record.timestamp != 0);
+    BOOST_REQUIRE(record.authority.ip() == peer.ip());
+    BOOST_REQUIRE_EQUAL(record.authority.port(), 8333u);
+    const auto raw = ping.to_data();
+    BOOST_REQUIRE(std::equal(raw.begin(), raw.end(), record.heading.begin()));
+    BOOST_REQUIRE(record.payload == payload);
+
+    BOOST_REQUIRE(traffic_capture::read(file, record));
+    BOOST_REQUIRE(record.payload.empty());
+    BOOST_REQUIRE(!traffic_capture::read(file, record));
+}
+
+BOOST_AUTO_TEST_CASE(traffic_capture__start__existing__appends_one_header)
+{
+    const data_chunk payload{ 1, 2, 3, 4, 5, 6, 7, 8 };
+    const config::authority peer(asio::ipv6::loopback(), 8333);
+    const auto ping = make_heading("ping", 8);
+
+    traffic_capture instance(TEST_FILE);
+    BOOST_REQUIRE_EQUAL(instance.start(), error::success);
+    instance.write(peer, ping, payload.data());
+    instance.stop();
+    BOOST_REQUIRE_EQUAL(instance.start(), error::success);
+    instance.write(peer, ping, payload.data());
+    instance.stop();
+
+    bc::ifstream file(TEST_FILE, std::ios::binary);
+    BOOST_REQUIRE(traffic_capture::read_header(file));
+
+    traffic_capture::record record;
+    BOOST_REQUIRE(traffic_capture::read(file, record));
+    BOOST_REQUIRE(traffic_capture::read(file, record));
+    BOOST_REQUIRE(!traffic_capture::read(file, record));
+}
+
+BOOST_AUTO_TEST_CASE(traffic_capture__read_header__other_file__false)
+{
+    bc::ofstream out(TEST_FILE, std::ios::binary);
+    out << "not a capture file";
+    out.close();
+
+    bc::ifstream file(TEST_FILE, std::ios::binary);
+    BOOST_REQUIRE(!traffic_capture::read_header(file));
+}
+
+BOOST_AUTO_TEST_CASE(traffic_capture__read__oversized_payload__false)
+{
+    // A record prefix of zeros and a heading that claims a 4 GiB payload.
+    const auto raw = make_heading("block", max_uint32).to_data();
+    std::string text(traffic_capture::prefix_size, '\0');
+    text.append(raw.begin(), raw.end());
+    std::istringstream stream(text);
+
+    traffic_capture::record record;
+    BOOST_REQUIRE(!traffic_capture::read(stream, record));
+    BOOST_REQUIRE(record.payload.empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()